@@ -130,6 +130,31 @@ absl::Status DeviceCompilationProfiler::RegisterCompilation(
   return BroadcastXlaActivity(std::move(jit_compilation_activity));
 }
 
+void DeviceCompilationProfiler::RegisterSpeculativeCompilation(
+    const NameAttrList& function) {
+  mutex_lock lock(mu_);
+  auto it =
+      cluster_compile_stats_.emplace(function.name(), ClusterCompileStats{})
+          .first;
+  it->second.speculative_compile_count++;
+}
+
+void DeviceCompilationProfiler::RegisterSpeculationOutcome(
+    const NameAttrList& function, bool hit) {
+  mutex_lock lock(mu_);
+  auto it =
+      cluster_compile_stats_.emplace(function.name(), ClusterCompileStats{})
+          .first;
+  if (hit) {
+    it->second.speculation_hit_count++;
+  } else {
+    it->second.speculation_miss_count++;
+  }
+  VLOG(2) << "Speculative compilation " << (hit ? "hit" : "miss") << " for "
+          << function.name() << ", hits: " << it->second.speculation_hit_count
+          << ", misses: " << it->second.speculation_miss_count;
+}
+
 bool DeviceCompilationProfiler::ShouldCompileCluster(
     const NameAttrList& function, DeviceCompileMode compile_mode,
     int64_t current_request_count) {
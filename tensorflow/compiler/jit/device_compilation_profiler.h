@@ -46,12 +46,25 @@ class DeviceCompilationProfiler : public ResourceBase {
     // tagged megamorphic, it stays megamorphic forever.
     bool is_megamorphic = false;
 
+    // Number of compilations started ahead of time for signatures predicted
+    // from the ones seen so far. These are included in `compile_count`.
+    int64_t speculative_compile_count = 0;
+
+    // Number of requests for a signature whose compilation had been started
+    // speculatively (hits), and for a signature that hadn't been compiled yet
+    // while speculative compilation was enabled (misses).
+    int64_t speculation_hit_count = 0;
+    int64_t speculation_miss_count = 0;
+
     std::string DebugString() const {
       return absl::StrCat(
           "DeviceCompilationProfiler::ClusterCompileStats {compile_count=",
           compile_count, ", execution_count=", execution_count,
           ", cumulative_compile_time_us=", cumulative_compile_time_us,
-          ", is_megamorphic=", is_megamorphic, "}");
+          ", is_megamorphic=", is_megamorphic,
+          ", speculative_compile_count=", speculative_compile_count,
+          ", speculation_hit_count=", speculation_hit_count,
+          ", speculation_miss_count=", speculation_miss_count, "}");
     }
   };
 
@@ -78,6 +91,15 @@ class DeviceCompilationProfiler : public ResourceBase {
                                            int64_t compile_time_us,
                                            bool used_persistent_cache);
 
+  // Registers that a compilation of a predicted signature of the given cluster
+  // was started ahead of time. The compilation itself is registered through
+  // `RegisterCompilation` once it finishes.
+  void RegisterSpeculativeCompilation(const NameAttrList& function);
+
+  // Registers whether the compilation of a requested signature of the given
+  // cluster had been started speculatively (`hit`) or is still to be started.
+  void RegisterSpeculationOutcome(const NameAttrList& function, bool hit);
+
   void IncrementOngoingAsyncCompilations();
   void DecrementOngoingAsyncCompilations();
   int64_t GetNumOngoingAsyncCompilations() const;
@@ -81,6 +81,28 @@ TEST(DeviceCompilationProfilerTest, RegisterCompilation) {
   }
 }
 
+TEST(DeviceCompilationProfilerTest, RegisterSpeculation) {
+  DeviceCompilationProfiler* profiler = new DeviceCompilationProfiler();
+  core::ScopedUnref profiler_ref(profiler);
+
+  NameAttrList function;
+  function.set_name("TestFunc");
+
+  for (int i = 0; i < 3; ++i) {
+    profiler->RegisterSpeculativeCompilation(function);
+  }
+  profiler->RegisterSpeculationOutcome(function, /*hit=*/true);
+  profiler->RegisterSpeculationOutcome(function, /*hit=*/true);
+  profiler->RegisterSpeculationOutcome(function, /*hit=*/false);
+
+  TF_ASSERT_OK_AND_ASSIGN(auto stats, profiler->GetCompileStats(function));
+  EXPECT_EQ(stats.speculative_compile_count, 3);
+  EXPECT_EQ(stats.speculation_hit_count, 2);
+  EXPECT_EQ(stats.speculation_miss_count, 1);
+  // Speculative compilations are only counted once they have finished.
+  EXPECT_EQ(stats.compile_count, 0);
+}
+
 TEST(DeviceCompilationProfilerTest, OngoingAsyncCompilations) {
   DeviceCompilationProfiler* profiler = new DeviceCompilationProfiler();
   core::ScopedUnref profiler_ref(profiler);
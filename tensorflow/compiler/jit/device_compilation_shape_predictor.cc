@@ -0,0 +1,170 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/device_compilation_shape_predictor.h"
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "absl/types/variant.h"
+#include "tensorflow/compiler/tf2xla/xla_argument.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace {
+
+// The number of distinct shapes remembered per cluster, which bounds the
+// periods that can be recognized.
+constexpr int kMaxHistory = 8;
+constexpr int kMaxPeriod = kMaxHistory / 2;
+
+using Shapes = std::vector<TensorShape>;
+
+// Returns the indices of the arguments whose shapes are predicted.
+std::vector<int> PredictedArguments(absl::Span<const XlaArgument> args) {
+  std::vector<int> indices;
+  for (int i = 0; i < args.size(); ++i) {
+    if (args[i].kind == XlaArgument::kParameter &&
+        absl::holds_alternative<TensorShape>(args[i].shape)) {
+      indices.push_back(i);
+    }
+  }
+  return indices;
+}
+
+bool SameRanks(const Shapes& a, const Shapes& b) {
+  return a.size() == b.size() &&
+         absl::c_equal(a, b, [](const TensorShape& x, const TensorShape& y) {
+           return x.dims() == y.dims();
+         });
+}
+
+// Continues the progression of the last three shapes in `history`, if they
+// form one.
+std::vector<Shapes> PredictGrowth(const std::deque<Shapes>& history,
+                                  int max_predictions) {
+  const int n = history.size();
+  if (n < 3) return {};
+  const Shapes& first = history[n - 3];
+  const Shapes& second = history[n - 2];
+  const Shapes& last = history[n - 1];
+
+  for (int i = 0; i < last.size(); ++i) {
+    for (int d = 0; d < last[i].dims(); ++d) {
+      if (last[i].dim_size(d) - second[i].dim_size(d) !=
+          second[i].dim_size(d) - first[i].dim_size(d)) {
+        return {};
+      }
+    }
+  }
+
+  std::vector<Shapes> predictions;
+  for (int k = 1; k <= max_predictions; ++k) {
+    Shapes next = last;
+    for (int i = 0; i < next.size(); ++i) {
+      for (int d = 0; d < next[i].dims(); ++d) {
+        const int64_t delta = last[i].dim_size(d) - second[i].dim_size(d);
+        const int64_t size = last[i].dim_size(d) + k * delta;
+        if (size < 0) return predictions;
+        next[i].set_dim(d, size);
+      }
+    }
+    predictions.push_back(std::move(next));
+  }
+  return predictions;
+}
+
+// Continues the shortest cycle the last shapes in `history` repeat, if any.
+std::vector<Shapes> PredictPeriod(const std::deque<Shapes>& history,
+                                  int max_predictions) {
+  const int n = history.size();
+  for (int period = 2; period <= kMaxPeriod && 2 * period <= n; ++period) {
+    bool repeats = true;
+    for (int i = n - period; i < n && repeats; ++i) {
+      repeats = history[i] == history[i - period];
+    }
+    if (!repeats) continue;
+
+    std::vector<Shapes> predictions;
+    for (int k = 0; k < max_predictions && k < period - 1; ++k) {
+      predictions.push_back(history[n - period + k]);
+    }
+    return predictions;
+  }
+  return {};
+}
+
+}  // namespace
+
+std::vector<DeviceCompilationShapePredictor::ParameterShapes>
+DeviceCompilationShapePredictor::Predict(
+    const std::deque<ParameterShapes>& history) const {
+  std::vector<ParameterShapes> predictions =
+      PredictGrowth(history, max_predictions_);
+  if (predictions.empty()) {
+    predictions = PredictPeriod(history, max_predictions_);
+  }
+  return predictions;
+}
+
+std::vector<std::vector<XlaArgument>>
+DeviceCompilationShapePredictor::RecordAndPredict(
+    absl::string_view cluster, absl::Span<const XlaArgument> args) {
+  const std::vector<int> indices = PredictedArguments(args);
+  if (indices.empty()) return {};
+
+  ParameterShapes shapes;
+  shapes.reserve(indices.size());
+  for (int i : indices) {
+    shapes.push_back(absl::get<TensorShape>(args[i].shape));
+  }
+
+  std::vector<ParameterShapes> predictions;
+  {
+    mutex_lock lock(mu_);
+    std::deque<ParameterShapes>& history = history_[std::string(cluster)];
+    if (!history.empty()) {
+      if (history.back() == shapes) return {};
+      // The parameters have changed in a way no pattern accounts for.
+      if (!SameRanks(history.back(), shapes)) history.clear();
+    }
+    history.push_back(std::move(shapes));
+    if (history.size() > kMaxHistory) history.pop_front();
+    predictions = Predict(history);
+  }
+
+  std::vector<std::vector<XlaArgument>> predicted_args;
+  predicted_args.reserve(predictions.size());
+  for (ParameterShapes& prediction : predictions) {
+    std::vector<XlaArgument>& next =
+        predicted_args.emplace_back(args.begin(), args.end());
+    for (int i = 0; i < indices.size(); ++i) {
+      next[indices[i]].shape = std::move(prediction[i]);
+    }
+  }
+  VLOG(2) << "Predicted " << predicted_args.size() << " signatures of "
+          << cluster;
+  return predicted_args;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,74 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_JIT_DEVICE_COMPILATION_SHAPE_PREDICTOR_H_
+#define TENSORFLOW_COMPILER_JIT_DEVICE_COMPILATION_SHAPE_PREDICTOR_H_
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tensorflow/compiler/tf2xla/xla_argument.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+// Records the shapes of the parameters each cluster is compiled for, and
+// predicts the shapes it is going to be compiled for next, so that they can be
+// compiled ahead of time (see --tf_xla_speculative_compilation).
+//
+// Two patterns are recognized in the sequence of distinct consecutive shapes:
+//  - growth: the last three shapes differ by the same nonzero amount in every
+//    dimension, e.g. a sequence length growing by one token at every step.
+//    The next shapes continue the progression.
+//  - periodic: the last few shapes repeat the ones before them, e.g. the batch
+//    sizes of an epoch whose last batch is smaller. The next shapes continue
+//    the cycle.
+class DeviceCompilationShapePredictor {
+ public:
+  explicit DeviceCompilationShapePredictor(int max_predictions = 2)
+      : max_predictions_(max_predictions) {}
+
+  // Records the shapes of the parameters among `args` for `cluster` and
+  // returns copies of `args` with the parameter shapes that are predicted to
+  // follow, most likely first. Returns nothing if the shapes haven't changed
+  // since the last call, or if they follow no known pattern.
+  std::vector<std::vector<XlaArgument>> RecordAndPredict(
+      absl::string_view cluster, absl::Span<const XlaArgument> args);
+
+ private:
+  // The shapes of the parameters of one compilation.
+  using ParameterShapes = std::vector<TensorShape>;
+
+  std::vector<ParameterShapes> Predict(
+      const std::deque<ParameterShapes>& history) const;
+
+  const int max_predictions_;
+
+  mutex mu_;
+  // The last distinct consecutive parameter shapes of each cluster, oldest
+  // first.
+  absl::flat_hash_map<std::string, std::deque<ParameterShapes>> history_
+      TF_GUARDED_BY(mu_);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_JIT_DEVICE_COMPILATION_SHAPE_PREDICTOR_H_
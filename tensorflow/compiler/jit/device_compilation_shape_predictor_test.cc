@@ -0,0 +1,132 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/device_compilation_shape_predictor.h"
+
+#include <cstdint>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/types/variant.h"
+#include "tensorflow/compiler/tf2xla/xla_argument.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.pb.h"
+
+namespace tensorflow {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+XlaArgument Parameter(const TensorShape& shape) {
+  XlaArgument arg;
+  arg.kind = XlaArgument::kParameter;
+  arg.type = DT_FLOAT;
+  arg.shape = shape;
+  return arg;
+}
+
+// Returns the shape of the first argument of each prediction.
+std::vector<TensorShape> FirstShapes(
+    const std::vector<std::vector<XlaArgument>>& predictions) {
+  std::vector<TensorShape> shapes;
+  for (const std::vector<XlaArgument>& args : predictions) {
+    shapes.push_back(absl::get<TensorShape>(args[0].shape));
+  }
+  return shapes;
+}
+
+TEST(DeviceCompilationShapePredictorTest, PredictsGrowth) {
+  DeviceCompilationShapePredictor predictor;
+  const TensorShape weights({16, 16});
+
+  EXPECT_THAT(predictor.RecordAndPredict(
+                  "cluster", {Parameter(TensorShape({1, 10, 16})),
+                              Parameter(weights)}),
+              IsEmpty());
+  EXPECT_THAT(predictor.RecordAndPredict(
+                  "cluster", {Parameter(TensorShape({1, 12, 16})),
+                              Parameter(weights)}),
+              IsEmpty());
+  auto predictions = predictor.RecordAndPredict(
+      "cluster",
+      {Parameter(TensorShape({1, 14, 16})), Parameter(weights)});
+
+  EXPECT_THAT(FirstShapes(predictions),
+              ElementsAre(TensorShape({1, 16, 16}), TensorShape({1, 18, 16})));
+  // Arguments whose shape doesn't change are left alone.
+  for (const auto& args : predictions) {
+    EXPECT_EQ(absl::get<TensorShape>(args[1].shape), weights);
+  }
+}
+
+TEST(DeviceCompilationShapePredictorTest, StopsGrowthBelowZero) {
+  DeviceCompilationShapePredictor predictor;
+  predictor.RecordAndPredict("cluster", {Parameter(TensorShape({5}))});
+  predictor.RecordAndPredict("cluster", {Parameter(TensorShape({3}))});
+  EXPECT_THAT(
+      predictor.RecordAndPredict("cluster", {Parameter(TensorShape({1}))}),
+      IsEmpty());
+}
+
+TEST(DeviceCompilationShapePredictorTest, PredictsPeriod) {
+  DeviceCompilationShapePredictor predictor;
+  for (int64_t batch : {32, 32, 7, 32, 32}) {
+    predictor.RecordAndPredict("cluster", {Parameter(TensorShape({batch}))});
+  }
+  EXPECT_THAT(FirstShapes(predictor.RecordAndPredict(
+                  "cluster", {Parameter(TensorShape({7}))})),
+              ElementsAre(TensorShape({32})));
+
+  DeviceCompilationShapePredictor three;
+  for (int64_t batch : {8, 16, 4, 8, 16}) {
+    three.RecordAndPredict("cluster", {Parameter(TensorShape({batch}))});
+  }
+  EXPECT_THAT(FirstShapes(three.RecordAndPredict(
+                  "cluster", {Parameter(TensorShape({4}))})),
+              ElementsAre(TensorShape({8}), TensorShape({16})));
+}
+
+TEST(DeviceCompilationShapePredictorTest, IgnoresUnpredictableShapes) {
+  DeviceCompilationShapePredictor predictor;
+  for (int64_t batch : {3, 9, 4, 1}) {
+    EXPECT_THAT(predictor.RecordAndPredict(
+                    "cluster", {Parameter(TensorShape({batch}))}),
+                IsEmpty());
+  }
+}
+
+TEST(DeviceCompilationShapePredictorTest, ResetsHistoryOnRankChange) {
+  DeviceCompilationShapePredictor predictor;
+  predictor.RecordAndPredict("cluster", {Parameter(TensorShape({1}))});
+  predictor.RecordAndPredict("cluster", {Parameter(TensorShape({2}))});
+  EXPECT_THAT(predictor.RecordAndPredict("cluster",
+                                         {Parameter(TensorShape({3, 1}))}),
+              IsEmpty());
+}
+
+TEST(DeviceCompilationShapePredictorTest, TracksClustersSeparately) {
+  DeviceCompilationShapePredictor predictor;
+  predictor.RecordAndPredict("a", {Parameter(TensorShape({1}))});
+  predictor.RecordAndPredict("b", {Parameter(TensorShape({5}))});
+  predictor.RecordAndPredict("a", {Parameter(TensorShape({2}))});
+  EXPECT_THAT(FirstShapes(predictor.RecordAndPredict(
+                  "a", {Parameter(TensorShape({3}))})),
+              ElementsAre(TensorShape({4}), TensorShape({5})));
+}
+
+}  // namespace
+}  // namespace tensorflow
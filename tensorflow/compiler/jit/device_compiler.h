@@ -26,11 +26,13 @@ limitations under the License.
 
 #include "absl/base/call_once.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "tensorflow/compiler/jit/device_compilation_cache.h"
 #include "tensorflow/compiler/jit/device_compilation_cluster_signature.h"
 #include "tensorflow/compiler/jit/device_compilation_profiler.h"
+#include "tensorflow/compiler/jit/device_compilation_shape_predictor.h"
 #include "tensorflow/compiler/jit/device_compiler_client.h"
 #include "tensorflow/compiler/jit/device_executable_persistor.h"
 #include "tensorflow/compiler/jit/flags.h"
@@ -62,7 +64,10 @@ namespace tensorflow {
 // to disk.
 //
 // Since XLA computations must have static shapes, DeviceCompiler generates a
-// new XLA computation for each new set of input shapes.
+// new XLA computation for each new set of input shapes. With
+// --tf_xla_speculative_compilation, asynchronously compiled clusters also get
+// the input shapes they are predicted to receive next compiled in the
+// background (see DeviceCompilationShapePredictor).
 // TODO(b/255826209): De-templatize once we've moved to Device API completely.
 template <typename ExecutableType, typename ClientType>
 class DeviceCompiler : public ResourceBase {
@@ -160,6 +165,18 @@ class DeviceCompiler : public ResourceBase {
       const NameAttrList& function, CompileScope scope, OpKernelContext* ctx,
       DeviceCompilationProfiler* profiler);
 
+  // Records the shapes of `args` and compiles the signatures predicted to
+  // follow them in the background, unless they are already cached.
+  void CompileSpeculatively(
+      const DeviceCompilationClusterSignature& signature,
+      const XlaCompiler::CompileOptions& compile_options,
+      const XlaCompiler::Options& options,
+      const std::vector<XlaCompiler::Argument>& args,
+      const NameAttrList& function, DeviceCompilationProfiler* profiler);
+
+  // Returns the mutex serializing the compilation of `signature`.
+  mutex* GetClusterMutex(const DeviceCompilationClusterSignature& signature);
+
   std::unique_ptr<DeviceExecutablePersistor<ExecutableType, ClientType>>
       persistor_;
   std::unique_ptr<DeviceCompilerClient<ExecutableType, ClientType>>
@@ -169,6 +186,21 @@ class DeviceCompiler : public ResourceBase {
   // Pool of threads for asynchronous compilations.
   std::unique_ptr<thread::ThreadPool> async_compiler_threads_;
 
+  // Pool of threads for compilations of predicted signatures, kept separate so
+  // that they never delay the compilation of requested ones.
+  std::unique_ptr<thread::ThreadPool> speculative_compiler_threads_;
+
+  DeviceCompilationShapePredictor shape_predictor_;
+
+  mutex speculation_mu_;
+  // Predicted signatures that were compiled speculatively and haven't been
+  // requested yet.
+  absl::flat_hash_set<DeviceCompilationClusterSignature,
+                      DeviceCompilationClusterSignature::Hash>
+      speculative_signatures_ TF_GUARDED_BY(speculation_mu_);
+  int64_t num_ongoing_speculative_compilations_
+      TF_GUARDED_BY(speculation_mu_) = 0;
+
   mutex cluster_mutexes_mu_;
   absl::flat_hash_map<DeviceCompilationClusterSignature, std::unique_ptr<mutex>,
                       DeviceCompilationClusterSignature::Hash>
@@ -217,6 +249,10 @@ DeviceCompiler<ExecutableType, ClientType>::DeviceCompiler(
   async_compiler_threads_ = std::make_unique<tensorflow::thread::ThreadPool>(
       tensorflow::Env::Default(), "async_compiler_threads",
       kNumAsyncDeviceCompilerThreads);
+  speculative_compiler_threads_ =
+      std::make_unique<tensorflow::thread::ThreadPool>(
+          tensorflow::Env::Default(), "speculative_compiler_threads",
+          kNumSpeculativeDeviceCompilerThreads);
 }
 
 template <typename ExecutableType, typename ClientType>
@@ -230,6 +266,7 @@ DeviceCompiler<ExecutableType, ClientType>::~DeviceCompiler() {
   // is destructed, which is dependent on the order of the members in the
   // DeviceCompiler class, which is error prone if the order changes.
   async_compiler_threads_.reset();
+  speculative_compiler_threads_.reset();
   // TODO(b/110813685): Think about the program ownership model. Programs are
   // currently owned by the compilation cache which means we must wait for
   // program completion in the destructor. There are multiple compilation caches
@@ -395,6 +432,87 @@ absl::Status DeviceCompiler<ExecutableType, ClientType>::CompileAsynchronous(
   return absl::OkStatus();
 }
 
+template <typename ExecutableType, typename ClientType>
+void DeviceCompiler<ExecutableType, ClientType>::CompileSpeculatively(
+    const DeviceCompilationClusterSignature& signature,
+    const XlaCompiler::CompileOptions& compile_options,
+    const XlaCompiler::Options& options,
+    const std::vector<XlaCompiler::Argument>& args,
+    const NameAttrList& function, DeviceCompilationProfiler* profiler) {
+  std::vector<std::vector<XlaCompiler::Argument>> predictions =
+      shape_predictor_.RecordAndPredict(function.name(), args);
+  if (predictions.empty()) return;
+  // Don't sink more compile time into clusters whose shapes keep changing.
+  auto stats = profiler->GetCompileStats(function);
+  if (stats.ok() && stats->is_megamorphic) return;
+
+  for (std::vector<XlaCompiler::Argument>& predicted_args : predictions) {
+    auto predicted_signature =
+        DeviceCompilationClusterSignature::Build(function, predicted_args);
+    if (!predicted_signature.ok() || *predicted_signature == signature) {
+      continue;
+    }
+
+    mutex_lock cluster_compile_lock(*GetClusterMutex(*predicted_signature));
+    auto cache_value = cache_->Lookup(*predicted_signature);
+    if (cache_value.has_value() &&
+        cache_value->compile_state != DeviceCompileState::kUncompiled) {
+      continue;
+    }
+    {
+      mutex_lock lock(speculation_mu_);
+      if (num_ongoing_speculative_compilations_ >=
+          kNumSpeculativeDeviceCompilerThreads) {
+        return;
+      }
+      ++num_ongoing_speculative_compilations_;
+      speculative_signatures_.insert(*predicted_signature);
+    }
+    cache_->Store(*predicted_signature, DeviceCompileState::kCompiling,
+                  std::nullopt, std::nullopt, std::nullopt);
+    profiler->RegisterSpeculativeCompilation(function);
+    VLOG(2) << "Queueing speculative compilation for signature: "
+            << predicted_signature->HumanString();
+
+    // As for asynchronous compilations, the thread pool is destroyed before
+    // anything the lambda captures by pointer.
+    speculative_compiler_threads_->Schedule(
+        [=, speculative_signature = *std::move(predicted_signature),
+         speculative_args = std::move(predicted_args)] {
+          mutex mu;
+          mutex_lock lock(mu);
+          auto s = CompileStrict(
+              speculative_signature, compile_options, options,
+              speculative_args, function,
+              typename DeviceCompilationCache<ExecutableType>::Value(),
+              CompileScope::kFunction, /*ctx=*/nullptr, profiler, &mu);
+          mutex_lock speculation_lock(speculation_mu_);
+          --num_ongoing_speculative_compilations_;
+          if (!s.ok()) {
+            // The predicted shapes may not be valid for the cluster at all.
+            // Forget about them, so that an actual request for them is
+            // compiled (and fails) on its own.
+            VLOG(2) << "Speculative compilation of " << function.name()
+                    << " failed: " << s.status();
+            speculative_signatures_.erase(speculative_signature);
+            cache_->Store(speculative_signature,
+                          DeviceCompileState::kUncompiled,
+                          absl::OkStatus(), std::nullopt, std::nullopt);
+          }
+        });
+  }
+}
+
+template <typename ExecutableType, typename ClientType>
+mutex* DeviceCompiler<ExecutableType, ClientType>::GetClusterMutex(
+    const DeviceCompilationClusterSignature& signature) {
+  // The outer lock protects the existence of the mutex in the map.
+  mutex_lock lock(cluster_mutexes_mu_);
+  auto it =
+      cluster_mutexes_.emplace(signature, std::make_unique<mutex>()).first;
+  return it->second.get();
+}
+
 template <typename ExecutableType, typename ClientType>
 absl::Status DeviceCompiler<ExecutableType, ClientType>::CompileImpl(
     const XlaCompiler::CompileOptions& compile_options,
@@ -416,17 +534,19 @@ absl::Status DeviceCompiler<ExecutableType, ClientType>::CompileImpl(
   TF_ASSIGN_OR_RETURN(auto signature,
                       DeviceCompilationClusterSignature::Build(function, args));
 
-  // The outer lock protects the existence of the mutex in the map.
-  mutex* cluster_mutex;
-  {
-    mutex_lock lock(cluster_mutexes_mu_);
-    auto it =
-        cluster_mutexes_.emplace(signature, std::make_unique<mutex>()).first;
-    cluster_mutex = it->second.get();
-  }
+  mutex* cluster_mutex = GetClusterMutex(signature);
 
   profiler->RegisterExecution(function);
 
+  const bool speculate =
+      scope == CompileScope::kFunction &&
+      compile_mode == DeviceCompileMode::kAsync &&
+      GetXlaOpsCommonFlags()->tf_xla_speculative_compilation;
+  if (speculate) {
+    CompileSpeculatively(signature, compile_options, options, args, function,
+                         profiler);
+  }
+
   string human_signature;
   if (VLOG_IS_ON(2)) {
     human_signature = VLOG_IS_ON(3) ? signature.HumanString() : function.name();
@@ -449,6 +569,17 @@ absl::Status DeviceCompiler<ExecutableType, ClientType>::CompileImpl(
   *out_compilation_result = nullptr;
   *out_executable = nullptr;
 
+  if (speculate) {
+    bool predicted;
+    {
+      mutex_lock lock(speculation_mu_);
+      predicted = speculative_signatures_.erase(signature) > 0;
+    }
+    if (predicted || state == DeviceCompileState::kUncompiled) {
+      profiler->RegisterSpeculationOutcome(function, /*hit=*/predicted);
+    }
+  }
+
   // Check if the requested entry is uncompiled and return an error if
   // compilation is disabled. This will raise an error for kLazy even if we have
   // not yet hit the compilation threshold and no compilation happens this
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/device_compiler.h"
 
+#include <cstdint>
 #include <iostream>
 #include <memory>
 #include <optional>
@@ -24,11 +25,13 @@ limitations under the License.
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include "absl/cleanup/cleanup.h"
 #include "tensorflow/cc/framework/scope.h"
 #include "tensorflow/cc/ops/function_ops.h"
 #include "tensorflow/cc/ops/math_ops.h"
 #include "tensorflow/compiler/jit/device_compilation_cluster_signature.h"
 #include "tensorflow/compiler/jit/device_compiler_client.h"
+#include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/jit/tests/device_compiler_test_helper.h"
 #include "tensorflow/compiler/jit/xla_device_compiler_client.h"
 #include "xla/client/client_library.h"
@@ -318,6 +321,70 @@ TEST_F(DeviceCompilerTest, CompileAsyncSuccess) {
   EXPECT_TRUE(cache_value->compilation_status.ok());
 }
 
+TEST_F(DeviceCompilerTest, CompileSpeculativeSuccess) {
+  const XlaCompiler::CompilationResult* compilation_result = nullptr;
+  xla::LocalExecutable* xla_executable = nullptr;
+
+  XlaCompiler::Options options = GetDefaultXlaOptions();
+
+  NameAttrList fn;
+  fn.set_name("foo");
+
+  auto args_with_size = [](int64_t size) {
+    auto args = SampleArgsForAddXY();
+    args[0].shape = TensorShape({size});
+    args[1].shape = TensorShape({size});
+    return args;
+  };
+
+  // The three requested sizes and the two sizes predicted to follow them are
+  // compiled first. Requesting the first prediction may predict one more.
+  mutex mu;
+  int num_compilations = 0;
+  Notification predicted;
+  EXPECT_CALL(*mock_profiler_, ShouldCompileCluster(_, _, _))
+      .WillRepeatedly(Return(true));
+  EXPECT_CALL(*mock_profiler_, RegisterCompilation(_, _, false))
+      .Times(::testing::Between(5, 6))
+      .WillRepeatedly([&] {
+        mutex_lock lock(mu);
+        if (++num_compilations == 5) predicted.Notify();
+        return absl::OkStatus();
+      });
+
+  bool& speculative_compilation =
+      GetXlaOpsCommonFlags()->tf_xla_speculative_compilation;
+  absl::Cleanup restore_speculative_compilation =
+      [&speculative_compilation, previous = speculative_compilation] {
+        speculative_compilation = previous;
+      };
+  speculative_compilation = true;
+  for (int64_t size : {2, 3, 4}) {
+    TF_EXPECT_OK(xla_device_compiler_->CompileIfNeeded(
+        options, fn, args_with_size(size), XlaCompiler::CompileOptions{},
+        DeviceCompileMode::kAsync, mock_profiler_, &compilation_result,
+        &xla_executable));
+  }
+  predicted.WaitForNotification();
+
+  // The next size is compiled before it is requested.
+  TF_EXPECT_OK(xla_device_compiler_->CompileIfNeeded(
+      options, fn, args_with_size(5), XlaCompiler::CompileOptions{},
+      DeviceCompileMode::kAsync, mock_profiler_, &compilation_result,
+      &xla_executable));
+
+  EXPECT_TRUE(compilation_result != nullptr);
+  EXPECT_TRUE(xla_executable != nullptr);
+
+  // Wait for the remaining speculative compilation, if any.
+  xla_device_compiler_ref_.reset();
+
+  TF_ASSERT_OK_AND_ASSIGN(auto stats, mock_profiler_->GetCompileStats(fn));
+  EXPECT_GE(stats.speculative_compile_count, 2);
+  EXPECT_EQ(stats.speculation_hit_count, 1);
+  EXPECT_EQ(stats.speculation_miss_count, 3);
+}
+
 TEST_F(DeviceCompilerTest, CompilePersistentCacheEnabled) {
   auto xla_device_compiler =
       CreateXlaDeviceCompiler(/*enable_persistence=*/true);
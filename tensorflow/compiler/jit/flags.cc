@@ -263,6 +263,9 @@ void AllocateAndParseFlags() {
   ops_flags = new XlaOpsCommonFlags;
   ops_flags->tf_xla_always_defer_compilation = false;
   ops_flags->tf_xla_async_compilation = false;
+  ops_flags->tf_xla_speculative_compilation = false;
+  ops_flags->tf_xla_shape_bucketing = "";
+  ops_flags->tf_xla_donate_variable_buffers = true;
   ops_flags->tf_xla_use_device_api.enabled_for_xla_launch_ = true;
   ops_flags->tf_xla_use_device_api.enabled_for_compile_on_demand_ = true;
   ops_flags->tf_xla_use_device_api.enabled_for_compile_and_run_ = true;
@@ -334,6 +337,22 @@ void AllocateAndParseFlags() {
             "When lazy compilation is enabled, asynchronous compilation starts "
             "the cluster compilation in the background, and the fallback path "
             "is executed until the compilation has finished."),
+       Flag("tf_xla_speculative_compilation",
+            &ops_flags->tf_xla_speculative_compilation,
+            "When asynchronous compilation is enabled, predicts the next "
+            "input shapes of each cluster from simple patterns, such as a "
+            "growing sequence length or a periodic batch size, and compiles "
+            "them in the background ahead of time."),
+       Flag("tf_xla_shape_bucketing", &ops_flags->tf_xla_shape_bucketing,
+            "If set, pads the leading dimension of auto-clustered inputs up "
+            "to a bucket to reduce recompilations: \"pow2\" for powers of "
+            "two, or a comma separated list of increasing sizes. Clusters "
+            "whose ops may mix rows are compiled for their exact shapes."),
+       Flag("tf_xla_donate_variable_buffers",
+            &ops_flags->tf_xla_donate_variable_buffers,
+            "If true, auto-clustered computations update the resource "
+            "variables they hold the only reference to in place instead of "
+            "allocating new buffers for their values."),
        Flag("tf_xla_use_device_api_for_xla_launch",
             &ops_flags->tf_xla_use_device_api.enabled_for_xla_launch_,
             "If true, uses Device API (PjRt) for single device compilation and "
@@ -151,6 +151,20 @@ struct XlaOpsCommonFlags {
   // If true, _XlaCompile compiles the cluster asynchronously with respect to
   // the main execution. The fallback path is taken while compilation happens.
   bool tf_xla_async_compilation;
+  // If true (together with tf_xla_async_compilation), _XlaCompile predicts the
+  // upcoming input shapes of each cluster from the ones it has seen, and
+  // compiles them in the background before they are requested.
+  bool tf_xla_speculative_compilation;
+  // If not empty, _XlaCompile pads the leading dimension of the cluster inputs
+  // up to a bucket so that fewer executables are compiled: "pow2" to round up
+  // to powers of two, or a comma separated list of increasing sizes. See
+  // jit/shape_bucketing.h.
+  std::string tf_xla_shape_bucketing;
+  // If true, _XlaCompile compiles clusters so that updated resource variables
+  // may alias their new values, and _XlaRun donates the buffers of variables
+  // it holds the only reference to, so that they are updated in place.
+  // Defaults to true.
+  bool tf_xla_donate_variable_buffers;
 
   class PjRtForSingleDeviceCompilationRollout {
    public:
@@ -35,6 +35,7 @@ limitations under the License.
 #include "tensorflow/compiler/jit/encapsulate_subgraphs_pass.h"
 #include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/jit/pjrt_compile_util.h"
+#include "tensorflow/compiler/jit/shape_bucketing.h"
 #include "tensorflow/compiler/jit/variable_info.h"
 #include "tensorflow/compiler/jit/variable_info_util.h"
 #include "tensorflow/compiler/jit/xla_activity_listener.h"
@@ -99,18 +100,23 @@ auto* xla_launch_counter = monitoring::Counter<1>::New(
 // the initial values for the resource variables (and cannot snapshot them again
 // during execution) because otherwise we risk observing a different snapshot
 // with shapes different from what we compiled for.
+//
+// Likewise, the shape bucketing plan records how the inputs were padded for
+// the executable, so that XlaRun pads them the same way.
 template <typename ExecutableType, typename ClientType>
 class ExecutableClosure {
  public:
   explicit ExecutableClosure(
       ClientType* client, ExecutableType* executable,
       const XlaCompiler::CompilationResult* compilation_result,
-      ResourceVarsSnapshot resource_var_snapshots, int num_constant_args)
+      ResourceVarsSnapshot resource_var_snapshots, int num_constant_args,
+      ShapeBucketingPlan shape_bucketing_plan = {})
       : client_(client),
         executable_(executable),
         compilation_result_(compilation_result),
         resource_var_snapshots_(std::move(resource_var_snapshots)),
-        num_constant_args_(num_constant_args) {}
+        num_constant_args_(num_constant_args),
+        shape_bucketing_plan_(std::move(shape_bucketing_plan)) {}
 
   ExecutableClosure(ExecutableClosure&&) = default;
   ExecutableClosure& operator=(ExecutableClosure&&) = default;
@@ -123,7 +129,13 @@ class ExecutableClosure {
   const ResourceVarsSnapshot& resource_var_snapshots() const {
     return resource_var_snapshots_;
   }
+  ResourceVarsSnapshot* mutable_resource_var_snapshots() {
+    return &resource_var_snapshots_;
+  }
   int num_constant_args() const { return num_constant_args_; }
+  const ShapeBucketingPlan& shape_bucketing_plan() const {
+    return shape_bucketing_plan_;
+  }
 
  private:
   ClientType* client_;
@@ -131,6 +143,7 @@ class ExecutableClosure {
   const XlaCompiler::CompilationResult* compilation_result_;
   ResourceVarsSnapshot resource_var_snapshots_;
   int num_constant_args_;
+  ShapeBucketingPlan shape_bucketing_plan_;
 
   ExecutableClosure(const ExecutableClosure&) = delete;
   void operator=(const ExecutableClosure&) = delete;
@@ -192,6 +205,36 @@ se::Stream* GetStream(OpKernelContext* ctx) {
                                   : nullptr;
 }
 
+// Replaces the inputs of an XlaRun op that `plan` pads with padded copies,
+// which are owned by `padded_inputs`. XlaRun doesn't have the must-be-constant
+// inputs of XlaCompile, which are the first `num_constant_args`.
+absl::Status PadBucketedInputs(const ShapeBucketingPlan& plan,
+                               int num_constant_args, OpKernelContext* ctx,
+                               std::vector<const Tensor*>* inputs,
+                               std::vector<Tensor>* padded_inputs) {
+  padded_inputs->reserve(plan.padded_args.size());
+  for (int arg : plan.padded_args) {
+    const int input = arg - num_constant_args;
+    TF_ASSIGN_OR_RETURN(
+        Tensor padded,
+        PadLeadingDimension(ctx, *(*inputs)[input], plan.padded_batch_size));
+    padded_inputs->push_back(std::move(padded));
+    (*inputs)[input] = &padded_inputs->back();
+  }
+  return absl::OkStatus();
+}
+
+bool HasAliasedParameters(
+    const xla::HloInputOutputAliasConfig& input_output_alias) {
+  bool has_aliased_parameters = false;
+  input_output_alias.ForEachAlias(
+      [&](const xla::ShapeIndex&,
+          const xla::HloInputOutputAliasConfig::Alias&) {
+        has_aliased_parameters = true;
+      });
+  return has_aliased_parameters;
+}
+
 XlaComputationLaunchContext GetLaunchContext(
     const XlaPlatformInfo& platform_info, OpKernelContext* ctx,
     xla::LocalClient* client, se::DeviceMemoryAllocator* allocator) {
@@ -743,6 +786,7 @@ void XlaCompileOp::Compute(OpKernelContext* ctx) {
   xla::PjRtClient* pjrt_client = nullptr;
   xla::PjRtLoadedExecutable* pjrt_executable = nullptr;
   ResourceVarsSnapshot variables_snapshot;
+  ShapeBucketingPlan shape_bucketing_plan;
 
   std::vector<const Tensor*> inputs = InputsFromContext(ctx);
   bool cannot_compile_cluster;
@@ -771,24 +815,48 @@ void XlaCompileOp::Compute(OpKernelContext* ctx) {
     auto args_and_variables_snapshot = GetXlaCompilerArgsAndSnapshotVariables(
         resources_, constants_, inputs, ctx);
     OP_REQUIRES_OK(ctx, args_and_variables_snapshot.status());
-    const std::vector<XlaCompiler::Argument>& args =
+    std::vector<XlaCompiler::Argument>& args =
         args_and_variables_snapshot->first;
     variables_snapshot = std::move(args_and_variables_snapshot->second);
 
-    // Do not alias resource updates as locking variables in XlaCompile and
-    // unlocking them in XlaRun may lead to deadlocks.
-    absl::Status status;
-    if (use_pjrt) {
-      VLOG(2) << "Using PJRT for compilation. Function name: "
-              << function_.name();
-      status = CompileToPjRtLoadedExecutable(
-          *ctx, platform_info_, function_, args, compile_mode, has_ref_vars_,
-          /*may_alias_resource_update=*/false, &kernel, &pjrt_client,
-          &pjrt_executable);
-    } else {
-      status = CompileToLocalExecutable(
+    // XLA devices wrap their buffers in XlaTensors, which aren't padded.
+    const ShapeBuckets& shape_buckets = GetShapeBucketsFromFlags();
+    if (shape_buckets.enabled() && !platform_info_.is_on_xla_device()) {
+      if (ShapeBucketingAnalysis* analysis = GetShapeBucketingAnalysis(ctx)) {
+        shape_bucketing_plan = analysis->Plan(args, shape_buckets);
+        ApplyShapeBucketingPlan(shape_bucketing_plan, &args);
+      }
+    }
+
+    // Variables aren't locked from XlaCompile to XlaRun, as that may lead to
+    // deadlocks. XlaRun only donates the buffers of the updated variables that
+    // haven't been assigned since they were snapshotted here.
+    const bool may_alias_resource_update =
+        GetXlaOpsCommonFlags()->tf_xla_donate_variable_buffers;
+    auto compile = [&]() {
+      if (use_pjrt) {
+        VLOG(2) << "Using PJRT for compilation. Function name: "
+                << function_.name();
+        return CompileToPjRtLoadedExecutable(
+            *ctx, platform_info_, function_, args, compile_mode, has_ref_vars_,
+            may_alias_resource_update, &kernel, &pjrt_client,
+            &pjrt_executable);
+      }
+      return CompileToLocalExecutable(
           ctx, function_, has_ref_vars_, platform_info_, args, compile_mode,
-          /*may_alias_resource_update=*/false, &client, &kernel, &executable);
+          may_alias_resource_update, &client, &kernel, &executable);
+    };
+    absl::Status status = compile();
+    // The analysis only sees the ops of the cluster, not their shapes, so an
+    // op may still reject the padded shapes. The exact ones are always valid.
+    if (!status.ok() && !shape_bucketing_plan.empty()) {
+      LOG(WARNING) << "Compilation with inputs padded to a leading dimension "
+                   << "of " << shape_bucketing_plan.padded_batch_size
+                   << " failed: " << status
+                   << ". Compiling for the exact shapes instead.";
+      RevertShapeBucketingPlan(shape_bucketing_plan, &args);
+      shape_bucketing_plan = ShapeBucketingPlan();
+      status = compile();
     }
     if (compile_mode != DeviceCompileMode::kLazy ||
         status.code() != error::UNIMPLEMENTED) {
@@ -834,14 +902,14 @@ void XlaCompileOp::Compute(OpKernelContext* ctx) {
     PjRtExecutableClosureStore::KeyT key =
         PjRtExecutableClosureStore::Global()->Produce(PjRtExecutableClosure(
             pjrt_client, pjrt_executable, kernel, std::move(variables_snapshot),
-            constants_.size()));
+            constants_.size(), std::move(shape_bucketing_plan)));
     compilation_key.flat<tstring>()(0) = key;
     VLOG(2) << "Compiled with PJRT. compilation_key: " << key;
   } else {
     XlaExecutableClosureStore::KeyT key =
         XlaExecutableClosureStore::Global()->Produce(XlaExecutableClosure(
             client, executable, kernel, std::move(variables_snapshot),
-            constants_.size()));
+            constants_.size(), std::move(shape_bucketing_plan)));
     compilation_key.flat<tstring>()(0) = key;
     VLOG(2) << "Compiled with XLA. compilation_key: " << key;
   }
@@ -853,6 +921,21 @@ void XlaCompileOp::Compute(OpKernelContext* ctx) {
   ctx->set_output(1, compilation_successful);
 }
 
+ShapeBucketingAnalysis* XlaCompileOp::GetShapeBucketingAnalysis(
+    OpKernelContext* ctx) {
+  mutex_lock lock(shape_bucketing_mu_);
+  if (shape_bucketing_analysis_ == nullptr) {
+    const FunctionDef* fdef =
+        ctx->function_library() == nullptr
+            ? nullptr
+            : ctx->function_library()->GetFunctionLibraryDefinition()->Find(
+                  function_.name());
+    if (fdef == nullptr) return nullptr;
+    shape_bucketing_analysis_ = std::make_unique<ShapeBucketingAnalysis>(*fdef);
+  }
+  return shape_bucketing_analysis_.get();
+}
+
 XlaRunOp::XlaRunOp(OpKernelConstruction* ctx)
     : OpKernel(ctx), platform_info_(XlaPlatformInfoFromDevice(ctx->device())) {}
 
@@ -876,6 +959,19 @@ void XlaRunOp::Compute(OpKernelContext* ctx) {
     // last input. So the inputs look like: input tensors, resource variables,
     // closure key tensor.
     std::vector<const Tensor*> inputs = InputsFromContext(ctx);
+    const ShapeBucketingPlan& shape_bucketing_plan =
+        closure.shape_bucketing_plan();
+    std::vector<Tensor> padded_inputs;
+    if (!shape_bucketing_plan.empty()) {
+      OP_REQUIRES_OK(ctx, PadBucketedInputs(shape_bucketing_plan,
+                                            closure.num_constant_args(), ctx,
+                                            &inputs, &padded_inputs));
+      // PjRt may run the executable on another stream than the one padding
+      // the inputs.
+      if (se::Stream* stream = GetStream(ctx)) {
+        OP_REQUIRES_OK(ctx, stream->BlockHostUntilDone());
+      }
+    }
     absl::flat_hash_map<int, const Tensor*> variable_snapshots;
     for (const auto& [variable_index, variable_tensor] :
          closure.resource_var_snapshots()) {
@@ -890,6 +986,12 @@ void XlaRunOp::Compute(OpKernelContext* ctx) {
                              closure.num_constant_args());
       OP_REQUIRES_OK(ctx, updated_variables.status());
       OP_REQUIRES_OK(ctx, LockVariables(absl::MakeSpan(*updated_variables)));
+      for (const auto& [variable_index, variable_tensor] :
+           DonateUpdatedVariables(*updated_variables,
+                                  closure.num_constant_args(),
+                                  closure.mutable_resource_var_snapshots())) {
+        variable_snapshots[variable_index] = variable_tensor;
+      }
       OP_REQUIRES_OK(
           ctx, RunPjRtExecutable(closure.num_constant_args(), inputs,
                                  variable_snapshots, *updated_variables,
@@ -897,7 +999,7 @@ void XlaRunOp::Compute(OpKernelContext* ctx) {
                                  closure.client(), closure.executable(), ctx));
     }
 
-    OP_REQUIRES_OK(ctx, absl::OkStatus());
+    OP_REQUIRES_OK(ctx, SliceBucketedOutputs(shape_bucketing_plan, ctx));
     return;
   }
 
@@ -915,8 +1017,42 @@ void XlaRunOp::Compute(OpKernelContext* ctx) {
   // already been baked into the compiled kernel.
   const xla::HloInputOutputAliasConfig& input_output_alias =
       closure.executable()->executable()->module().input_output_alias_config();
+
+  // The updated variables are normally only locked to assign their new values.
+  // If the executable aliases them with its outputs, they are locked before
+  // the inputs are populated instead, so that their buffers can be donated.
+  // Clusters that communicate with the host are excluded: a host computation
+  // that blocks on one of the locked variables would deadlock.
+  const tf2xla::HostComputeMetadata& host_compute_metadata =
+      closure.compilation_result()->host_compute_metadata;
+  const bool donate_variables =
+      GetXlaOpsCommonFlags()->tf_xla_donate_variable_buffers &&
+      HasAliasedParameters(input_output_alias) &&
+      host_compute_metadata.device_to_host().empty() &&
+      host_compute_metadata.host_to_device().empty();
+  std::vector<VariableInfo> variable_infos;
+  auto lock_updated_variables = [&]() -> absl::Status {
+    TF_ASSIGN_OR_RETURN(variable_infos,
+                        GatherVariableInfo(ctx, *closure.compilation_result(),
+                                           closure.num_constant_args()));
+    return LockVariables(absl::MakeSpan(variable_infos));
+  };
+  if (donate_variables) {
+    OP_REQUIRES_OK(ctx, lock_updated_variables());
+  }
+
   absl::StatusOr<std::vector<xla::ExecutionInput>> execution_inputs;
   std::map<int, const Tensor*> snapshot_ptrs;
+  const ShapeBucketingPlan& shape_bucketing_plan =
+      closure.shape_bucketing_plan();
+  std::vector<const Tensor*> inputs;
+  std::vector<Tensor> padded_inputs;
+  if (!shape_bucketing_plan.empty()) {
+    inputs = InputsFromContext(ctx);
+    OP_REQUIRES_OK(ctx, PadBucketedInputs(shape_bucketing_plan,
+                                          closure.num_constant_args(), ctx,
+                                          &inputs, &padded_inputs));
+  }
   {
     tsl::profiler::TraceMe hlo_module_activity(
         [&] {
@@ -932,10 +1068,17 @@ void XlaRunOp::Compute(OpKernelContext* ctx) {
                                                 ? &variable_tensor.value()
                                                 : nullptr);
     }
+    if (donate_variables) {
+      for (const auto& [variable_index, variable_tensor] :
+           DonateUpdatedVariables(variable_infos, closure.num_constant_args(),
+                                  closure.mutable_resource_var_snapshots())) {
+        snapshot_ptrs[variable_index] = variable_tensor;
+      }
+    }
     execution_inputs = launch_context.PopulateInputs(
         ctx, closure.compilation_result(), snapshot_ptrs,
         /*missing_ctx_input_prefix=*/closure.num_constant_args(),
-        input_output_alias);
+        input_output_alias, inputs);
     OP_REQUIRES_OK(ctx, execution_inputs.status());
   }
 
@@ -960,16 +1103,16 @@ void XlaRunOp::Compute(OpKernelContext* ctx) {
       },
       tsl::profiler::TraceMeLevel::kInfo);
 
-  absl::StatusOr<std::vector<VariableInfo>> variable_infos = GatherVariableInfo(
-      ctx, *closure.compilation_result(), closure.num_constant_args());
-  OP_REQUIRES_OK(ctx, variable_infos.status());
-  OP_REQUIRES_OK(ctx, LockVariables(absl::MakeSpan(*variable_infos)));
+  if (!donate_variables) {
+    OP_REQUIRES_OK(ctx, lock_updated_variables());
+  }
   OP_REQUIRES_OK(
       ctx,
       launch_context.PopulateOutputs(
           ctx, closure.compilation_result(), execution_output->ConsumeResult(),
           /*missing_ctx_input_prefix=*/closure.num_constant_args(),
-          absl::MakeSpan(*variable_infos), input_output_alias, snapshot_ptrs));
+          absl::MakeSpan(variable_infos), input_output_alias, snapshot_ptrs));
+  OP_REQUIRES_OK(ctx, SliceBucketedOutputs(shape_bucketing_plan, ctx));
 }
 
 XlaMergeOp::XlaMergeOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
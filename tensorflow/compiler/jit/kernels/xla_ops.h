@@ -17,8 +17,10 @@ limitations under the License.
 #define TENSORFLOW_COMPILER_JIT_KERNELS_XLA_OPS_H_
 
 #include <atomic>
+#include <memory>
 
 #include "tensorflow/compiler/jit/device_compiler.h"
+#include "tensorflow/compiler/jit/shape_bucketing.h"
 #include "tensorflow/compiler/jit/xla_device.h"
 #include "tensorflow/compiler/jit/xla_launch_util.h"
 #include "tensorflow/compiler/jit/xla_platform_info.h"
@@ -116,6 +118,14 @@ class XlaCompileOp : public OpKernel {
       false;
 
   mutex cannot_compile_cluster_mu_;
+
+  // Returns the analysis of `function_` used to bucket its input shapes, or
+  // nullptr if the function can't be found.
+  ShapeBucketingAnalysis* GetShapeBucketingAnalysis(OpKernelContext* ctx);
+
+  std::unique_ptr<ShapeBucketingAnalysis> shape_bucketing_analysis_
+      TF_GUARDED_BY(shape_bucketing_mu_);
+  mutex shape_bucketing_mu_;
 };
 
 class XlaRunOp : public OpKernel {
@@ -0,0 +1,573 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/shape_bucketing.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "absl/types/variant.h"
+#include "tensorflow/compiler/jit/flags.h"
+#include "tensorflow/compiler/tf2xla/xla_argument.h"
+#include "xla/stream_executor/device_memory.h"
+#include "xla/stream_executor/stream.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace {
+
+// How an op may consume inputs that carry rows of the padded inputs, such that
+// the rows of its outputs only depend on the corresponding rows of those
+// inputs.
+enum class RowRule {
+  // Any input, e.g. elementwise ops. Operands that don't carry rows must be
+  // scalar constants, and those that do must have the same rank, so that
+  // broadcasting can't move the rows to another dimension.
+  kAnyInput,
+  // The only input, of rank 2 or more, e.g. a softmax along the last
+  // dimension, which is the rows for rank 1.
+  kLastDimension,
+  // Only the first input, e.g. the data but not the weights of a MatMul.
+  kFirstInput,
+  // Any input except the axes, which must be constants that exclude 0. The
+  // axes are the second input, or the last for kLastInputAxes, in which case
+  // all other inputs must carry rows and have the same rank.
+  kSecondInputAxes,
+  kLastInputAxes,
+  // A Transpose whose constant permutation keeps dimension 0 in place.
+  kTranspose,
+  // Only the indices of a gather along dimension 0.
+  kGatherIndices,
+};
+
+const absl::flat_hash_map<absl::string_view, RowRule>& RowRules() {
+  static const auto* const rules =
+      new absl::flat_hash_map<absl::string_view, RowRule>({
+          // Elementwise.
+          {"Abs", RowRule::kAnyInput},
+          {"Add", RowRule::kAnyInput},
+          {"AddV2", RowRule::kAnyInput},
+          {"Cast", RowRule::kAnyInput},
+          {"Ceil", RowRule::kAnyInput},
+          {"ClipByValue", RowRule::kAnyInput},
+          {"Div", RowRule::kAnyInput},
+          {"DivNoNan", RowRule::kAnyInput},
+          {"Elu", RowRule::kAnyInput},
+          {"Equal", RowRule::kAnyInput},
+          {"Erf", RowRule::kAnyInput},
+          {"Exp", RowRule::kAnyInput},
+          {"Floor", RowRule::kAnyInput},
+          {"Gelu", RowRule::kAnyInput},
+          {"Greater", RowRule::kAnyInput},
+          {"GreaterEqual", RowRule::kAnyInput},
+          {"Identity", RowRule::kAnyInput},
+          {"IdentityN", RowRule::kAnyInput},
+          {"LeakyRelu", RowRule::kAnyInput},
+          {"Less", RowRule::kAnyInput},
+          {"LessEqual", RowRule::kAnyInput},
+          {"Log", RowRule::kAnyInput},
+          {"Log1p", RowRule::kAnyInput},
+          {"LogicalAnd", RowRule::kAnyInput},
+          {"LogicalNot", RowRule::kAnyInput},
+          {"LogicalOr", RowRule::kAnyInput},
+          {"Maximum", RowRule::kAnyInput},
+          {"Minimum", RowRule::kAnyInput},
+          {"Mul", RowRule::kAnyInput},
+          {"Neg", RowRule::kAnyInput},
+          {"NotEqual", RowRule::kAnyInput},
+          {"OnesLike", RowRule::kAnyInput},
+          {"Pow", RowRule::kAnyInput},
+          {"RealDiv", RowRule::kAnyInput},
+          {"Reciprocal", RowRule::kAnyInput},
+          {"Relu", RowRule::kAnyInput},
+          {"Relu6", RowRule::kAnyInput},
+          {"Round", RowRule::kAnyInput},
+          {"Rsqrt", RowRule::kAnyInput},
+          {"Select", RowRule::kAnyInput},
+          {"SelectV2", RowRule::kAnyInput},
+          {"Selu", RowRule::kAnyInput},
+          {"Sigmoid", RowRule::kAnyInput},
+          {"Sign", RowRule::kAnyInput},
+          {"Snapshot", RowRule::kAnyInput},
+          {"Softplus", RowRule::kAnyInput},
+          {"Sqrt", RowRule::kAnyInput},
+          {"Square", RowRule::kAnyInput},
+          {"SquaredDifference", RowRule::kAnyInput},
+          {"StopGradient", RowRule::kAnyInput},
+          {"Sub", RowRule::kAnyInput},
+          {"Tanh", RowRule::kAnyInput},
+          {"ZerosLike", RowRule::kAnyInput},
+          // Along the last dimension.
+          {"LogSoftmax", RowRule::kLastDimension},
+          {"Softmax", RowRule::kLastDimension},
+          // Per example.
+          {"AvgPool", RowRule::kFirstInput},
+          {"BiasAdd", RowRule::kFirstInput},
+          {"Conv2D", RowRule::kFirstInput},
+          {"Conv3D", RowRule::kFirstInput},
+          {"DepthwiseConv2dNative", RowRule::kFirstInput},
+          {"MatMul", RowRule::kFirstInput},
+          {"MaxPool", RowRule::kFirstInput},
+          // Reductions and concatenations along other dimensions.
+          {"All", RowRule::kSecondInputAxes},
+          {"Any", RowRule::kSecondInputAxes},
+          {"ArgMax", RowRule::kSecondInputAxes},
+          {"ArgMin", RowRule::kSecondInputAxes},
+          {"Max", RowRule::kSecondInputAxes},
+          {"Mean", RowRule::kSecondInputAxes},
+          {"Min", RowRule::kSecondInputAxes},
+          {"Prod", RowRule::kSecondInputAxes},
+          {"Sum", RowRule::kSecondInputAxes},
+          {"ConcatV2", RowRule::kLastInputAxes},
+          {"Transpose", RowRule::kTranspose},
+          // Embedding lookups.
+          {"GatherV2", RowRule::kGatherIndices},
+          {"ResourceGather", RowRule::kGatherIndices},
+      });
+  return *rules;
+}
+
+// Returns the name of the node or argument an input of a FunctionDef node
+// refers to, e.g. "x" for "x:output:0".
+absl::string_view InputSource(absl::string_view input) {
+  return input.substr(0, input.find(':'));
+}
+
+bool IsControlInput(absl::string_view input) {
+  return !input.empty() && input[0] == '^';
+}
+
+// Returns the values of the integer Const node `name`, or nullopt.
+std::optional<std::vector<int64_t>> ConstantValues(
+    const absl::flat_hash_map<absl::string_view, const NodeDef*>& nodes,
+    absl::string_view name) {
+  auto it = nodes.find(name);
+  if (it == nodes.end() || it->second->op() != "Const") return std::nullopt;
+  auto value = it->second->attr().find("value");
+  if (value == it->second->attr().end()) return std::nullopt;
+  Tensor tensor;
+  if (!tensor.FromProto(value->second.tensor())) return std::nullopt;
+  std::vector<int64_t> values;
+  if (tensor.dtype() == DT_INT32) {
+    for (int64_t i = 0; i < tensor.NumElements(); ++i) {
+      values.push_back(tensor.flat<int32_t>()(i));
+    }
+  } else if (tensor.dtype() == DT_INT64) {
+    for (int64_t i = 0; i < tensor.NumElements(); ++i) {
+      values.push_back(tensor.flat<int64_t>()(i));
+    }
+  } else {
+    return std::nullopt;
+  }
+  return values;
+}
+
+// Returns true if `name` is a Const node holding a scalar.
+bool IsScalarConstant(
+    const absl::flat_hash_map<absl::string_view, const NodeDef*>& nodes,
+    absl::string_view name) {
+  auto it = nodes.find(name);
+  if (it == nodes.end() || it->second->op() != "Const") return false;
+  auto value = it->second->attr().find("value");
+  if (value == it->second->attr().end()) return false;
+  const TensorShapeProto& shape = value->second.tensor().tensor_shape();
+  return !shape.unknown_rank() && shape.dim_size() == 0;
+}
+
+bool BoolAttr(const NodeDef& node, absl::string_view name) {
+  auto it = node.attr().find(std::string(name));
+  return it != node.attr().end() && it->second.b();
+}
+
+int64_t IntAttr(const NodeDef& node, absl::string_view name) {
+  auto it = node.attr().find(std::string(name));
+  return it == node.attr().end() ? 0 : it->second.i();
+}
+
+// The rank of a carrier that isn't known.
+constexpr int kUnknownRank = -1;
+
+// Returns true if `node` keeps the rows of its outputs independent when the
+// data inputs at `carried` (in order) carry rows of the padded inputs, and sets
+// `output_rank` to the rank of its outputs. `carriers` maps the nodes and
+// arguments that carry rows to their rank.
+bool PreservesRows(
+    const NodeDef& node, const std::vector<int>& carried,
+    const std::vector<absl::string_view>& data_inputs,
+    const absl::flat_hash_map<absl::string_view, int>& carriers,
+    const absl::flat_hash_map<absl::string_view, const NodeDef*>& nodes,
+    int* output_rank) {
+  *output_rank = kUnknownRank;
+  auto rule = RowRules().find(node.op());
+  if (rule == RowRules().end()) return false;
+  auto only_inputs_before = [&](int input) {
+    return carried.back() < input;
+  };
+  auto rank = [&](int input) {
+    auto it = carriers.find(InputSource(data_inputs[input]));
+    return it == carriers.end() ? kUnknownRank : it->second;
+  };
+  // Returns the rank shared by all carried inputs, or kUnknownRank.
+  auto common_rank = [&]() {
+    const int first_rank = rank(carried.front());
+    for (int input : carried) {
+      if (rank(input) != first_rank) return kUnknownRank;
+    }
+    return first_rank;
+  };
+  auto axes = [&](int input) -> std::optional<std::vector<int64_t>> {
+    if (input < 0 || input >= static_cast<int>(data_inputs.size())) {
+      return std::nullopt;
+    }
+    std::optional<std::vector<int64_t>> axes =
+        ConstantValues(nodes, InputSource(data_inputs[input]));
+    // Negative axes may refer to dimension 0 of a tensor of rank 1.
+    if (!axes.has_value() ||
+        !absl::c_all_of(*axes, [](int64_t axis) { return axis > 0; })) {
+      return std::nullopt;
+    }
+    return axes;
+  };
+  switch (rule->second) {
+    case RowRule::kAnyInput: {
+      if (data_inputs.size() == 1) {
+        *output_rank = rank(0);
+        return true;
+      }
+      // Each output of IdentityN is one of its inputs, so all of them must
+      // carry rows for the outputs to be sliced.
+      if (node.op() == "IdentityN") {
+        if (carried.size() != data_inputs.size()) return false;
+        *output_rank = common_rank();
+        return true;
+      }
+      const int carried_rank = common_rank();
+      if (carried_rank == kUnknownRank) return false;
+      for (int input = 0; input < static_cast<int>(data_inputs.size());
+           ++input) {
+        if (!absl::c_linear_search(carried, input) &&
+            !IsScalarConstant(nodes, InputSource(data_inputs[input]))) {
+          return false;
+        }
+      }
+      *output_rank = carried_rank;
+      return true;
+    }
+    case RowRule::kLastDimension:
+      if (!only_inputs_before(1) || rank(0) < 2) return false;
+      *output_rank = rank(0);
+      return true;
+    case RowRule::kFirstInput:
+      if (node.op() == "MatMul" && BoolAttr(node, "transpose_a")) {
+        return false;
+      }
+      *output_rank = node.op() == "MatMul" ? 2 : rank(0);
+      return only_inputs_before(1);
+    case RowRule::kSecondInputAxes: {
+      std::optional<std::vector<int64_t>> reduced = axes(1);
+      if (!only_inputs_before(1) || !reduced.has_value()) return false;
+      const int input_rank = rank(0);
+      if (input_rank == kUnknownRank) return true;
+      if (node.op() == "ArgMax" || node.op() == "ArgMin") {
+        *output_rank = input_rank - 1;
+      } else if (BoolAttr(node, "keep_dims")) {
+        *output_rank = input_rank;
+      } else {
+        absl::flat_hash_set<int64_t> unique_axes(reduced->begin(),
+                                                 reduced->end());
+        *output_rank = input_rank - static_cast<int>(unique_axes.size());
+      }
+      return true;
+    }
+    case RowRule::kLastInputAxes: {
+      // Inputs that don't carry rows would have a different leading
+      // dimension than the padded ones.
+      const int axis_input = static_cast<int>(data_inputs.size()) - 1;
+      if (static_cast<int>(carried.size()) != axis_input ||
+          !only_inputs_before(axis_input) || !axes(axis_input).has_value()) {
+        return false;
+      }
+      *output_rank = common_rank();
+      return *output_rank != kUnknownRank;
+    }
+    case RowRule::kTranspose: {
+      if (!only_inputs_before(1) || data_inputs.size() < 2) return false;
+      std::optional<std::vector<int64_t>> perm =
+          ConstantValues(nodes, InputSource(data_inputs[1]));
+      *output_rank = rank(0);
+      return perm.has_value() && !perm->empty() && (*perm)[0] == 0;
+    }
+    case RowRule::kGatherIndices: {
+      // The rank of the output also depends on the params, which don't carry
+      // rows, so it is left unknown.
+      if (carried != std::vector<int>{1} || IntAttr(node, "batch_dims") != 0) {
+        return false;
+      }
+      if (node.op() == "ResourceGather") return true;
+      std::optional<std::vector<int64_t>> axis =
+          data_inputs.size() > 2
+              ? ConstantValues(nodes, InputSource(data_inputs[2]))
+              : std::nullopt;
+      return axis.has_value() && axis->size() == 1 && (*axis)[0] == 0;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+absl::StatusOr<ShapeBuckets> ShapeBuckets::Parse(absl::string_view spec) {
+  ShapeBuckets buckets;
+  if (spec.empty()) return buckets;
+  if (spec == "pow2") {
+    buckets.powers_of_two_ = true;
+    return buckets;
+  }
+  for (absl::string_view size_str : absl::StrSplit(spec, ',')) {
+    int64_t size;
+    if (!absl::SimpleAtoi(size_str, &size) || size <= 0 ||
+        (!buckets.sizes_.empty() && size <= buckets.sizes_.back())) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Invalid shape buckets \"", spec,
+          "\": expected \"pow2\" or increasing positive integers separated by "
+          "commas."));
+    }
+    buckets.sizes_.push_back(size);
+  }
+  return buckets;
+}
+
+int64_t ShapeBuckets::Bucket(int64_t size) const {
+  if (size <= 0) return size;
+  if (powers_of_two_) {
+    int64_t bucket = 1;
+    while (bucket < size) bucket <<= 1;
+    return bucket;
+  }
+  auto it = absl::c_lower_bound(sizes_, size);
+  return it == sizes_.end() ? size : *it;
+}
+
+const ShapeBuckets& GetShapeBucketsFromFlags() {
+  static const ShapeBuckets* const buckets = [] {
+    absl::StatusOr<ShapeBuckets> parsed =
+        ShapeBuckets::Parse(GetXlaOpsCommonFlags()->tf_xla_shape_bucketing);
+    if (!parsed.ok()) {
+      LOG(ERROR) << parsed.status() << " Shape bucketing is disabled.";
+      return new ShapeBuckets();
+    }
+    return new ShapeBuckets(*std::move(parsed));
+  }();
+  return *buckets;
+}
+
+ShapeBucketingPlan ShapeBucketingAnalysis::Plan(
+    absl::Span<const XlaArgument> args, const ShapeBuckets& buckets) {
+  ShapeBucketingPlan plan;
+  for (int i = 0; i < args.size(); ++i) {
+    const XlaArgument& arg = args[i];
+    if (arg.kind != XlaArgument::kParameter ||
+        !absl::holds_alternative<TensorShape>(arg.shape) ||
+        !DataTypeCanUseMemcpy(arg.type)) {
+      continue;
+    }
+    const TensorShape& shape = absl::get<TensorShape>(arg.shape);
+    if (shape.dims() == 0) continue;
+    if (plan.batch_size == 0) plan.batch_size = shape.dim_size(0);
+    if (shape.dim_size(0) == plan.batch_size) plan.padded_args.push_back(i);
+  }
+  plan.padded_batch_size = buckets.Bucket(plan.batch_size);
+  if (plan.padded_batch_size == plan.batch_size) return ShapeBucketingPlan();
+
+  std::vector<int> arg_ranks;
+  arg_ranks.reserve(args.size());
+  for (const XlaArgument& arg : args) {
+    arg_ranks.push_back(absl::holds_alternative<TensorShape>(arg.shape)
+                            ? absl::get<TensorShape>(arg.shape).dims()
+                            : kUnknownRank);
+  }
+  std::optional<std::vector<int>> sliced_outputs;
+  {
+    mutex_lock lock(mu_);
+    auto key = std::make_pair(plan.padded_args, std::move(arg_ranks));
+    auto it = cache_.find(key);
+    if (it == cache_.end()) {
+      std::optional<std::vector<int>> analysis =
+          AnalyzeRows(key.first, key.second);
+      it = cache_.emplace(std::move(key), std::move(analysis)).first;
+    }
+    sliced_outputs = it->second;
+  }
+  if (!sliced_outputs.has_value()) return ShapeBucketingPlan();
+  plan.sliced_outputs = *std::move(sliced_outputs);
+  return plan;
+}
+
+std::optional<std::vector<int>> ShapeBucketingAnalysis::AnalyzeRows(
+    const std::vector<int>& padded_args,
+    const std::vector<int>& arg_ranks) const {
+  // Nodes and arguments that carry rows of the padded arguments, and their
+  // rank.
+  absl::flat_hash_map<absl::string_view, int> carriers;
+  for (int arg : padded_args) {
+    if (arg < function_.signature().input_arg_size()) {
+      carriers.emplace(
+          function_.signature().input_arg(arg).name(),
+          arg < static_cast<int>(arg_ranks.size()) ? arg_ranks[arg]
+                                                   : kUnknownRank);
+    }
+  }
+  absl::flat_hash_map<absl::string_view, const NodeDef*> nodes;
+  for (const NodeDef& node : function_.node_def()) {
+    nodes[node.name()] = &node;
+  }
+
+  // Nodes aren't necessarily in topological order, so propagate until
+  // nothing changes.
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (const NodeDef& node : function_.node_def()) {
+      if (carriers.contains(node.name())) continue;
+      std::vector<absl::string_view> data_inputs;
+      std::vector<int> carried;
+      for (const std::string& input : node.input()) {
+        if (IsControlInput(input)) continue;
+        if (carriers.contains(InputSource(input))) {
+          carried.push_back(data_inputs.size());
+        }
+        data_inputs.push_back(input);
+      }
+      if (carried.empty()) continue;
+      int rank;
+      if (!PreservesRows(node, carried, data_inputs, carriers, nodes, &rank)) {
+        VLOG(2) << "Not bucketing " << function_.signature().name()
+                << ": rows may be mixed by " << node.name() << " ("
+                << node.op() << ")";
+        return std::nullopt;
+      }
+      carriers.emplace(node.name(), rank);
+      changed = true;
+    }
+  }
+
+  std::vector<int> outputs;
+  for (int i = 0; i < function_.signature().output_arg_size(); ++i) {
+    auto ret = function_.ret().find(function_.signature().output_arg(i).name());
+    if (ret != function_.ret().end() &&
+        carriers.contains(InputSource(ret->second))) {
+      outputs.push_back(i);
+    }
+  }
+  return outputs;
+}
+
+void ApplyShapeBucketingPlan(const ShapeBucketingPlan& plan,
+                             std::vector<XlaArgument>* args) {
+  for (int arg : plan.padded_args) {
+    absl::get<TensorShape>((*args)[arg].shape)
+        .set_dim(0, plan.padded_batch_size);
+  }
+}
+
+void RevertShapeBucketingPlan(const ShapeBucketingPlan& plan,
+                              std::vector<XlaArgument>* args) {
+  for (int arg : plan.padded_args) {
+    absl::get<TensorShape>((*args)[arg].shape).set_dim(0, plan.batch_size);
+  }
+}
+
+absl::StatusOr<Tensor> PadLeadingDimension(OpKernelContext* ctx,
+                                           const Tensor& input,
+                                           int64_t padded_size) {
+  if (input.dims() == 0 || input.dim_size(0) > padded_size ||
+      !DataTypeCanUseMemcpy(input.dtype())) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Cannot pad a ", DataTypeString(input.dtype()),
+                     " tensor of shape ", input.shape().DebugString(),
+                     " to a leading dimension of ", padded_size));
+  }
+  TensorShape padded_shape = input.shape();
+  padded_shape.set_dim(0, padded_size);
+  Tensor padded;
+  TF_RETURN_IF_ERROR(ctx->allocate_temp(input.dtype(), padded_shape, &padded));
+
+  // The rows are contiguous, so the input is a prefix of the padded tensor.
+  const size_t input_bytes = input.TotalBytes();
+  const size_t padding_bytes = padded.TotalBytes() - input_bytes;
+  char* padded_data = static_cast<char*>(padded.data());
+  se::Stream* stream =
+      ctx->op_device_context() ? ctx->op_device_context()->stream() : nullptr;
+  if (stream == nullptr) {
+    std::memcpy(padded_data, input.data(), input_bytes);
+    std::memset(padded_data + input_bytes, 0, padding_bytes);
+    return padded;
+  }
+  se::DeviceMemoryBase src(const_cast<void*>(input.data()), input_bytes);
+  se::DeviceMemoryBase dst(padded_data, input_bytes);
+  se::DeviceMemoryBase padding(padded_data + input_bytes, padding_bytes);
+  if (input_bytes > 0) {
+    TF_RETURN_IF_ERROR(stream->MemcpyD2D(&dst, src, input_bytes));
+  }
+  if (padding_bytes > 0) {
+    TF_RETURN_IF_ERROR(stream->MemZero(&padding, padding_bytes));
+  }
+  return padded;
+}
+
+absl::Status SliceBucketedOutputs(const ShapeBucketingPlan& plan,
+                                  OpKernelContext* ctx) {
+  for (int output : plan.sliced_outputs) {
+    Tensor* tensor = ctx->mutable_output(output);
+    if (tensor == nullptr) continue;
+    if (tensor->dims() == 0 ||
+        tensor->dim_size(0) != plan.padded_batch_size) {
+      return absl::InternalError(absl::StrCat(
+          "Expected output ", output, " to have a leading dimension of ",
+          plan.padded_batch_size, ", got shape ",
+          tensor->shape().DebugString()));
+    }
+    *tensor = tensor->Slice(0, plan.batch_size);
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace tensorflow
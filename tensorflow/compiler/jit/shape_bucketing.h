@@ -0,0 +1,135 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_JIT_SHAPE_BUCKETING_H_
+#define TENSORFLOW_COMPILER_JIT_SHAPE_BUCKETING_H_
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tensorflow/compiler/tf2xla/xla_argument.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+// Shape bucketing lets auto-clustered computations whose inputs vary in their
+// leading (batch) dimension share executables: the leading dimension of the
+// inputs is padded with zeros up to the next bucket before compilation and
+// execution, and the padding is sliced off the outputs. A stream of batch
+// sizes 1..100 then compiles e.g. 8 executables instead of 100.
+//
+// Padding is only correct if the rows of every output only depend on the
+// corresponding rows of the inputs, so clusters are bucketed only when every
+// op on the path from the padded inputs preserves this (see
+// ShapeBucketingAnalysis). Other clusters are compiled for their exact shapes.
+
+// The sizes the leading dimension of cluster inputs is rounded up to.
+class ShapeBuckets {
+ public:
+  // Parses --tf_xla_shape_bucketing: empty to disable bucketing, "pow2" to
+  // round up to powers of two, or a comma separated list of increasing sizes.
+  // Sizes larger than the largest one in the list aren't rounded up.
+  static absl::StatusOr<ShapeBuckets> Parse(absl::string_view spec);
+
+  bool enabled() const { return powers_of_two_ || !sizes_.empty(); }
+
+  // Returns the smallest bucket that is at least `size`, or `size` if there is
+  // none.
+  int64_t Bucket(int64_t size) const;
+
+ private:
+  bool powers_of_two_ = false;
+  std::vector<int64_t> sizes_;
+};
+
+// Returns the buckets specified by --tf_xla_shape_bucketing. Logs an error and
+// disables bucketing if the flag is invalid.
+const ShapeBuckets& GetShapeBucketsFromFlags();
+
+// How the inputs and outputs of a cluster are padded for one execution.
+struct ShapeBucketingPlan {
+  // The leading dimension of the inputs, and what it is padded to.
+  int64_t batch_size = 0;
+  int64_t padded_batch_size = 0;
+  // Cluster arguments whose leading dimension is padded.
+  std::vector<int> padded_args;
+  // Cluster outputs whose leading dimension is sliced back to `batch_size`.
+  std::vector<int> sliced_outputs;
+
+  bool empty() const { return padded_args.empty(); }
+};
+
+// Finds which outputs of a cluster function carry the rows of the inputs that
+// are padded, and whether padding them is safe. Results are cached by set of
+// padded inputs and the ranks of the inputs.
+class ShapeBucketingAnalysis {
+ public:
+  explicit ShapeBucketingAnalysis(FunctionDef function)
+      : function_(std::move(function)) {}
+
+  // Returns a plan to pad the leading dimension of the parameters among
+  // `args` that share the leading dimension of the first one, or an empty plan
+  // if it is already a bucket or padding isn't safe.
+  ShapeBucketingPlan Plan(absl::Span<const XlaArgument> args,
+                          const ShapeBuckets& buckets);
+
+ private:
+  // Returns the outputs that carry the rows of `padded_args`, or nullopt if
+  // some op may mix rows. `arg_ranks` are the ranks of all arguments, or -1
+  // where unknown.
+  std::optional<std::vector<int>> AnalyzeRows(
+      const std::vector<int>& padded_args,
+      const std::vector<int>& arg_ranks) const;
+
+  const FunctionDef function_;
+  mutex mu_;
+  // By padded arguments and argument ranks.
+  absl::flat_hash_map<std::pair<std::vector<int>, std::vector<int>>,
+                      std::optional<std::vector<int>>>
+      cache_ TF_GUARDED_BY(mu_);
+};
+
+// Sets the leading dimension of the padded arguments to the padded size.
+void ApplyShapeBucketingPlan(const ShapeBucketingPlan& plan,
+                             std::vector<XlaArgument>* args);
+
+// Undoes ApplyShapeBucketingPlan.
+void RevertShapeBucketingPlan(const ShapeBucketingPlan& plan,
+                              std::vector<XlaArgument>* args);
+
+// Returns a copy of `input` on the device of `ctx` whose leading dimension is
+// padded with zeros to `padded_size`.
+absl::StatusOr<Tensor> PadLeadingDimension(OpKernelContext* ctx,
+                                           const Tensor& input,
+                                           int64_t padded_size);
+
+// Slices the padding off the outputs of `ctx` listed in `plan`, without
+// copying them.
+absl::Status SliceBucketedOutputs(const ShapeBucketingPlan& plan,
+                                  OpKernelContext* ctx);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_JIT_SHAPE_BUCKETING_H_
@@ -0,0 +1,267 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/shape_bucketing.h"
+
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tensorflow/compiler/tf2xla/xla_argument.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.pb.h"
+
+namespace tensorflow {
+namespace {
+
+using ::testing::ElementsAre;
+using FDH = FunctionDefHelper;
+
+XlaArgument Parameter(const TensorShape& shape) {
+  XlaArgument arg;
+  arg.kind = XlaArgument::kParameter;
+  arg.type = DT_FLOAT;
+  arg.shape = shape;
+  return arg;
+}
+
+ShapeBuckets PowersOfTwo() { return *ShapeBuckets::Parse("pow2"); }
+
+TEST(ShapeBucketsTest, Parse) {
+  EXPECT_FALSE(ShapeBuckets::Parse("")->enabled());
+  EXPECT_TRUE(ShapeBuckets::Parse("pow2")->enabled());
+  EXPECT_TRUE(ShapeBuckets::Parse("8,32,128")->enabled());
+
+  EXPECT_EQ(ShapeBuckets::Parse("32,8").status().code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(ShapeBuckets::Parse("0,8").status().code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(ShapeBuckets::Parse("pow3").status().code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+TEST(ShapeBucketsTest, Bucket) {
+  ShapeBuckets pow2 = PowersOfTwo();
+  EXPECT_EQ(pow2.Bucket(1), 1);
+  EXPECT_EQ(pow2.Bucket(5), 8);
+  EXPECT_EQ(pow2.Bucket(64), 64);
+  EXPECT_EQ(pow2.Bucket(65), 128);
+
+  ShapeBuckets sizes = *ShapeBuckets::Parse("8,32,128");
+  EXPECT_EQ(sizes.Bucket(1), 8);
+  EXPECT_EQ(sizes.Bucket(32), 32);
+  EXPECT_EQ(sizes.Bucket(33), 128);
+  EXPECT_EQ(sizes.Bucket(200), 200);
+}
+
+// relu(x * w), with the rows of `x` along the batch.
+FunctionDef DenseLayer() {
+  return FDH::Create(
+      "DenseLayer", {"x: float", "w: float"}, {"y: float", "w_out: float"},
+      {},
+      {{{"matmul"}, "MatMul", {"x", "w"}, {{"T", DT_FLOAT}}},
+       {{"relu"}, "Relu", {"matmul:product:0"}, {{"T", DT_FLOAT}}}},
+      {{"y", "relu:activations:0"}, {"w_out", "w"}});
+}
+
+TEST(ShapeBucketingAnalysisTest, PadsRowwiseCluster) {
+  ShapeBucketingAnalysis analysis(DenseLayer());
+  std::vector<XlaArgument> args = {Parameter(TensorShape({5, 4})),
+                                   Parameter(TensorShape({4, 3}))};
+
+  ShapeBucketingPlan plan = analysis.Plan(args, PowersOfTwo());
+  EXPECT_EQ(plan.batch_size, 5);
+  EXPECT_EQ(plan.padded_batch_size, 8);
+  EXPECT_THAT(plan.padded_args, ElementsAre(0));
+  // The weights are passed through unpadded.
+  EXPECT_THAT(plan.sliced_outputs, ElementsAre(0));
+
+  ApplyShapeBucketingPlan(plan, &args);
+  EXPECT_EQ(absl::get<TensorShape>(args[0].shape), TensorShape({8, 4}));
+  EXPECT_EQ(absl::get<TensorShape>(args[1].shape), TensorShape({4, 3}));
+}
+
+TEST(ShapeBucketingAnalysisTest, DoesNotPadBuckets) {
+  ShapeBucketingAnalysis analysis(DenseLayer());
+  std::vector<XlaArgument> args = {Parameter(TensorShape({8, 4})),
+                                   Parameter(TensorShape({4, 3}))};
+  EXPECT_TRUE(analysis.Plan(args, PowersOfTwo()).empty());
+}
+
+FunctionDef ReduceAlong(int axis) {
+  return FDH::Create("Reduce", {"x: float"}, {"y: float"}, {},
+                     {FDH::Const<int32_t>("axis", axis),
+                      {{"sum"},
+                       "Sum",
+                       {"x", "axis:output:0"},
+                       {{"T", DT_FLOAT}, {"Tidx", DT_INT32}}}},
+                     {{"y", "sum:output:0"}});
+}
+
+TEST(ShapeBucketingAnalysisTest, PadsReductionAlongOtherDimensions) {
+  ShapeBucketingAnalysis analysis(ReduceAlong(1));
+  ShapeBucketingPlan plan =
+      analysis.Plan({Parameter(TensorShape({3, 4}))}, PowersOfTwo());
+  EXPECT_EQ(plan.padded_batch_size, 4);
+  EXPECT_THAT(plan.sliced_outputs, ElementsAre(0));
+}
+
+TEST(ShapeBucketingAnalysisTest, DoesNotPadReductionAlongRows) {
+  ShapeBucketingAnalysis analysis(ReduceAlong(0));
+  EXPECT_TRUE(
+      analysis.Plan({Parameter(TensorShape({3, 4}))}, PowersOfTwo()).empty());
+}
+
+// x op y, elementwise.
+FunctionDef Binary(absl::string_view op) {
+  return FDH::Create(
+      "Binary", {"x: float", "y: float"}, {"z: float"}, {},
+      {{{"z"}, std::string(op), {"x", "y"}, {{"T", DT_FLOAT}}}},
+      {{"z", "z:z:0"}});
+}
+
+TEST(ShapeBucketingAnalysisTest, PadsElementwiseOpsOfPaddedInputs) {
+  ShapeBucketingAnalysis analysis(Binary("AddV2"));
+  ShapeBucketingPlan plan = analysis.Plan(
+      {Parameter(TensorShape({3, 4})), Parameter(TensorShape({3, 4}))},
+      PowersOfTwo());
+  EXPECT_THAT(plan.padded_args, ElementsAre(0, 1));
+  EXPECT_THAT(plan.sliced_outputs, ElementsAre(0));
+}
+
+TEST(ShapeBucketingAnalysisTest, DoesNotPadElementwiseOpsOfUnpaddedInputs) {
+  // `y` is broadcast along the rows, so it isn't padded.
+  ShapeBucketingAnalysis analysis(Binary("AddV2"));
+  EXPECT_TRUE(analysis
+                  .Plan({Parameter(TensorShape({3, 4})),
+                         Parameter(TensorShape({1, 4}))},
+                        PowersOfTwo())
+                  .empty());
+}
+
+TEST(ShapeBucketingAnalysisTest, DoesNotPadElementwiseOpsOfDifferentRanks) {
+  // The rows of `x` would be broadcast along dimension 1 of `y`.
+  ShapeBucketingAnalysis analysis(Binary("AddV2"));
+  EXPECT_TRUE(analysis
+                  .Plan({Parameter(TensorShape({3})),
+                         Parameter(TensorShape({3, 3}))},
+                        PowersOfTwo())
+                  .empty());
+}
+
+FunctionDef MulByConstant(const std::vector<float>& values) {
+  return FDH::Create(
+      "MulByConstant", {"x: float"}, {"y: float"}, {},
+      {values.size() == 1
+           ? FDH::Const<float>("c", values[0])
+           : FDH::Const<float>("c", absl::Span<const float>(values)),
+       {{"y"}, "Mul", {"x", "c:output:0"}, {{"T", DT_FLOAT}}}},
+      {{"y", "y:z:0"}});
+}
+
+TEST(ShapeBucketingAnalysisTest, PadsElementwiseOpsOfScalarConstants) {
+  ShapeBucketingAnalysis analysis(MulByConstant({2}));
+  ShapeBucketingPlan plan =
+      analysis.Plan({Parameter(TensorShape({3, 4}))}, PowersOfTwo());
+  EXPECT_EQ(plan.padded_batch_size, 4);
+  EXPECT_THAT(plan.sliced_outputs, ElementsAre(0));
+}
+
+TEST(ShapeBucketingAnalysisTest, DoesNotPadElementwiseOpsOfOtherConstants) {
+  // The constant has as many elements as there are rows.
+  ShapeBucketingAnalysis analysis(MulByConstant({1, 2, 3}));
+  EXPECT_TRUE(
+      analysis.Plan({Parameter(TensorShape({3}))}, PowersOfTwo()).empty());
+}
+
+FunctionDef Softmax() {
+  return FDH::Create(
+      "Softmax", {"x: float"}, {"y: float"}, {},
+      {{{"softmax"}, "Softmax", {"x"}, {{"T", DT_FLOAT}}}},
+      {{"y", "softmax:softmax:0"}});
+}
+
+TEST(ShapeBucketingAnalysisTest, PadsSoftmaxAlongOtherDimensions) {
+  ShapeBucketingAnalysis analysis(Softmax());
+  EXPECT_THAT(
+      analysis.Plan({Parameter(TensorShape({3, 4}))}, PowersOfTwo())
+          .sliced_outputs,
+      ElementsAre(0));
+}
+
+TEST(ShapeBucketingAnalysisTest, DoesNotPadSoftmaxAlongRows) {
+  ShapeBucketingAnalysis analysis(Softmax());
+  EXPECT_TRUE(
+      analysis.Plan({Parameter(TensorShape({3}))}, PowersOfTwo()).empty());
+}
+
+// concat([x, y], axis=1).
+FunctionDef Concat() {
+  return FDH::Create("Concat", {"x: float", "y: float"}, {"z: float"}, {},
+                     {FDH::Const<int32_t>("axis", 1),
+                      {{"concat"},
+                       "ConcatV2",
+                       {"x", "y", "axis:output:0"},
+                       {{"N", 2}, {"T", DT_FLOAT}, {"Tidx", DT_INT32}}}},
+                     {{"z", "concat:output:0"}});
+}
+
+TEST(ShapeBucketingAnalysisTest, PadsConcatOfPaddedInputs) {
+  ShapeBucketingAnalysis analysis(Concat());
+  EXPECT_THAT(analysis
+                  .Plan({Parameter(TensorShape({3, 4})),
+                         Parameter(TensorShape({3, 2}))},
+                        PowersOfTwo())
+                  .sliced_outputs,
+              ElementsAre(0));
+}
+
+TEST(ShapeBucketingAnalysisTest, DoesNotPadConcatOfUnpaddedInputs) {
+  // Only the leading dimension of `x` would be padded.
+  ShapeBucketingAnalysis analysis(Concat());
+  EXPECT_TRUE(analysis
+                  .Plan({Parameter(TensorShape({3, 4})),
+                         Parameter(TensorShape({1, 4}))},
+                        PowersOfTwo())
+                  .empty());
+}
+
+TEST(ShapeBucketingAnalysisTest, RevertsPlan) {
+  ShapeBucketingAnalysis analysis(DenseLayer());
+  std::vector<XlaArgument> args = {Parameter(TensorShape({5, 4})),
+                                   Parameter(TensorShape({4, 3}))};
+  ShapeBucketingPlan plan = analysis.Plan(args, PowersOfTwo());
+  ApplyShapeBucketingPlan(plan, &args);
+  RevertShapeBucketingPlan(plan, &args);
+  EXPECT_EQ(absl::get<TensorShape>(args[0].shape), TensorShape({5, 4}));
+  EXPECT_EQ(absl::get<TensorShape>(args[1].shape), TensorShape({4, 3}));
+}
+
+TEST(ShapeBucketingAnalysisTest, DoesNotPadUnknownOps) {
+  ShapeBucketingAnalysis analysis(FDH::Create(
+      "Shape", {"x: float"}, {"y: int32"}, {},
+      {{{"shape"}, "Shape", {"x"}, {{"T", DT_FLOAT}, {"out_type", DT_INT32}}}},
+      {{"y", "shape:output:0"}}));
+  EXPECT_TRUE(
+      analysis.Plan({Parameter(TensorShape({3, 4}))}, PowersOfTwo()).empty());
+}
+
+}  // namespace
+}  // namespace tensorflow
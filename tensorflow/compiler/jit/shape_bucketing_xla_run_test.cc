@@ -0,0 +1,172 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Runs auto-clustered graphs through _XlaCompile and _XlaRun with
+// --tf_xla_shape_bucketing=pow2, which pads the inputs of the cluster up to a
+// bucket and slices the padding off its outputs.
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/cc/framework/ops.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/compiler/jit/flags.h"
+#include "tensorflow/compiler/jit/xla_activity_listener.h"
+#include "tensorflow/core/common_runtime/direct_session.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class CompilationListener : public XlaActivityListener {
+ public:
+  absl::Status Listen(
+      const XlaAutoClusteringActivity& auto_clustering_activity) override {
+    return absl::OkStatus();
+  }
+
+  absl::Status Listen(
+      const XlaJitCompilationActivity& jit_compilation_activity) override {
+    ++num_compilations_;
+    return absl::OkStatus();
+  }
+
+  absl::Status Listen(
+      const XlaOptimizationRemark& optimization_remark) override {
+    return absl::OkStatus();
+  }
+
+  int num_compilations() const { return num_compilations_; }
+
+ private:
+  int num_compilations_ = 0;
+};
+
+class ShapeBucketingXlaRunTest : public ::testing::Test {
+ protected:
+  ShapeBucketingXlaRunTest() {
+    auto listener = std::make_unique<CompilationListener>();
+    listener_ = listener.get();
+    RegisterXlaActivityListener(std::move(listener));
+  }
+
+  // Creates a session running `2 * relu(A x W + 1)`, with W = [[1, 2], [3, 4]],
+  // summed over the rows if `reduce_rows`, which keeps the cluster from being
+  // bucketed.
+  std::unique_ptr<Session> CreateSession(bool reduce_rows) {
+    Scope root = Scope::NewRootScope().ExitOnError().WithAssignedDevice(
+        "/job:localhost/replica:0/task:0/device:CPU:0");
+    Output a = ops::Placeholder(root.WithOpName("A"), DT_FLOAT,
+                                ops::Placeholder::Shape({-1, 2}));
+    Output w = ops::Const(root.WithOpName("W"), {{1.0f, 2.0f}, {3.0f, 4.0f}});
+    Output y = ops::MatMul(root.WithOpName("matmul"), a, w);
+    y = ops::Add(root.WithOpName("add"), y, 1.0f);
+    y = ops::Relu(root.WithOpName("relu"), y);
+    y = ops::Mul(root.WithOpName("mul"), y, 2.0f);
+    if (reduce_rows) y = ops::Sum(root.WithOpName("sum"), y, 0);
+    ops::Identity(root.WithOpName("Y"), y);
+
+    GraphDef graph_def;
+    TF_CHECK_OK(root.ToGraphDef(&graph_def));
+    SessionOptions options;
+    options.config.mutable_graph_options()
+        ->mutable_optimizer_options()
+        ->set_global_jit_level(OptimizerOptions::ON_2);
+    std::unique_ptr<Session> session(NewSession(options));
+    TF_CHECK_OK(session->Create(graph_def));
+    return session;
+  }
+
+  // Runs `session` on a batch whose row r is [r, r], and returns Y.
+  Tensor Run(Session* session, int batch_size) {
+    Tensor a(DT_FLOAT, TensorShape({batch_size, 2}));
+    for (int r = 0; r < batch_size; ++r) {
+      a.matrix<float>()(r, 0) = r;
+      a.matrix<float>()(r, 1) = r;
+    }
+    std::vector<Tensor> outputs;
+    TF_CHECK_OK(session->Run({{"A", a}}, {"Y:0"}, /*target_tensor_names=*/{},
+                             &outputs));
+    return outputs[0];
+  }
+
+  // Row r of `2 * relu(A x W + 1)` is [8r + 2, 12r + 2].
+  static Tensor ExpectedRows(int batch_size) {
+    Tensor expected(DT_FLOAT, TensorShape({batch_size, 2}));
+    for (int r = 0; r < batch_size; ++r) {
+      expected.matrix<float>()(r, 0) = 8 * r + 2;
+      expected.matrix<float>()(r, 1) = 12 * r + 2;
+    }
+    return expected;
+  }
+
+  int num_compilations() const { return listener_->num_compilations(); }
+
+ private:
+  CompilationListener* listener_;
+};
+
+TEST_F(ShapeBucketingXlaRunTest, PadsAndSlicesBucketedClusters) {
+  std::unique_ptr<Session> session = CreateSession(/*reduce_rows=*/false);
+
+  // The first execution compiles the cluster for a leading dimension of 4.
+  test::ExpectTensorEqual<float>(Run(session.get(), 3), ExpectedRows(3));
+  EXPECT_EQ(num_compilations(), 1);
+  test::ExpectTensorEqual<float>(Run(session.get(), 4), ExpectedRows(4));
+  EXPECT_EQ(num_compilations(), 1);
+
+  // A new bucket is compiled lazily, on its second request, so the first
+  // batch of 5 falls back to the TensorFlow ops.
+  test::ExpectTensorEqual<float>(Run(session.get(), 5), ExpectedRows(5));
+  EXPECT_EQ(num_compilations(), 1);
+  test::ExpectTensorEqual<float>(Run(session.get(), 5), ExpectedRows(5));
+  EXPECT_EQ(num_compilations(), 2);
+  // Batches of 6 to 8 rows reuse the executable compiled for 8.
+  test::ExpectTensorEqual<float>(Run(session.get(), 7), ExpectedRows(7));
+  test::ExpectTensorEqual<float>(Run(session.get(), 8), ExpectedRows(8));
+  EXPECT_EQ(num_compilations(), 2);
+}
+
+TEST_F(ShapeBucketingXlaRunTest, CompilesExactShapesOfRowMixingClusters) {
+  std::unique_ptr<Session> session = CreateSession(/*reduce_rows=*/true);
+
+  // Zero rows of padding would each add [2, 2] to the sums.
+  for (int batch_size : {3, 3, 5, 5}) {
+    const Tensor rows = ExpectedRows(batch_size);
+    Tensor expected(DT_FLOAT, TensorShape({2}));
+    expected.vec<float>().setZero();
+    for (int r = 0; r < batch_size; ++r) {
+      expected.vec<float>()(0) += rows.matrix<float>()(r, 0);
+      expected.vec<float>()(1) += rows.matrix<float>()(r, 1);
+    }
+    test::ExpectTensorEqual<float>(Run(session.get(), batch_size), expected);
+  }
+  // One executable for each batch size.
+  EXPECT_EQ(num_compilations(), 2);
+}
+
+}  // namespace
+}  // namespace tensorflow
+
+int main(int argc, char** argv) {
+  tensorflow::GetMarkForCompilationPassFlags()->tf_xla_cpu_global_jit = true;
+  tensorflow::GetXlaOpsCommonFlags()->tf_xla_shape_bucketing = "pow2";
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -25,6 +25,10 @@ limitations under the License.
 namespace tensorflow {
 // The number of compiler threads to use for asynchronous device compilation.
 inline constexpr int64_t kNumAsyncDeviceCompilerThreads = 10;
+// The number of compiler threads to use for compiling predicted signatures
+// ahead of time. This is also the maximum number of such compilations in
+// flight, so that they never queue up behind each other.
+inline constexpr int64_t kNumSpeculativeDeviceCompilerThreads = 2;
 
 enum class DeviceCompileMode {
   kLazy,
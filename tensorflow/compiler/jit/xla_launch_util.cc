@@ -24,9 +24,11 @@ limitations under the License.
 
 #include "absl/algorithm/container.h"
 #include "absl/cleanup/cleanup.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/types/span.h"
+#include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/jit/pjrt_tensor_buffer.h"
 #include "tensorflow/compiler/jit/pjrt_tensor_buffer_util.h"
 #include "tensorflow/compiler/jit/variable_info.h"
@@ -153,7 +155,8 @@ XlaComputationLaunchContext::PopulateInputs(
     const XlaCompiler::CompilationResult* compilation_result,
     const std::map<int, const Tensor*>& resource_vars,
     int missing_ctx_input_prefix,
-    const xla::HloInputOutputAliasConfig& input_output_alias) {
+    const xla::HloInputOutputAliasConfig& input_output_alias,
+    absl::Span<const Tensor* const> inputs) {
   std::vector<xla::ExecutionInput> arguments;
   arguments.reserve(compilation_result->xla_input_shapes.size());
 
@@ -176,9 +179,10 @@ XlaComputationLaunchContext::PopulateInputs(
                                 update.modified;
                        });
 
-    const Tensor* t = is_resource_variable
-                          ? resource_var_it->second
-                          : &(ctx->input(arg_num - missing_ctx_input_prefix));
+    const Tensor* t =
+        is_resource_variable ? resource_var_it->second
+        : inputs.empty()     ? &(ctx->input(arg_num - missing_ctx_input_prefix))
+                             : inputs[arg_num - missing_ctx_input_prefix];
     CHECK(t);
     bool donate_buffer =
         t->RefCountIsOne() && is_updated_resource_variable &&
@@ -322,6 +326,35 @@ absl::Status SetOutputForConstant(
   return absl::OkStatus();
 }
 
+absl::flat_hash_map<int, const Tensor*> DonateUpdatedVariables(
+    absl::Span<const VariableInfo> variables, int num_constant_args,
+    ResourceVarsSnapshot* snapshots) {
+  absl::flat_hash_map<int, const Tensor*> donated;
+  if (!GetXlaOpsCommonFlags()->tf_xla_donate_variable_buffers) {
+    return donated;
+  }
+
+  // A variable passed to the cluster twice can't be donated to both inputs.
+  absl::flat_hash_map<const Var*, int> num_uses;
+  for (const VariableInfo& variable : variables) {
+    ++num_uses[variable.var()];
+  }
+
+  for (const VariableInfo& variable : variables) {
+    const Tensor* tensor = variable.var()->tensor();
+    auto it = snapshots->find(variable.index() + num_constant_args);
+    if (num_uses[variable.var()] > 1 || it == snapshots->end() ||
+        !it->second.has_value() || !tensor->SharesBufferWith(*it->second) ||
+        tensor->shape() != it->second->shape()) {
+      continue;
+    }
+    VLOG(3) << "Donating variable " << variable.name();
+    it->second.reset();
+    donated[it->first] = tensor;
+  }
+  return donated;
+}
+
 static absl::StatusOr<Var*> GetOrCreateResourceVar(
     OpKernelContext* ctx, const ResourceHandle& handle,
     const XlaCompiler::ResourceUpdate& write) {
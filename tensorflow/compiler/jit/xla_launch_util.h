@@ -23,7 +23,10 @@ limitations under the License.
 #include <set>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/span.h"
 #include "tensorflow/compiler/jit/variable_info.h"
+#include "tensorflow/compiler/jit/variable_info_util.h"
 #include "tensorflow/compiler/jit/xla_tensor.h"
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
 #include "xla/client/local_client.h"
@@ -53,6 +56,19 @@ absl::Status SetOutputForConstant(
     OpKernelContext* ctx, bool requires_copy_to_device,
     const XlaCompiler::CompilationResult* compilation_result, int output_num);
 
+// Returns the locked updated `variables` whose buffers can be passed to the
+// executable instead of their snapshots in `snapshots`, keyed by input index.
+// A variable is skipped if it is passed more than once or if another op has
+// assigned it since the snapshot was taken. The snapshots of the returned
+// variables are released, which usually leaves the variables as the only
+// owners of their buffers so that they can be donated and updated in place.
+// Snapshots are keyed by XlaCompile input indices, which include the
+// `num_constant_args` must-be-constant inputs. Returns nothing if
+// --tf_xla_donate_variable_buffers is false.
+absl::flat_hash_map<int, const Tensor*> DonateUpdatedVariables(
+    absl::Span<const VariableInfo> variables, int num_constant_args,
+    ResourceVarsSnapshot* snapshots);
+
 // Converts input tensors and variables which are parameters of the
 // XlaComputation into PjRtBuffers to be fed as input to the
 // PjRtLoadedExecutable.
@@ -185,12 +201,16 @@ class XlaComputationLaunchContext {
   // missing and adjusts input indices accordingly.  All elements in kernel's
   // input_mapping must be greater than or equal to `missing_ctx_input_prefix`
   // (in other words, no inputs actually required by the kernel can be missing).
+  //
+  // If `inputs` is not empty, it replaces the inputs of `ctx`, e.g. with
+  // padded copies of them.
   absl::StatusOr<std::vector<xla::ExecutionInput>> PopulateInputs(
       OpKernelContext* ctx,
       const XlaCompiler::CompilationResult* compilation_result,
       const std::map<int, const Tensor*>& resource_vars,
       int missing_ctx_input_prefix,
-      const xla::HloInputOutputAliasConfig& input_output_alias);
+      const xla::HloInputOutputAliasConfig& input_output_alias,
+      absl::Span<const Tensor* const> inputs = {});
 
   // Given the XLA output in `output`, populate all outputs of `ctx`.  Also
   // writes out the resource variable updates.
@@ -21,6 +21,8 @@ limitations under the License.
 #include <vector>
 
 #include <gtest/gtest.h>
+#include "absl/cleanup/cleanup.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/compiler/jit/device_compiler.h"
 #include "tensorflow/compiler/jit/flags.h"
@@ -228,6 +230,45 @@ class PjRtExecutionUtilTest : public OpsTestBase {
     return var;
   }
 
+  // Creates a Variable whose buffer isn't shared with any other Tensor.
+  template <typename T>
+  Var* CreateUniquelyOwnedVariable(const TensorShape& shape,
+                                   const gtl::ArraySlice<T> data) {
+    Tensor* host_tensor = CreateHostTensor<T>(shape, data);
+    Var* var = new Var(DataTypeToEnum<T>::v());
+    *var->tensor() = Tensor(device_allocator_, DataTypeToEnum<T>::v(), shape);
+    TF_EXPECT_OK(device_context_->CopyCPUTensorToDeviceSync(
+        host_tensor, device_, var->tensor()));
+    var->is_initialized = true;
+
+    return var;
+  }
+
+  // Returns the number of variable inputs that can't be donated to the
+  // executable once the `donated` variables replace their `snapshots`.
+  int NumNonDonatableVariables(
+      const ResourceVarsSnapshot& snapshots,
+      const absl::flat_hash_map<int, const Tensor*>& donated) {
+    std::vector<int> input_mapping;
+    absl::flat_hash_map<int, const Tensor*> variable_snapshots;
+    for (const auto& [index, tensor] : snapshots) {
+      input_mapping.push_back(index);
+      variable_snapshots[index] = tensor.has_value() ? &*tensor : nullptr;
+    }
+    for (const auto& [index, tensor] : donated) {
+      variable_snapshots[index] = tensor;
+    }
+
+    std::vector<xla::PjRtBuffer*> exec_args;
+    absl::flat_hash_set<int> non_donatable_input_indices;
+    TF_EXPECT_OK(PreparePjRtExecutableArguments(
+        /*num_missing_prefix_ctx_inputs=*/0, input_mapping, /*inputs=*/{},
+        variable_snapshots, /*pjrt_client=*/nullptr, /*pjrt_device=*/nullptr,
+        /*use_pjrt_tensor_buffer=*/false, &exec_args, /*owned_args=*/{},
+        &non_donatable_input_indices));
+    return non_donatable_input_indices.size();
+  }
+
   // Creates a Variable, adds it to the resource manager and also adds it as one
   // of the inputs in the context_
   template <typename T>
@@ -325,6 +366,100 @@ TEST_F(PjRtExecutionUtilTest, PreparePjRtExecutableArgumentsVariableInputs) {
       *literal2, xla::LiteralUtil::CreateR2<int32_t>({{3, 4}})));
 }
 
+TEST_F(PjRtExecutionUtilTest, DonateUpdatedVariables) {
+  std::vector<VariableInfo> variables;
+  Var* var = CreateUniquelyOwnedVariable<int32>(TensorShape({1, 2}), {1, 2});
+  variables.emplace_back(0, "v", var);
+  // The snapshot is keyed by the XlaCompile input index, which is offset by
+  // the must-be-constant inputs.
+  ResourceVarsSnapshot snapshots;
+  snapshots[1] = *var->tensor();
+  EXPECT_EQ(NumNonDonatableVariables(snapshots, {}), 1);
+
+  absl::flat_hash_map<int, const Tensor*> donated =
+      DonateUpdatedVariables(variables, /*num_constant_args=*/1, &snapshots);
+
+  ASSERT_EQ(donated.size(), 1);
+  EXPECT_EQ(donated[1], var->tensor());
+  EXPECT_FALSE(snapshots[1].has_value());
+  EXPECT_TRUE(var->tensor()->RefCountIsOne());
+  EXPECT_EQ(NumNonDonatableVariables(snapshots, donated), 0);
+}
+
+TEST_F(PjRtExecutionUtilTest, DonateUpdatedVariablesWithOtherReference) {
+  std::vector<VariableInfo> variables;
+  Var* var = CreateUniquelyOwnedVariable<int32>(TensorShape({1, 2}), {1, 2});
+  variables.emplace_back(0, "v", var);
+  ResourceVarsSnapshot snapshots;
+  snapshots[0] = *var->tensor();
+  Tensor other_reference = *var->tensor();
+
+  absl::flat_hash_map<int, const Tensor*> donated =
+      DonateUpdatedVariables(variables, /*num_constant_args=*/0, &snapshots);
+
+  // Releasing the snapshot isn't enough for the buffer to be donated.
+  EXPECT_EQ(donated.size(), 1);
+  EXPECT_FALSE(var->tensor()->RefCountIsOne());
+  EXPECT_EQ(NumNonDonatableVariables(snapshots, donated), 1);
+}
+
+TEST_F(PjRtExecutionUtilTest, DonateUpdatedVariablesAssignedSinceSnapshot) {
+  std::vector<VariableInfo> variables;
+  Var* var = CreateUniquelyOwnedVariable<int32>(TensorShape({1, 2}), {1, 2});
+  variables.emplace_back(0, "v", var);
+  ResourceVarsSnapshot snapshots;
+  snapshots[0] = *var->tensor();
+  *var->tensor() = *CreateDeviceTensor<int32>(TensorShape({1, 2}), {3, 4});
+
+  absl::flat_hash_map<int, const Tensor*> donated =
+      DonateUpdatedVariables(variables, /*num_constant_args=*/0, &snapshots);
+
+  EXPECT_TRUE(donated.empty());
+  EXPECT_TRUE(snapshots[0].has_value());
+}
+
+TEST_F(PjRtExecutionUtilTest, DonateUpdatedVariablesPassedTwice) {
+  std::vector<VariableInfo> variables;
+  Var* var = CreateUniquelyOwnedVariable<int32>(TensorShape({1, 2}), {1, 2});
+  var->Ref();
+  variables.emplace_back(0, "v", var);
+  variables.emplace_back(1, "v", var);
+  ResourceVarsSnapshot snapshots;
+  snapshots[0] = *var->tensor();
+  snapshots[1] = *var->tensor();
+
+  absl::flat_hash_map<int, const Tensor*> donated =
+      DonateUpdatedVariables(variables, /*num_constant_args=*/0, &snapshots);
+
+  EXPECT_TRUE(donated.empty());
+  EXPECT_TRUE(snapshots[0].has_value());
+  EXPECT_TRUE(snapshots[1].has_value());
+  EXPECT_EQ(NumNonDonatableVariables(snapshots, donated), 2);
+}
+
+TEST_F(PjRtExecutionUtilTest, DonateUpdatedVariablesDisabled) {
+  bool& donate_variable_buffers =
+      GetXlaOpsCommonFlags()->tf_xla_donate_variable_buffers;
+  const bool old_donate_variable_buffers = donate_variable_buffers;
+  absl::Cleanup restore_flag = [&] {
+    donate_variable_buffers = old_donate_variable_buffers;
+  };
+  donate_variable_buffers = false;
+
+  std::vector<VariableInfo> variables;
+  Var* var = CreateUniquelyOwnedVariable<int32>(TensorShape({1, 2}), {1, 2});
+  variables.emplace_back(0, "v", var);
+  ResourceVarsSnapshot snapshots;
+  snapshots[0] = *var->tensor();
+
+  absl::flat_hash_map<int, const Tensor*> donated =
+      DonateUpdatedVariables(variables, /*num_constant_args=*/0, &snapshots);
+
+  EXPECT_TRUE(donated.empty());
+  EXPECT_TRUE(snapshots[0].has_value());
+  EXPECT_EQ(NumNonDonatableVariables(snapshots, donated), 1);
+}
+
 TEST_F(PjRtExecutionUtilTest, PopulateCtxOutputs) {
   XlaOpRegistry::RegisterCompilationKernels();
   TF_EXPECT_OK(NodeDefBuilder("AddV2", "AddV2")
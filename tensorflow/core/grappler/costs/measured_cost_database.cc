@@ -0,0 +1,252 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/measured_cost_database.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/match.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/grappler/costs/utils.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+// Reduces 'op_info' to the fields that determine the cost of the op. Returns
+// false if the input shapes are not fully known.
+bool CanonicalizeOpInfo(const OpInfo& op_info, OpInfo* canonical) {
+  canonical->set_op(op_info.op());
+  for (const auto& attr : op_info.attr()) {
+    // Internal attributes (e.g. _class, _output_shapes) don't affect the cost.
+    if (absl::StartsWith(attr.first, "_")) continue;
+    (*canonical->mutable_attr())[attr.first] = attr.second;
+  }
+  canonical->mutable_device()->set_type(op_info.device().type());
+  for (const auto& input : op_info.inputs()) {
+    if (input.shape().unknown_rank()) return false;
+    auto* canonical_input = canonical->add_inputs();
+    canonical_input->set_dtype(input.dtype());
+    auto* shape = canonical_input->mutable_shape();
+    for (const auto& dim : input.shape().dim()) {
+      if (dim.size() < 0) return false;
+      shape->add_dim()->set_size(dim.size());
+    }
+  }
+  return true;
+}
+
+bool MakeKey(const OpInfo& canonical, std::string* key) {
+  return SerializeToStringDeterministic(canonical, key);
+}
+
+}  // namespace
+
+const MeasuredCostDatabase* MeasuredCostDatabase::Default() {
+  static const MeasuredCostDatabase* database =
+      []() -> const MeasuredCostDatabase* {
+    std::string path;
+    absl::Status status =
+        ReadStringFromEnvVar(kMeasuredCostDatabaseEnvVar, "", &path);
+    if (!status.ok() || path.empty()) return nullptr;
+    auto* database = new MeasuredCostDatabase();
+    status = database->LoadFromFile(path);
+    if (!status.ok()) {
+      LOG(WARNING) << "Not using measured op costs from " << path << ": "
+                   << status;
+      delete database;
+      return nullptr;
+    }
+    VLOG(1) << "Loaded " << database->num_entries()
+            << " measured op costs from " << path;
+    return database;
+  }();
+  return database;
+}
+
+void MeasuredCostDatabase::MergeEntry(const OpInfo& canonical_op,
+                                      const std::string& key,
+                                      int64_t num_samples, double mean_ns,
+                                      double m2) {
+  if (num_samples <= 0) return;
+  Entry& entry = entries_[key];
+  if (entry.num_samples == 0) {
+    entry.op = canonical_op;
+    entry.num_samples = num_samples;
+    entry.mean_ns = mean_ns;
+    entry.m2 = m2;
+    return;
+  }
+  // Combines the two sets of statistics (Chan et al.).
+  const double n_a = entry.num_samples;
+  const double n_b = num_samples;
+  const double n = n_a + n_b;
+  const double delta = mean_ns - entry.mean_ns;
+  entry.mean_ns += delta * n_b / n;
+  entry.m2 += m2 + delta * delta * n_a * n_b / n;
+  entry.num_samples += num_samples;
+}
+
+void MeasuredCostDatabase::AddMeasurement(const OpInfo& op_info,
+                                          int64_t compute_time_ns) {
+  if (compute_time_ns < 0) return;
+  OpInfo canonical;
+  std::string key;
+  if (!CanonicalizeOpInfo(op_info, &canonical) || !MakeKey(canonical, &key)) {
+    return;
+  }
+  mutex_lock l(mu_);
+  MergeEntry(canonical, key, 1, compute_time_ns, 0);
+}
+
+void MeasuredCostDatabase::AddOpPerformanceList(
+    const OpPerformanceList& performance_list) {
+  for (const OpPerformance& performance : performance_list.op_performance()) {
+    // A zero cost means the op was not measured.
+    if (performance.compute_cost() <= 0) continue;
+    AddMeasurement(performance.op(), performance.compute_cost());
+  }
+}
+
+void MeasuredCostDatabase::AddRunMetadata(const GraphDef& graph,
+                                          const RunMetadata& run_metadata) {
+  // A node can run several times per step, e.g. in a loop.
+  std::unordered_map<std::string, std::vector<int64_t>> step_times_ns;
+  for (const DeviceStepStats& device_stats :
+       run_metadata.step_stats().dev_stats()) {
+    for (const NodeExecStats& node_stats : device_stats.node_stats()) {
+      int64_t time_ns =
+          node_stats.op_end_rel_nanos() - node_stats.op_start_rel_nanos();
+      if (time_ns <= 0) {
+        time_ns = (node_stats.op_end_rel_micros() -
+                   node_stats.op_start_rel_micros()) *
+                  1000;
+      }
+      step_times_ns[node_stats.node_name()].push_back(
+          std::max<int64_t>(time_ns, 0));
+    }
+  }
+
+  const OpPerformanceList performance_list =
+      CostGraphToOpPerformanceData(run_metadata.cost_graph(), graph);
+  for (const OpPerformance& performance : performance_list.op_performance()) {
+    auto it = step_times_ns.find(performance.node());
+    if (it == step_times_ns.end()) {
+      if (performance.compute_cost() > 0) {
+        AddMeasurement(performance.op(), performance.compute_cost());
+      }
+      continue;
+    }
+    for (int64_t time_ns : it->second) {
+      AddMeasurement(performance.op(), time_ns);
+    }
+  }
+}
+
+bool MeasuredCostDatabase::Lookup(const OpInfo& op_info,
+                                  int64_t* compute_time_ns) const {
+  OpInfo canonical;
+  std::string key;
+  if (!CanonicalizeOpInfo(op_info, &canonical) || !MakeKey(canonical, &key)) {
+    return false;
+  }
+  mutex_lock l(mu_);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) return false;
+  *compute_time_ns = std::llround(it->second.mean_ns);
+  return true;
+}
+
+int64_t MeasuredCostDatabase::num_entries() const {
+  mutex_lock l(mu_);
+  return entries_.size();
+}
+
+void MeasuredCostDatabase::Merge(const MeasuredOpCostList& costs) {
+  for (const MeasuredOpCost& cost : costs.measured_op_cost()) {
+    OpInfo canonical;
+    std::string key;
+    if (!CanonicalizeOpInfo(cost.op(), &canonical) ||
+        !MakeKey(canonical, &key)) {
+      continue;
+    }
+    const double sigma = cost.compute_time().sigma();
+    mutex_lock l(mu_);
+    MergeEntry(canonical, key, cost.num_samples(), cost.compute_time().mu(),
+               sigma * sigma * cost.num_samples());
+  }
+}
+
+MeasuredOpCostList MeasuredCostDatabase::ToProto() const {
+  mutex_lock l(mu_);
+  // Sort by key so that the same database always serializes the same way.
+  std::vector<const std::pair<const std::string, Entry>*> sorted;
+  sorted.reserve(entries_.size());
+  for (const auto& entry : entries_) sorted.push_back(&entry);
+  std::sort(sorted.begin(), sorted.end(),
+            [](const auto* a, const auto* b) { return a->first < b->first; });
+
+  MeasuredOpCostList costs;
+  for (const auto* entry : sorted) {
+    MeasuredOpCost* cost = costs.add_measured_op_cost();
+    *cost->mutable_op() = entry->second.op;
+    cost->set_num_samples(entry->second.num_samples);
+    cost->mutable_compute_time()->set_mu(entry->second.mean_ns);
+    cost->mutable_compute_time()->set_sigma(
+        std::sqrt(entry->second.m2 / entry->second.num_samples));
+  }
+  return costs;
+}
+
+absl::Status MeasuredCostDatabase::LoadFromFile(const std::string& path) {
+  MeasuredOpCostList costs;
+  TF_RETURN_IF_ERROR(ReadBinaryProto(Env::Default(), path, &costs));
+  Merge(costs);
+  return absl::OkStatus();
+}
+
+absl::Status MeasuredCostDatabase::SaveToFile(const std::string& path) const {
+  Env* env = Env::Default();
+  // Write to a unique temporary file first so that concurrent readers never
+  // observe a partially written database.
+  std::string temp_path = path;
+  if (!env->CreateUniqueFileName(&temp_path, ".tmp")) {
+    return errors::Internal("Failed to create a temporary file name for ",
+                            path);
+  }
+  absl::Status status = WriteBinaryProto(env, temp_path, ToProto());
+  if (status.ok()) {
+    status = env->RenameFile(temp_path, path);
+  }
+  if (!status.ok()) {
+    env->DeleteFile(temp_path).IgnoreError();
+  }
+  return status;
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,111 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_COSTS_MEASURED_COST_DATABASE_H_
+#define TENSORFLOW_CORE_GRAPPLER_COSTS_MEASURED_COST_DATABASE_H_
+
+#include <cstdint>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Environment variable naming the file the default database is loaded from.
+inline constexpr char kMeasuredCostDatabaseEnvVar[] =
+    "TF_GRAPPLER_MEASURED_COST_DATABASE";
+
+// A database of op execution times measured on the local host, keyed by op
+// type, attributes, device type and input types and shapes. Ops whose input
+// shapes are not fully known are never recorded or looked up.
+//
+// Measurements are typically collected from the RunMetadata of real steps
+// (with step stats and a cost graph), saved to disk, and loaded by later
+// processes so that OpLevelCostEstimator can use them instead of its
+// analytical estimates.
+//
+// Thread-safe.
+class MeasuredCostDatabase {
+ public:
+  MeasuredCostDatabase() = default;
+
+  MeasuredCostDatabase(const MeasuredCostDatabase&) = delete;
+  MeasuredCostDatabase& operator=(const MeasuredCostDatabase&) = delete;
+
+  // Returns the process-wide database, loaded on first use from the file named
+  // by $TF_GRAPPLER_MEASURED_COST_DATABASE, or null if the variable is not
+  // set or the file can't be read.
+  static const MeasuredCostDatabase* Default();
+
+  // Records that the op described by 'op_info' took 'compute_time_ns'.
+  void AddMeasurement(const OpInfo& op_info, int64_t compute_time_ns)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Records the measured compute cost of every op in 'performance_list'.
+  void AddOpPerformanceList(const OpPerformanceList& performance_list)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Records the ops executed in a step of 'graph'. Shapes come from the cost
+  // graph of 'run_metadata', and times from its step stats when present and
+  // from the cost graph otherwise.
+  void AddRunMetadata(const GraphDef& graph, const RunMetadata& run_metadata)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns true and sets 'compute_time_ns' to the mean measured time if the
+  // op described by 'op_info' has been measured.
+  bool Lookup(const OpInfo& op_info, int64_t* compute_time_ns) const
+      TF_LOCKS_EXCLUDED(mu_);
+
+  int64_t num_entries() const TF_LOCKS_EXCLUDED(mu_);
+
+  // Merges the measurements of 'costs' into the database.
+  void Merge(const MeasuredOpCostList& costs) TF_LOCKS_EXCLUDED(mu_);
+  MeasuredOpCostList ToProto() const TF_LOCKS_EXCLUDED(mu_);
+
+  // Merges the database stored in 'path' into this one.
+  absl::Status LoadFromFile(const std::string& path) TF_LOCKS_EXCLUDED(mu_);
+  // Writes the database to 'path', replacing it atomically.
+  absl::Status SaveToFile(const std::string& path) const
+      TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  // Running statistics of the compute time of one key.
+  struct Entry {
+    OpInfo op;
+    int64_t num_samples = 0;
+    double mean_ns = 0;
+    // Sum of squared differences from the mean (Welford).
+    double m2 = 0;
+  };
+
+  void MergeEntry(const OpInfo& canonical_op, const std::string& key,
+                  int64_t num_samples, double mean_ns, double m2)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  mutable mutex mu_;
+  absl::flat_hash_map<std::string, Entry> entries_ TF_GUARDED_BY(mu_);
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_COSTS_MEASURED_COST_DATABASE_H_
@@ -0,0 +1,169 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/measured_cost_database.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/cost_graph.pb.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kCpuDevice[] = "/job:localhost/replica:0/task:0/cpu:0";
+
+OpInfo DescribeRelu(const std::vector<int64_t>& dims) {
+  OpInfo op_info;
+  op_info.set_op("Relu");
+  (*op_info.mutable_attr())["T"].set_type(DT_FLOAT);
+  op_info.mutable_device()->set_type("CPU");
+  auto* input = op_info.add_inputs();
+  input->set_dtype(DT_FLOAT);
+  for (int64_t dim : dims) {
+    input->mutable_shape()->add_dim()->set_size(dim);
+  }
+  return op_info;
+}
+
+TEST(MeasuredCostDatabaseTest, AveragesMeasurements) {
+  MeasuredCostDatabase database;
+  database.AddMeasurement(DescribeRelu({4, 8}), 1000);
+  database.AddMeasurement(DescribeRelu({4, 8}), 3000);
+
+  int64_t time_ns = 0;
+  ASSERT_TRUE(database.Lookup(DescribeRelu({4, 8}), &time_ns));
+  EXPECT_EQ(time_ns, 2000);
+  EXPECT_EQ(database.num_entries(), 1);
+}
+
+TEST(MeasuredCostDatabaseTest, KeysByShapeDtypeAndDevice) {
+  MeasuredCostDatabase database;
+  database.AddMeasurement(DescribeRelu({4, 8}), 1000);
+
+  int64_t time_ns = 0;
+  EXPECT_FALSE(database.Lookup(DescribeRelu({8, 8}), &time_ns));
+
+  OpInfo double_relu = DescribeRelu({4, 8});
+  double_relu.mutable_inputs(0)->set_dtype(DT_DOUBLE);
+  EXPECT_FALSE(database.Lookup(double_relu, &time_ns));
+
+  OpInfo gpu_relu = DescribeRelu({4, 8});
+  gpu_relu.mutable_device()->set_type("GPU");
+  EXPECT_FALSE(database.Lookup(gpu_relu, &time_ns));
+
+  // Device details other than its type and internal attributes are ignored.
+  OpInfo annotated_relu = DescribeRelu({4, 8});
+  annotated_relu.mutable_device()->set_num_cores(64);
+  (*annotated_relu.mutable_attr())["_class"].set_s("loc:@a");
+  EXPECT_TRUE(database.Lookup(annotated_relu, &time_ns));
+}
+
+TEST(MeasuredCostDatabaseTest, IgnoresUnknownShapes) {
+  MeasuredCostDatabase database;
+  database.AddMeasurement(DescribeRelu({-1, 8}), 1000);
+  EXPECT_EQ(database.num_entries(), 0);
+
+  OpInfo unknown_rank = DescribeRelu({});
+  unknown_rank.mutable_inputs(0)->mutable_shape()->set_unknown_rank(true);
+  database.AddMeasurement(unknown_rank, 1000);
+  EXPECT_EQ(database.num_entries(), 0);
+}
+
+TEST(MeasuredCostDatabaseTest, SavesAndMerges) {
+  const std::string path =
+      io::JoinPath(testing::TmpDir(), "measured_op_costs.pb");
+  {
+    MeasuredCostDatabase database;
+    database.AddMeasurement(DescribeRelu({4, 8}), 1000);
+    database.AddMeasurement(DescribeRelu({16, 8}), 4000);
+    TF_ASSERT_OK(database.SaveToFile(path));
+  }
+
+  MeasuredCostDatabase database;
+  database.AddMeasurement(DescribeRelu({4, 8}), 2000);
+  database.AddMeasurement(DescribeRelu({4, 8}), 3000);
+  TF_ASSERT_OK(database.LoadFromFile(path));
+  EXPECT_EQ(database.num_entries(), 2);
+
+  int64_t time_ns = 0;
+  ASSERT_TRUE(database.Lookup(DescribeRelu({4, 8}), &time_ns));
+  EXPECT_EQ(time_ns, 2000);
+  ASSERT_TRUE(database.Lookup(DescribeRelu({16, 8}), &time_ns));
+  EXPECT_EQ(time_ns, 4000);
+
+  const MeasuredOpCostList costs = database.ToProto();
+  ASSERT_EQ(costs.measured_op_cost_size(), 2);
+  for (const MeasuredOpCost& cost : costs.measured_op_cost()) {
+    if (cost.op().inputs(0).shape().dim(0).size() == 4) {
+      EXPECT_EQ(cost.num_samples(), 3);
+      EXPECT_NEAR(cost.compute_time().sigma(), 816.5, 0.1);
+    }
+  }
+}
+
+TEST(MeasuredCostDatabaseTest, CollectsFromRunMetadata) {
+  GraphDef graph;
+  TF_ASSERT_OK(NodeDefBuilder("a", "Placeholder")
+                   .Attr("dtype", DT_FLOAT)
+                   .Finalize(graph.add_node()));
+  TF_ASSERT_OK(NodeDefBuilder("b", "Relu")
+                   .Input("a", 0, DT_FLOAT)
+                   .Finalize(graph.add_node()));
+
+  RunMetadata run_metadata;
+  CostGraphDef::Node* a_cost = run_metadata.mutable_cost_graph()->add_node();
+  a_cost->set_name("a");
+  a_cost->set_device(kCpuDevice);
+  auto* a_output = a_cost->add_output_info();
+  a_output->set_dtype(DT_FLOAT);
+  a_output->mutable_shape()->add_dim()->set_size(4);
+  a_output->mutable_shape()->add_dim()->set_size(8);
+  CostGraphDef::Node* b_cost = run_metadata.mutable_cost_graph()->add_node();
+  b_cost->set_name("b");
+  b_cost->set_device(kCpuDevice);
+  b_cost->set_compute_cost(100);
+
+  // Step stats take precedence over the cost graph.
+  DeviceStepStats* device_stats =
+      run_metadata.mutable_step_stats()->add_dev_stats();
+  device_stats->set_device(kCpuDevice);
+  for (int64_t end_ns : {5000, 3000}) {
+    NodeExecStats* node_stats = device_stats->add_node_stats();
+    node_stats->set_node_name("b");
+    node_stats->set_op_start_rel_nanos(0);
+    node_stats->set_op_end_rel_nanos(end_ns);
+  }
+
+  MeasuredCostDatabase database;
+  database.AddRunMetadata(graph, run_metadata);
+
+  int64_t time_ns = 0;
+  ASSERT_TRUE(database.Lookup(DescribeRelu({4, 8}), &time_ns));
+  EXPECT_EQ(time_ns, 4000);
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -363,7 +363,8 @@ std::vector<int64_t> MaybeGetMinimumShape(
   return minimal_shape;
 }
 
-OpLevelCostEstimator::OpLevelCostEstimator() {
+OpLevelCostEstimator::OpLevelCostEstimator()
+    : measured_costs_(MeasuredCostDatabase::Default()) {
   // Syntactic sugar to build and return a lambda that takes an OpInfo and
   // returns a cost.
   typedef absl::Status (OpLevelCostEstimator::*CostImpl)(
@@ -658,6 +659,27 @@ OpLevelCostEstimator::OpLevelCostEstimator() {
 }
 
 Costs OpLevelCostEstimator::PredictCosts(const OpContext& op_context) const {
+  Costs costs = PredictAnalyticalCosts(op_context);
+  int64_t measured_time_ns;
+  if (measured_costs_ != nullptr &&
+      measured_costs_->Lookup(op_context.op_info, &measured_time_ns)) {
+    // The measurement covers both compute and memory accesses. Memory usage
+    // stats still come from the analytical model.
+    VLOG(1) << "Operation " << op_context.op_info.op()
+            << " was measured to take " << measured_time_ns << " ns.";
+    costs.compute_time = Costs::NanoSeconds(measured_time_ns);
+    costs.execution_time = Costs::NanoSeconds(measured_time_ns);
+    costs.memory_time = Costs::Duration::zero();
+    costs.intermediate_memory_time = Costs::Duration::zero();
+    costs.intermediate_memory_read_time = Costs::Duration::zero();
+    costs.intermediate_memory_write_time = Costs::Duration::zero();
+    costs.inaccurate = false;
+  }
+  return costs;
+}
+
+Costs OpLevelCostEstimator::PredictAnalyticalCosts(
+    const OpContext& op_context) const {
   Costs costs;
   NodeCosts node_costs;
   if (PredictNodeCosts(op_context, &node_costs).ok()) {
@@ -26,6 +26,7 @@ limitations under the License.
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "tensorflow/core/grappler/costs/cost_estimator.h"
+#include "tensorflow/core/grappler/costs/measured_cost_database.h"
 #include "tensorflow/core/grappler/costs/op_context.h"
 #include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
 #include "tensorflow/core/platform/types.h"
@@ -106,7 +107,17 @@ class OpLevelCostEstimator {
   // Returns basic device performance info.
   virtual DeviceInfo GetDeviceInfo(const DeviceProperties& device) const;
 
+  // Sets the database of measured op costs that takes precedence over the
+  // analytical estimates. May be null. Defaults to
+  // MeasuredCostDatabase::Default().
+  void set_measured_costs(const MeasuredCostDatabase* measured_costs) {
+    measured_costs_ = measured_costs;
+  }
+
  protected:
+  // Predicts the cost of an op from its analytical model only.
+  Costs PredictAnalyticalCosts(const OpContext& op_context) const;
+
   // TODO(dyoon): Consider to remove PredictOpCountBasedCosts() with OpInfo.
   // Naive cost estimate based on the given operations count and total
   // input/output tensor sizes of the given op_info combined.
@@ -335,6 +346,8 @@ class OpLevelCostEstimator {
   // compute_time and memory_time, instead of sum of those two.
   bool compute_memory_overlap_;
   std::set<string> persistent_ops_;
+  // Not owned.
+  const MeasuredCostDatabase* measured_costs_;
 
  private:
   friend class OpLevelCostEstimatorTest;
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/costs/measured_cost_database.h"
 #include "tensorflow/core/platform/status_matchers.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/protobuf/device_properties.pb.h"
@@ -685,6 +686,25 @@ TEST_F(OpLevelCostEstimatorTest, TestPersistentOpCosts) {
   }
 }
 
+TEST_F(OpLevelCostEstimatorTest, MeasuredCostsOverrideAnalyticalCosts) {
+  const OpContext measured = DescribeMatMul(2, 4, 7, 7);
+  const OpContext unmeasured = DescribeMatMul(4, 4, 7, 7);
+  const Costs analytical = PredictCosts(unmeasured);
+
+  MeasuredCostDatabase measured_costs;
+  measured_costs.AddMeasurement(measured.op_info, 12345);
+  estimator_.set_measured_costs(&measured_costs);
+
+  const Costs cost = PredictCosts(measured);
+  EXPECT_EQ(Costs::Duration(12345), cost.compute_time);
+  EXPECT_EQ(Costs::Duration(12345), cost.execution_time);
+  EXPECT_EQ(Costs::Duration(0), cost.memory_time);
+  EXPECT_FALSE(cost.inaccurate);
+
+  EXPECT_EQ(analytical.execution_time, PredictCosts(unmeasured).execution_time);
+  estimator_.set_measured_costs(nullptr);
+}
+
 TEST_F(OpLevelCostEstimatorTest, TestGatherCosts) {
   std::vector<std::string> gather_ops = {"Gather", "GatherNd", "GatherV2"};
 
@@ -21,7 +21,10 @@ limitations under the License.
 #include <type_traits>
 #include <utility>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
@@ -50,6 +53,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/model_pruner.h"
+#include "tensorflow/core/grappler/optimizers/optimized_graph_cache.h"
 #include "tensorflow/core/grappler/optimizers/pin_to_host_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/remapper.h"
 #include "tensorflow/core/grappler/optimizers/scoped_allocator_optimizer.h"
@@ -61,9 +65,13 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/tpu.h"
 #include "tensorflow/core/grappler/verifiers/structure_verifier.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/util/dump_graph.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/util.h"
 #include "tensorflow/core/util/xla_config_registry.h"
 
@@ -81,6 +89,8 @@ namespace {
 constexpr int kDefaultNumberOfIterations = 2;
 constexpr int kDefaultMinGraphNodes = 4;
 constexpr char kGrapplerCategory[] = "Grappler";
+constexpr char kFunctionOptimizationThreadsEnvVar[] =
+    "TF_GRAPPLER_FUNCTION_OPTIMIZATION_THREADS";
 
 int64_t NumEdges(const GraphDef& graph) {
   int64_t num_edges = 0;
@@ -276,6 +286,14 @@ MetaOptimizer::MetaOptimizer(DeviceBase* cpu_device, const ConfigProto& cfg)
   auto global_jit_level =
       cfg.graph_options().optimizer_options().global_jit_level();
   xla_auto_clustering_on_ = IsXlaGlobalJitOn(global_jit_level);
+  graph_cache_ = OptimizedGraphCache::FromEnvironment();
+  absl::Status status = ReadInt64FromEnvVar(
+      kFunctionOptimizationThreadsEnvVar, /*default_val=*/1,
+      &num_function_optimization_threads_);
+  if (!status.ok()) {
+    LOG(WARNING) << "Optimizing functions serially: " << status;
+    num_function_optimization_threads_ = 1;
+  }
 }
 
 absl::Status MetaOptimizer::InitializeOptimizers(
@@ -888,8 +906,12 @@ absl::Status MetaOptimizer::OptimizeGraph(
                                      return result.status.ok();
                                    }) != optimization_result.results.end();
 
-  // Record graph optimization result.
-  optimization_results_.push_back(optimization_result);
+  // Record graph optimization result. Function bodies might be optimized
+  // concurrently.
+  {
+    mutex_lock l(optimization_results_mu_);
+    optimization_results_.push_back(optimization_result);
+  }
 
   if (is_optimized) {
     TF_RETURN_IF_ERROR(TopologicalSort(optimized_graph));
@@ -1057,7 +1079,30 @@ absl::Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster,
       {kGrapplerCategory, "*"});
 
   VLOG(1) << "Starting optimization for grappler item: " << item.id;
-  optimization_results_.clear();
+  {
+    mutex_lock l(optimization_results_mu_);
+    optimization_results_.clear();
+  }
+
+  // Reuse the result of an earlier identical optimization if there is one.
+  // The key has to be computed before the item is modified below.
+  std::string cache_key;
+  if (graph_cache_ != nullptr) {
+    absl::StatusOr<std::string> key =
+        OptimizedGraphCache::ComputeKey(item, config_proto_, cluster,
+                                        cpu_device_);
+    if (key.ok()) {
+      cache_key = *std::move(key);
+      if (graph_cache_->Lookup(cache_key, optimized_graph)) {
+        VLOG(1) << "Using cached optimized graph for grappler item: "
+                << item.id << " (key = " << cache_key << ")";
+        return absl::OkStatus();
+      }
+    } else {
+      VLOG(1) << "Not caching grappler item " << item.id << ": "
+              << key.status();
+    }
+  }
 
   // Constructs a FunctionLibraryDefinition with functions that are reachable
   // from the nodes of the graph.
@@ -1166,6 +1211,140 @@ absl::Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster,
   // True if this is a TPU graph using the old bridge.
   bool is_tpu_graph = IsLegacyTPUBridgeGraphDef(*optimized_graph);
 
+  // Optimizes the body of a function prepared in the loop below. Only reads
+  // `flib`, so it can run concurrently for several functions.
+  const auto optimize_function_body =
+      [&](GrapplerFunctionItem* func_item,
+          GraphDef* optimized_func_graph) -> absl::Status {
+    GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+    if (is_tpu_graph) {
+      // Skip optimizing functions if this is a TPU graph. Currently, Grappler
+      // passes do not handle TPU functions correctly in a variety of ways
+      // (Note that due to the pre-placement TPU graph rewriting passes, the
+      // TPU-related ops are encapsulated away into functions). For example,
+      // TPU graphs contain TPUReplicateMetadata node that carries relevant
+      // TPU metadata and Grappler passes could prune that away. Grappler
+      // passes could also cause issues around shape inference. Since the
+      // desired and existing behavior is to not optimize TPU functions with
+      // Grappler, this check preserves that. The only exception is
+      // implementation selector what is required to swap in some TPU specific
+      // lowering code and is verified the work correctly on TPUs.
+      ImplementationSelector implementation_selector;
+
+      // Implementation selector needs to have access to valid function
+      // signature and attributes, and it doesn't need actual function body.
+      std::unique_ptr<FunctionDefLibrary> func_item_function_library(
+          func_item->graph.release_library());
+      *func_item->graph.mutable_library() =
+          GetFunctionDefLibraryStub(*func_item_function_library);
+
+      return implementation_selector.Optimize(cluster, *func_item,
+                                              optimized_func_graph);
+    }
+    GrapplerFunctionItem func_item_copy = *func_item;
+    return OptimizeGraph(cluster, std::move(func_item_copy),
+                         optimized_func_graph);
+  };
+
+  // Replaces a function in `flib` with its optimized version. Functions are
+  // always finalized in library order, which keeps the result independent of
+  // how many threads optimized the function bodies.
+  const auto finalize_function =
+      [&](const string& func_name, GrapplerFunctionItem* func_item,
+          GraphDef* optimized_func_graph) -> absl::Status {
+    // Function body optimization might have created new specialized
+    // functions for each instantiation context. Add them to the library.
+    for (const FunctionDef& func_def :
+         optimized_func_graph->library().function()) {
+      if (flib.Find(func_def.signature().name()) == nullptr) {
+        TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
+      }
+    }
+
+    // Convert optimized graph back to FunctionDef.
+    FunctionDef optimized_func;
+    func_item->SwapFunctionBody(std::move(*optimized_func_graph));
+    TF_RETURN_IF_ERROR(MakeFunctionDef(*func_item, flib, &optimized_func));
+
+    // Replace optimized function with a new FunctionDef.
+    return flib.ReplaceFunction(func_name, optimized_func);
+  };
+
+  // With a thread pool, function bodies are optimized in batches of functions
+  // that don't call each other. Every function in a batch sees the same
+  // library it would see if the functions were optimized one at a time, so the
+  // results are identical to the serial ones.
+  std::unique_ptr<thread::ThreadPool> function_thread_pool;
+  if (num_function_optimization_threads_ > 1 &&
+      optimized_graph->library().function_size() > 1) {
+    function_thread_pool = std::make_unique<thread::ThreadPool>(
+        Env::Default(), "grappler_function_optimizer",
+        num_function_optimization_threads_);
+  }
+  struct PendingFunction {
+    string name;
+    GrapplerFunctionItem item;
+    GraphDef optimized_graph;
+    absl::Status status;
+  };
+  std::vector<PendingFunction> pending_funcs;
+  absl::flat_hash_set<string> pending_func_names;
+
+  const auto flush_pending_funcs = [&]() -> absl::Status {
+    if (pending_funcs.empty()) return absl::OkStatus();
+    size_t first_result;
+    {
+      mutex_lock l(optimization_results_mu_);
+      first_result = optimization_results_.size();
+    }
+
+    BlockingCounter counter(pending_funcs.size());
+    for (PendingFunction& pending : pending_funcs) {
+      function_thread_pool->Schedule([&, func = &pending]() {
+        func->status =
+            optimize_function_body(&func->item, &func->optimized_graph);
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+
+    // Record optimization results in library order, as the serial loop would.
+    absl::flat_hash_map<string, int> func_index;
+    for (int i = 0; i < pending_funcs.size(); ++i) {
+      func_index[pending_funcs[i].name] = i;
+    }
+    {
+      mutex_lock l(optimization_results_mu_);
+      std::stable_sort(optimization_results_.begin() + first_result,
+                       optimization_results_.end(),
+                       [&](const GraphOptimizationResult& a,
+                           const GraphOptimizationResult& b) {
+                         return func_index[a.id] < func_index[b.id];
+                       });
+    }
+
+    for (PendingFunction& pending : pending_funcs) {
+      TF_RETURN_IF_ERROR(pending.status);
+      TF_RETURN_IF_ERROR(finalize_function(pending.name, &pending.item,
+                                           &pending.optimized_graph));
+    }
+    pending_funcs.clear();
+    pending_func_names.clear();
+    return absl::OkStatus();
+  };
+
+  // Returns true if `func_item` calls, directly or not, a function that is
+  // waiting to be finalized; it then has to see the finalized version.
+  const auto calls_pending_func =
+      [&](const GrapplerFunctionItem& func_item) -> bool {
+    for (const FunctionDef& func_def : func_item.graph.library().function()) {
+      if (pending_func_names.contains(func_def.signature().name())) {
+        return true;
+      }
+    }
+    return false;
+  };
+
   // Optimize each function only once.
   absl::flat_hash_set<string> optimized_funcs;
   while (optimize_function_library) {
@@ -1207,6 +1386,11 @@ absl::Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster,
       GrapplerFunctionItem func_item;
       TF_RETURN_IF_ERROR(
           MakeGrapplerFunctionItem(func, flib, producer, &func_item));
+      if (calls_pending_func(func_item)) {
+        TF_RETURN_IF_ERROR(flush_pending_funcs());
+        TF_RETURN_IF_ERROR(
+            MakeGrapplerFunctionItem(func, flib, producer, &func_item));
+      }
 
       // If we need to compute the gradient of optimized function at runtime, we
       // can't perform non-differentiable rewrites.
@@ -1228,54 +1412,25 @@ absl::Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster,
       func_item.optimization_options().allow_pruning_stateful_and_dataset_ops =
           false;
 
-      // Optimize function body graph.
-      GraphDef optimized_func_graph;
-      if (is_tpu_graph) {
-        // Skip optimizing functions if this is a TPU graph. Currently, Grappler
-        // passes do not handle TPU functions correctly in a variety of ways
-        // (Note that due to the pre-placement TPU graph rewriting passes, the
-        // TPU-related ops are encapsulated away into functions). For example,
-        // TPU graphs contain TPUReplicateMetadata node that carries relevant
-        // TPU metadata and Grappler passes could prune that away. Grappler
-        // passes could also cause issues around shape inference. Since the
-        // desired and existing behavior is to not optimize TPU functions with
-        // Grappler, this check preserves that. The only exception is
-        // implementation selector what is required to swap in some TPU specific
-        // lowering code and is verified the work correctly on TPUs.
-        ImplementationSelector implementation_selector;
-
-        // Implementation selector needs to have access to valid function
-        // signature and attributes, and it doesn't need actual function body.
-        std::unique_ptr<FunctionDefLibrary> func_item_function_library(
-            func_item.graph.release_library());
-        *func_item.graph.mutable_library() =
-            GetFunctionDefLibraryStub(*func_item_function_library);
-
-        TF_RETURN_IF_ERROR(implementation_selector.Optimize(
-            cluster, func_item, &optimized_func_graph));
-      } else {
-        GrapplerFunctionItem func_item_copy = func_item;
-        TF_RETURN_IF_ERROR(OptimizeGraph(cluster, std::move(func_item_copy),
-                                         &optimized_func_graph));
-      }
-
-      // Function body optimization might have created new specialized
-      // functions for each instantiation context. Add them to the library.
-      for (const FunctionDef& func_def :
-           optimized_func_graph.library().function()) {
-        if (flib.Find(func_def.signature().name()) == nullptr) {
-          TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
+      if (function_thread_pool != nullptr) {
+        pending_func_names.insert(func_name);
+        pending_funcs.push_back({func_name, std::move(func_item)});
+        // Bound the number of function bodies held in memory at once.
+        if (pending_funcs.size() >=
+            4 * static_cast<size_t>(num_function_optimization_threads_)) {
+          TF_RETURN_IF_ERROR(flush_pending_funcs());
         }
+        continue;
       }
 
-      // Convert optimized graph back to FunctionDef.
-      FunctionDef optimized_func;
-      func_item.SwapFunctionBody(std::move(optimized_func_graph));
-      TF_RETURN_IF_ERROR(MakeFunctionDef(func_item, flib, &optimized_func));
-
-      // Replace optimized function with a new FunctionDef.
-      TF_RETURN_IF_ERROR(flib.ReplaceFunction(func_name, optimized_func));
+      // Optimize function body graph.
+      GraphDef optimized_func_graph;
+      TF_RETURN_IF_ERROR(
+          optimize_function_body(&func_item, &optimized_func_graph));
+      TF_RETURN_IF_ERROR(
+          finalize_function(func_name, &func_item, &optimized_func_graph));
     }
+    TF_RETURN_IF_ERROR(flush_pending_funcs());
 
     // If optimized at least one function, update the graph library.
     if (optimize_function_library) {
@@ -1318,11 +1473,31 @@ absl::Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster,
         *optimized_graph);
   }
 
+  // Don't cache graphs that some optimizer failed to process; the failure may
+  // be transient (e.g. a timeout) and would otherwise stick.
+  bool all_optimizers_succeeded = true;
+  {
+    mutex_lock l(optimization_results_mu_);
+    for (const GraphOptimizationResult& graph_result : optimization_results_) {
+      for (const OptimizerResult& result : graph_result.results) {
+        all_optimizers_succeeded &= result.status.ok();
+      }
+    }
+  }
+  if (!cache_key.empty() && all_optimizers_succeeded) {
+    absl::Status status = graph_cache_->Insert(cache_key, *optimized_graph);
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to cache the optimized graph for grappler item "
+                   << item.id << ": " << status;
+    }
+  }
+
   return absl::OkStatus();
 }
 
 string MetaOptimizer::GetResultString() const {
   std::string result_string;
+  mutex_lock l(optimization_results_mu_);
   for (const GraphOptimizationResult& graph_result : optimization_results_) {
     absl::StrAppend(&result_string,
                     "Optimization results for grappler item: ", graph_result.id,
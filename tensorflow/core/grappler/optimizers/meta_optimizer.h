@@ -22,8 +22,11 @@ limitations under the License.
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/optimized_graph_cache.h"
 #include "tensorflow/core/grappler/verifiers/graph_verifier.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
 #include "tensorflow/core/protobuf/verifier_config.pb.h"
@@ -101,6 +104,13 @@ class MetaOptimizer : public GraphOptimizer {
   ConfigProto config_proto_;
   RewriterConfig& cfg_;
   bool xla_auto_clustering_on_;
+  // Persistent cache of optimized graphs; null unless
+  // TF_GRAPPLER_OPTIMIZED_GRAPH_CACHE_DIR is set.
+  std::unique_ptr<OptimizedGraphCache> graph_cache_;
+  // Number of threads used to optimize the function library; set through
+  // TF_GRAPPLER_FUNCTION_OPTIMIZATION_THREADS. Functions are optimized
+  // serially if it is 1.
+  int64_t num_function_optimization_threads_ = 1;
 
   struct OptimizerResult {
     string optimizer_name;
@@ -119,7 +129,11 @@ class MetaOptimizer : public GraphOptimizer {
                             GraphDef* optimized_graph,
                             GraphOptimizationResult* optimization_result);
 
-  std::vector<GraphOptimizationResult> optimization_results_;
+  // Guards `optimization_results_` while function bodies are optimized in
+  // parallel.
+  mutable mutex optimization_results_mu_;
+  std::vector<GraphOptimizationResult> optimization_results_
+      TF_GUARDED_BY(optimization_results_mu_);
 };
 
 bool MetaOptimizerEnabled(const ConfigProto& cfg);
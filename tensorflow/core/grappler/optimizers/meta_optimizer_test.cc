@@ -17,7 +17,9 @@ limitations under the License.
 
 #include <atomic>
 
+#include "absl/cleanup/cleanup.h"
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/substitute.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/dataset.h"
@@ -32,8 +34,11 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/grappler_test.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 
 namespace tensorflow {
@@ -150,6 +155,92 @@ TEST_F(MetaOptimizerTest, RunsCustomOptimizer) {
   EXPECT_TRUE(TestOptimizer::IsOptimized());
 }
 
+TEST_F(MetaOptimizerTest, ReusesCachedOptimizedGraph) {
+  TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {kDevice});
+  GrapplerItem item;
+  ASSERT_TRUE(fake_input.NextItem(&item));
+
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config.add_optimizers("TestOptimizer");
+  rewriter_config.set_min_graph_nodes(-1);
+
+  const string cache_dir =
+      io::JoinPath(testing::TmpDir(), "meta_optimizer_graph_cache");
+  int64_t undeleted_files, undeleted_dirs;
+  Env::Default()
+      ->DeleteRecursively(cache_dir, &undeleted_files, &undeleted_dirs)
+      .IgnoreError();
+  setenv(kOptimizedGraphCacheDirEnvVar, cache_dir.c_str(), 1);
+  absl::Cleanup unset_cache_dir = [] {
+    unsetenv(kOptimizedGraphCacheDirEnvVar);
+  };
+
+  TestOptimizer::SetOptimized(false);
+  GraphDef output;
+  {
+    MetaOptimizer optimizer(nullptr, config_proto);
+    TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  }
+  EXPECT_TRUE(TestOptimizer::IsOptimized());
+
+  // A second optimizer, e.g. in a later process, is served from the cache.
+  TestOptimizer::SetOptimized(false);
+  GraphDef cached_output;
+  {
+    MetaOptimizer optimizer(nullptr, config_proto);
+    TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &cached_output));
+  }
+  EXPECT_FALSE(TestOptimizer::IsOptimized());
+  CompareGraphs(output, cached_output);
+}
+
+class FailingTestOptimizer : public TestOptimizer {
+ public:
+  string name() const override { return "failing_test_optimizer"; }
+
+  absl::Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                        GraphDef* optimized_graph) override {
+    return errors::Unavailable("FailingTestOptimizer always fails");
+  }
+};
+
+REGISTER_GRAPH_OPTIMIZER(FailingTestOptimizer);
+
+TEST_F(MetaOptimizerTest, DoesNotCacheGraphsAfterOptimizerErrors) {
+  TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {kDevice});
+  GrapplerItem item;
+  ASSERT_TRUE(fake_input.NextItem(&item));
+
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config.add_optimizers("FailingTestOptimizer");
+  rewriter_config.add_optimizers("TestOptimizer");
+  rewriter_config.set_min_graph_nodes(-1);
+
+  const string cache_dir =
+      io::JoinPath(testing::TmpDir(), "meta_optimizer_failure_graph_cache");
+  int64_t undeleted_files, undeleted_dirs;
+  Env::Default()
+      ->DeleteRecursively(cache_dir, &undeleted_files, &undeleted_dirs)
+      .IgnoreError();
+  setenv(kOptimizedGraphCacheDirEnvVar, cache_dir.c_str(), 1);
+  absl::Cleanup unset_cache_dir = [] {
+    unsetenv(kOptimizedGraphCacheDirEnvVar);
+  };
+
+  // The failure is not fatal, but the result must not be reused.
+  for (int i = 0; i < 2; ++i) {
+    TestOptimizer::SetOptimized(false);
+    GraphDef output;
+    MetaOptimizer optimizer(nullptr, config_proto);
+    TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+    EXPECT_TRUE(TestOptimizer::IsOptimized()) << "run " << i;
+  }
+}
+
 TEST_F(MetaOptimizerTest, RunsCustomOptimizerWithParams) {
   TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {kDevice});
   GrapplerItem item;
@@ -703,6 +794,85 @@ TEST_F(MetaOptimizerTest, OptimizeFunctionLibraryWithRestrictions) {
       optimization_options_my_mul_2->allow_non_differentiable_rewrites);
 }
 
+// Builds a graph that calls each of 'num_functions' functions from the main
+// graph. Every function scales its input by a constant, and all but every
+// fourth one also call the previous function, so the library has both
+// independent functions and call chains.
+GrapplerItem MakeManyFunctionsItem(int num_functions) {
+  using test::function::NDef;
+
+  std::vector<FunctionDef> functions;
+  std::vector<NodeDef> nodes = {
+      NDef("x", "Placeholder", {}, {{"dtype", DT_FLOAT}}, kDevice)};
+  for (int i = 0; i < num_functions; ++i) {
+    const string name = absl::StrCat("MyFunc", i);
+    std::vector<FunctionDefHelper::Node> body = {
+        FunctionDefHelper::Const("two", 2.0f),
+        {{"scaled"}, "Mul", {"x", "two:output:0"}, {{"T", DT_FLOAT}}},
+        {{"scaled_twice"},
+         "Mul",
+         {"scaled:z:0", "two:output:0"},
+         {{"T", DT_FLOAT}}}};
+    string ret = "scaled_twice:z:0";
+    if (i % 4 != 0) {
+      body.push_back({{"call"},
+                      absl::StrCat("MyFunc", i - 1),
+                      {"scaled_twice:z:0"},
+                      {}});
+      ret = "call:z:0";
+    }
+    FunctionDef func = FunctionDefHelper::Create(
+        name, {"x:float"}, {"z:float"}, {}, body, {{"z", ret}});
+    (*func.mutable_attr())["_noinline"].set_b(true);
+    functions.push_back(std::move(func));
+
+    nodes.push_back(NDef(absl::StrCat("call_", i), name, {"x"}, {}, kDevice));
+  }
+
+  GrapplerItem item;
+  item.id = "tf_graph";
+  item.graph = test::function::GDef(nodes, functions);
+  for (int i = 0; i < num_functions; ++i) {
+    item.fetch.push_back(absl::StrCat("call_", i));
+  }
+  return item;
+}
+
+// Optimizes 'item' using 'num_threads' threads for the function library.
+GraphDef OptimizeWithFunctionThreads(const GrapplerItem& item,
+                                     int num_threads) {
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config.set_min_graph_nodes(-1);
+
+  setenv("TF_GRAPPLER_FUNCTION_OPTIMIZATION_THREADS",
+         absl::StrCat(num_threads).c_str(), 1);
+  MetaOptimizer optimizer(nullptr, config_proto);
+  unsetenv("TF_GRAPPLER_FUNCTION_OPTIMIZATION_THREADS");
+
+  GraphDef output;
+  TF_CHECK_OK(optimizer.Optimize(nullptr, item, &output));
+  return output;
+}
+
+TEST_F(MetaOptimizerTest, ParallelFunctionLibraryOptimizationMatchesSerial) {
+  const GrapplerItem item = MakeManyFunctionsItem(32);
+  const GraphDef serial = OptimizeWithFunctionThreads(item, 1);
+  EXPECT_GT(serial.library().function_size(), 32);
+
+  string serial_serialized;
+  ASSERT_TRUE(SerializeToStringDeterministic(serial, &serial_serialized));
+  for (int num_threads : {2, 4, 8}) {
+    const GraphDef parallel = OptimizeWithFunctionThreads(item, num_threads);
+    string parallel_serialized;
+    ASSERT_TRUE(
+        SerializeToStringDeterministic(parallel, &parallel_serialized));
+    EXPECT_EQ(serial_serialized, parallel_serialized)
+        << "num_threads = " << num_threads;
+  }
+}
+
 class SleepingOptimizer : public CustomGraphOptimizer {
  public:
   SleepingOptimizer() {}
@@ -1412,6 +1582,24 @@ INSTANTIATE_TEST_SUITE_P(
       return test_name;
     });
 
+static void BM_OptimizeFunctionLibrary(::testing::benchmark::State& state) {
+  const int num_functions = state.range(0);
+  const int num_threads = state.range(1);
+  const GrapplerItem item = MakeManyFunctionsItem(num_functions);
+
+  for (auto s : state) {
+    GraphDef output = OptimizeWithFunctionThreads(item, num_threads);
+    testing::DoNotOptimize(output);
+  }
+}
+BENCHMARK(BM_OptimizeFunctionLibrary)
+    ->UseRealTime()
+    ->ArgPair(100, 1)
+    ->ArgPair(100, 8)
+    ->ArgPair(1000, 1)
+    ->ArgPair(1000, 8)
+    ->ArgPair(1000, 32);
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
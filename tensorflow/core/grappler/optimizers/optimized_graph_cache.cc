@@ -0,0 +1,191 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/optimized_graph_cache.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/public/version.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kEntrySuffix[] = ".graphdef";
+
+// Appends 'values' to 'key' in a canonical order.
+template <typename Container>
+void AppendSorted(const Container& values, std::string* key) {
+  std::vector<std::string> sorted(values.begin(), values.end());
+  std::sort(sorted.begin(), sorted.end());
+  absl::StrAppend(key, sorted.size(), ";");
+  for (const std::string& value : sorted) {
+    absl::StrAppend(key, value.size(), ":", value, ";");
+  }
+}
+
+absl::Status AppendProto(const protobuf::MessageLite& proto,
+                         std::string* key) {
+  std::string serialized;
+  if (!SerializeToStringDeterministic(proto, &serialized)) {
+    return errors::Internal("Failed to serialize ", proto.GetTypeName(),
+                            " for the optimized graph cache key.");
+  }
+  absl::StrAppend(key, serialized.size(), ":", serialized, ";");
+  return absl::OkStatus();
+}
+
+std::string HexFingerprint(const Fprint128& fingerprint) {
+  return absl::StrCat(absl::Hex(fingerprint.high64, absl::kZeroPad16),
+                      absl::Hex(fingerprint.low64, absl::kZeroPad16));
+}
+
+}  // namespace
+
+OptimizedGraphCache::OptimizedGraphCache(std::string directory, Env* env)
+    : directory_(std::move(directory)), env_(env) {}
+
+std::unique_ptr<OptimizedGraphCache> OptimizedGraphCache::FromEnvironment() {
+  std::string directory;
+  absl::Status status =
+      ReadStringFromEnvVar(kOptimizedGraphCacheDirEnvVar, "", &directory);
+  if (!status.ok() || directory.empty()) return nullptr;
+  return std::make_unique<OptimizedGraphCache>(std::move(directory));
+}
+
+absl::StatusOr<std::string> OptimizedGraphCache::ComputeKey(
+    const GrapplerItem& item, const ConfigProto& config,
+    const Cluster* cluster, const DeviceBase* cpu_device) {
+  // The graph dominates the size of the key material, so it is fingerprinted
+  // on its own rather than copied into 'key'.
+  std::string graph;
+  if (!SerializeToStringDeterministic(item.graph, &graph)) {
+    return errors::Internal("Failed to serialize the graph of item ", item.id,
+                            " for the optimized graph cache key.");
+  }
+  const Fprint128 graph_fingerprint = Fingerprint128(graph);
+  graph.clear();
+
+  std::string key = absl::StrCat(TF_VERSION_STRING, ";", TF_GRAPH_DEF_VERSION,
+                                 ";");
+  AppendSorted(item.fetch, &key);
+  AppendSorted(item.keep_ops, &key);
+  AppendSorted(item.init_ops, &key);
+  AppendSorted(item.devices(), &key);
+  absl::StrAppend(&key, item.feed.size(), ";");
+  for (const auto& feed : item.feed) {
+    absl::StrAppend(&key, feed.first, ";");
+    TensorProto value;
+    feed.second.AsProtoTensorContent(&value);
+    TF_RETURN_IF_ERROR(AppendProto(value, &key));
+  }
+
+  const GrapplerItem::OptimizationOptions& options =
+      item.optimization_options();
+  absl::StrAppend(&key, options.allow_non_differentiable_rewrites, ",",
+                  options.allow_pruning_stateful_and_dataset_ops, ",",
+                  options.optimize_function_library, ",",
+                  options.is_eager_mode, ",",
+                  options.intra_op_parallelism_threads, ";");
+
+  TF_RETURN_IF_ERROR(
+      AppendProto(config.graph_options().rewrite_options(), &key));
+  absl::StrAppend(
+      &key,
+      static_cast<int>(
+          config.graph_options().optimizer_options().global_jit_level()),
+      ";");
+  // Several optimizers are skipped or configured differently under TFRT and
+  // for particular executors.
+  absl::StrAppend(&key, config.experimental().use_tfrt(), ",",
+                  config.experimental().executor_type(), ";");
+  // Constant folding evaluates nodes on the caller's CPU device if there is
+  // one, and creates its own otherwise.
+  absl::StrAppend(&key, cpu_device != nullptr, ";");
+
+  if (cluster != nullptr) {
+    // Order the devices by name; the cluster keeps them in a hash map.
+    std::map<std::string, const DeviceProperties*> devices;
+    for (const auto& device : cluster->GetDevices()) {
+      devices.emplace(device.first, &device.second);
+    }
+    absl::StrAppend(&key, devices.size(), ";");
+    for (const auto& device : devices) {
+      absl::StrAppend(&key, device.first, ";");
+      TF_RETURN_IF_ERROR(AppendProto(*device.second, &key));
+    }
+  }
+
+  return absl::StrCat(HexFingerprint(graph_fingerprint),
+                      HexFingerprint(Fingerprint128(key)));
+}
+
+std::string OptimizedGraphCache::EntryPath(const std::string& key) const {
+  return io::JoinPath(directory_, absl::StrCat(key, kEntrySuffix));
+}
+
+bool OptimizedGraphCache::Lookup(const std::string& key,
+                                 GraphDef* optimized_graph) const {
+  const std::string path = EntryPath(key);
+  if (!env_->FileExists(path).ok()) return false;
+  absl::Status status = ReadBinaryProto(env_, path, optimized_graph);
+  if (!status.ok()) {
+    LOG(WARNING) << "Ignoring unreadable optimized graph cache entry " << path
+                 << ": " << status;
+    optimized_graph->Clear();
+    return false;
+  }
+  return true;
+}
+
+absl::Status OptimizedGraphCache::Insert(
+    const std::string& key, const GraphDef& optimized_graph) const {
+  TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(directory_));
+  const std::string path = EntryPath(key);
+  // Write to a unique temporary file first so that concurrent readers never
+  // observe a partially written entry.
+  std::string temp_path = path;
+  if (!env_->CreateUniqueFileName(&temp_path, ".tmp")) {
+    return errors::Internal("Failed to create a temporary file name for ",
+                            path);
+  }
+  absl::Status status = WriteBinaryProto(env_, temp_path, optimized_graph);
+  if (status.ok()) {
+    status = env_->RenameFile(temp_path, path);
+  }
+  if (!status.ok()) {
+    env_->DeleteFile(temp_path).IgnoreError();
+  }
+  return status;
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,88 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_OPTIMIZED_GRAPH_CACHE_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_OPTIMIZED_GRAPH_CACHE_H_
+
+#include <memory>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Environment variable naming the directory of the persistent cache used by
+// the meta optimizer. The cache is disabled when it is unset or empty.
+inline constexpr char kOptimizedGraphCacheDirEnvVar[] =
+    "TF_GRAPPLER_OPTIMIZED_GRAPH_CACHE_DIR";
+
+// An on-disk cache of meta optimizer results, so that a process that optimizes
+// the same graph with the same configuration as an earlier one can skip
+// Grappler entirely.
+//
+// Each entry is the optimized GraphDef, including its function library, stored
+// in its own file named after the key. Entries are written to a temporary file
+// and then renamed into place, so several processes can share a directory.
+//
+// Keys cover everything the meta optimizer reads: the graph and its library,
+// the GrapplerItem fetch/feed/keep/device sets and optimization options, the
+// RewriterConfig, XLA JIT level and runtime (TFRT, executor type), whether a
+// CPU device is available for constant folding, the devices of the cluster,
+// and the TensorFlow version. They do not cover the code of custom or plugin
+// optimizers; clear the directory when those change.
+class OptimizedGraphCache {
+ public:
+  explicit OptimizedGraphCache(std::string directory,
+                               Env* env = Env::Default());
+
+  // Returns a cache rooted at $TF_GRAPPLER_OPTIMIZED_GRAPH_CACHE_DIR, or null
+  // if the variable is not set.
+  static std::unique_ptr<OptimizedGraphCache> FromEnvironment();
+
+  // Computes the cache key for optimizing 'item' with 'config' on 'cluster',
+  // using 'cpu_device' for constant folding. Both of these may be null.
+  static absl::StatusOr<std::string> ComputeKey(
+      const GrapplerItem& item, const ConfigProto& config,
+      const Cluster* cluster, const DeviceBase* cpu_device = nullptr);
+
+  // Returns true and fills 'optimized_graph' if there is a valid entry for
+  // 'key'. Unreadable entries are treated as misses.
+  bool Lookup(const std::string& key, GraphDef* optimized_graph) const;
+
+  // Stores 'optimized_graph' under 'key', replacing any existing entry.
+  absl::Status Insert(const std::string& key,
+                      const GraphDef& optimized_graph) const;
+
+  const std::string& directory() const { return directory_; }
+
+ private:
+  std::string EntryPath(const std::string& key) const;
+
+  const std::string directory_;
+  Env* const env_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_OPTIMIZED_GRAPH_CACHE_H_
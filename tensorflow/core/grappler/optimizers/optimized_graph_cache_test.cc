@@ -0,0 +1,169 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/optimized_graph_cache.h"
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/grappler/clusters/virtual_cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/inputs/trivial_test_graph_input_yielder.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/protobuf/device_properties.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kDevice[] = "/device:CPU:0";
+
+class OptimizedGraphCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {kDevice});
+    ASSERT_TRUE(fake_input.NextItem(&item_));
+  }
+
+  std::string Key(const GrapplerItem& item, const ConfigProto& config,
+                  const Cluster* cluster = nullptr,
+                  const DeviceBase* cpu_device = nullptr) {
+    absl::StatusOr<std::string> key =
+        OptimizedGraphCache::ComputeKey(item, config, cluster, cpu_device);
+    TF_CHECK_OK(key.status());
+    return *key;
+  }
+
+  std::string CacheDir(const std::string& name) {
+    return io::JoinPath(testing::TmpDir(), "optimized_graph_cache", name);
+  }
+
+  GrapplerItem item_;
+};
+
+TEST_F(OptimizedGraphCacheTest, KeyIsStable) {
+  ConfigProto config;
+  GrapplerItem copy = item_;
+  copy.id = "another_id";
+  EXPECT_EQ(Key(item_, config), Key(copy, config));
+}
+
+TEST_F(OptimizedGraphCacheTest, KeyCoversGraph) {
+  ConfigProto config;
+  GrapplerItem modified = item_;
+  modified.graph.mutable_node(0)->set_device("/device:CPU:1");
+  EXPECT_NE(Key(item_, config), Key(modified, config));
+}
+
+TEST_F(OptimizedGraphCacheTest, KeyCoversItemConstraints) {
+  ConfigProto config;
+  GrapplerItem modified = item_;
+  modified.fetch.push_back(item_.graph.node(0).name());
+  EXPECT_NE(Key(item_, config), Key(modified, config));
+
+  modified = item_;
+  modified.optimization_options().allow_non_differentiable_rewrites = false;
+  EXPECT_NE(Key(item_, config), Key(modified, config));
+
+  modified = item_;
+  TF_ASSERT_OK(modified.AddDevice("/job:localhost/replica:0/task:0/cpu:1"));
+  EXPECT_NE(Key(item_, config), Key(modified, config));
+}
+
+TEST_F(OptimizedGraphCacheTest, KeyCoversRewriterConfig) {
+  ConfigProto config;
+  ConfigProto modified;
+  auto& rewriter_config =
+      *modified.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config.set_min_graph_nodes(-1);
+  EXPECT_NE(Key(item_, config), Key(item_, modified));
+}
+
+TEST_F(OptimizedGraphCacheTest, KeyCoversRuntime) {
+  ConfigProto config;
+  ConfigProto tfrt;
+  tfrt.mutable_experimental()->set_use_tfrt(true);
+  EXPECT_NE(Key(item_, config), Key(item_, tfrt));
+
+  ConfigProto single_threaded;
+  single_threaded.mutable_experimental()->set_executor_type(
+      "SINGLE_THREADED_EXECUTOR");
+  EXPECT_NE(Key(item_, config), Key(item_, single_threaded));
+
+  DeviceBase cpu_device(Env::Default());
+  EXPECT_NE(Key(item_, config), Key(item_, config, nullptr, &cpu_device));
+}
+
+TEST_F(OptimizedGraphCacheTest, KeyCoversClusterDevices) {
+  ConfigProto config;
+  DeviceProperties cpu;
+  cpu.set_type("CPU");
+  VirtualCluster one_cpu({{kDevice, cpu}});
+  VirtualCluster two_cpus({{kDevice, cpu}, {"/device:CPU:1", cpu}});
+  cpu.set_num_cores(64);
+  VirtualCluster big_cpu({{kDevice, cpu}});
+
+  EXPECT_EQ(Key(item_, config, &one_cpu), Key(item_, config, &one_cpu));
+  EXPECT_NE(Key(item_, config, &one_cpu), Key(item_, config, &two_cpus));
+  EXPECT_NE(Key(item_, config, &one_cpu), Key(item_, config, &big_cpu));
+  EXPECT_NE(Key(item_, config, &one_cpu), Key(item_, config));
+}
+
+TEST_F(OptimizedGraphCacheTest, InsertAndLookup) {
+  OptimizedGraphCache cache(CacheDir("insert_and_lookup"));
+  const std::string key = Key(item_, ConfigProto());
+
+  GraphDef graph;
+  EXPECT_FALSE(cache.Lookup(key, &graph));
+
+  TF_ASSERT_OK(cache.Insert(key, item_.graph));
+  ASSERT_TRUE(cache.Lookup(key, &graph));
+  EXPECT_EQ(graph.SerializeAsString(), item_.graph.SerializeAsString());
+
+  // Another cache over the same directory, e.g. in a later process, sees the
+  // entry too.
+  OptimizedGraphCache other(CacheDir("insert_and_lookup"));
+  graph.Clear();
+  ASSERT_TRUE(other.Lookup(key, &graph));
+  EXPECT_EQ(graph.node_size(), item_.graph.node_size());
+}
+
+TEST_F(OptimizedGraphCacheTest, IgnoresCorruptEntries) {
+  const std::string dir = CacheDir("corrupt");
+  OptimizedGraphCache cache(dir);
+  const std::string key = Key(item_, ConfigProto());
+  TF_ASSERT_OK(cache.Insert(key, item_.graph));
+
+  std::vector<std::string> entries;
+  TF_ASSERT_OK(Env::Default()->GetChildren(dir, &entries));
+  ASSERT_EQ(entries.size(), 1);
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(),
+                                 io::JoinPath(dir, entries[0]),
+                                 "not a GraphDef"));
+
+  GraphDef graph;
+  EXPECT_FALSE(cache.Lookup(key, &graph));
+  EXPECT_EQ(graph.node_size(), 0);
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
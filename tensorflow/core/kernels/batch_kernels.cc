@@ -23,6 +23,7 @@ limitations under the License.
 #include <utility>
 
 #include "absl/status/status.h"
+#include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
@@ -122,6 +123,14 @@ int32 NumBatchThreadsFromEnvironmentWithDefault(int default_num_batch_threads) {
                                                    : default_num_batch_threads;
 }
 
+// Returns true if the TF_BATCHING_POOLED_CONCAT_BUFFERS environment variable
+// requests concatenating batched inputs into pooled buffers.
+bool PooledConcatBuffersFromEnvironment() {
+  const char* val = std::getenv("TF_BATCHING_POOLED_CONCAT_BUFFERS");
+  bool enabled = false;
+  return val && absl::SimpleAtob(val, &enabled) && enabled;
+}
+
 static thread::ThreadPool* GetOrCreateBatchThreadsPool() {
   static thread::ThreadPool* shared_thread_pool = [&]() -> thread::ThreadPool* {
     serving::BoundedExecutor::Options options;
@@ -423,6 +432,8 @@ void BatchFunctionKernel::ComputeAsync(OpKernelContext* c, DoneCallback done) {
       if (session_metadata) {
         new_resource->set_session_metadata(*session_metadata);
       }
+      new_resource->set_enable_pooled_concat_buffers(
+          PooledConcatBuffersFromEnvironment());
       *r = new_resource.release();
       return absl::OkStatus();
     };
@@ -445,6 +456,8 @@ void BatchFunctionKernel::ComputeAsync(OpKernelContext* c, DoneCallback done) {
       if (session_metadata) {
         new_resource->set_session_metadata(*session_metadata);
       }
+      new_resource->set_enable_pooled_concat_buffers(
+          PooledConcatBuffersFromEnvironment());
       *r = new_resource.release();
       return absl::OkStatus();
     };
@@ -686,6 +699,8 @@ class BatchKernel : public AsyncOpKernel {
               /*has_process_batch_function=*/false, num_batch_threads_,
               max_batch_size_, batch_timeout_micros_, max_enqueued_batches_,
               allowed_batch_sizes_, false, &new_resource));
+          new_resource->set_enable_pooled_concat_buffers(
+              PooledConcatBuffersFromEnvironment());
           *r = new_resource.release();
           return absl::OkStatus();
         };
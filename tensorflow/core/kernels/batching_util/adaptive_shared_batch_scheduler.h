@@ -26,6 +26,7 @@ limitations under the License.
 
 #include "absl/types/optional.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
+#include "tensorflow/core/kernels/batching_util/batching_params_controller.h"
 #include "tensorflow/core/kernels/batching_util/periodic_function.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -172,6 +173,15 @@ class AdaptiveSharedBatchScheduler
 
     // If true, the padding will not be appended.
     bool disable_padding = false;
+
+    // If `learned_params.target_p99_latency_micros` is positive, the batch
+    // size and batch timeout of the queue are learned online by a
+    // BatchingParamsController, which maximizes throughput under that p99
+    // latency target; `max_batch_size` and `batch_timeout_micros` then only
+    // act as upper bounds. The controller's `max_batch_size`,
+    // `max_batch_timeout_micros` and `num_batch_threads` are filled in from
+    // these queue options and the scheduler options.
+    BatchingParamsController::Options learned_params;
   };
 
   using BatchProcessor = std::function<void(std::unique_ptr<Batch<TaskType>>)>;
@@ -302,7 +312,8 @@ class ASBSQueue : public BatchScheduler<TaskType> {
       typename AdaptiveSharedBatchScheduler<TaskType>::QueueOptions;
 
   ASBSQueue(std::shared_ptr<AdaptiveSharedBatchScheduler<TaskType>> scheduler,
-            const QueueOptions& options);
+            const QueueOptions& options,
+            std::shared_ptr<BatchingParamsController> params_controller);
 
   ~ASBSQueue() override;
 
@@ -323,7 +334,24 @@ class ASBSQueue : public BatchScheduler<TaskType> {
 
   size_t max_task_size() const override { return options_.max_batch_size; }
 
+  // Null unless the batching parameters are learned.
+  BatchingParamsController* params_controller() const {
+    return params_controller_.get();
+  }
+
  private:
+  // The size at which batches are closed.
+  int BatchSizeLimit() const {
+    return params_controller_ ? params_controller_->batch_size()
+                              : options_.max_batch_size;
+  }
+
+  // How long non-full batches wait before becoming schedulable.
+  int64_t BatchTimeoutMicros() const {
+    return params_controller_ ? params_controller_->batch_timeout_micros()
+                              : options_.batch_timeout_micros;
+  }
+
   // Number of size 1 tasks which could currently be scheduled without failing.
   size_t SchedulingCapacityLocked() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
@@ -333,6 +361,9 @@ class ASBSQueue : public BatchScheduler<TaskType> {
 
   std::shared_ptr<AdaptiveSharedBatchScheduler<TaskType>> scheduler_;
   const QueueOptions options_;
+  // Shared with the batches of this queue, which report their processing
+  // latency to it after the queue may be gone.
+  const std::shared_ptr<BatchingParamsController> params_controller_;
   // Owned by scheduler_.
   ASBSBatch<TaskType>* current_batch_ TF_GUARDED_BY(mu_) = nullptr;
   int64_t num_enqueued_batches_ TF_GUARDED_BY(mu_) = 0;
@@ -347,11 +378,14 @@ template <typename TaskType>
 class ASBSBatch : public Batch<TaskType> {
  public:
   ASBSBatch(ASBSQueue<TaskType>* queue, int64_t creation_time_micros,
-            int64_t batch_timeout_micros, uint64 traceme_context_id)
+            int64_t batch_timeout_micros, uint64 traceme_context_id,
+            std::shared_ptr<BatchingParamsController> params_controller =
+                nullptr)
       : queue_(queue),
         creation_time_micros_(creation_time_micros),
         schedulable_time_micros_(creation_time_micros + batch_timeout_micros),
-        traceme_context_id_(traceme_context_id) {}
+        traceme_context_id_(traceme_context_id),
+        params_controller_(std::move(params_controller)) {}
 
   ~ASBSBatch() override {}
 
@@ -363,11 +397,16 @@ class ASBSBatch : public Batch<TaskType> {
 
   uint64 traceme_context_id() const { return traceme_context_id_; }
 
+  const std::shared_ptr<BatchingParamsController>& params_controller() const {
+    return params_controller_;
+  }
+
  private:
   ASBSQueue<TaskType>* queue_;
   const int64_t creation_time_micros_;
   const int64_t schedulable_time_micros_;
   const uint64 traceme_context_id_;
+  const std::shared_ptr<BatchingParamsController> params_controller_;
   ASBSBatch(const ASBSBatch&) = delete;
   void operator=(const ASBSBatch&) = delete;
 };
@@ -468,9 +507,22 @@ absl::Status AdaptiveSharedBatchScheduler<TaskType>::AddQueue(
           options.max_batch_size);
     }
   }
+  std::shared_ptr<BatchingParamsController> params_controller;
+  if (options.learned_params.target_p99_latency_micros > 0) {
+    BatchingParamsController::Options controller_options =
+        options.learned_params;
+    controller_options.max_batch_size = options.max_batch_size;
+    controller_options.max_batch_timeout_micros = options.batch_timeout_micros;
+    controller_options.num_batch_threads = options_.num_batch_threads;
+    std::unique_ptr<BatchingParamsController> controller;
+    TF_RETURN_IF_ERROR(
+        BatchingParamsController::Create(controller_options, &controller));
+    params_controller = std::move(controller);
+  }
   internal::ASBSQueue<TaskType>* asbs_queue_raw;
   queue->reset(asbs_queue_raw = new internal::ASBSQueue<TaskType>(
-                   this->shared_from_this(), options));
+                   this->shared_from_this(), options,
+                   std::move(params_controller)));
   mutex_lock l(mu_);
   queues_and_callbacks_[asbs_queue_raw] = process_batch_callback;
   return absl::OkStatus();
@@ -643,9 +695,19 @@ void AdaptiveSharedBatchScheduler<TaskType>::CallbackWrapper(
       tsl::profiler::ContextType::kAdaptiveSharedBatchScheduler,
       batch->traceme_context_id());
   const int64_t start_time = batch->creation_time_micros();
+  // The batch is destroyed by the callback; keep what is needed to report its
+  // processing latency.
+  const std::shared_ptr<BatchingParamsController> params_controller =
+      batch->params_controller();
+  const int64_t batch_size = batch->size();
+  const int64_t processing_start_time = GetEnv()->NowMicros();
   callback(std::unique_ptr<Batch<TaskType>>(
       const_cast<internal::ASBSBatch<TaskType>*>(batch)));
   int64_t end_time = GetEnv()->NowMicros();
+  if (params_controller != nullptr) {
+    params_controller->RecordBatchProcessed(batch_size,
+                                            end_time - processing_start_time);
+  }
   mutex_lock l(mu_);
   if (is_express) {
     in_flight_express_batches_--;
@@ -710,8 +772,11 @@ namespace internal {
 template <typename TaskType>
 ASBSQueue<TaskType>::ASBSQueue(
     std::shared_ptr<AdaptiveSharedBatchScheduler<TaskType>> scheduler,
-    const QueueOptions& options)
-    : scheduler_(scheduler), options_(options) {}
+    const QueueOptions& options,
+    std::shared_ptr<BatchingParamsController> params_controller)
+    : scheduler_(scheduler),
+      options_(options),
+      params_controller_(std::move(params_controller)) {}
 
 template <typename TaskType>
 ASBSQueue<TaskType>::~ASBSQueue() {
@@ -745,6 +810,10 @@ absl::Status ASBSQueue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
                                    options_.max_input_task_size.value());
   }
 
+  if (params_controller_ != nullptr) {
+    params_controller_->RecordArrival(size, scheduler_->GetEnv()->NowMicros());
+  }
+
   std::vector<std::unique_ptr<TaskType>> tasks_to_schedule;
   std::vector<ASBSBatch<TaskType>*> new_batches;
   bool closed_batch = false;
@@ -754,10 +823,17 @@ absl::Status ASBSQueue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
       return errors::Unavailable("The batch scheduling queue is full");
     }
 
+    const int batch_size_limit = BatchSizeLimit();
+    // A learned batch size may have shrunk below the size of the open batch.
+    if (current_batch_ && current_batch_->size() >= batch_size_limit) {
+      current_batch_->Close();
+      closed_batch = true;
+      current_batch_ = nullptr;
+    }
     int remaining_batch_size =
         current_batch_ == nullptr
-            ? options_.max_batch_size
-            : options_.max_batch_size - current_batch_->size();
+            ? batch_size_limit
+            : batch_size_limit - current_batch_->size();
     if (options_.split_input_task_func == nullptr ||
         size <= remaining_batch_size) {
       // Either we don't allow task splitting or task fits within the current
@@ -768,13 +844,12 @@ absl::Status ASBSQueue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
       // Beyond this point Schedule should not fail, as the caller has been
       // promised that all of the split tasks will be scheduled.
       TF_RETURN_IF_ERROR(options_.split_input_task_func(
-          task, remaining_batch_size, options_.max_batch_size,
-          &tasks_to_schedule));
+          task, remaining_batch_size, batch_size_limit, &tasks_to_schedule));
     }
     for (auto& task : tasks_to_schedule) {
       // Can't fit within current batch, close it off and try to create another.
       if (current_batch_ &&
-          current_batch_->size() + task->size() > options_.max_batch_size) {
+          current_batch_->size() + task->size() > batch_size_limit) {
         current_batch_->Close();
         closed_batch = true;
         current_batch_ = nullptr;
@@ -786,8 +861,8 @@ absl::Status ASBSQueue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
         // When multiple calls to "ASBS::Schedule" accumulate to one batch, they
         // are processed in the same batch and should share traceme_context_id.
         current_batch_ = new ASBSBatch<TaskType>(
-            this, scheduler_->GetEnv()->NowMicros(),
-            options_.batch_timeout_micros, NewTraceMeContextIdForBatch());
+            this, scheduler_->GetEnv()->NowMicros(), BatchTimeoutMicros(),
+            NewTraceMeContextIdForBatch(), params_controller_);
         new_batches.push_back(current_batch_);
       }
 
@@ -807,8 +882,7 @@ absl::Status ASBSQueue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
       bool reached_max_tasks =
           (options_.max_tasks_per_batch.has_value() &&
            current_batch_->num_tasks() >= options_.max_tasks_per_batch.value());
-      if (current_batch_->size() == options_.max_batch_size ||
-          reached_max_tasks) {
+      if (current_batch_->size() >= batch_size_limit || reached_max_tasks) {
         current_batch_->Close();
         closed_batch = true;
         current_batch_ = nullptr;
@@ -851,11 +925,17 @@ size_t ASBSQueue<TaskType>::SchedulingCapacity() const {
 
 template <typename TaskType>
 size_t ASBSQueue<TaskType>::SchedulingCapacityLocked() const {
-  const int current_batch_capacity =
-      current_batch_ ? options_.max_batch_size - current_batch_->size() : 0;
-  const int spare_batches =
-      options_.max_enqueued_batches - num_enqueued_batches_;
-  return spare_batches * options_.max_batch_size + current_batch_capacity;
+  const int64_t batch_size_limit = BatchSizeLimit();
+  // The learned batch size may drop below the size of the open batch, and the
+  // queue may briefly hold more than max_enqueued_batches, so clamp both terms.
+  const int64_t current_batch_capacity =
+      current_batch_ ? std::max<int64_t>(
+                           0, batch_size_limit -
+                                  static_cast<int64_t>(current_batch_->size()))
+                     : 0;
+  const int64_t spare_batches = std::max<int64_t>(
+      0, options_.max_enqueued_batches - num_enqueued_batches_);
+  return spare_batches * batch_size_limit + current_batch_capacity;
 }
 
 template <typename TaskType>
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/batching_util/adaptive_shared_batch_scheduler.h"
 
+#include "tensorflow/core/kernels/batching_util/batch_stats.h"
 #include "tensorflow/core/kernels/batching_util/fake_clock_env.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -428,6 +429,48 @@ TEST(AdaptiveSharedBatchSchedulerTest, QueueCapacityInfo) {
   finish_processing.Notify();
 }
 
+TEST(AdaptiveSharedBatchSchedulerTest, FullQueueHasNoCapacity) {
+  AdaptiveSharedBatchScheduler<FakeTask>::Options options;
+  // A single thread keeps closed batches enqueued while the first one runs.
+  options.num_batch_threads = 1;
+  options.initial_in_flight_batches_limit = 1;
+  options.batches_to_average_over = 1000;
+  Notification processing_started;
+  Notification finish_processing;
+  auto queue_callback = [&processing_started, &finish_processing](
+                            std::unique_ptr<Batch<FakeTask>> batch) {
+    ASSERT_TRUE(batch->IsClosed());
+    if (!processing_started.HasBeenNotified()) {
+      processing_started.Notify();
+      finish_processing.WaitForNotification();
+    }
+  };
+  std::shared_ptr<AdaptiveSharedBatchScheduler<FakeTask>> scheduler;
+  TF_ASSERT_OK(
+      AdaptiveSharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+  AdaptiveSharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+  queue_options.max_batch_size = 10;
+  queue_options.max_enqueued_batches = 2;
+  queue_options.batch_timeout_micros = 1000000000000;
+  std::unique_ptr<BatchScheduler<FakeTask>> queue;
+  TF_ASSERT_OK(scheduler->AddQueue(queue_options, queue_callback, &queue));
+
+  // The first batch is taken off the queue and blocks the only thread.
+  TF_ASSERT_OK(ScheduleTask(10, queue.get()));
+  processing_started.WaitForNotification();
+  EXPECT_EQ(queue->SchedulingCapacity(), 2 * 10);
+
+  // Fill both enqueued batches, then try to go past max_enqueued_batches.
+  TF_ASSERT_OK(ScheduleTask(10, queue.get()));
+  TF_ASSERT_OK(ScheduleTask(10, queue.get()));
+  EXPECT_EQ(queue->NumEnqueuedTasks(), 2);
+  EXPECT_EQ(queue->SchedulingCapacity(), 0);
+  EXPECT_EQ(error::UNAVAILABLE, ScheduleTask(1, queue.get()).code());
+  EXPECT_EQ(queue->NumEnqueuedTasks(), 2);
+  EXPECT_EQ(queue->SchedulingCapacity(), 0);
+  finish_processing.Notify();
+}
+
 TEST(AdaptiveSharedBatchSchedulerTest, FullBatches) {
   std::shared_ptr<AdaptiveSharedBatchScheduler<FakeTask>> scheduler;
   TF_ASSERT_OK(AdaptiveSharedBatchScheduler<FakeTask>::Create({}, &scheduler));
@@ -518,6 +561,57 @@ TEST(AdaptiveSharedBatchSchedulerTest, MaxTasksPerBatch) {
     if (processed_batches == 3) break;
   }
 }
+TEST(AdaptiveSharedBatchSchedulerTest, LearnedBatchingParams) {
+  ModelBatchStats stats;
+  mutex mu;
+  int processed_batches = 0;
+  auto queue_callback =
+      [&mu, &processed_batches](std::unique_ptr<Batch<FakeTask>> batch) {
+        ASSERT_TRUE(batch->IsClosed());
+        // Take long enough for the processing latency to be measurable.
+        Env::Default()->SleepForMicroseconds(1000);
+        mutex_lock l(mu);
+        ++processed_batches;
+      };
+  std::shared_ptr<AdaptiveSharedBatchScheduler<FakeTask>> scheduler;
+  TF_ASSERT_OK(AdaptiveSharedBatchScheduler<FakeTask>::Create({}, &scheduler));
+  std::unique_ptr<BatchScheduler<FakeTask>> queue;
+
+  AdaptiveSharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+  queue_options.max_batch_size = 100;
+  queue_options.batch_timeout_micros = 100000000;
+  queue_options.learned_params.target_p99_latency_micros = 100000000;
+  queue_options.learned_params.decay = 2;
+  EXPECT_FALSE(
+      scheduler->AddQueue(queue_options, queue_callback, &queue).ok());
+
+  queue_options.learned_params.decay = 1;
+  queue_options.learned_params.batches_between_updates = 1;
+  queue_options.learned_params.min_samples_per_batch_size = 1;
+  queue_options.learned_params.model_batch_stats = &stats;
+  TF_ASSERT_OK(scheduler->AddQueue(queue_options, queue_callback, &queue));
+  // The controller starts from the configured upper bounds.
+  EXPECT_EQ(stats.learned_batch_size(), 100);
+  EXPECT_EQ(stats.learned_batch_timeout_micros(), 100000000);
+
+  // Once a full batch has been processed, nothing indicates load, so the
+  // smallest batch size is chosen.
+  TF_ASSERT_OK(ScheduleTask(100, queue.get()));
+  while (stats.learned_batch_size() == 100) {
+    Env::Default()->SleepForMicroseconds(100);
+  }
+  EXPECT_EQ(stats.learned_batch_size(), 1);
+
+  // Tasks of size one now fill batches on their own, rather than waiting for
+  // the (huge) configured timeout.
+  TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+  TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+  while (true) {
+    mutex_lock l(mu);
+    if (processed_batches == 3) break;
+  }
+}
+
 }  // namespace anonymous
 }  // namespace serving
 }  // namespace tensorflow
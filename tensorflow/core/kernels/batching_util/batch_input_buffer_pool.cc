@@ -0,0 +1,229 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/batch_input_buffer_pool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/types/span.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// Validates that the rows of 'src' can be memcpy'ed into 'dst' at
+// 'row_offset', 'num_rows' rows at a time.
+absl::Status ValidateRowCopy(const Tensor& src, int64_t row_offset,
+                             int64_t num_rows, const Tensor& dst) {
+  if (src.dtype() != dst.dtype()) {
+    return errors::InvalidArgument("Cannot copy rows of a ",
+                                   DataTypeString(src.dtype()),
+                                   " tensor into a ",
+                                   DataTypeString(dst.dtype()), " tensor.");
+  }
+  if (!DataTypeCanUseMemcpy(src.dtype())) {
+    return errors::InvalidArgument("Cannot copy rows of a ",
+                                   DataTypeString(src.dtype()),
+                                   " tensor in place.");
+  }
+  if (src.dims() == 0 || src.dims() != dst.dims()) {
+    return errors::InvalidArgument(
+        "Ranks of batched tensors should match and be at least 1: ",
+        src.shape().DebugString(), " vs. ", dst.shape().DebugString());
+  }
+  for (int i = 1; i < src.dims(); ++i) {
+    if (src.dim_size(i) != dst.dim_size(i)) {
+      return errors::InvalidArgument(
+          "Dimensions of batched tensors should match: ",
+          src.shape().DebugString(), " vs. ", dst.shape().DebugString());
+    }
+  }
+  if (row_offset < 0 || num_rows < 0 ||
+      row_offset + num_rows > dst.dim_size(0)) {
+    return errors::InvalidArgument("Rows [", row_offset, ", ",
+                                   row_offset + num_rows,
+                                   ") are out of range for a tensor of shape ",
+                                   dst.shape().DebugString());
+  }
+  return absl::OkStatus();
+}
+
+// Returns the number of bytes in one row (along the 0th dimension) of 't'.
+int64_t RowBytes(const Tensor& t) {
+  return t.dim_size(0) == 0 ? 0 : t.TotalBytes() / t.dim_size(0);
+}
+
+char* MutableData(Tensor* t) {
+  return const_cast<char*>(t->tensor_data().data());
+}
+
+}  // namespace
+
+absl::Status BatchInputBufferPool::Acquire(Allocator* allocator,
+                                           DataType dtype,
+                                           const TensorShape& shape,
+                                           Tensor* buffer) {
+  const int64_t num_bytes = shape.num_elements() * DataTypeSize(dtype);
+  // Empty tensors have no buffer to share, and only memcpy-able buffers can be
+  // reinterpreted as another dtype.
+  const bool poolable = num_bytes > 0 && DataTypeCanUseMemcpy(dtype);
+
+  mutex_lock l(mu_);
+  ++clock_;
+  if (poolable) {
+    auto it = buffers_.find(num_bytes);
+    if (it != buffers_.end()) {
+      for (PooledBuffer& pooled : it->second) {
+        // The pool itself holds the only reference once the batch that last
+        // used the buffer (and any output aliasing it) has been released.
+        if (pooled.buffer.RefCountIsOne()) {
+          pooled.last_use = clock_;
+          return buffer->BitcastFrom(pooled.buffer, dtype, shape);
+        }
+      }
+    }
+  }
+
+  Tensor allocated = poolable
+                         ? Tensor(allocator, DT_UINT8, TensorShape({num_bytes}))
+                         : Tensor(allocator, dtype, shape);
+  if (!allocated.IsInitialized()) {
+    return errors::ResourceExhausted("Failed to allocate a batch buffer of ",
+                                     DataTypeString(dtype), " with shape ",
+                                     shape.DebugString());
+  }
+  ++num_allocations_;
+  if (!poolable) {
+    *buffer = std::move(allocated);
+    return absl::OkStatus();
+  }
+  if (MakeRoomLocked(num_bytes)) {
+    buffers_[num_bytes].push_back({allocated, clock_});
+    pooled_bytes_ += num_bytes;
+  }
+  return buffer->BitcastFrom(allocated, dtype, shape);
+}
+
+bool BatchInputBufferPool::MakeRoomLocked(int64_t num_bytes) {
+  while (pooled_bytes_ + num_bytes > max_pooled_bytes_) {
+    auto lru = buffers_.end();
+    size_t lru_index = 0;
+    for (auto it = buffers_.begin(); it != buffers_.end(); ++it) {
+      for (size_t i = 0; i < it->second.size(); ++i) {
+        const PooledBuffer& pooled = it->second[i];
+        if (!pooled.buffer.RefCountIsOne()) continue;
+        if (lru == buffers_.end() ||
+            pooled.last_use < lru->second[lru_index].last_use) {
+          lru = it;
+          lru_index = i;
+        }
+      }
+    }
+    // Buffers in use can't be evicted.
+    if (lru == buffers_.end()) return false;
+
+    pooled_bytes_ -= lru->first;
+    lru->second.erase(lru->second.begin() + lru_index);
+    if (lru->second.empty()) buffers_.erase(lru);
+  }
+  return true;
+}
+
+int64_t BatchInputBufferPool::num_allocations() const {
+  mutex_lock l(mu_);
+  return num_allocations_;
+}
+
+int64_t BatchInputBufferPool::pooled_bytes() const {
+  mutex_lock l(mu_);
+  return pooled_bytes_;
+}
+
+absl::Status CopyRowsInto(const Tensor& src, int64_t row_offset, Tensor* dst) {
+  TF_RETURN_IF_ERROR(ValidateRowCopy(src, row_offset, src.dim_size(0), *dst));
+  const int64_t row_bytes = RowBytes(*dst);
+  if (src.TotalBytes() > 0) {
+    std::memcpy(MutableData(dst) + row_offset * row_bytes,
+                src.tensor_data().data(), src.TotalBytes());
+  }
+  return absl::OkStatus();
+}
+
+absl::Status FillRowsWithFirstRow(const Tensor& src, int64_t row_offset,
+                                  int64_t num_rows, Tensor* dst) {
+  TF_RETURN_IF_ERROR(ValidateRowCopy(src, row_offset, num_rows, *dst));
+  if (num_rows == 0) return absl::OkStatus();
+  if (src.dim_size(0) == 0) {
+    return errors::InvalidArgument(
+        "Cannot use an empty tensor with zero rows as padding when batching. "
+        "(Got shape ",
+        src.shape().DebugString(), ".)");
+  }
+  const int64_t row_bytes = RowBytes(*dst);
+  char* out = MutableData(dst) + row_offset * row_bytes;
+  for (int64_t i = 0; i < num_rows; ++i) {
+    std::memcpy(out + i * row_bytes, src.tensor_data().data(), row_bytes);
+  }
+  return absl::OkStatus();
+}
+
+absl::Status SplitAliased(const Tensor& tensor,
+                          absl::Span<const int64_t> sizes,
+                          std::vector<Tensor>* result) {
+  if (tensor.dims() == 0) {
+    return errors::InvalidArgument("Cannot split a zero-dimensional tensor");
+  }
+  if (!DataTypeCanUseMemcpy(tensor.dtype())) {
+    return errors::InvalidArgument("Cannot alias splits of a ",
+                                   DataTypeString(tensor.dtype()), " tensor.");
+  }
+  int64_t total_size = 0;
+  for (int64_t size : sizes) {
+    total_size += size;
+  }
+  if (total_size != tensor.dim_size(0)) {
+    return errors::InvalidArgument(
+        "The values in 'sizes' do not sum to the zeroth-dimension size of "
+        "'tensor'");
+  }
+
+  result->reserve(result->size() + sizes.size());
+  int64_t offset = 0;
+  for (int64_t size : sizes) {
+    Tensor slice = tensor.Slice(offset, offset + size);
+    if (slice.IsAligned()) {
+      result->push_back(std::move(slice));
+    } else {
+      result->push_back(tensor::DeepCopy(slice));
+    }
+    offset += size;
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace serving
+}  // namespace tensorflow
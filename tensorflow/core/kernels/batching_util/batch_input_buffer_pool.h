@@ -0,0 +1,121 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_INPUT_BUFFER_POOL_H_
+#define TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_INPUT_BUFFER_POOL_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/types/span.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace serving {
+
+// A pool of preallocated buffers that batched inputs are concatenated into.
+//
+// The batches formed by one batch resource repeat a small set of padded shapes
+// (typically one per allowed batch size). Instead of allocating a new
+// concatenation target for every batch, the pool hands out a buffer allocated
+// for an earlier batch once nothing else references it any more. The rows of
+// each task are still copied into the buffer, but the buffer stays warm.
+//
+// Buffers are keyed by their size in bytes, so a buffer can be reused for any
+// input of the same size, whatever its dtype and shape. At most
+// 'max_pooled_bytes' are retained; to make room for a new buffer, the least
+// recently used idle buffers are evicted, and if that isn't enough the new
+// buffer isn't pooled.
+//
+// Thread-safe.
+class BatchInputBufferPool {
+ public:
+  static constexpr int64_t kDefaultMaxPooledBytes = int64_t{256} << 20;
+
+  explicit BatchInputBufferPool(
+      int64_t max_pooled_bytes = kDefaultMaxPooledBytes)
+      : max_pooled_bytes_(max_pooled_bytes) {}
+
+  BatchInputBufferPool(const BatchInputBufferPool&) = delete;
+  BatchInputBufferPool& operator=(const BatchInputBufferPool&) = delete;
+
+  // Sets 'buffer' to a tensor of 'dtype' and 'shape', allocated from
+  // 'allocator' unless an idle pooled buffer of the same size is available.
+  // Buffers of dtypes that can't be memcpy'ed are never pooled. The contents
+  // of the returned buffer are unspecified.
+  absl::Status Acquire(Allocator* allocator, DataType dtype,
+                       const TensorShape& shape, Tensor* buffer)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Number of `Acquire` calls that had to allocate memory.
+  int64_t num_allocations() const TF_LOCKS_EXCLUDED(mu_);
+
+  // Total size of the buffers retained by the pool.
+  int64_t pooled_bytes() const TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct PooledBuffer {
+    Tensor buffer;
+    // Value of 'clock_' when the buffer was last handed out.
+    uint64_t last_use;
+  };
+
+  // Evicts idle buffers, least recently used first, until 'num_bytes' more
+  // fit into the pool. Returns false if they still don't fit.
+  bool MakeRoomLocked(int64_t num_bytes) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const int64_t max_pooled_bytes_;
+
+  mutable mutex mu_;
+  int64_t num_allocations_ TF_GUARDED_BY(mu_) = 0;
+  int64_t pooled_bytes_ TF_GUARDED_BY(mu_) = 0;
+  uint64_t clock_ TF_GUARDED_BY(mu_) = 0;
+  absl::flat_hash_map<int64_t, std::vector<PooledBuffer>> buffers_
+      TF_GUARDED_BY(mu_);
+};
+
+// Copies all rows (along the 0th dimension) of 'src' into 'dst', starting at
+// row 'row_offset' of 'dst'.
+//
+// REQUIRES: 'src' and 'dst' hold the same memcpy-able dtype and agree on all
+// but the 0th dimension.
+absl::Status CopyRowsInto(const Tensor& src, int64_t row_offset, Tensor* dst);
+
+// Fills rows ['row_offset', 'row_offset' + 'num_rows') of 'dst' with copies of
+// the first row of 'src'. Used to write batch padding in place.
+absl::Status FillRowsWithFirstRow(const Tensor& src, int64_t row_offset,
+                                  int64_t num_rows, Tensor* dst);
+
+// Like tensor::Split(), but the i-th result aliases the rows of 'tensor' it
+// covers instead of owning a copy of them. Splits whose start is not
+// suitably aligned for Eigen are copied, because kernels consuming them may
+// require aligned buffers.
+//
+// REQUIRES: 'tensor' holds a memcpy-able dtype.
+absl::Status SplitAliased(const Tensor& tensor,
+                          absl::Span<const int64_t> sizes,
+                          std::vector<Tensor>* result);
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_INPUT_BUFFER_POOL_H_
@@ -0,0 +1,207 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/batch_input_buffer_pool.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+TEST(BatchInputBufferPoolTest, ReusesIdleBuffers) {
+  BatchInputBufferPool pool;
+  const TensorShape shape({4, 3});
+
+  const void* first_data = nullptr;
+  {
+    Tensor buffer;
+    TF_ASSERT_OK(pool.Acquire(cpu_allocator(), DT_FLOAT, shape, &buffer));
+    first_data = buffer.tensor_data().data();
+  }
+  Tensor buffer;
+  TF_ASSERT_OK(pool.Acquire(cpu_allocator(), DT_FLOAT, shape, &buffer));
+  EXPECT_EQ(buffer.tensor_data().data(), first_data);
+  EXPECT_EQ(pool.num_allocations(), 1);
+}
+
+TEST(BatchInputBufferPoolTest, DoesNotHandOutBuffersInUse) {
+  BatchInputBufferPool pool;
+  const TensorShape shape({4, 3});
+
+  Tensor first;
+  TF_ASSERT_OK(pool.Acquire(cpu_allocator(), DT_FLOAT, shape, &first));
+  // A slice aliasing the buffer keeps it in use even after 'first' is gone.
+  Tensor slice = first.Slice(0, 2);
+  first = Tensor();
+
+  Tensor second;
+  TF_ASSERT_OK(pool.Acquire(cpu_allocator(), DT_FLOAT, shape, &second));
+  EXPECT_FALSE(second.SharesBufferWith(slice));
+  EXPECT_EQ(pool.num_allocations(), 2);
+}
+
+TEST(BatchInputBufferPoolTest, KeysBySize) {
+  BatchInputBufferPool pool;
+  const void* float_data = nullptr;
+  {
+    Tensor buffer;
+    TF_ASSERT_OK(
+        pool.Acquire(cpu_allocator(), DT_FLOAT, TensorShape({4}), &buffer));
+    float_data = buffer.tensor_data().data();
+  }
+  // Buffers of the same size are shared across dtypes and shapes.
+  {
+    Tensor int_buffer;
+    TF_ASSERT_OK(pool.Acquire(cpu_allocator(), DT_INT32, TensorShape({2, 2}),
+                              &int_buffer));
+    EXPECT_EQ(int_buffer.dtype(), DT_INT32);
+    EXPECT_EQ(int_buffer.shape(), TensorShape({2, 2}));
+    EXPECT_EQ(int_buffer.tensor_data().data(), float_data);
+  }
+  Tensor larger_buffer;
+  TF_ASSERT_OK(pool.Acquire(cpu_allocator(), DT_FLOAT, TensorShape({8}),
+                            &larger_buffer));
+  EXPECT_EQ(larger_buffer.shape(), TensorShape({8}));
+  EXPECT_EQ(pool.num_allocations(), 2);
+  EXPECT_EQ(pool.pooled_bytes(), 48);
+}
+
+TEST(BatchInputBufferPoolTest, EvictsLeastRecentlyUsedIdleBuffers) {
+  // Room for two buffers of 16 bytes.
+  BatchInputBufferPool pool(/*max_pooled_bytes=*/32);
+  const void* first_data = nullptr;
+  {
+    Tensor first, second;
+    TF_ASSERT_OK(
+        pool.Acquire(cpu_allocator(), DT_FLOAT, TensorShape({4}), &first));
+    TF_ASSERT_OK(
+        pool.Acquire(cpu_allocator(), DT_INT32, TensorShape({4, 1}), &second));
+    first_data = first.tensor_data().data();
+  }
+  // Reusing a buffer makes it the most recently used one.
+  {
+    Tensor reused;
+    TF_ASSERT_OK(
+        pool.Acquire(cpu_allocator(), DT_FLOAT, TensorShape({4}), &reused));
+    EXPECT_EQ(reused.tensor_data().data(), first_data);
+  }
+  EXPECT_EQ(pool.pooled_bytes(), 32);
+
+  // A buffer of another size evicts the least recently used idle buffer.
+  {
+    Tensor other_size;
+    TF_ASSERT_OK(
+        pool.Acquire(cpu_allocator(), DT_FLOAT, TensorShape({2}), &other_size));
+  }
+  EXPECT_EQ(pool.pooled_bytes(), 24);
+
+  Tensor kept;
+  TF_ASSERT_OK(
+      pool.Acquire(cpu_allocator(), DT_FLOAT, TensorShape({4}), &kept));
+  EXPECT_EQ(kept.tensor_data().data(), first_data);
+  EXPECT_EQ(pool.num_allocations(), 3);
+}
+
+TEST(BatchInputBufferPoolTest, DoesNotPoolBeyondLimit) {
+  BatchInputBufferPool pool(/*max_pooled_bytes=*/16);
+  Tensor first;
+  TF_ASSERT_OK(
+      pool.Acquire(cpu_allocator(), DT_FLOAT, TensorShape({4}), &first));
+  // The only pooled buffer is in use, so there is no room for another one.
+  {
+    Tensor second;
+    TF_ASSERT_OK(
+        pool.Acquire(cpu_allocator(), DT_FLOAT, TensorShape({4}), &second));
+    EXPECT_FALSE(second.SharesBufferWith(first));
+  }
+  Tensor too_large;
+  TF_ASSERT_OK(
+      pool.Acquire(cpu_allocator(), DT_FLOAT, TensorShape({8}), &too_large));
+  EXPECT_EQ(pool.pooled_bytes(), 16);
+  EXPECT_EQ(pool.num_allocations(), 3);
+}
+
+TEST(BatchInputBufferPoolTest, CopyRowsIntoAndPad) {
+  Tensor dst(DT_INT32, TensorShape({5, 2}));
+  TF_ASSERT_OK(CopyRowsInto(test::AsTensor<int32_t>({1, 2}, {1, 2}), 0, &dst));
+  TF_ASSERT_OK(
+      CopyRowsInto(test::AsTensor<int32_t>({3, 4, 5, 6}, {2, 2}), 1, &dst));
+  const Tensor padding_source = test::AsTensor<int32_t>({7, 8, 9, 10}, {2, 2});
+  TF_ASSERT_OK(FillRowsWithFirstRow(padding_source, 3, 2, &dst));
+  test::ExpectTensorEqual<int32_t>(
+      dst, test::AsTensor<int32_t>({1, 2, 3, 4, 5, 6, 7, 8, 7, 8}, {5, 2}));
+}
+
+TEST(BatchInputBufferPoolTest, CopyRowsIntoRejectsMismatchedShapes) {
+  Tensor dst(DT_INT32, TensorShape({4, 2}));
+  EXPECT_EQ(
+      CopyRowsInto(test::AsTensor<int32_t>({1, 2, 3}, {1, 3}), 0, &dst).code(),
+      absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(
+      CopyRowsInto(test::AsTensor<int32_t>({1, 2, 3, 4}, {2, 2}), 3, &dst)
+          .code(),
+      absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(CopyRowsInto(test::AsTensor<float>({1, 2}, {1, 2}), 0, &dst).code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+TEST(BatchInputBufferPoolTest, SplitAliasedSharesAlignedRows) {
+  // 16 floats per row keeps every split start aligned for Eigen.
+  Tensor batched(DT_FLOAT, TensorShape({4, 16}));
+  auto flat = batched.flat<float>();
+  for (int i = 0; i < flat.size(); ++i) flat(i) = i;
+
+  std::vector<Tensor> splits;
+  TF_ASSERT_OK(SplitAliased(batched, {1, 3}, &splits));
+  ASSERT_EQ(splits.size(), 2);
+  EXPECT_TRUE(splits[0].SharesBufferWith(batched));
+  EXPECT_TRUE(splits[1].SharesBufferWith(batched));
+  EXPECT_EQ(splits[1].shape(), TensorShape({3, 16}));
+  EXPECT_EQ(splits[1].flat<float>()(0), 16.0f);
+}
+
+TEST(BatchInputBufferPoolTest, SplitAliasedCopiesUnalignedRows) {
+  Tensor batched = test::AsTensor<float>({1, 2, 3}, {3, 1});
+
+  std::vector<Tensor> splits;
+  TF_ASSERT_OK(SplitAliased(batched, {1, 1, 1}, &splits));
+  ASSERT_EQ(splits.size(), 3);
+  for (int i = 0; i < splits.size(); ++i) {
+    EXPECT_TRUE(splits[i].IsAligned());
+    test::ExpectTensorEqual<float>(
+        splits[i], test::AsTensor<float>({static_cast<float>(i + 1)}, {1, 1}));
+  }
+}
+
+TEST(BatchInputBufferPoolTest, SplitAliasedRejectsBadSizes) {
+  Tensor batched(DT_FLOAT, TensorShape({4, 2}));
+  std::vector<Tensor> splits;
+  EXPECT_EQ(SplitAliased(batched, {1, 2}, &splits).code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
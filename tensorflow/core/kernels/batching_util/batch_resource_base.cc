@@ -37,6 +37,7 @@ limitations under the License.
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "tensorflow/core/common_runtime/cost_constants.h"
 #include "tensorflow/core/common_runtime/cost_measurement.h"
 #include "tensorflow/core/common_runtime/cost_measurement_registry.h"
@@ -51,9 +52,11 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/kernels/batching_util/batch_input_buffer_pool.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler_utils.h"
 #include "tensorflow/core/kernels/batching_util/batch_stats.h"
+#include "tensorflow/core/kernels/batching_util/batching_params_controller.h"
 #include "tensorflow/core/kernels/batching_util/concat_split_util.h"
 #include "tensorflow/core/kernels/batching_util/input_split_metadata.h"
 #include "tensorflow/core/kernels/batching_util/threadsafe_status.h"
@@ -733,15 +736,28 @@ absl::Status BatchResourceBase::ConcatInputTensors(
 
     // Add padding as needed if padding is allowed. Use the first row of the
     // first task's tensor as the data for padding.
+    const Tensor& padding_source = batch.task(0).inputs.at(i);
+    if (padding_amount != 0 && padding_source.shape().dim_size(0) == 0) {
+      return errors::InvalidArgument(
+          "Cannot use an empty tensor with zero rows as padding when "
+          "batching. (Input ",
+          i, " got shape ", padding_source.shape().DebugString(), ".)");
+    }
+
+    // With pooled concat buffers, the rows of each task (and the padding) are
+    // copied into a pooled buffer rather than concatenated into a freshly
+    // allocated tensor.
+    if (input_buffer_pool_ != nullptr &&
+        DataTypeCanUseMemcpy(padding_source.dtype())) {
+      Tensor assembled;
+      TF_RETURN_IF_ERROR(AssembleInputTensor(
+          context, to_concatenate, padding_source, padding_amount, &assembled));
+      concatenated_tensors->push_back(std::move(assembled));
+      continue;
+    }
+
     if (padding_amount != 0) {
-      const Tensor& padding_source = batch.task(0).inputs.at(i);
       Tensor padding;
-      if (padding_source.shape().dim_size(0) == 0) {
-        return errors::InvalidArgument(
-            "Cannot use an empty tensor with zero rows as padding when "
-            "batching. (Input ",
-            i, " got shape ", padding_source.shape().DebugString(), ".)");
-      }
       if (padding_source.shape().dim_size(0) == 1) {
         padding = padding_source;
       } else {
@@ -761,6 +777,38 @@ absl::Status BatchResourceBase::ConcatInputTensors(
   return absl::OkStatus();
 }
 
+absl::Status BatchResourceBase::AssembleInputTensor(
+    OpKernelContext* context, absl::Span<const Tensor> tensors,
+    const Tensor& padding_source, int padding_amount, Tensor* assembled) const {
+  // A single unpadded task already is the batch.
+  if (tensors.size() == 1 && padding_amount == 0) {
+    *assembled = tensors[0];
+    return absl::OkStatus();
+  }
+
+  int64_t num_rows = padding_amount;
+  for (const Tensor& tensor : tensors) {
+    if (tensor.dims() == 0) {
+      return errors::InvalidArgument(
+          "Batching input tensors must have at least one dimension");
+    }
+    num_rows += tensor.dim_size(0);
+  }
+  TensorShape shape = padding_source.shape();
+  shape.set_dim(0, num_rows);
+
+  TF_RETURN_IF_ERROR(input_buffer_pool_->Acquire(
+      context->get_allocator(AllocatorAttributes()), padding_source.dtype(),
+      shape, assembled));
+  int64_t row_offset = 0;
+  for (const Tensor& tensor : tensors) {
+    TF_RETURN_IF_ERROR(CopyRowsInto(tensor, row_offset, assembled));
+    row_offset += tensor.dim_size(0);
+  }
+  return FillRowsWithFirstRow(padding_source, row_offset, padding_amount,
+                              assembled);
+}
+
 /*static*/ absl::Status BatchResourceBase::SplitInputTask(
     std::unique_ptr<BatchTask>* input_task_ptr, int open_batch_remaining_slot,
     int max_batch_size, std::vector<std::unique_ptr<BatchTask>>* output_tasks) {
@@ -914,9 +962,16 @@ absl::Status BatchResourceBase::SplitOutputTensors(
           "; padding size: ", padding_size);
     }
 
+    // With pooled concat buffers, each task receives a view of its rows of the
+    // batched output instead of a copy.
     std::vector<Tensor> split_tensor;
-    const absl::Status split_status = tensor::Split(
-        output_tensor, task_sizes_plus_optional_padding, &split_tensor);
+    const absl::Status split_status =
+        input_buffer_pool_ != nullptr &&
+                DataTypeCanUseMemcpy(output_tensor.dtype())
+            ? SplitAliased(output_tensor, task_sizes_plus_optional_padding,
+                           &split_tensor)
+            : tensor::Split(output_tensor, task_sizes_plus_optional_padding,
+                            &split_tensor);
     DCHECK(split_status.ok()) << split_status;
     if (!split_status.ok()) {
       return errors::Internal("Tensor split operation failed: ",
@@ -1223,8 +1278,24 @@ absl::Status BatchResourceBase::LookupOrCreateBatcherQueue(
         reduced_process_batch_callback = [this](std::unique_ptr<BatchT> batch) {
           ProcessBatchCallBack(std::move(batch), {});
         };
+    AdaptiveBatcherT::QueueOptions adaptive_batcher_queue_options =
+        adaptive_batcher_queue_options_;
+    BatchingParamsController::Options& learned_params =
+        adaptive_batcher_queue_options.learned_params;
+    if (learned_params.target_p99_latency_micros > 0) {
+      learned_params.model_batch_stats = &GlobalBatchStatsRegistry().model(
+          /* model_name= */ model_name, /* op_name= */ op_name);
+      learned_params.model_name = model_name;
+      learned_params.op_name = op_name;
+      // Batches are padded to the allowed batch sizes anyway, so those are the
+      // only sizes worth choosing from.
+      if (learned_params.candidate_batch_sizes.empty()) {
+        learned_params.candidate_batch_sizes.assign(
+            allowed_batch_sizes_.begin(), allowed_batch_sizes_.end());
+      }
+    }
     TF_RETURN_IF_ERROR(adaptive_batcher_->AddQueue(
-        adaptive_batcher_queue_options_, reduced_process_batch_callback,
+        adaptive_batcher_queue_options, reduced_process_batch_callback,
         &new_queue));
   } else {
     return errors::Internal("No batcher defined.");
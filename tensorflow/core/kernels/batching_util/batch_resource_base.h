@@ -34,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/kernels/batching_util/adaptive_shared_batch_scheduler.h"
+#include "tensorflow/core/kernels/batching_util/batch_input_buffer_pool.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler_utils.h"
 #include "tensorflow/core/kernels/batching_util/shared_batch_scheduler.h"
@@ -186,6 +187,22 @@ class BatchResourceBase : public ResourceBase {
 
   const SessionMetadata& session_metadata() const { return session_metadata_; }
 
+  // When enabled, batched inputs are concatenated by copying each task's rows
+  // to their offset in a pooled, preallocated buffer (a batch made of a single
+  // unpadded task is passed through without any copy), and the outputs handed
+  // back to tasks alias the rows of the batched output instead of being
+  // copied out of it.
+  void set_enable_pooled_concat_buffers(bool enable) {
+    input_buffer_pool_ =
+        enable ? std::make_unique<BatchInputBufferPool>() : nullptr;
+  }
+
+  // The pool of buffers batched inputs are concatenated into, or null unless
+  // pooled concat buffers are enabled.
+  const BatchInputBufferPool* input_buffer_pool() const {
+    return input_buffer_pool_.get();
+  }
+
   using CreateBatchTaskFn =
       std::function<StatusOr<std::unique_ptr<BatchTask>>()>;
 
@@ -308,6 +325,14 @@ class BatchResourceBase : public ResourceBase {
       OpKernelContext* context,
       std::vector<Tensor>* concatenated_tensors) const;
 
+  // Writes 'tensors' followed by 'padding_amount' copies of the first row of
+  // 'padding_source' into a buffer from 'input_buffer_pool_'. Used by
+  // ConcatInputTensors when pooled concat buffers are enabled.
+  Status AssembleInputTensor(OpKernelContext* context,
+                             absl::Span<const Tensor> tensors,
+                             const Tensor& padding_source, int padding_amount,
+                             Tensor* assembled) const;
+
   Status SplitOutputTensors(
       const std::vector<Tensor>& combined_outputs, BatchT* batch,
       std::vector<std::unique_ptr<BatchTask>>& unbatched_tasks) const;
@@ -368,6 +393,10 @@ class BatchResourceBase : public ResourceBase {
   std::map<string, std::unique_ptr<BatcherQueueT>> batcher_queues_
       TF_GUARDED_BY(batcher_queues_mu_);
 
+  // Buffers that batched inputs are concatenated into; null unless pooled
+  // concat buffers are enabled.
+  std::unique_ptr<BatchInputBufferPool> input_buffer_pool_;
+
   std::vector<int32> allowed_batch_sizes_;
   // A concatenated string of <allowed_batch_sizes_>, separated by ",". This is
   // used to record batching parameter.
@@ -39,6 +39,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/kernels/batching_util/batch_input_buffer_pool.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler_utils.h"
 #include "tensorflow/core/kernels/batching_util/batch_stats.h"
@@ -622,6 +623,88 @@ TEST_F(BatchResourceBaseTest, ConfiguredBatchPaddingPolicyMetric) {
   my_batch_resource->Unref();
 }
 
+TEST_F(BatchResourceBaseTest, ReusesPooledConcatBuffers) {
+  using BatchTask = BatchResourceBase::BatchTask;
+
+  // Records the buffers of the batched inputs of every processed batch.
+  class RecordingBatchResource : public BatchResourceBase {
+   public:
+    using BatchResourceBase::BatchResourceBase;
+
+    std::string DebugString() const override { return ""; }
+
+    void ProcessFuncBatchImpl(
+        const BatchResourceBase::BatchTask& /* last_task */,
+        absl::Span<const Tensor> inputs,
+        std::vector<Tensor>* /* combined_outputs */,
+        std::function<void(const absl::Status&)> /* done */) const override {
+      std::vector<const char*> buffers;
+      for (const Tensor& input : inputs) {
+        buffers.push_back(input.tensor_data().data());
+      }
+      batch_buffers_.push_back(std::move(buffers));
+    }
+
+    const std::vector<std::vector<const char*>>& batch_buffers() const {
+      return batch_buffers_;
+    }
+
+   private:
+    mutable std::vector<std::vector<const char*>> batch_buffers_;
+  };
+
+  // Notifies once the scheduler has destroyed the batch it belongs to, which
+  // releases the buffers of the batched inputs.
+  class NotifyingBatchTask : public BatchTask {
+   public:
+    explicit NotifyingBatchTask(Notification* destroyed)
+        : destroyed_(destroyed) {}
+    ~NotifyingBatchTask() override { destroyed_->Notify(); }
+
+   private:
+    Notification* destroyed_;
+  };
+
+  std::shared_ptr<SharedBatchScheduler<BatchTask>> batcher;
+  TF_CHECK_OK(SharedBatchScheduler<BatchTask>::Create({}, &batcher));
+
+  // The 5 rows of the only task are padded to 8, so they are copied into a
+  // concat buffer instead of being passed through.
+  RecordingBatchResource* my_batch_resource = new RecordingBatchResource(
+      /* has_process_batch_function */ true,
+      /* batcher= */ batcher,
+      /* batcher_queue_options */ {},
+      /* allowed_batch_sizes */ {8});
+  my_batch_resource->set_enable_pooled_concat_buffers(true);
+
+  for (int guid = 0; guid < 2; ++guid) {
+    Notification destroyed;
+    TF_CHECK_OK(my_batch_resource->RegisterInput(
+        guid, context_.get(), "batcher_queue_name",
+        [&destroyed]() -> absl::StatusOr<std::unique_ptr<BatchTask>> {
+          return std::make_unique<NotifyingBatchTask>(&destroyed);
+        },
+        /* done_callback= */ [] {}, /* forced_warmup_batch_size= */ 0));
+    ASSERT_TRUE(destroyed.WaitForNotificationWithTimeout(absl::Seconds(10)));
+  }
+
+  // Both batches have two batched inputs and one captured input, and the
+  // second batch reuses the concat buffers of the first one.
+  const std::vector<std::vector<const char*>>& batch_buffers =
+      my_batch_resource->batch_buffers();
+  ASSERT_EQ(batch_buffers.size(), 2);
+  ASSERT_EQ(batch_buffers[0].size(), 3);
+  ASSERT_EQ(batch_buffers[1].size(), 3);
+  EXPECT_THAT(std::vector<const char*>(batch_buffers[1].begin(),
+                                       batch_buffers[1].begin() + 2),
+              UnorderedElementsAre(batch_buffers[0][0], batch_buffers[0][1]));
+  EXPECT_NE(batch_buffers[0][0], input_tensor_.tensor_data().data());
+  EXPECT_EQ(my_batch_resource->input_buffer_pool()->num_allocations(), 2);
+
+  // This is how we have to destroy the BatchResource.
+  my_batch_resource->Unref();
+}
+
 }  // namespace
 }  // namespace serving
 }  // namespace tensorflow
@@ -69,6 +69,7 @@ namespace tensorflow::serving {
 // Default values for when there is no recorded statistic in ModelBatchStats.
 constexpr int64_t kNumBatchThreadsUnknown = -1;
 constexpr int64_t kBatchTimeoutMicrosUnknown = -1;
+constexpr int64_t kLearnedBatchSizeUnknown = -1;
 
 // Tracks the average cost of registered samples.
 //
@@ -188,6 +189,23 @@ class ModelBatchStats {
     return batch_timeout_micros_.load(std::memory_order_relaxed);
   }
 
+  // Records the batch size and timeout most recently chosen by a
+  // BatchingParamsController for this model.
+  void SetLearnedBatchingParams(int64_t batch_size,
+                                int64_t batch_timeout_micros) {
+    learned_batch_size_.store(batch_size, std::memory_order_relaxed);
+    learned_batch_timeout_micros_.store(batch_timeout_micros,
+                                        std::memory_order_relaxed);
+  }
+
+  int64_t learned_batch_size() const {
+    return learned_batch_size_.load(std::memory_order_relaxed);
+  }
+
+  int64_t learned_batch_timeout_micros() const {
+    return learned_batch_timeout_micros_.load(std::memory_order_relaxed);
+  }
+
  private:
   mutable mutex mu_;
 
@@ -212,6 +230,12 @@ class ModelBatchStats {
   // The timeout in microseconds for this model (after which the current batch
   // is sent to be processed by the TPU).
   std::atomic<int64_t> batch_timeout_micros_ = kBatchTimeoutMicrosUnknown;
+
+  // The batch size and timeout learned online for this model, if batching
+  // parameters are learned rather than fixed.
+  std::atomic<int64_t> learned_batch_size_ = kLearnedBatchSizeUnknown;
+  std::atomic<int64_t> learned_batch_timeout_micros_ =
+      kBatchTimeoutMicrosUnknown;
 };
 
 // Tracks batch statistics for all models.
@@ -148,6 +148,19 @@ TEST(BatchStatsTest, NumBatchThreadsIsCorrect) {
   ASSERT_EQ(stats.num_batch_threads(), 16);
 }
 
+TEST(BatchStatsTest, LearnedBatchingParamsAreCorrect) {
+  ModelBatchStats stats;
+
+  // Originally the learned parameters are -1 if unassigned.
+  ASSERT_EQ(stats.learned_batch_size(), -1);
+  ASSERT_EQ(stats.learned_batch_timeout_micros(), -1);
+
+  stats.SetLearnedBatchingParams(/*batch_size=*/32,
+                                 /*batch_timeout_micros=*/500);
+  ASSERT_EQ(stats.learned_batch_size(), 32);
+  ASSERT_EQ(stats.learned_batch_timeout_micros(), 500);
+}
+
 }  // namespace
 
 }  // namespace tensorflow::serving
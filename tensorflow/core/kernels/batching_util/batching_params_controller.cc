@@ -0,0 +1,319 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/batching_params_controller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/gauge.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// z-score of the 99th percentile of a normal distribution.
+constexpr double kP99ZScore = 2.326;
+
+// Arrivals are aggregated over windows of at least this length before being
+// folded into the arrival rate estimate.
+constexpr int64_t kArrivalWindowMicros = 10 * 1000;
+
+// Capacity must exceed the arrival rate by this factor for a batch size to be
+// considered sufficient; keeps queues from building up under noisy load.
+constexpr double kCapacityHeadroom = 1.25;
+
+void RecordLearnedBatchingParams(int64_t batch_size,
+                                 int64_t batch_timeout_micros,
+                                 const std::string& model_name,
+                                 const std::string& op_name) {
+  static auto* batch_size_cell = monitoring::Gauge<int64_t, 2>::New(
+      "/tensorflow/serving/batching/learned_batch_size",
+      "Tracks the batch size chosen by the learned batching parameters "
+      "controller.",
+      "model_name", "op_name");
+  static auto* batch_timeout_cell = monitoring::Gauge<int64_t, 2>::New(
+      "/tensorflow/serving/batching/learned_batch_timeout_micros",
+      "Tracks the batch timeout chosen by the learned batching parameters "
+      "controller.",
+      "model_name", "op_name");
+  batch_size_cell->GetCell(model_name, op_name)->Set(batch_size);
+  batch_timeout_cell->GetCell(model_name, op_name)->Set(batch_timeout_micros);
+}
+
+void RecordLearnedBatchingParamsChange(const std::string& model_name,
+                                       const std::string& op_name) {
+  static auto* cell = monitoring::Counter<2>::New(
+      "/tensorflow/serving/batching/learned_batching_params_changes",
+      "Counts how often the learned batching parameters controller changed "
+      "its decision.",
+      "model_name", "op_name");
+  cell->GetCell(model_name, op_name)->IncrementBy(1);
+}
+
+std::vector<int> GetBatchSizes(
+    const BatchingParamsController::Options& options) {
+  std::vector<int> batch_sizes;
+  if (options.candidate_batch_sizes.empty()) {
+    for (int size = 1; size < options.max_batch_size; size *= 2) {
+      batch_sizes.push_back(size);
+    }
+  } else {
+    for (int size : options.candidate_batch_sizes) {
+      if (size > 0 && size < options.max_batch_size) {
+        batch_sizes.push_back(size);
+      }
+    }
+  }
+  batch_sizes.push_back(options.max_batch_size);
+  std::sort(batch_sizes.begin(), batch_sizes.end());
+  batch_sizes.erase(std::unique(batch_sizes.begin(), batch_sizes.end()),
+                    batch_sizes.end());
+  return batch_sizes;
+}
+
+}  // namespace
+
+absl::Status BatchingParamsController::Create(
+    const Options& options,
+    std::unique_ptr<BatchingParamsController>* controller) {
+  if (options.target_p99_latency_micros <= 0) {
+    return errors::InvalidArgument(
+        "target_p99_latency_micros must be positive; was ",
+        options.target_p99_latency_micros);
+  }
+  if (options.max_batch_size <= 0) {
+    return errors::InvalidArgument("max_batch_size must be positive; was ",
+                                   options.max_batch_size);
+  }
+  if (options.max_batch_timeout_micros < 0) {
+    return errors::InvalidArgument(
+        "max_batch_timeout_micros can't be negative; was ",
+        options.max_batch_timeout_micros);
+  }
+  if (options.num_batch_threads < 1) {
+    return errors::InvalidArgument("num_batch_threads must be positive; was ",
+                                   options.num_batch_threads);
+  }
+  if (options.decay <= 0 || options.decay > 1) {
+    return errors::InvalidArgument("decay must be in (0, 1]; was ",
+                                   options.decay);
+  }
+  if (options.batches_between_updates < 1) {
+    return errors::InvalidArgument(
+        "batches_between_updates must be positive; was ",
+        options.batches_between_updates);
+  }
+  controller->reset(new BatchingParamsController(options));
+  return absl::OkStatus();
+}
+
+BatchingParamsController::BatchingParamsController(const Options& options)
+    : options_(options),
+      batch_sizes_(GetBatchSizes(options)),
+      batch_size_(options.max_batch_size),
+      batch_timeout_micros_(options.max_batch_timeout_micros),
+      latencies_(batch_sizes_.size()) {
+  Publish(options_.max_batch_size, options_.max_batch_timeout_micros);
+}
+
+int BatchingParamsController::BucketIndex(int64_t batch_size) const {
+  auto it =
+      std::lower_bound(batch_sizes_.begin(), batch_sizes_.end(), batch_size);
+  if (it == batch_sizes_.end()) return batch_sizes_.size() - 1;
+  return it - batch_sizes_.begin();
+}
+
+void BatchingParamsController::RecordArrival(int64_t task_size,
+                                             int64_t now_micros) {
+  mutex_lock l(mu_);
+  if (window_start_micros_ < 0) {
+    window_start_micros_ = now_micros;
+  }
+  window_units_ += task_size;
+  const int64_t elapsed_micros = now_micros - window_start_micros_;
+  if (elapsed_micros < kArrivalWindowMicros) return;
+
+  const double rate = static_cast<double>(window_units_) / elapsed_micros;
+  if (has_arrival_rate_) {
+    arrival_rate_ += options_.decay * (rate - arrival_rate_);
+  } else {
+    arrival_rate_ = rate;
+    has_arrival_rate_ = true;
+  }
+  window_start_micros_ = now_micros;
+  window_units_ = 0;
+}
+
+double BatchingParamsController::arrival_rate() const {
+  mutex_lock l(mu_);
+  return arrival_rate_;
+}
+
+void BatchingParamsController::RecordBatchProcessed(int64_t batch_size,
+                                                    int64_t latency_micros) {
+  mutex_lock l(mu_);
+  LatencyEstimate& estimate = latencies_[BucketIndex(batch_size)];
+  if (estimate.num_samples == 0) {
+    estimate.mean_micros = latency_micros;
+    estimate.variance = 0;
+  } else {
+    // Exponentially-weighted mean and variance (West, 1979).
+    const double delta = latency_micros - estimate.mean_micros;
+    estimate.mean_micros += options_.decay * delta;
+    estimate.variance = (1 - options_.decay) *
+                        (estimate.variance + options_.decay * delta * delta);
+  }
+  ++estimate.num_samples;
+
+  if (++batches_since_update_ >= options_.batches_between_updates) {
+    UpdateParamsLocked();
+  }
+}
+
+std::optional<std::pair<double, double>>
+BatchingParamsController::EstimateLatency(int i) const {
+  const LatencyEstimate& own = latencies_[i];
+  if (own.num_samples >= options_.min_samples_per_batch_size) {
+    return std::make_pair(
+        own.mean_micros,
+        own.mean_micros + kP99ZScore * std::sqrt(own.variance));
+  }
+
+  // Fit mean latency = a + b * batch_size over the trusted buckets, and scale
+  // the p99 by the worst p99/mean ratio seen among them.
+  double n = 0, sum_x = 0, sum_y = 0, sum_xx = 0, sum_xy = 0;
+  double p99_ratio = 1;
+  for (int j = 0; j < latencies_.size(); ++j) {
+    const LatencyEstimate& estimate = latencies_[j];
+    if (estimate.num_samples < options_.min_samples_per_batch_size) continue;
+    const double x = batch_sizes_[j];
+    const double y = estimate.mean_micros;
+    n += 1;
+    sum_x += x;
+    sum_y += y;
+    sum_xx += x * x;
+    sum_xy += x * y;
+    if (y > 0) {
+      p99_ratio = std::max(
+          p99_ratio, (y + kP99ZScore * std::sqrt(estimate.variance)) / y);
+    }
+  }
+  if (n == 0) return std::nullopt;
+
+  double mean;
+  const double denominator = n * sum_xx - sum_x * sum_x;
+  if (n == 1 || denominator <= 0) {
+    // A single data point: assume latency is proportional to the batch size,
+    // which is the pessimistic case of no amortization at all.
+    mean = sum_y / sum_x * batch_sizes_[i];
+  } else {
+    const double slope = (n * sum_xy - sum_x * sum_y) / denominator;
+    const double intercept = (sum_y - slope * sum_x) / n;
+    mean = intercept + slope * batch_sizes_[i];
+  }
+  if (mean <= 0) return std::nullopt;
+  return std::make_pair(mean, mean * p99_ratio);
+}
+
+void BatchingParamsController::UpdateParams() {
+  mutex_lock l(mu_);
+  UpdateParamsLocked();
+}
+
+void BatchingParamsController::UpdateParamsLocked() {
+  batches_since_update_ = 0;
+
+  const double rate = arrival_rate_;
+  const double target = options_.target_p99_latency_micros;
+
+  int best_sufficient = -1;
+  int best_capacity = -1;
+  double best_capacity_value = 0;
+  std::vector<int64_t> timeouts(batch_sizes_.size());
+  for (int i = 0; i < batch_sizes_.size(); ++i) {
+    const std::optional<std::pair<double, double>> latency = EstimateLatency(i);
+    if (!latency.has_value()) continue;
+    const auto [mean_micros, p99_micros] = *latency;
+    if (p99_micros >= target) continue;
+
+    const double batch_size = batch_sizes_[i];
+    double timeout_micros =
+        std::min(target - p99_micros,
+                 static_cast<double>(options_.max_batch_timeout_micros));
+    if (rate > 0) {
+      timeout_micros = std::min(timeout_micros, batch_size / rate);
+    }
+    timeouts[i] = static_cast<int64_t>(timeout_micros);
+
+    // The number of units a batch holds when it is closed, either because it
+    // is full or because it timed out.
+    const double filled = std::clamp(rate * timeout_micros, 1.0, batch_size);
+    const double capacity =
+        options_.num_batch_threads * filled / std::max(mean_micros, 1.0);
+    if (best_sufficient < 0 && capacity >= kCapacityHeadroom * rate) {
+      best_sufficient = i;
+    }
+    // Ties go to the larger batch size, which explores sizes that have not
+    // been measured yet when the load exceeds what is known to be sustainable.
+    if (best_capacity < 0 || capacity >= best_capacity_value) {
+      best_capacity = i;
+      best_capacity_value = capacity;
+    }
+  }
+
+  int chosen = best_sufficient >= 0 ? best_sufficient : best_capacity;
+  int batch_size;
+  int64_t batch_timeout_micros;
+  if (chosen >= 0) {
+    batch_size = batch_sizes_[chosen];
+    batch_timeout_micros = timeouts[chosen];
+  } else {
+    // Nothing is known to meet the target yet; keep the current choice.
+    batch_size = batch_size_.load(std::memory_order_relaxed);
+    batch_timeout_micros =
+        batch_timeout_micros_.load(std::memory_order_relaxed);
+  }
+
+  if (batch_size != batch_size_.load(std::memory_order_relaxed)) {
+    RecordLearnedBatchingParamsChange(options_.model_name, options_.op_name);
+  }
+  batch_size_.store(batch_size, std::memory_order_relaxed);
+  batch_timeout_micros_.store(batch_timeout_micros, std::memory_order_relaxed);
+  Publish(batch_size, batch_timeout_micros);
+}
+
+void BatchingParamsController::Publish(int batch_size,
+                                       int64_t batch_timeout_micros) {
+  if (options_.model_batch_stats != nullptr) {
+    options_.model_batch_stats->SetLearnedBatchingParams(batch_size,
+                                                         batch_timeout_micros);
+  }
+  RecordLearnedBatchingParams(batch_size, batch_timeout_micros,
+                              options_.model_name, options_.op_name);
+}
+
+}  // namespace serving
+}  // namespace tensorflow
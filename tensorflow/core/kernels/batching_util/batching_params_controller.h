@@ -0,0 +1,176 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCHING_PARAMS_CONTROLLER_H_
+#define TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCHING_PARAMS_CONTROLLER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "tensorflow/core/kernels/batching_util/batch_stats.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Learns, online and per model, the batch size and batch timeout that maximize
+// throughput while keeping the estimated p99 request latency under a target.
+//
+// The controller observes two things:
+//  - the processing latency of each batch, bucketed by the smallest candidate
+//    batch size that holds it (i.e. the size it would be padded to), tracked
+//    as an exponentially-decaying mean and variance;
+//  - the arrival rate of work, in unit-sized tasks per microsecond, also
+//    exponentially decayed.
+//
+// Every `batches_between_updates` batches it re-evaluates each candidate batch
+// size `b`:
+//  - the p99 processing latency p99(b) is estimated as mean(b) + 2.33 *
+//    stddev(b); sizes without enough samples are extrapolated with a
+//    least-squares linear fit over the sizes that have them;
+//  - `b` is feasible if p99(b) leaves some slack under the target. Its timeout
+//    is that slack, capped by `max_batch_timeout_micros` and by the expected
+//    time to fill `b` at the current arrival rate;
+//  - its throughput capacity is `num_batch_threads * filled(b) / mean(b)`,
+//    where filled(b) is the number of units a batch is expected to hold when
+//    it closes.
+// Among feasible sizes it picks the smallest one whose capacity keeps up with
+// the arrival rate (with some headroom), and otherwise the one with the
+// largest capacity. Decisions are published to `model_batch_stats` and to
+// monitoring gauges.
+//
+// Thread-safe.
+class BatchingParamsController {
+ public:
+  struct Options {
+    // The p99 latency (queueing plus processing) the controller aims to stay
+    // under. Must be positive.
+    int64_t target_p99_latency_micros = 0;
+
+    // Upper bounds for the chosen parameters; the initial choice uses both.
+    int max_batch_size = 0;
+    int64_t max_batch_timeout_micros = 0;
+
+    // Batch sizes the controller chooses from. If empty, powers of two below
+    // `max_batch_size` plus `max_batch_size` itself are used. Sizes above
+    // `max_batch_size` are ignored.
+    std::vector<int> candidate_batch_sizes;
+
+    // Number of batches that can be processed concurrently for this model.
+    int64_t num_batch_threads = 1;
+
+    // Weight of a new sample in the exponentially-decaying estimates.
+    double decay = 0.05;
+
+    // Number of processed batches between two re-evaluations.
+    int64_t batches_between_updates = 100;
+
+    // Number of samples a batch size needs before its own latency estimate is
+    // trusted over the linear fit.
+    int64_t min_samples_per_batch_size = 10;
+
+    // Where the chosen parameters are published; may be null.
+    ModelBatchStats* model_batch_stats = nullptr;
+
+    // Labels for the monitoring gauges.
+    std::string model_name;
+    std::string op_name;
+  };
+
+  static absl::Status Create(
+      const Options& options,
+      std::unique_ptr<BatchingParamsController>* controller);
+
+  BatchingParamsController(const BatchingParamsController&) = delete;
+  BatchingParamsController& operator=(const BatchingParamsController&) =
+      delete;
+
+  // Records that a task of 'task_size' units arrived at 'now_micros'.
+  void RecordArrival(int64_t task_size, int64_t now_micros)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Records that a batch holding 'batch_size' units took 'latency_micros' to
+  // process. Re-evaluates the parameters every `batches_between_updates`
+  // calls.
+  void RecordBatchProcessed(int64_t batch_size, int64_t latency_micros)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // The currently chosen batch size and timeout. Cheap enough to be called for
+  // every scheduled task.
+  int batch_size() const { return batch_size_.load(std::memory_order_relaxed); }
+  int64_t batch_timeout_micros() const {
+    return batch_timeout_micros_.load(std::memory_order_relaxed);
+  }
+
+  // The current arrival rate estimate, in units per microsecond.
+  double arrival_rate() const TF_LOCKS_EXCLUDED(mu_);
+
+  // Re-evaluates the parameters from the samples recorded so far.
+  void UpdateParams() TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  // Exponentially-decaying estimate of the processing latency of one batch
+  // size bucket.
+  struct LatencyEstimate {
+    int64_t num_samples = 0;
+    double mean_micros = 0;
+    double variance = 0;
+  };
+
+  explicit BatchingParamsController(const Options& options);
+
+  // Returns the index in `batch_sizes_` of the bucket 'batch_size' is counted
+  // in.
+  int BucketIndex(int64_t batch_size) const;
+
+  // Returns {mean, p99} processing latency estimates for `batch_sizes_[i]`, or
+  // nullopt if there isn't enough data to estimate it.
+  std::optional<std::pair<double, double>> EstimateLatency(int i) const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  void UpdateParamsLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  void Publish(int batch_size, int64_t batch_timeout_micros);
+
+  const Options options_;
+  // Candidate batch sizes in increasing order.
+  std::vector<int> batch_sizes_;
+
+  std::atomic<int> batch_size_;
+  std::atomic<int64_t> batch_timeout_micros_;
+
+  mutable mutex mu_;
+  std::vector<LatencyEstimate> latencies_ TF_GUARDED_BY(mu_);
+  int64_t batches_since_update_ TF_GUARDED_BY(mu_) = 0;
+
+  // Arrival rate estimation: units seen since `window_start_micros_`, folded
+  // into `arrival_rate_` once the window is long enough.
+  double arrival_rate_ TF_GUARDED_BY(mu_) = 0;
+  bool has_arrival_rate_ TF_GUARDED_BY(mu_) = false;
+  int64_t window_start_micros_ TF_GUARDED_BY(mu_) = -1;
+  int64_t window_units_ TF_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCHING_PARAMS_CONTROLLER_H_
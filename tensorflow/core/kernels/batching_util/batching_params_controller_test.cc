@@ -0,0 +1,198 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/batching_params_controller.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/kernels/batching_util/batch_stats.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+BatchingParamsController::Options TestOptions() {
+  BatchingParamsController::Options options;
+  options.target_p99_latency_micros = 10000;
+  options.max_batch_size = 32;
+  options.max_batch_timeout_micros = 5000;
+  // Use only the most recent sample, which makes the estimates exact.
+  options.decay = 1;
+  options.batches_between_updates = 1000;
+  options.min_samples_per_batch_size = 10;
+  return options;
+}
+
+// Records 'num_samples' batches of 'batch_size' that take
+// 1000 + 10 * batch_size microseconds to process.
+void RecordLatencies(BatchingParamsController& controller, int batch_size,
+                     int num_samples = 10) {
+  for (int i = 0; i < num_samples; ++i) {
+    controller.RecordBatchProcessed(batch_size, 1000 + 10 * batch_size);
+  }
+}
+
+// Records arrivals at a steady 'units_per_window' every 10ms.
+void RecordArrivals(BatchingParamsController& controller,
+                    int64_t units_per_window) {
+  for (int64_t now = 0; now <= 100000; now += 10000) {
+    controller.RecordArrival(units_per_window, now);
+  }
+}
+
+TEST(BatchingParamsControllerTest, BadOptions) {
+  std::unique_ptr<BatchingParamsController> controller;
+  BatchingParamsController::Options options = TestOptions();
+  options.target_p99_latency_micros = 0;
+  EXPECT_FALSE(BatchingParamsController::Create(options, &controller).ok());
+
+  options = TestOptions();
+  options.max_batch_size = 0;
+  EXPECT_FALSE(BatchingParamsController::Create(options, &controller).ok());
+
+  options = TestOptions();
+  options.decay = 0;
+  EXPECT_FALSE(BatchingParamsController::Create(options, &controller).ok());
+
+  options = TestOptions();
+  options.num_batch_threads = 0;
+  EXPECT_FALSE(BatchingParamsController::Create(options, &controller).ok());
+}
+
+TEST(BatchingParamsControllerTest, StartsWithUpperBoundsAndPublishes) {
+  ModelBatchStats stats;
+  BatchingParamsController::Options options = TestOptions();
+  options.model_batch_stats = &stats;
+  std::unique_ptr<BatchingParamsController> controller;
+  TF_ASSERT_OK(BatchingParamsController::Create(options, &controller));
+
+  EXPECT_EQ(controller->batch_size(), 32);
+  EXPECT_EQ(controller->batch_timeout_micros(), 5000);
+  EXPECT_EQ(stats.learned_batch_size(), 32);
+  EXPECT_EQ(stats.learned_batch_timeout_micros(), 5000);
+}
+
+TEST(BatchingParamsControllerTest, KeepsParamsWithoutData) {
+  std::unique_ptr<BatchingParamsController> controller;
+  TF_ASSERT_OK(BatchingParamsController::Create(TestOptions(), &controller));
+  controller->UpdateParams();
+  EXPECT_EQ(controller->batch_size(), 32);
+  EXPECT_EQ(controller->batch_timeout_micros(), 5000);
+}
+
+TEST(BatchingParamsControllerTest, EstimatesArrivalRate) {
+  std::unique_ptr<BatchingParamsController> controller;
+  TF_ASSERT_OK(BatchingParamsController::Create(TestOptions(), &controller));
+  RecordArrivals(*controller, /*units_per_window=*/1000);
+  EXPECT_DOUBLE_EQ(controller->arrival_rate(), 0.1);
+}
+
+TEST(BatchingParamsControllerTest, LowLoadPicksSmallBatches) {
+  ModelBatchStats stats;
+  BatchingParamsController::Options options = TestOptions();
+  options.model_batch_stats = &stats;
+  std::unique_ptr<BatchingParamsController> controller;
+  TF_ASSERT_OK(BatchingParamsController::Create(options, &controller));
+  for (int batch_size : {1, 2, 4, 8, 16, 32}) {
+    RecordLatencies(*controller, batch_size);
+  }
+  // One unit per millisecond: batches of one can't keep up (with headroom),
+  // batches of two can.
+  RecordArrivals(*controller, /*units_per_window=*/10);
+  controller->UpdateParams();
+
+  EXPECT_EQ(controller->batch_size(), 2);
+  // Waiting longer than it takes to fill the batch doesn't help.
+  EXPECT_EQ(controller->batch_timeout_micros(), 2000);
+  EXPECT_EQ(stats.learned_batch_size(), 2);
+  EXPECT_EQ(stats.learned_batch_timeout_micros(), 2000);
+}
+
+TEST(BatchingParamsControllerTest, HighLoadMaximizesThroughput) {
+  std::unique_ptr<BatchingParamsController> controller;
+  TF_ASSERT_OK(BatchingParamsController::Create(TestOptions(), &controller));
+  for (int batch_size : {1, 2, 4, 8, 16, 32}) {
+    RecordLatencies(*controller, batch_size);
+  }
+  RecordArrivals(*controller, /*units_per_window=*/1000);
+  controller->UpdateParams();
+
+  EXPECT_EQ(controller->batch_size(), 32);
+  EXPECT_EQ(controller->batch_timeout_micros(), 320);
+}
+
+TEST(BatchingParamsControllerTest, RespectsLatencyTarget) {
+  BatchingParamsController::Options options = TestOptions();
+  options.target_p99_latency_micros = 1200;
+  std::unique_ptr<BatchingParamsController> controller;
+  TF_ASSERT_OK(BatchingParamsController::Create(options, &controller));
+  for (int batch_size : {1, 2, 4, 8, 16, 32}) {
+    RecordLatencies(*controller, batch_size);
+  }
+  RecordArrivals(*controller, /*units_per_window=*/1000);
+  controller->UpdateParams();
+
+  // Batches of 32 take 1320us, which misses the target on their own. Batches
+  // of 16 would have to time out after 40us, holding only 4 units, so batches
+  // of 8 sustain the most throughput.
+  EXPECT_EQ(controller->batch_size(), 8);
+  EXPECT_EQ(controller->batch_timeout_micros(), 80);
+}
+
+TEST(BatchingParamsControllerTest, ExtrapolatesUnmeasuredBatchSizes) {
+  std::unique_ptr<BatchingParamsController> controller;
+  TF_ASSERT_OK(BatchingParamsController::Create(TestOptions(), &controller));
+  RecordLatencies(*controller, 1);
+  RecordLatencies(*controller, 2);
+  RecordArrivals(*controller, /*units_per_window=*/1000);
+  controller->UpdateParams();
+
+  EXPECT_EQ(controller->batch_size(), 32);
+}
+
+TEST(BatchingParamsControllerTest, BucketsBatchesByCandidateSize) {
+  BatchingParamsController::Options options = TestOptions();
+  options.candidate_batch_sizes = {8, 32};
+  std::unique_ptr<BatchingParamsController> controller;
+  TF_ASSERT_OK(BatchingParamsController::Create(options, &controller));
+  // Batches of 5 are padded to, and counted as, batches of 8.
+  for (int i = 0; i < 10; ++i) {
+    controller->RecordBatchProcessed(5, 1000);
+  }
+  RecordArrivals(*controller, /*units_per_window=*/10);
+  controller->UpdateParams();
+
+  EXPECT_EQ(controller->batch_size(), 8);
+}
+
+TEST(BatchingParamsControllerTest, UpdatesPeriodically) {
+  BatchingParamsController::Options options = TestOptions();
+  options.batches_between_updates = 20;
+  std::unique_ptr<BatchingParamsController> controller;
+  TF_ASSERT_OK(BatchingParamsController::Create(options, &controller));
+  RecordArrivals(*controller, /*units_per_window=*/10);
+  RecordLatencies(*controller, 1);
+  EXPECT_EQ(controller->batch_size(), 32);
+  RecordLatencies(*controller, 2);
+  EXPECT_EQ(controller->batch_size(), 2);
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
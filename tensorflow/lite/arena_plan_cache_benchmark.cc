@@ -0,0 +1,88 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+// Benchmark of AllocateTensors() for a model whose inputs alternate between
+// two shapes, with and without the arena plan cache of
+// InterpreterOptions::SetArenaPlanCacheSize().
+//
+// Run with:
+//   bazel run -c opt tensorflow/lite:arena_plan_cache_benchmark -- \
+//     --benchmark_filter=all
+//
+// and compare the cache_size:0 and cache_size:2 results of each num_ops.
+#include <memory>
+#include <vector>
+
+#include "benchmark/benchmark.h"  // from @com_google_benchmark
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/interpreter.h"
+#include "tensorflow/lite/core/kernels/builtin_op_kernels.h"
+#include "tensorflow/lite/interpreter_options.h"
+
+namespace tflite {
+namespace {
+
+// A chain of `num_ops` negate ops whose outputs are all summed by a final
+// ADD_N op, so that every intermediate tensor is live until the end and the
+// runtime planner has to fit each tensor around all previous ones.
+std::unique_ptr<Interpreter> BuildInterpreter(int num_ops, int cache_size) {
+  auto interpreter = std::make_unique<Interpreter>();
+  interpreter->AddTensors(num_ops + 2);
+  interpreter->SetInputs({0});
+  interpreter->SetOutputs({num_ops + 1});
+  TfLiteQuantizationParams quant;
+  for (int i = 0; i < num_ops + 2; ++i) {
+    interpreter->SetTensorParametersReadWrite(i, kTfLiteFloat32, "", {1},
+                                              quant);
+  }
+  std::vector<int> add_n_inputs;
+  for (int i = 0; i < num_ops; ++i) {
+    interpreter->AddNodeWithParameters({i}, {i + 1}, nullptr, 0, nullptr,
+                                       ops::builtin::Register_NEG());
+    add_n_inputs.push_back(i + 1);
+  }
+  interpreter->AddNodeWithParameters(add_n_inputs, {num_ops + 1}, nullptr, 0,
+                                     nullptr, ops::builtin::Register_ADD_N());
+
+  InterpreterOptions options;
+  options.SetArenaPlanCacheSize(cache_size);
+  interpreter->ApplyOptions(&options);
+  return interpreter;
+}
+
+void BM_AllocateTensorsAlternatingShapes(benchmark::State& state) {
+  const int num_ops = state.range(0);
+  const int cache_size = state.range(1);
+  std::unique_ptr<Interpreter> interpreter =
+      BuildInterpreter(num_ops, cache_size);
+  bool large = false;
+  for (auto _ : state) {
+    large = !large;
+    if (interpreter->ResizeInputTensor(0, {large ? 1024 : 16}) != kTfLiteOk ||
+        interpreter->AllocateTensors() != kTfLiteOk) {
+      state.SkipWithError("Failed to allocate tensors.");
+      return;
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_AllocateTensorsAlternatingShapes)
+    ->ArgNames({"num_ops", "cache_size"})
+    ->ArgsProduct({{16, 128, 1024}, {0, 2}});
+
+}  // namespace
+}  // namespace tflite
+
+BENCHMARK_MAIN();
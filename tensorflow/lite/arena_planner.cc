@@ -25,6 +25,7 @@ limitations under the License.
 
 #include "tensorflow/lite/core/c/common.h"
 #include "tensorflow/lite/graph_info.h"
+#include "tensorflow/lite/offline_arena_plan.h"
 #include "tensorflow/lite/simple_memory_arena.h"
 
 namespace tflite {
@@ -94,6 +95,103 @@ TfLiteStatus ArenaPlanner::ResetAllocationsAfter(int node) {
   return kTfLiteOk;
 }
 
+TfLiteStatus ArenaPlanner::SetExecutionWavefronts(
+    const std::vector<int>& wavefront_ends) {
+  wavefront_first_node_.clear();
+  wavefront_last_node_.clear();
+  int first_node = 0;
+  for (int end : wavefront_ends) {
+    TF_LITE_ENSURE(context_, end > first_node);
+    first_node = end;
+  }
+  first_node = 0;
+  for (int end : wavefront_ends) {
+    wavefront_first_node_.insert(wavefront_first_node_.end(), end - first_node,
+                                 first_node);
+    wavefront_last_node_.insert(wavefront_last_node_.end(), end - first_node,
+                                end - 1);
+    first_node = end;
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus ArenaPlanner::SetOfflineArenaPlan(OfflineArenaPlan plan) {
+  offline_plan_.clear();
+  offline_plan_index_.clear();
+  if (plan.empty()) return kTfLiteOk;
+  TF_LITE_ENSURE(context_, IsValidOfflineArenaPlan(plan, tensor_alignment_));
+  // The plan comes from the model, so it is not trusted to refer to tensors
+  // and nodes of this subgraph.
+  const int32_t num_tensors = graph_info_->num_tensors();
+  const int32_t num_nodes = graph_info_->num_total_nodes();
+  std::vector<int32_t> index;
+  for (int32_t i = 0; i < static_cast<int32_t>(plan.size()); ++i) {
+    const int32_t tensor = plan[i].tensor;
+    TF_LITE_ENSURE(context_, tensor >= 0 && tensor < num_tensors);
+    TF_LITE_ENSURE(context_, plan[i].first_node >= 0 &&
+                                 plan[i].first_node <= plan[i].last_node &&
+                                 plan[i].last_node < num_nodes);
+    if (tensor >= static_cast<int32_t>(index.size())) {
+      index.resize(tensor + 1, -1);
+    }
+    TF_LITE_ENSURE_EQ(context_, index[tensor], -1);
+    index[tensor] = i;
+  }
+  offline_plan_ = std::move(plan);
+  offline_plan_index_ = std::move(index);
+  return kTfLiteOk;
+}
+
+OfflineArenaPlan ArenaPlanner::GetArenaAllocations() const {
+  OfflineArenaPlan allocations;
+  const TfLiteTensor* tensors = graph_info_->tensors();
+  for (const ArenaAllocWithUsageInterval& alloc : allocs_) {
+    if (alloc.size > 0 &&
+        tensors[alloc.tensor].allocation_type == kTfLiteArenaRw) {
+      allocations.push_back({alloc.tensor, alloc.first_node, alloc.last_node,
+                             alloc.offset, alloc.size});
+    }
+  }
+  return allocations;
+}
+
+bool ArenaPlanner::OfflinePlanCovers(
+    const std::vector<int32_t>& tensors_to_allocate) const {
+  if (offline_plan_.empty()) return false;
+  const TfLiteTensor* tensors = graph_info_->tensors();
+  for (int32_t tensor_index : tensors_to_allocate) {
+    const TfLiteTensor& tensor = tensors[tensor_index];
+    if (tensor.allocation_type != kTfLiteArenaRw || tensor.bytes == 0 ||
+        actual_tensor_id_.count(tensor_index)) {
+      continue;
+    }
+    if (tensor_index >= static_cast<int32_t>(offline_plan_index_.size()) ||
+        offline_plan_index_[tensor_index] == -1) {
+      return false;
+    }
+    const OfflineArenaAllocation& planned =
+        offline_plan_[offline_plan_index_[tensor_index]];
+    if (planned.size < tensor.bytes ||
+        planned.first_node > alloc_node_[tensor_index] ||
+        planned.last_node < dealloc_node_[tensor_index]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ArenaPlanner::ExtendLifetimesToWavefronts() {
+  if (wavefront_first_node_.empty()) return;
+  for (size_t i = 0; i < alloc_node_.size(); ++i) {
+    if (alloc_node_[i] != kNodeNotAssigned) {
+      alloc_node_[i] = wavefront_first_node_[alloc_node_[i]];
+    }
+    if (dealloc_node_[i] != kNodeNotAssigned) {
+      dealloc_node_[i] = wavefront_last_node_[dealloc_node_[i]];
+    }
+  }
+}
+
 int ArenaPlanner::FindSharedTensor(int tensor_index) {
   auto actual_tensor_it = actual_tensor_id_.find(tensor_index);
   if (actual_tensor_it != actual_tensor_id_.end()) {
@@ -333,6 +431,14 @@ TfLiteStatus ArenaPlanner::PlanAllocations() {
   }
   // Note that graph outputs will never be scheduled for deallocation. We
   // could do that here for completeness, but it won't have any effect.
+  if (wavefront_first_node_.size() !=
+      static_cast<size_t>(num_execution_nodes)) {
+    // The execution plan changed since the wavefronts were set, so its nodes
+    // will run sequentially.
+    wavefront_first_node_.clear();
+    wavefront_last_node_.clear();
+  }
+  ExtendLifetimesToWavefronts();
   return kTfLiteOk;
 }
 
@@ -350,12 +456,18 @@ TfLiteStatus ArenaPlanner::ExecuteAllocations(int first_node, int last_node) {
        i <= static_cast<size_t>(last_node) && i < num_execution_nodes; ++i) {
     const TfLiteNode& node = graph_info_->node(i);
     TfLiteIntArray* node_temporaries = node.temporaries;
+    // Temporaries of concurrent nodes must not share memory either.
+    const bool concurrent = i < wavefront_first_node_.size();
+    const int32_t first_concurrent_node =
+        concurrent ? wavefront_first_node_[i] : static_cast<int32_t>(i);
+    const int32_t last_concurrent_node =
+        concurrent ? wavefront_last_node_[i] : static_cast<int32_t>(i);
     for (int j = 0; j < node_temporaries->size; ++j) {
       int tensor_index = node_temporaries->data[j];
-      alloc_node_[tensor_index] = i;
+      alloc_node_[tensor_index] = first_concurrent_node;
       nodes_to_tensors_[i].insert(tensor_index);
       if (!preserve_all_tensors_) {
-        dealloc_node_[tensor_index] = i;
+        dealloc_node_[tensor_index] = last_concurrent_node;
       }
     }
   }
@@ -518,10 +630,7 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(
     arena_.PurgeActiveAllocs(first_node);
   }
   CreateTensorAllocationVector(tensors_allocated);
-  // Vector of ids of already allocated tensors, ordered by offset.
   for (const auto& tensor_index : *tensors_allocated) {
-    TfLiteTensor& tensor = tensors[tensor_index];
-    // Only allocate ArenaRw tensors which own their buffer.
     auto it = actual_tensor_id_.find(tensor_index);
     if (it != actual_tensor_id_.end()) {
       // A tensor whose buffer is shared may have had its allocation type
@@ -535,16 +644,31 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(
       if (allocation_type != kTfLiteArenaRw ||
           tensors[it->second].bytes != tensors[it->first].bytes) {
         actual_tensor_id_.erase(it);
-      } else {
-        // Don't allocate the tensor, it can safely share the input buffer.
-        continue;
       }
     }
+  }
+  // The offline plan is only used for whole plans, so that the tensors it
+  // places don't have to fit around ones placed at runtime.
+  const bool use_offline_plan =
+      first_node == 0 && OfflinePlanCovers(*tensors_allocated);
+  // Vector of ids of already allocated tensors, ordered by offset.
+  for (const auto& tensor_index : *tensors_allocated) {
+    TfLiteTensor& tensor = tensors[tensor_index];
+    // Only allocate ArenaRw tensors which own their buffer. Others can safely
+    // share their input buffer.
+    if (actual_tensor_id_.count(tensor_index)) continue;
     if (tensor.allocation_type == kTfLiteArenaRw) {
-      TF_LITE_ENSURE_STATUS(
-          arena_.Allocate(context_, tensor_alignment_, tensor.bytes,
-                          tensor_index, alloc_node_[tensor_index],
-                          dealloc_node_[tensor_index], &allocs_[tensor_index]));
+      if (use_offline_plan && tensor.bytes > 0) {
+        TF_LITE_ENSURE_STATUS(arena_.AllocateAt(
+            context_, offline_plan_[offline_plan_index_[tensor_index]].offset,
+            tensor.bytes, tensor_index, alloc_node_[tensor_index],
+            dealloc_node_[tensor_index], &allocs_[tensor_index]));
+      } else {
+        TF_LITE_ENSURE_STATUS(arena_.Allocate(
+            context_, tensor_alignment_, tensor.bytes, tensor_index,
+            alloc_node_[tensor_index], dealloc_node_[tensor_index],
+            &allocs_[tensor_index]));
+      }
     }
     // Check allocs_[].size to prevent from reallocation of persistent tensors.
     // Only allocate ArenaRwPersistent tensors which own their buffer.
@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/lite/core/c/common.h"
 #include "tensorflow/lite/graph_info.h"
 #include "tensorflow/lite/memory_planner.h"
+#include "tensorflow/lite/offline_arena_plan.h"
 #include "tensorflow/lite/simple_memory_arena.h"
 #include "tensorflow/lite/util.h"
 
@@ -60,6 +61,10 @@ class ArenaPlanner : public MemoryPlanner {
 
   TfLiteStatus ResetAllocations() override;
   TfLiteStatus ResetAllocationsAfter(int node) override;
+  TfLiteStatus SetExecutionWavefronts(
+      const std::vector<int>& wavefront_ends) override;
+  TfLiteStatus SetOfflineArenaPlan(OfflineArenaPlan plan) override;
+  OfflineArenaPlan GetArenaAllocations() const override;
   TfLiteStatus PlanAllocations() override;
   TfLiteStatus ExecuteAllocations(int first_node, int last_node) override;
   TfLiteStatus ReleaseNonPersistentMemory() override;
@@ -120,6 +125,16 @@ class ArenaPlanner : public MemoryPlanner {
   // Return the index of the tensor owing `tensor_index's` buffer.
   int FindSharedTensor(int tensor_index);
 
+  // Widens the lifetime of tensors so that it covers the whole wavefront of
+  // the nodes allocating and deallocating them. No-op if nodes run
+  // sequentially.
+  void ExtendLifetimesToWavefronts();
+
+  // Returns true if the offline plan has an allocation for each of the
+  // `tensors` owning an arena buffer, at least as large and long-lived as
+  // needed.
+  bool OfflinePlanCovers(const std::vector<int32_t>& tensors) const;
+
   TfLiteContext* context_;
   std::unique_ptr<GraphInfo> graph_info_;
 
@@ -166,6 +181,18 @@ class ArenaPlanner : public MemoryPlanner {
 
   // Store number of references to each tensor.
   std::vector<int> refcounts_;
+
+  // First and last execution plan index of the wavefront of each node, if
+  // nodes of a wavefront may run concurrently. Tensors used by concurrent
+  // nodes must not share memory, so their lifetimes are widened to whole
+  // wavefronts. Empty when nodes run sequentially.
+  std::vector<int32_t> wavefront_first_node_;
+  std::vector<int32_t> wavefront_last_node_;
+
+  // Offsets of the arena tensors computed ahead of time, if any, and the
+  // index of the allocation of each tensor in it or -1.
+  OfflineArenaPlan offline_plan_;
+  std::vector<int32_t> offline_plan_index_;
 };
 
 }  // namespace tflite
@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/lite/c/c_api_types.h"
 #include "tensorflow/lite/core/c/common.h"
 #include "tensorflow/lite/graph_info.h"
+#include "tensorflow/lite/offline_arena_plan.h"
 
 namespace tflite {
 
@@ -266,6 +267,14 @@ class ArenaPlannerTest : public ::testing::Test {
     return offset;
   }
 
+  // Returns true if the buffers of the given tensors overlap.
+  bool Overlap(int tensor_index1, int tensor_index2) {
+    const std::ptrdiff_t offset1 = GetOffset(tensor_index1);
+    const std::ptrdiff_t offset2 = GetOffset(tensor_index2);
+    return offset1 < offset2 + (*graph_->tensors())[tensor_index2].bytes &&
+           offset2 < offset1 + (*graph_->tensors())[tensor_index1].bytes;
+  }
+
   // Returns if the given tensor is unallocated or not.
   bool IsUnallocated(int tensor_index) {
     return (*graph_->tensors())[tensor_index].data.raw == nullptr;
@@ -1114,5 +1123,124 @@ TEST_F(ArenaPlannerTest, SimpleProfilerTest) {
   EXPECT_EQ(gNumDealloc, 1);
 }
 
+TEST_F(ArenaPlannerTest, ConcurrentNodesDontShareMemory) {
+  // Two branches, executed wavefront by wavefront: {0, 1}, {2, 3} and {4}.
+  TestGraph graph({0},
+                  {
+                      /* in, out, tmp */
+                      {{0}, {1}, {}},      // Branch 1
+                      {{0}, {2}, {}},      // Branch 2
+                      {{1}, {3}, {7}},     // Branch 1
+                      {{2}, {4}, {8}},     // Branch 2
+                      {{3, 4}, {5}, {}},  // Join
+                  },
+                  {5});
+  SetGraph(&graph);
+  Execute(0, graph.nodes().size() - 1);
+  // Nodes 2 and 3 run one after the other, so their temporaries can share
+  // memory, and so can the input of node 2 and the output of node 3.
+  EXPECT_TRUE(Overlap(7, 8));
+  EXPECT_TRUE(Overlap(1, 4));
+
+  ASSERT_EQ(planner_->SetExecutionWavefronts({2, 4, 5}), kTfLiteOk);
+  ASSERT_EQ(planner_->PlanAllocations(), kTfLiteOk);
+  Execute(0, graph.nodes().size() - 1);
+  EXPECT_FALSE(Overlap(7, 8));
+  EXPECT_FALSE(Overlap(1, 4));
+  EXPECT_FALSE(Overlap(3, 8));
+
+  // Back to sequential execution.
+  ASSERT_EQ(planner_->SetExecutionWavefronts({}), kTfLiteOk);
+  ASSERT_EQ(planner_->PlanAllocations(), kTfLiteOk);
+  Execute(0, graph.nodes().size() - 1);
+  EXPECT_TRUE(Overlap(7, 8));
+}
+
+TEST_F(ArenaPlannerTest, InvalidWavefronts) {
+  TestGraph graph({0}, {{{0}, {1}, {}}, {{0}, {2}, {}}}, {1, 2});
+  SetGraph(&graph);
+  EXPECT_EQ(planner_->SetExecutionWavefronts({1, 1}), kTfLiteError);
+}
+
+TEST_F(ArenaPlannerTest, UsesOfflinePlan) {
+  TestGraph graph({0},
+                  {
+                      /* in, out, tmp */
+                      {{0}, {1}, {4}},
+                      {{1}, {2}, {}},
+                      {{2}, {3}, {}},
+                  },
+                  {3});
+  SetGraph(&graph);
+  Execute(0, graph.nodes().size() - 1);
+  const OfflineArenaPlan runtime_plan = planner_->GetArenaAllocations();
+  ASSERT_EQ(runtime_plan.size(), 5);
+  const std::ptrdiff_t runtime_offset = GetOffset(3);
+
+  // Places the tensors one after the other, in reverse order.
+  OfflineArenaPlan plan = runtime_plan;
+  for (OfflineArenaAllocation& alloc : plan) {
+    alloc.offset = (4 - alloc.tensor) * 64;
+  }
+  ASSERT_EQ(planner_->SetOfflineArenaPlan(plan), kTfLiteOk);
+  ResetAllocations();
+  Execute(0, graph.nodes().size() - 1);
+  for (int tensor = 0; tensor <= 4; ++tensor) {
+    EXPECT_EQ(GetOffset(tensor), (4 - tensor) * 64);
+  }
+
+  // Tensors larger than planned are planned at runtime.
+  (*graph.tensors())[2].bytes = 100;
+  ResetAllocations();
+  Execute(0, graph.nodes().size() - 1);
+  EXPECT_NE(GetOffset(0), 4 * 64);
+  (*graph.tensors())[2].bytes = 9;
+
+  // So are tensors missing from the plan.
+  plan.pop_back();
+  ASSERT_EQ(planner_->SetOfflineArenaPlan(plan), kTfLiteOk);
+  ResetAllocations();
+  Execute(0, graph.nodes().size() - 1);
+  EXPECT_EQ(GetOffset(3), runtime_offset);
+}
+
+TEST_F(ArenaPlannerTest, InvalidOfflinePlan) {
+  TestGraph graph({0}, {{{0}, {1}, {}}, {{1}, {2}, {}}}, {2});
+  SetGraph(&graph);
+  Execute(0, graph.nodes().size() - 1);
+  OfflineArenaPlan plan = planner_->GetArenaAllocations();
+  ASSERT_EQ(plan.size(), 3);
+  // Tensors 0 and 1 are both used by node 0.
+  plan[0].offset = plan[1].offset;
+  EXPECT_EQ(planner_->SetOfflineArenaPlan(plan), kTfLiteError);
+  plan[0].offset = 1;
+  EXPECT_EQ(planner_->SetOfflineArenaPlan(plan), kTfLiteError);
+  EXPECT_EQ(planner_->SetOfflineArenaPlan({}), kTfLiteOk);
+}
+
+TEST_F(ArenaPlannerTest, OfflinePlanOutOfRange) {
+  TestGraph graph({0}, {{{0}, {1}, {}}, {{1}, {2}, {}}}, {2});
+  SetGraph(&graph);
+  Execute(0, graph.nodes().size() - 1);
+  const OfflineArenaPlan plan = planner_->GetArenaAllocations();
+  ASSERT_EQ(plan.size(), 3);
+  ASSERT_EQ(planner_->SetOfflineArenaPlan(plan), kTfLiteOk);
+
+  OfflineArenaPlan bad_plan = plan;
+  bad_plan[2].tensor = graph.tensors()->size();
+  EXPECT_EQ(planner_->SetOfflineArenaPlan(bad_plan), kTfLiteError);
+  bad_plan[2].tensor = -1;
+  EXPECT_EQ(planner_->SetOfflineArenaPlan(bad_plan), kTfLiteError);
+
+  bad_plan = plan;
+  bad_plan[2].last_node = graph.nodes().size();
+  EXPECT_EQ(planner_->SetOfflineArenaPlan(bad_plan), kTfLiteError);
+  bad_plan[2].last_node = plan[2].first_node - 1;
+  EXPECT_EQ(planner_->SetOfflineArenaPlan(bad_plan), kTfLiteError);
+  bad_plan = plan;
+  bad_plan[0].first_node = -1;
+  EXPECT_EQ(planner_->SetOfflineArenaPlan(bad_plan), kTfLiteError);
+}
+
 }  // namespace
 }  // namespace tflite
@@ -0,0 +1,286 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/batched_signature_runner.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/interpreter_builder.h"
+#include "tensorflow/lite/minimal_logging.h"
+#include "tensorflow/lite/model_builder.h"
+#include "tensorflow/lite/op_resolver.h"
+
+namespace tflite {
+namespace {
+
+bool IsBatchable(const TfLiteTensor& tensor) {
+  return tensor.dims != nullptr && tensor.dims->size > 0 &&
+         tensor.type != kTfLiteString && tensor.type != kTfLiteResource &&
+         tensor.type != kTfLiteVariant;
+}
+
+}  // namespace
+
+BatchedSignatureRunner::BatchedSignatureRunner(const Options& options)
+    : options_(options) {}
+
+std::unique_ptr<BatchedSignatureRunner> BatchedSignatureRunner::Create(
+    const FlatBufferModel& model, const OpResolver& op_resolver,
+    const std::string& signature_key, const Options& options) {
+  if (options.batch_sizes.empty() || options.batch_sizes[0] < 1) {
+    TFLITE_LOG(TFLITE_LOG_ERROR, "Batch sizes must be positive.");
+    return nullptr;
+  }
+  for (size_t i = 1; i < options.batch_sizes.size(); ++i) {
+    if (options.batch_sizes[i] <= options.batch_sizes[i - 1]) {
+      TFLITE_LOG(TFLITE_LOG_ERROR, "Batch sizes must be increasing.");
+      return nullptr;
+    }
+  }
+
+  std::unique_ptr<BatchedSignatureRunner> batched_runner(
+      new BatchedSignatureRunner(options));
+  for (int batch_size : options.batch_sizes) {
+    Bucket bucket;
+    bucket.batch_size = batch_size;
+    InterpreterBuilder builder(model, op_resolver);
+    if (builder.SetNumThreads(options.num_threads) != kTfLiteOk ||
+        builder(&bucket.interpreter) != kTfLiteOk) {
+      return nullptr;
+    }
+    bucket.runner = bucket.interpreter->GetSignatureRunner(
+        signature_key.c_str());
+    if (bucket.runner == nullptr) {
+      TFLITE_LOG(TFLITE_LOG_ERROR, "Signature '%s' not found.",
+                 signature_key.c_str());
+      return nullptr;
+    }
+    for (const char* name : bucket.runner->input_names()) {
+      const TfLiteTensor* input = bucket.runner->input_tensor(name);
+      if (!IsBatchable(*input)) {
+        TFLITE_LOG(TFLITE_LOG_ERROR, "Input '%s' can't be batched.", name);
+        return nullptr;
+      }
+      std::vector<int> dims(input->dims->data,
+                            input->dims->data + input->dims->size);
+      dims[0] = batch_size;
+      if (bucket.runner->ResizeInputTensor(name, dims) != kTfLiteOk) {
+        return nullptr;
+      }
+    }
+    if (bucket.runner->AllocateTensors() != kTfLiteOk) {
+      TFLITE_LOG(TFLITE_LOG_ERROR,
+                 "Signature '%s' can't be allocated for batch size %d.",
+                 signature_key.c_str(), batch_size);
+      return nullptr;
+    }
+    for (const char* name : bucket.runner->output_names()) {
+      const TfLiteTensor* output = bucket.runner->output_tensor(name);
+      // Dynamic outputs are only known after invocation.
+      if (output->allocation_type == kTfLiteDynamic) continue;
+      if (!IsBatchable(*output) || output->dims->data[0] != batch_size) {
+        TFLITE_LOG(TFLITE_LOG_ERROR, "Output '%s' can't be batched.", name);
+        return nullptr;
+      }
+    }
+    batched_runner->buckets_.push_back(std::move(bucket));
+  }
+
+  const Bucket& bucket = batched_runner->buckets_.front();
+  for (const char* name : bucket.runner->input_names()) {
+    const TfLiteTensor* input = bucket.runner->input_tensor(name);
+    InputInfo info;
+    info.name = name;
+    info.type = input->type;
+    info.example_dims.assign(input->dims->data + 1,
+                             input->dims->data + input->dims->size);
+    info.example_bytes = input->bytes / bucket.batch_size;
+    batched_runner->inputs_.push_back(std::move(info));
+  }
+
+  batched_runner->batching_thread_ =
+      std::thread([runner = batched_runner.get()] { runner->BatchingLoop(); });
+  return batched_runner;
+}
+
+BatchedSignatureRunner::~BatchedSignatureRunner() {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    stop_ = true;
+  }
+  queue_cv_.notify_all();
+  if (batching_thread_.joinable()) batching_thread_.join();
+}
+
+TfLiteStatus BatchedSignatureRunner::ValidateInputs(const TensorMap& inputs,
+                                                    int* batch_size) const {
+  if (inputs.size() != inputs_.size()) {
+    TFLITE_LOG(TFLITE_LOG_ERROR, "Expected %d inputs, got %d.",
+               static_cast<int>(inputs_.size()),
+               static_cast<int>(inputs.size()));
+    return kTfLiteError;
+  }
+  *batch_size = -1;
+  for (const InputInfo& info : inputs_) {
+    auto it = inputs.find(info.name);
+    if (it == inputs.end()) {
+      TFLITE_LOG(TFLITE_LOG_ERROR, "Missing input '%s'.", info.name.c_str());
+      return kTfLiteError;
+    }
+    const TensorValue& value = it->second;
+    if (value.type != info.type || value.dims.empty() ||
+        !std::equal(value.dims.begin() + 1, value.dims.end(),
+                    info.example_dims.begin(), info.example_dims.end())) {
+      TFLITE_LOG(TFLITE_LOG_ERROR,
+                 "Input '%s' doesn't match the type or shape of the "
+                 "signature.",
+                 info.name.c_str());
+      return kTfLiteError;
+    }
+    if (*batch_size == -1) *batch_size = value.dims[0];
+    if (value.dims[0] != *batch_size || *batch_size < 1 ||
+        *batch_size > max_batch_size()) {
+      TFLITE_LOG(TFLITE_LOG_ERROR,
+                 "Inputs must have the same number of examples, between 1 "
+                 "and %d.",
+                 max_batch_size());
+      return kTfLiteError;
+    }
+    const size_t bytes = static_cast<size_t>(*batch_size) * info.example_bytes;
+    if (value.data.size() != bytes) {
+      TFLITE_LOG(TFLITE_LOG_ERROR, "Input '%s' has %d bytes, expected %d.",
+                 info.name.c_str(), static_cast<int>(value.data.size()),
+                 static_cast<int>(bytes));
+      return kTfLiteError;
+    }
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus BatchedSignatureRunner::Invoke(const TensorMap& inputs,
+                                            TensorMap* outputs) {
+  Request request;
+  request.inputs = &inputs;
+  request.outputs = outputs;
+  TF_LITE_ENSURE_STATUS(ValidateInputs(inputs, &request.batch_size));
+  request.enqueue_time = std::chrono::steady_clock::now();
+
+  std::unique_lock<std::mutex> lock(mu_);
+  if (stop_) return kTfLiteError;
+  queue_.push_back(&request);
+  queued_batch_size_ += request.batch_size;
+  queue_cv_.notify_one();
+  done_cv_.wait(lock, [&request] { return request.done; });
+  return request.status;
+}
+
+void BatchedSignatureRunner::BatchingLoop() {
+  std::unique_lock<std::mutex> lock(mu_);
+  while (true) {
+    queue_cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+    if (stop_) break;
+    // Give other requests a chance to join the batch of the oldest one.
+    queue_cv_.wait_until(
+        lock, queue_.front()->enqueue_time + options_.batch_timeout,
+        [this] { return stop_ || queued_batch_size_ >= max_batch_size(); });
+    if (stop_) break;
+
+    std::vector<Request*> requests;
+    int batch_size = 0;
+    while (!queue_.empty() &&
+           batch_size + queue_.front()->batch_size <= max_batch_size()) {
+      batch_size += queue_.front()->batch_size;
+      requests.push_back(queue_.front());
+      queue_.pop_front();
+    }
+    queued_batch_size_ -= batch_size;
+
+    lock.unlock();
+    RunBatch(requests, batch_size);
+    lock.lock();
+    for (Request* request : requests) request->done = true;
+    done_cv_.notify_all();
+  }
+
+  for (Request* request : queue_) {
+    request->status = kTfLiteError;
+    request->done = true;
+  }
+  queue_.clear();
+  done_cv_.notify_all();
+}
+
+void BatchedSignatureRunner::RunBatch(const std::vector<Request*>& requests,
+                                      int batch_size) {
+  auto set_status = [&requests](TfLiteStatus status) {
+    for (Request* request : requests) request->status = status;
+  };
+  const Bucket* bucket = &buckets_.back();
+  for (const Bucket& candidate : buckets_) {
+    if (candidate.batch_size >= batch_size) {
+      bucket = &candidate;
+      break;
+    }
+  }
+
+  for (const InputInfo& info : inputs_) {
+    TfLiteTensor* input = bucket->runner->input_tensor(info.name.c_str());
+    char* data = input->data.raw;
+    for (const Request* request : requests) {
+      const std::vector<char>& value = request->inputs->at(info.name).data;
+      std::memcpy(data, value.data(), value.size());
+      data += value.size();
+    }
+    // Padding examples are zeros so that their results are well defined.
+    std::memset(data, 0, input->data.raw + input->bytes - data);
+  }
+
+  if (bucket->runner->Invoke() != kTfLiteOk) {
+    set_status(kTfLiteError);
+    return;
+  }
+
+  for (const char* name : bucket->runner->output_names()) {
+    const TfLiteTensor* output = bucket->runner->output_tensor(name);
+    if (!IsBatchable(*output) || output->dims->data[0] != bucket->batch_size) {
+      TFLITE_LOG(TFLITE_LOG_ERROR, "Output '%s' can't be batched.", name);
+      set_status(kTfLiteError);
+      return;
+    }
+    const size_t example_bytes = output->bytes / bucket->batch_size;
+    const char* data = output->data.raw_const;
+    for (Request* request : requests) {
+      TensorValue& value = (*request->outputs)[name];
+      value.type = output->type;
+      value.dims.assign(output->dims->data,
+                        output->dims->data + output->dims->size);
+      value.dims[0] = request->batch_size;
+      const size_t bytes = request->batch_size * example_bytes;
+      value.data.assign(data, data + bytes);
+      data += bytes;
+    }
+  }
+  set_status(kTfLiteOk);
+}
+
+}  // namespace tflite
@@ -0,0 +1,170 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/// \file
+///
+/// Batches concurrent requests to a signature of a TF Lite model.
+#ifndef TENSORFLOW_LITE_BATCHED_SIGNATURE_RUNNER_H_
+#define TENSORFLOW_LITE_BATCHED_SIGNATURE_RUNNER_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/model_builder.h"
+#include "tensorflow/lite/op_resolver.h"
+#include "tensorflow/lite/signature_runner.h"
+
+namespace tflite {
+
+/// Runs concurrent requests to a signature in batches.
+///
+/// Requests are queued and concatenated along their first (batch) dimension,
+/// up to the largest configured batch size. Each batch runs in a single
+/// invocation of an interpreter preallocated for the smallest configured batch
+/// size that fits it, padded with zeros, and the outputs are sliced back into
+/// the requests. All interpreters are built from the same `FlatBufferModel`,
+/// so they share its read-only weights.
+///
+/// Every input and output of the signature must have a leading batch
+/// dimension that the model can be resized along, and examples must be
+/// independent of each other within a batch. String, resource and variant
+/// tensors are not supported.
+///
+/// Usage:
+///
+/// <pre><code>
+/// auto runner = tflite::BatchedSignatureRunner::Create(
+///     *model, resolver, "serving_default", {});
+/// tflite::BatchedSignatureRunner::TensorMap inputs, outputs;
+/// inputs["x"] = {kTfLiteFloat32, {1, 4}, /*data=*/...};
+/// // From any number of threads:
+/// if (runner->Invoke(inputs, &outputs) != kTfLiteOk) {
+///   // Return failure.
+/// }
+/// </code></pre>
+///
+/// WARNING: This is an experimental API and subject to change.
+class BatchedSignatureRunner {
+ public:
+  struct Options {
+    /// Batch sizes an interpreter is preallocated for, in increasing order.
+    std::vector<int> batch_sizes = {1, 2, 4, 8, 16, 32};
+    /// How long the oldest queued request waits for others to fill the
+    /// largest batch before its batch runs anyway.
+    std::chrono::microseconds batch_timeout = std::chrono::microseconds(1000);
+    /// Number of threads each interpreter may use, as in
+    /// `InterpreterBuilder::SetNumThreads`.
+    int num_threads = -1;
+  };
+
+  /// The value of a signature input or output for a single request. The
+  /// first dimension is the number of examples in the request.
+  struct TensorValue {
+    TfLiteType type = kTfLiteNoType;
+    std::vector<int> dims;
+    std::vector<char> data;
+  };
+  /// Maps signature input or output names to their values.
+  using TensorMap = std::map<std::string, TensorValue>;
+
+  /// Creates a runner for the signature `signature_key` of `model`, or
+  /// returns nullptr if the signature can't be batched. `model` and
+  /// `op_resolver` must outlive the runner.
+  static std::unique_ptr<BatchedSignatureRunner> Create(
+      const FlatBufferModel& model, const OpResolver& op_resolver,
+      const std::string& signature_key, const Options& options);
+
+  /// Fails the requests that are still queued.
+  ~BatchedSignatureRunner();
+
+  BatchedSignatureRunner(const BatchedSignatureRunner&) = delete;
+  BatchedSignatureRunner& operator=(const BatchedSignatureRunner&) = delete;
+
+  /// Runs the signature on `inputs`, batched with concurrent requests, and
+  /// sets `outputs` to its outputs. Blocks until the batch has run. Every
+  /// input must be given, with the same number of examples, at most
+  /// `max_batch_size()`. Thread-safe.
+  TfLiteStatus Invoke(const TensorMap& inputs, TensorMap* outputs);
+
+  /// Returns the largest number of examples that run in one batch.
+  int max_batch_size() const { return buckets_.back().batch_size; }
+
+ private:
+  // An interpreter preallocated for a batch size.
+  struct Bucket {
+    int batch_size;
+    std::unique_ptr<Interpreter> interpreter;
+    SignatureRunner* runner;
+  };
+
+  // Shape and type of a single example of a signature input.
+  struct InputInfo {
+    std::string name;
+    TfLiteType type;
+    std::vector<int> example_dims;
+    size_t example_bytes;
+  };
+
+  struct Request {
+    const TensorMap* inputs;
+    TensorMap* outputs;
+    int batch_size;
+    std::chrono::steady_clock::time_point enqueue_time;
+    TfLiteStatus status = kTfLiteOk;
+    bool done = false;
+  };
+
+  explicit BatchedSignatureRunner(const Options& options);
+
+  // Checks `inputs` against the signature and returns the number of examples
+  // in `batch_size`.
+  TfLiteStatus ValidateInputs(const TensorMap& inputs, int* batch_size) const;
+
+  // Forms batches from the queued requests and runs them.
+  void BatchingLoop();
+
+  // Runs `requests`, which have `batch_size` examples in total, in one
+  // invocation and sets their status and outputs.
+  void RunBatch(const std::vector<Request*>& requests, int batch_size);
+
+  const Options options_;
+  std::vector<Bucket> buckets_;
+  std::vector<InputInfo> inputs_;
+
+  std::mutex mu_;
+  // Signals the batching thread that requests were queued or that the runner
+  // is being destroyed.
+  std::condition_variable queue_cv_;
+  // Signals callers of Invoke() that their request is done.
+  std::condition_variable done_cv_;
+  std::deque<Request*> queue_;
+  int queued_batch_size_ = 0;
+  bool stop_ = false;
+
+  std::thread batching_thread_;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_BATCHED_SIGNATURE_RUNNER_H_
@@ -0,0 +1,133 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/batched_signature_runner.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstring>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/kernels/register.h"
+#include "tensorflow/lite/model_builder.h"
+
+namespace tflite {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+
+BatchedSignatureRunner::TensorValue FloatValue(
+    const std::vector<float>& values) {
+  BatchedSignatureRunner::TensorValue value;
+  value.type = kTfLiteFloat32;
+  value.dims = {static_cast<int>(values.size())};
+  value.data.resize(values.size() * sizeof(float));
+  std::memcpy(value.data.data(), values.data(), value.data.size());
+  return value;
+}
+
+std::vector<float> FloatValues(
+    const BatchedSignatureRunner::TensorValue& value) {
+  std::vector<float> values(value.data.size() / sizeof(float));
+  std::memcpy(values.data(), value.data.data(), value.data.size());
+  return values;
+}
+
+class BatchedSignatureRunnerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    model_ = FlatBufferModel::BuildFromFile(
+        "tensorflow/lite/testdata/multi_signatures.bin");
+    ASSERT_NE(model_, nullptr);
+  }
+
+  std::unique_ptr<FlatBufferModel> model_;
+  ops::builtin::BuiltinOpResolver resolver_;
+};
+
+TEST_F(BatchedSignatureRunnerTest, BatchesConcurrentRequests) {
+  BatchedSignatureRunner::Options options;
+  options.batch_sizes = {1, 4, 8};
+  options.batch_timeout = std::chrono::milliseconds(50);
+  auto runner =
+      BatchedSignatureRunner::Create(*model_, resolver_, "add", options);
+  ASSERT_NE(runner, nullptr);
+  EXPECT_EQ(runner->max_batch_size(), 8);
+
+  constexpr int kNumRequests = 6;
+  std::vector<BatchedSignatureRunner::TensorMap> outputs(kNumRequests);
+  std::vector<TfLiteStatus> statuses(kNumRequests, kTfLiteError);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumRequests; ++i) {
+    threads.emplace_back([&, i] {
+      // Requests have either one or two examples.
+      std::vector<float> x(1 + i % 2, 10.0f * i);
+      statuses[i] = runner->Invoke({{"x", FloatValue(x)}}, &outputs[i]);
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  for (int i = 0; i < kNumRequests; ++i) {
+    ASSERT_EQ(statuses[i], kTfLiteOk);
+    const BatchedSignatureRunner::TensorValue& output =
+        outputs[i].at("output_0");
+    EXPECT_EQ(output.type, kTfLiteFloat32);
+    EXPECT_THAT(output.dims, ElementsAre(1 + i % 2));
+    const std::vector<float> expected(1 + i % 2, 10.0f * i + 2);
+    EXPECT_THAT(FloatValues(output), ElementsAreArray(expected));
+  }
+}
+
+TEST_F(BatchedSignatureRunnerTest, RejectsInvalidRequests) {
+  BatchedSignatureRunner::Options options;
+  options.batch_sizes = {1, 2};
+  options.batch_timeout = std::chrono::milliseconds(0);
+  auto runner =
+      BatchedSignatureRunner::Create(*model_, resolver_, "sub", options);
+  ASSERT_NE(runner, nullptr);
+
+  BatchedSignatureRunner::TensorMap outputs;
+  EXPECT_EQ(runner->Invoke({}, &outputs), kTfLiteError);
+  EXPECT_EQ(runner->Invoke({{"y", FloatValue({1})}}, &outputs), kTfLiteError);
+  EXPECT_EQ(runner->Invoke({{"x", FloatValue({1, 2, 3})}}, &outputs),
+            kTfLiteError);
+  BatchedSignatureRunner::TensorValue int_value = FloatValue({1});
+  int_value.type = kTfLiteInt32;
+  EXPECT_EQ(runner->Invoke({{"x", int_value}}, &outputs), kTfLiteError);
+
+  ASSERT_EQ(runner->Invoke({{"x", FloatValue({5})}}, &outputs), kTfLiteOk);
+  EXPECT_THAT(FloatValues(outputs.at("output_0")), ElementsAre(2));
+}
+
+TEST_F(BatchedSignatureRunnerTest, InvalidOptions) {
+  BatchedSignatureRunner::Options options;
+  options.batch_sizes = {};
+  EXPECT_EQ(BatchedSignatureRunner::Create(*model_, resolver_, "add", options),
+            nullptr);
+  options.batch_sizes = {4, 2};
+  EXPECT_EQ(BatchedSignatureRunner::Create(*model_, resolver_, "add", options),
+            nullptr);
+  options.batch_sizes = {1};
+  EXPECT_EQ(
+      BatchedSignatureRunner::Create(*model_, resolver_, "dummy", options),
+      nullptr);
+}
+
+}  // namespace
+}  // namespace tflite
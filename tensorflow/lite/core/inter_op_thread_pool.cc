@@ -0,0 +1,138 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/core/inter_op_thread_pool.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/external_cpu_backend_context.h"
+
+namespace tflite {
+namespace {
+
+thread_local bool in_task = false;
+
+// Marks the current thread as running tasks for the lifetime of the object.
+class ScopedInTask {
+ public:
+  ScopedInTask() : was_in_task_(in_task) { in_task = true; }
+  ~ScopedInTask() { in_task = was_in_task_; }
+
+ private:
+  const bool was_in_task_;
+};
+
+}  // namespace
+
+InterOpThreadPool::InterOpThreadPool(int num_threads)
+    : num_threads_(std::max(num_threads, 1)) {
+  for (int worker = 1; worker < num_threads_; ++worker) {
+    cpu_backend_contexts_.push_back(
+        std::make_unique<ExternalCpuBackendContext>());
+  }
+  threads_.reserve(num_threads_ - 1);
+  for (int worker = 1; worker < num_threads_; ++worker) {
+    threads_.emplace_back([this, worker] { WorkerLoop(worker); });
+  }
+}
+
+InterOpThreadPool::~InterOpThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    stop_ = true;
+  }
+  work_cv_.notify_all();
+  for (std::thread& thread : threads_) thread.join();
+}
+
+bool InterOpThreadPool::InTask() { return in_task; }
+
+void InterOpThreadPool::ParallelFor(int num_tasks,
+                                    const std::function<void(int, int)>& fn) {
+  if (num_tasks <= 0) return;
+  if (num_tasks == 1 || threads_.empty() || in_task) {
+    ScopedInTask scoped_in_task;
+    for (int task = 0; task < num_tasks; ++task) fn(0, task);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    fn_ = &fn;
+    num_tasks_ = num_tasks;
+    next_task_.store(0, std::memory_order_relaxed);
+    num_busy_workers_ = threads_.size();
+    ++generation_;
+  }
+  work_cv_.notify_all();
+  RunTasks(/*worker=*/0);
+
+  std::unique_lock<std::mutex> lock(mu_);
+  done_cv_.wait(lock, [this] { return num_busy_workers_ == 0; });
+  fn_ = nullptr;
+}
+
+TfLiteExternalContext* InterOpThreadPool::cpu_backend_context(int worker) {
+  if (worker <= 0 ||
+      worker > static_cast<int>(cpu_backend_contexts_.size())) {
+    return nullptr;
+  }
+  return cpu_backend_contexts_[worker - 1].get();
+}
+
+void InterOpThreadPool::SetMaxNumThreadsPerWorker(int num_threads) {
+  if (num_threads == -1) return;
+  for (const auto& context : cpu_backend_contexts_) {
+    // Contexts are initialized lazily by the kernels, which then use the
+    // interpreter's recommended number of threads.
+    if (context->internal_backend_context()) {
+      context->internal_backend_context()->SetMaxNumThreads(num_threads);
+    }
+  }
+}
+
+void InterOpThreadPool::WorkerLoop(int worker) {
+  uint64_t seen_generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mu_);
+      work_cv_.wait(lock, [this, seen_generation] {
+        return stop_ || generation_ != seen_generation;
+      });
+      if (stop_) return;
+      seen_generation = generation_;
+    }
+    RunTasks(worker);
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      if (--num_busy_workers_ == 0) done_cv_.notify_one();
+    }
+  }
+}
+
+void InterOpThreadPool::RunTasks(int worker) {
+  ScopedInTask scoped_in_task;
+  // Tasks are claimed dynamically so that long-running nodes don't hold up
+  // the others.
+  for (int task = next_task_.fetch_add(1, std::memory_order_relaxed);
+       task < num_tasks_;
+       task = next_task_.fetch_add(1, std::memory_order_relaxed)) {
+    (*fn_)(worker, task);
+  }
+}
+
+}  // namespace tflite
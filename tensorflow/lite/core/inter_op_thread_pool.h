@@ -0,0 +1,99 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_CORE_INTER_OP_THREAD_POOL_H_
+#define TENSORFLOW_LITE_CORE_INTER_OP_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/external_cpu_backend_context.h"
+
+namespace tflite {
+
+// A pool of threads on which a subgraph runs nodes that don't depend on each
+// other concurrently (see `InterpreterOptions::SetNumInterOpThreads`). One pool
+// is shared by all the subgraphs of an interpreter.
+//
+// Kernel libraries such as ruy and gemmlowp don't support concurrent use of a
+// single CPU backend context, so each worker thread other than the calling
+// thread has its own `ExternalCpuBackendContext`.
+class InterOpThreadPool {
+ public:
+  // Creates a pool that runs tasks on `num_threads` threads, including the
+  // thread calling `ParallelFor()`.
+  explicit InterOpThreadPool(int num_threads);
+  ~InterOpThreadPool();
+
+  InterOpThreadPool(const InterOpThreadPool&) = delete;
+  InterOpThreadPool& operator=(const InterOpThreadPool&) = delete;
+
+  int num_threads() const { return num_threads_; }
+
+  // Calls `fn(worker, task)` for each `task` in [0, num_tasks) and returns
+  // once all calls have returned. `worker` is in [0, num_threads()), and
+  // worker 0 is the calling thread. Calls made from within a task run all
+  // tasks inline on the calling thread. Must not be called concurrently from
+  // different threads.
+  void ParallelFor(int num_tasks, const std::function<void(int, int)>& fn);
+
+  // Returns the CPU backend context to be used by kernels run by `worker`, or
+  // null for worker 0, which uses the one of the interpreter.
+  TfLiteExternalContext* cpu_backend_context(int worker);
+
+  // Updates the number of threads that the CPU backend contexts of the
+  // workers may use, as `Interpreter::SetNumThreads()` does for the
+  // interpreter's own context.
+  void SetMaxNumThreadsPerWorker(int num_threads);
+
+  // Returns true if called from within a task of any pool.
+  static bool InTask();
+
+ private:
+  void WorkerLoop(int worker);
+  void RunTasks(int worker);
+
+  const int num_threads_;
+  std::vector<std::unique_ptr<ExternalCpuBackendContext>>
+      cpu_backend_contexts_;
+
+  std::mutex mu_;
+  // Signals workers that a new batch of tasks is available or that the pool
+  // is being destroyed.
+  std::condition_variable work_cv_;
+  // Signals the calling thread that all workers are done with the batch.
+  std::condition_variable done_cv_;
+  uint64_t generation_ = 0;
+  int num_busy_workers_ = 0;
+  bool stop_ = false;
+
+  // The current batch of tasks. Written by the calling thread before
+  // `generation_` is incremented.
+  const std::function<void(int, int)>* fn_ = nullptr;
+  int num_tasks_ = 0;
+  std::atomic<int> next_task_{0};
+
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_CORE_INTER_OP_THREAD_POOL_H_
@@ -0,0 +1,97 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/core/inter_op_thread_pool.h"
+
+#include <atomic>
+#include <set>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/core/c/common.h"
+
+namespace tflite {
+namespace {
+
+using ::testing::Each;
+using ::testing::Eq;
+
+TEST(InterOpThreadPoolTest, RunsEveryTaskOnce) {
+  InterOpThreadPool pool(4);
+  EXPECT_EQ(pool.num_threads(), 4);
+  for (int num_tasks : {0, 1, 3, 4, 100}) {
+    std::vector<std::atomic<int>> runs(num_tasks);
+    pool.ParallelFor(num_tasks, [&](int worker, int task) {
+      EXPECT_GE(worker, 0);
+      EXPECT_LT(worker, 4);
+      ++runs[task];
+    });
+    for (const auto& count : runs) EXPECT_EQ(count.load(), 1);
+  }
+}
+
+TEST(InterOpThreadPoolTest, RunsTasksConcurrently) {
+  InterOpThreadPool pool(2);
+  // Each task waits for the other one, so this only terminates if they run on
+  // different threads.
+  std::atomic<int> started{0};
+  std::vector<int> workers(2, -1);
+  pool.ParallelFor(2, [&](int worker, int task) {
+    ++started;
+    while (started.load() < 2) {
+    }
+    workers[task] = worker;
+  });
+  EXPECT_NE(workers[0], workers[1]);
+}
+
+TEST(InterOpThreadPoolTest, NestedCallsRunInline) {
+  InterOpThreadPool pool(3);
+  EXPECT_FALSE(InterOpThreadPool::InTask());
+  std::vector<std::atomic<int>> runs(9);
+  pool.ParallelFor(3, [&](int outer_worker, int outer_task) {
+    EXPECT_TRUE(InterOpThreadPool::InTask());
+    pool.ParallelFor(3, [&](int worker, int task) {
+      EXPECT_EQ(worker, 0);
+      ++runs[outer_task * 3 + task];
+    });
+  });
+  EXPECT_FALSE(InterOpThreadPool::InTask());
+  for (const auto& count : runs) EXPECT_EQ(count.load(), 1);
+}
+
+TEST(InterOpThreadPoolTest, WorkersHaveTheirOwnCpuBackendContext) {
+  InterOpThreadPool pool(3);
+  EXPECT_EQ(pool.cpu_backend_context(0), nullptr);
+  std::set<TfLiteExternalContext*> contexts;
+  for (int worker = 1; worker < 3; ++worker) {
+    TfLiteExternalContext* context = pool.cpu_backend_context(worker);
+    ASSERT_NE(context, nullptr);
+    EXPECT_EQ(context->type, kTfLiteCpuBackendContext);
+    contexts.insert(context);
+  }
+  EXPECT_EQ(contexts.size(), 2);
+}
+
+TEST(InterOpThreadPoolTest, SingleThread) {
+  InterOpThreadPool pool(0);
+  EXPECT_EQ(pool.num_threads(), 1);
+  std::vector<int> workers(5, -1);
+  pool.ParallelFor(5, [&](int worker, int task) { workers[task] = worker; });
+  EXPECT_THAT(workers, Each(Eq(0)));
+}
+
+}  // namespace
+}  // namespace tflite
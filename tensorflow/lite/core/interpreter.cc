@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/lite/core/api/error_reporter.h"
 #include "tensorflow/lite/core/api/profiler.h"
 #include "tensorflow/lite/core/c/c_api_types.h"
+#include "tensorflow/lite/core/inter_op_thread_pool.h"
 #include "tensorflow/lite/core/signature_runner.h"
 #include "tensorflow/lite/core/subgraph.h"
 #include "tensorflow/lite/external_cpu_backend_context.h"
@@ -39,6 +40,7 @@ limitations under the License.
 #include "tensorflow/lite/interpreter_options.h"
 #include "tensorflow/lite/logger.h"
 #include "tensorflow/lite/minimal_logging.h"
+#include "tensorflow/lite/offline_arena_plan.h"
 #include "tensorflow/lite/profiling/root_profiler.h"
 #include "tensorflow/lite/profiling/telemetry/c/telemetry_setting.h"
 #include "tensorflow/lite/profiling/telemetry/telemetry.h"
@@ -324,6 +326,9 @@ TfLiteStatus Interpreter::SetNumThreads(int num_threads) {
       c->Refresh(context_);
     }
   }
+  if (inter_op_thread_pool_) {
+    inter_op_thread_pool_->SetMaxNumThreadsPerWorker(num_threads);
+  }
   return kTfLiteOk;
 }
 
@@ -442,12 +447,26 @@ TfLiteStatus Interpreter::SetMetadata(
           &model_control_dependencies_)) {
     model_control_dependencies_.clear();
   }
+  offline_arena_plans_.clear();
+  const auto maybe_offline_arena_plans =
+      metadata_.find(kOfflineArenaPlanMetadataKey);
+  if (maybe_offline_arena_plans != metadata_.end() &&
+      !ParseOfflineArenaPlans(maybe_offline_arena_plans->second.data(),
+                              maybe_offline_arena_plans->second.size(),
+                              &offline_arena_plans_)) {
+    TFLITE_LOG(TFLITE_LOG_WARNING, "Ignoring invalid offline arena plans.");
+    offline_arena_plans_.clear();
+  }
   for (int subgraph_index = 0; subgraph_index < subgraphs_.size();
        ++subgraph_index) {
     TF_LITE_ENSURE_STATUS(subgraphs_[subgraph_index]->SetMetadata(
-        &metadata_, model_control_dependencies_.empty()
-                        ? nullptr
-                        : &model_control_dependencies_[subgraph_index]));
+        &metadata_,
+        model_control_dependencies_.empty()
+            ? nullptr
+            : &model_control_dependencies_[subgraph_index],
+        subgraph_index < offline_arena_plans_.size()
+            ? &offline_arena_plans_[subgraph_index]
+            : nullptr));
   }
   return kTfLiteOk;
 }
@@ -497,9 +516,19 @@ TfLiteStatus Interpreter::ApplyOptionsImpl(InterpreterOptions* options) {
   }
   options_ = std::make_unique<InterpreterOptions>(*options);
 
+  const int num_inter_op_threads = options_->GetNumInterOpThreads();
+  if (num_inter_op_threads <= 1) {
+    inter_op_thread_pool_.reset();
+  } else if (!inter_op_thread_pool_ ||
+             inter_op_thread_pool_->num_threads() != num_inter_op_threads) {
+    inter_op_thread_pool_ =
+        std::make_unique<InterOpThreadPool>(num_inter_op_threads);
+  }
+
   // Set InterpreterOptions object to SubGraph.
   for (auto& subgraph : subgraphs_) {
     subgraph->SetOptions(options_.get());
+    subgraph->SetInterOpThreadPool(inter_op_thread_pool_.get());
   }
   return kTfLiteOk;
 }
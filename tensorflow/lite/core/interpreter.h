@@ -47,6 +47,7 @@ limitations under the License.
 #include "tensorflow/lite/core/api/profiler.h"
 #include "tensorflow/lite/core/async/async_signature_runner.h"
 #include "tensorflow/lite/core/c/common.h"  // IWYU pragma: export
+#include "tensorflow/lite/core/inter_op_thread_pool.h"
 #include "tensorflow/lite/core/signature_runner.h"
 #include "tensorflow/lite/core/subgraph.h"
 #include "tensorflow/lite/experimental/resource/initialization_status.h"
@@ -54,6 +55,7 @@ limitations under the License.
 #include "tensorflow/lite/external_cpu_backend_context.h"
 #include "tensorflow/lite/internal/signature_def.h"
 #include "tensorflow/lite/interpreter_options.h"
+#include "tensorflow/lite/offline_arena_plan.h"
 #include "tensorflow/lite/portable_type_to_tflitetype.h"
 #include "tensorflow/lite/profiling/root_profiler.h"
 #include "tensorflow/lite/profiling/telemetry/c/telemetry_setting_internal.h"
@@ -960,6 +962,10 @@ class Interpreter {
   // nullptr if necessary.
   std::unique_ptr<ExternalCpuBackendContext> own_external_cpu_backend_context_;
 
+  // The pool on which subgraphs invoke independent nodes concurrently. Only
+  // created if `InterpreterOptions::GetNumInterOpThreads()` > 1.
+  std::unique_ptr<InterOpThreadPool> inter_op_thread_pool_;
+
   // Subgraphs
   std::vector<std::unique_ptr<Subgraph>> subgraphs_;
 
@@ -1022,6 +1028,11 @@ class Interpreter {
   // checks when dereferencing by subgraph and operator index) will take place.
   ModelControlDependencies model_control_dependencies_;
 
+  // Arena plans computed offline for each subgraph, parsed from the metadata
+  // of the model in SetMetadata. Empty if there were none or they couldn't be
+  // parsed.
+  std::vector<OfflineArenaPlan> offline_arena_plans_;
+
   // Flag indicating whether to continue or cancel in flight invocation.
   // If false, the in flight invocation will be cancelled.
   // Will be set true when application starts a new invocation.
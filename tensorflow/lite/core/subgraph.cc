@@ -40,6 +40,7 @@ limitations under the License.
 #include "tensorflow/lite/core/api/tensor_utils.h"
 #include "tensorflow/lite/core/c/c_api_types.h"
 #include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/inter_op_thread_pool.h"
 #include "tensorflow/lite/experimental/resource/initialization_status.h"
 #include "tensorflow/lite/experimental/resource/resource_base.h"
 #include "tensorflow/lite/graph_info.h"
@@ -193,6 +194,48 @@ TfLiteStatus VerifyCustomAllocationForTensor(
   return kTfLiteOk;
 }
 
+// CPU backend context of the inter-op worker running on this thread, which
+// takes precedence over the one of the subgraph. Null outside of inter-op
+// tasks and on the thread that called Invoke().
+thread_local TfLiteExternalContext* inter_op_cpu_backend_context = nullptr;
+
+// Sets `inter_op_cpu_backend_context` for the lifetime of the object.
+class ScopedInterOpCpuBackendContext {
+ public:
+  explicit ScopedInterOpCpuBackendContext(TfLiteExternalContext* context)
+      : previous_context_(inter_op_cpu_backend_context) {
+    inter_op_cpu_backend_context = context;
+  }
+  ~ScopedInterOpCpuBackendContext() {
+    inter_op_cpu_backend_context = previous_context_;
+  }
+
+ private:
+  TfLiteExternalContext* const previous_context_;
+};
+
+// Where the node that an inter-op task is invoking on this thread records that
+// it resized a tensor of `subgraph`. Nodes of a wavefront record resizes
+// separately rather than racing on `tensor_resized_since_op_invoke_`.
+struct InterOpResizeRecord {
+  const Subgraph* subgraph = nullptr;
+  bool* tensor_resized = nullptr;
+};
+thread_local InterOpResizeRecord inter_op_resize_record;
+
+// Sets `inter_op_resize_record` for the lifetime of the object.
+class ScopedInterOpResizeRecord {
+ public:
+  ScopedInterOpResizeRecord(const Subgraph* subgraph, bool* tensor_resized)
+      : previous_record_(inter_op_resize_record) {
+    inter_op_resize_record = {subgraph, tensor_resized};
+  }
+  ~ScopedInterOpResizeRecord() { inter_op_resize_record = previous_record_; }
+
+ private:
+  const InterOpResizeRecord previous_record_;
+};
+
 }  // namespace
 
 // A trivial implementation of GraphInfo around the Interpreter.
@@ -626,6 +669,10 @@ TfLiteExternalContext* Subgraph::GetExternalContext(
 
 TfLiteExternalContext* Subgraph::GetExternalContext(
     struct TfLiteContext* context, TfLiteExternalContextType type) {
+  if (type == kTfLiteCpuBackendContext &&
+      inter_op_cpu_backend_context != nullptr) {
+    return inter_op_cpu_backend_context;
+  }
   return static_cast<Subgraph*>(context->impl_)->GetExternalContext(type);
 }
 
@@ -842,12 +889,72 @@ TfLiteStatus Subgraph::SetVariables(std::vector<int> variables) {
 
 TfLiteStatus Subgraph::SetMetadata(
     const std::map<std::string, std::string>* metadata,
-    const ControlEdges* control_edges) {
+    const ControlEdges* control_edges,
+    const OfflineArenaPlan* offline_arena_plan) {
   metadata_ = metadata;
   control_edges_ = control_edges;
+  offline_arena_plan_ = offline_arena_plan;
+  if (memory_planner_) ApplyOfflineArenaPlan();
   return kTfLiteOk;
 }
 
+void Subgraph::ApplyOfflineArenaPlan() {
+  // The plan of the model is made for its default input shapes, so a plan
+  // recorded for the current ones is a better fit.
+  const OfflineArenaPlan* plan = offline_arena_plan_;
+  if (!arena_plan_cache_.empty()) {
+    auto it = arena_plan_cache_.find(InputShapes());
+    if (it != arena_plan_cache_.end()) {
+      it->second.last_use = ++arena_plan_cache_clock_;
+      plan = &it->second.plan;
+    }
+  }
+  if (memory_planner_->SetOfflineArenaPlan(plan ? *plan : OfflineArenaPlan()) !=
+      kTfLiteOk) {
+    // The plan is only an optimization, so planning at runtime is fine.
+    TFLITE_LOG(TFLITE_LOG_WARNING,
+               "Ignoring invalid offline arena plan of subgraph %d.",
+               subgraph_index_);
+    memory_planner_->SetOfflineArenaPlan({});
+  }
+}
+
+void Subgraph::CacheArenaPlan() {
+  const int cache_size = options_ ? options_->GetArenaPlanCacheSize() : 0;
+  // Plans of subgraphs with dynamic tensors are only complete once invoked.
+  if (memory_planner_ == nullptr || has_dynamic_tensors_ || cache_size <= 0) {
+    return;
+  }
+  std::vector<std::vector<int>> input_shapes = InputShapes();
+  if (arena_plan_cache_.count(input_shapes)) return;
+  // The cache holds a handful of plans, so a linear scan for the least
+  // recently used one is cheap enough.
+  while (static_cast<int>(arena_plan_cache_.size()) >= cache_size) {
+    auto lru = arena_plan_cache_.begin();
+    for (auto it = arena_plan_cache_.begin(); it != arena_plan_cache_.end();
+         ++it) {
+      if (it->second.last_use < lru->second.last_use) lru = it;
+    }
+    arena_plan_cache_.erase(lru);
+  }
+  arena_plan_cache_.emplace(
+      std::move(input_shapes),
+      CachedArenaPlan{memory_planner_->GetArenaAllocations(),
+                      ++arena_plan_cache_clock_});
+}
+
+std::vector<std::vector<int>> Subgraph::InputShapes() const {
+  std::vector<std::vector<int>> input_shapes;
+  input_shapes.reserve(inputs_.size());
+  for (int input : inputs_) {
+    const TfLiteIntArray* dims =
+        input == kTfLiteOptionalTensor ? nullptr : tensors_[input].dims;
+    input_shapes.emplace_back(dims ? dims->data : nullptr,
+                              dims ? dims->data + dims->size : nullptr);
+  }
+  return input_shapes;
+}
+
 void Subgraph::SetCancellationFunction(void* data,
                                        bool (*check_cancelled_func)(void*)) {
   cancellation_data_ = data;
@@ -1008,11 +1115,14 @@ TfLiteStatus Subgraph::AllocateTensors() {
   next_original_execution_plan_index_to_prepare_ = 0;
   if (memory_planner_) {
     TF_LITE_ENSURE_STATUS(memory_planner_->ResetAllocations());
+    // Switch to the plan cached for the new input shapes, if any.
+    if (!arena_plan_cache_.empty()) ApplyOfflineArenaPlan();
   }
 
   TF_LITE_ENSURE_STATUS(PrepareOpsAndTensors());
 
   state_ = kStateInvokable;
+  CacheArenaPlan();
 
   // Reset the variable tensors to zero after (re)allocating the tensors.
   // Developers shouldn't rely on the side effect of this function to reset
@@ -1527,6 +1637,67 @@ TfLiteStatus Subgraph::PrepareOpsStartingAt(
   return kTfLiteOk;
 }
 
+bool Subgraph::CanRunNodesConcurrently() {
+  if (inter_op_thread_pool_ == nullptr || options_ == nullptr ||
+      options_->GetNumInterOpThreads() < 2) {
+    return false;
+  }
+  // Dynamic tensors are resized and (re)allocated while nodes are invoked,
+  // one node at a time.
+  if (has_dynamic_tensors_ ||
+      next_execution_plan_index_to_prepare_ != execution_plan_.size() ||
+      ShouldOptimizeMemoryForLargeTensors() || ShouldReleaseDynamicTensors()) {
+    return false;
+  }
+  // Delegate kernels may synchronize with their delegate in ways the
+  // dependencies between tensors don't show, and control edges aren't part
+  // of the graph info wavefronts are computed from.
+  if (!pre_delegation_execution_plan_.empty() ||
+      (control_edges_ != nullptr && !control_edges_->empty())) {
+    return false;
+  }
+  for (int node_index : execution_plan_) {
+    if (nodes_and_registration_[node_index].first.delegate != nullptr) {
+      return false;
+    }
+  }
+  return true;
+}
+
+TfLiteStatus Subgraph::UpdateInterOpSchedule() {
+  std::vector<int> order;
+  std::vector<int> wavefront_ends;
+  if (CanRunNodesConcurrently()) {
+    TF_LITE_ENSURE_STATUS(ComputeExecutionWavefronts(CreateGraphInfo().get(),
+                                                     &order, &wavefront_ends));
+    // Nothing to gain if no two nodes may run concurrently.
+    if (wavefront_ends.size() == execution_plan_.size()) {
+      wavefront_ends.clear();
+    }
+  }
+  // Once reordered, the execution plan is its own schedule.
+  if (wavefront_ends == inter_op_wavefront_ends_ &&
+      std::is_sorted(order.begin(), order.end())) {
+    return kTfLiteOk;
+  }
+  if (memory_planner_->SetExecutionWavefronts(wavefront_ends) != kTfLiteOk) {
+    // The memory planner can't keep allocations valid under concurrent
+    // execution.
+    if (inter_op_wavefront_ends_.empty()) return kTfLiteOk;
+    wavefront_ends.clear();
+    TF_LITE_ENSURE_STATUS(
+        memory_planner_->SetExecutionWavefronts(wavefront_ends));
+  } else if (!wavefront_ends.empty()) {
+    std::vector<int> execution_plan(execution_plan_.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+      execution_plan[i] = execution_plan_[order[i]];
+    }
+    execution_plan_ = std::move(execution_plan);
+  }
+  inter_op_wavefront_ends_ = std::move(wavefront_ends);
+  return memory_planner_->PlanAllocations();
+}
+
 TfLiteStatus Subgraph::PrepareOpsAndTensors() {
   // Prepare original execution plan if any applied delegate wants it.
   // If any of the delegates is immutable, this won't be triggered
@@ -1565,9 +1736,15 @@ TfLiteStatus Subgraph::PrepareOpsAndTensors() {
         &context_, CreateGraphInfo(), ShouldPreserveAllTensors(),
         kDefaultTensorAlignment, subgraph_index_);
 #endif
+    ApplyOfflineArenaPlan();
     memory_planner_->PlanAllocations();
   }
 
+  // The schedule can only change while nothing has been allocated yet.
+  if (next_execution_plan_index_to_plan_allocation_ == 0) {
+    TF_LITE_ENSURE_STATUS(UpdateInterOpSchedule());
+  }
+
   // Execute arena allocations.
   TF_LITE_ENSURE_STATUS(memory_planner_->ExecuteAllocations(
       next_execution_plan_index_to_plan_allocation_,
@@ -1622,6 +1799,134 @@ TfLiteStatus Subgraph::Invoke() {
   telemetry::TelemetryReportEvent(&context_, "Invoke", status);
   return status;
 }
+
+TfLiteStatus Subgraph::EnsureOpInputsAreReadable(
+    const TfLiteNode& node, const TfLiteRegistration& registration) {
+  for (int i = 0; i < node.inputs->size; ++i) {
+    int tensor_index = node.inputs->data[i];
+    if (tensor_index == kTfLiteOptionalTensor) {
+      continue;
+    }
+    TfLiteTensor* tensor = &tensors_[tensor_index];
+    if (tensor->delegate && tensor->delegate != node.delegate &&
+        tensor->data_is_stale) {
+      TF_LITE_ENSURE_STATUS(EnsureTensorDataIsReadable(tensor_index));
+    }
+    if (tensor->data.raw == nullptr && tensor->bytes > 0) {
+      if (registration.builtin_code == kTfLiteBuiltinReshape && i == 1 &&
+          tensor->dims->size != 1) {
+        // In general, having a tensor here with no buffer will be an error.
+        // However, for the reshape operator, the second input tensor is
+        // sometimes only used for the shape, not for the data. Thus, null
+        // buffer is ok in this situation.
+        // The situation where null buffer is not ok for reshape operator is
+        // only when there are 2 inputs given to the node and the one
+        // corresponding to the shape (i == 1) is a vector that contains all
+        // dimensions. See `GetOutputShape()` function in
+        // `tensorflow/lite/kernels/reshape.cc`
+        continue;
+      } else {
+        // In all other cases, we need to return an error as otherwise we will
+        // trigger a null pointer dereference (likely).
+        ReportError("Input tensor %d lacks data", tensor_index);
+        return kTfLiteError;
+      }
+    }
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus Subgraph::InvokeWavefronts(int* next_execution_plan_index) {
+  *next_execution_plan_index = 0;
+  // Nested invocations, e.g. of the body of a WHILE node run by an inter-op
+  // task, run sequentially, and so do profiled ones since profilers expect
+  // operator events to be properly nested.
+  if (inter_op_thread_pool_ == nullptr || inter_op_wavefront_ends_.empty() ||
+      profiler_ || InterOpThreadPool::InTask()) {
+    return kTfLiteOk;
+  }
+  std::vector<TfLiteStatus> statuses;
+  int first = 0;
+  for (int end : inter_op_wavefront_ends_) {
+    // Nodes that are yet to be prepared or allocated run sequentially.
+    if (end > next_execution_plan_index_to_prepare_ ||
+        end > next_execution_plan_index_to_plan_allocation_) {
+      break;
+    }
+    if (check_cancelled_func_ != nullptr &&
+        check_cancelled_func_(cancellation_data_)) {
+      ReportError("Client requested cancel during Invoke()");
+      return kTfLiteError;
+    }
+    if (continue_invocation_ && !continue_invocation_->test_and_set()) {
+      // `Cancel` is called and cancellation flag is flipped.
+      ReportError("Client requested cancel during Invoke()");
+      return kTfLiteCancelled;
+    }
+    for (int i = first; i < end; ++i) {
+      const auto& [node, registration] =
+          nodes_and_registration_[execution_plan_[i]];
+      TF_LITE_ENSURE_STATUS(EnsureOpInputsAreReadable(node, registration));
+    }
+
+    EnsureTensorsVectorCapacity();
+    statuses.assign(end - first, kTfLiteOk);
+    // Each node records its resizes in its own slot; they are merged once the
+    // wavefront has joined.
+    std::unique_ptr<bool[]> tensor_resized(new bool[end - first]());
+    inter_op_thread_pool_->ParallelFor(end - first, [&](int worker, int task) {
+      ScopedInterOpCpuBackendContext scoped_cpu_backend_context(
+          inter_op_thread_pool_->cpu_backend_context(worker));
+      ScopedInterOpResizeRecord scoped_resize_record(this,
+                                                     &tensor_resized[task]);
+      auto& [node, registration] =
+          nodes_and_registration_[execution_plan_[first + task]];
+      statuses[task] = OpInvoke(registration, &node);
+    });
+    tensor_resized_since_op_invoke_ = false;
+    for (int i = 0; i < end - first; ++i) {
+      tensor_resized_since_op_invoke_ |= tensor_resized[i];
+    }
+    // Errors are reported in execution plan order, on the calling thread.
+    for (int i = first; i < end; ++i) {
+      if (statuses[i - first] == kTfLiteOk) continue;
+      const int node_index = execution_plan_[i];
+      auto err = ReportOpError(
+          &context_, nodes_and_registration_[node_index].first,
+          nodes_and_registration_[node_index].second, node_index,
+          "failed to invoke");
+      return statuses[i - first] == kTfLiteCancelled ? kTfLiteCancelled : err;
+    }
+    const int wavefront_first = first;
+    first = end;
+
+    // Downstream ops need to be prepared again if a dynamic tensor was
+    // resized, which the sequential invocation takes care of.
+    if (tensor_resized_since_op_invoke_) {
+      bool resized_dynamic_tensor = false;
+      for (int i = wavefront_first; i < end; ++i) {
+        if (!tensor_resized[i - wavefront_first]) continue;
+        resized_dynamic_tensor |= HasDynamicTensor(
+            context_, nodes_and_registration_[execution_plan_[i]].first.outputs,
+            nullptr);
+      }
+      if (resized_dynamic_tensor) {
+        next_execution_plan_index_to_prepare_ = end;
+        if (next_execution_plan_index_to_plan_allocation_ > end) {
+          next_execution_plan_index_to_plan_allocation_ = end;
+          if (memory_planner_) {
+            TF_LITE_ENSURE_STATUS(
+                memory_planner_->ResetAllocationsAfter(end - 1));
+          }
+        }
+        break;
+      }
+    }
+  }
+  *next_execution_plan_index = first;
+  return kTfLiteOk;
+}
+
 TfLiteStatus Subgraph::InvokeImpl() {
   if (!consistent_) {
     ReportError("Invoke called on model that is not consistent.");
@@ -1642,11 +1947,17 @@ TfLiteStatus Subgraph::InvokeImpl() {
       tflite::OnTfLiteSubgraphInvoke(name_.c_str(), subgraph_index_);
 #endif  // TF_LITE_TENSORFLOW_PROFILER
 
-  // Invocations are always done in node order.
+  // Invocations are always done in node order, except for nodes that may run
+  // concurrently, which are invoked wavefront by wavefront first.
   // Note that calling Invoke repeatedly will cause the original memory plan to
   // be reused, unless either ResizeInputTensor() or AllocateTensors() has been
   // called.
-  for (int execution_plan_index = 0;
+  int first_sequential_execution_plan_index = 0;
+  if (auto s = InvokeWavefronts(&first_sequential_execution_plan_index);
+      s != kTfLiteOk) {
+    return s;
+  }
+  for (int execution_plan_index = first_sequential_execution_plan_index;
        execution_plan_index < execution_plan_.size(); execution_plan_index++) {
     if (execution_plan_index == next_execution_plan_index_to_prepare_) {
       TF_LITE_ENSURE_STATUS(PrepareOpsAndTensors());
@@ -1676,37 +1987,7 @@ TfLiteStatus Subgraph::InvokeImpl() {
     TFLITE_SCOPED_TAGGED_OPERATOR_PROFILE(
         profile_op ? profiler_.get() : nullptr, op_name, node_index);
 
-    for (int i = 0; i < node.inputs->size; ++i) {
-      int tensor_index = node.inputs->data[i];
-      if (tensor_index == kTfLiteOptionalTensor) {
-        continue;
-      }
-      TfLiteTensor* tensor = &tensors_[tensor_index];
-      if (tensor->delegate && tensor->delegate != node.delegate &&
-          tensor->data_is_stale) {
-        TF_LITE_ENSURE_STATUS(EnsureTensorDataIsReadable(tensor_index));
-      }
-      if (tensor->data.raw == nullptr && tensor->bytes > 0) {
-        if (registration.builtin_code == kTfLiteBuiltinReshape && i == 1 &&
-            tensor->dims->size != 1) {
-          // In general, having a tensor here with no buffer will be an error.
-          // However, for the reshape operator, the second input tensor is
-          // sometimes only used for the shape, not for the data. Thus, null
-          // buffer is ok in this situation.
-          // The situation where null buffer is not ok for reshape operator is
-          // only when there are 2 inputs given to the node and the one
-          // corresponding to the shape (i == 1) is a vector that contains all
-          // dimensions. See `GetOutputShape()` function in
-          // `tensorflow/lite/kernels/reshape.cc`
-          continue;
-        } else {
-          // In all other cases, we need to return an error as otherwise we will
-          // trigger a null pointer dereference (likely).
-          ReportError("Input tensor %d lacks data", tensor_index);
-          return kTfLiteError;
-        }
-      }
-    }
+    TF_LITE_ENSURE_STATUS(EnsureOpInputsAreReadable(node, registration));
     // Allocate dynamic tensors which memory is required to be allocated
     // before executing the node.
     MayAllocateOpOutput(&node);
@@ -1999,6 +2280,10 @@ TfLiteStatus Subgraph::SetExecutionPlan(const std::vector<int>& new_plan) {
                                   node_index < nodes_and_registration_.size());
   }
   execution_plan_ = new_plan;
+  inter_op_wavefront_ends_.clear();
+  if (memory_planner_) {
+    TF_LITE_ENSURE_STATUS(memory_planner_->SetExecutionWavefronts({}));
+  }
   return kTfLiteOk;
 }
 
@@ -2010,8 +2295,15 @@ TfLiteStatus Subgraph::ResizeTensorImpl(TfLiteTensor* tensor,
       tensor->allocation_type == kTfLiteArenaRwPersistent ||
       tensor->allocation_type == kTfLitePersistentRo ||
       tensor->allocation_type == kTfLiteCustom) {
-    tensor_resized_since_op_invoke_ |=
-        TfLiteIntArrayEqual(tensor->dims, new_size) == 0;
+    // Nodes invoked by inter-op tasks record the resize for their own node;
+    // InvokeWavefronts() merges these after the wavefront joins.
+    if (TfLiteIntArrayEqual(tensor->dims, new_size) == 0) {
+      if (inter_op_resize_record.subgraph == this) {
+        *inter_op_resize_record.tensor_resized = true;
+      } else {
+        tensor_resized_since_op_invoke_ = true;
+      }
+    }
     if (tensor->type != kTfLiteString && tensor->type != kTfLiteResource &&
         tensor->type != kTfLiteVariant) {
       size_t bytes_required;
@@ -2438,6 +2730,11 @@ void Subgraph::GetMemoryAllocInfo(SubgraphAllocInfo* alloc_info) const {
   }
 }
 
+OfflineArenaPlan Subgraph::GetArenaAllocations() const {
+  if (memory_planner_ == nullptr) return {};
+  return memory_planner_->GetArenaAllocations();
+}
+
 std::unique_ptr<GraphInfo> Subgraph::CreateGraphInfo() {
   return std::unique_ptr<GraphInfo>(new InterpreterInfo(this));
 }
@@ -42,11 +42,13 @@ limitations under the License.
 #include "tensorflow/lite/graph_info.h"
 #include "tensorflow/lite/interpreter_options.h"
 #include "tensorflow/lite/memory_planner.h"
+#include "tensorflow/lite/offline_arena_plan.h"
 #include "tensorflow/lite/util.h"
 
 namespace tflite {
 
 #ifndef DOXYGEN_SKIP
+class InterOpThreadPool;
 class SingleOpModel;  // Class for friend declarations.
 
 namespace internal {
@@ -439,6 +441,12 @@ class Subgraph {
   // Returns memory allocation status.
   void GetMemoryAllocInfo(SubgraphAllocInfo* alloc_info) const;
 
+  // WARNING: This is an experimental API and subject to change.
+  // Returns the allocations of the non-persistent arena tensors as currently
+  // planned, e.g. to compute an offline arena plan from after
+  // `AllocateTensors()`.
+  OfflineArenaPlan GetArenaAllocations() const;
+
   // WARNING: This is an experimental API and subject to change.
   // Set the given `InterpreterOptions` object.
   void SetOptions(InterpreterOptions* options) {
@@ -453,6 +461,14 @@ class Subgraph {
   // WARNING: This is an experimental API and subject to change.
   const InterpreterOptions* GetOptions() const { return options_; }
 
+  // WARNING: This is an experimental API and subject to change.
+  // Set the pool on which nodes that don't depend on each other are invoked
+  // concurrently if `InterpreterOptions::GetNumInterOpThreads()` > 1. The pool
+  // is owned by the interpreter. Takes effect on the next memory planning.
+  void SetInterOpThreadPool(InterOpThreadPool* pool) {
+    inter_op_thread_pool_ = pool;
+  }
+
   // WARNING: This is an experimental API and subject to change.
   // True if all intermediates tensors should be preserved for debugging.
   bool ShouldPreserveAllTensors() const {
@@ -728,6 +744,27 @@ class Subgraph {
   // Does not report invoke status through profiler.
   TfLiteStatus InvokeImpl();
 
+  // Check that the inputs of 'node' can be read by its kernel.
+  TfLiteStatus EnsureOpInputsAreReadable(
+      const TfLiteNode& node, const TfLiteRegistration& registration);
+
+  // True if the nodes of the execution plan may be invoked concurrently on
+  // the inter-op thread pool.
+  bool CanRunNodesConcurrently();
+
+  // Group the execution plan into wavefronts of nodes that don't depend on
+  // each other and reorder it wavefront by wavefront if nodes may run
+  // concurrently, or restore sequential execution otherwise. Replans
+  // allocations if the schedule changed. Must be called before any tensor is
+  // allocated.
+  TfLiteStatus UpdateInterOpSchedule();
+
+  // Invoke the leading wavefronts of the execution plan whose nodes are
+  // prepared and allocated, running the nodes of each wavefront concurrently.
+  // Fill 'next_execution_plan_index' with the index of the first node left
+  // to be invoked sequentially.
+  TfLiteStatus InvokeWavefronts(int* next_execution_plan_index);
+
   // Allow a delegate to look at the graph and modify the graph to handle
   // parts of the graph themselves. After this is called, the graph may
   // contain new nodes that replace 1 more nodes.
@@ -932,8 +969,22 @@ class Subgraph {
   // Since the lifetime of the Interpreter exceeds the Subgraph, metadata
   // remains valid for the latter's lifetime.
   // Also sets relevant fields on context_ based on known metadata.
-  TfLiteStatus SetMetadata(const std::map<std::string, std::string>* metadata,
-                           const ControlEdges* control_edges = nullptr);
+  TfLiteStatus SetMetadata(
+      const std::map<std::string, std::string>* metadata,
+      const ControlEdges* control_edges = nullptr,
+      const OfflineArenaPlan* offline_arena_plan = nullptr);
+
+  // Passes the arena plan cached for the current input shapes, or else
+  // `offline_arena_plan_`, on to the memory planner.
+  void ApplyOfflineArenaPlan();
+
+  // Records the arena plan for the current input shapes in
+  // `arena_plan_cache_`, if enabled by the options, evicting the least
+  // recently used plan if the cache is full.
+  void CacheArenaPlan();
+
+  // Returns the dimensions of the inputs, which key `arena_plan_cache_`.
+  std::vector<std::vector<int>> InputShapes() const;
 
   // Initializes the mapping between tensor index to the index of the
   // last operation that uses the tensor as input.
@@ -1088,6 +1139,14 @@ class Subgraph {
 
   std::unique_ptr<MemoryPlanner> memory_planner_;
 
+  // Pool used to invoke independent nodes concurrently, owned by the
+  // Interpreter; can be nullptr.
+  InterOpThreadPool* inter_op_thread_pool_ = nullptr;
+
+  // One past the last execution plan index of each wavefront of nodes that
+  // are invoked concurrently. Empty if nodes are invoked sequentially.
+  std::vector<int> inter_op_wavefront_ends_;
+
   // Maps tensor index to custom allocation for all applicable tensors.
   std::map<int, TfLiteCustomAllocation> custom_allocations_;
 
@@ -1164,6 +1223,22 @@ class Subgraph {
   // metadata_ by appropriately parametrized SetMetadata method calls.
   const ControlEdges* control_edges_ = nullptr;
 
+  // Arena plan computed offline for this subgraph, if any; the pointee is
+  // owned by the owning interpreter, like `control_edges_`.
+  const OfflineArenaPlan* offline_arena_plan_ = nullptr;
+
+  // Arena plans computed by `AllocateTensors()`, by input shapes (see
+  // `InterpreterOptions::SetArenaPlanCacheSize`). The memory planner checks
+  // that the tensors still fit a plan before using it, so stale entries, e.g.
+  // after delegates changed the execution plan, are merely ignored.
+  struct CachedArenaPlan {
+    OfflineArenaPlan plan;
+    // Value of `arena_plan_cache_clock_` when the plan was last used.
+    uint64_t last_use;
+  };
+  std::map<std::vector<std::vector<int>>, CachedArenaPlan> arena_plan_cache_;
+  uint64_t arena_plan_cache_clock_ = 0;
+
   // Whether this subgraph is "delegation skippable". If a subgraph is
   // delegation-skippable, then the subgraph will be handled by a TfLiteDelegate
   // (and that the delegate is supposed to be already aware of this state), and
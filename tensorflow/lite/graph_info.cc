@@ -17,6 +17,7 @@ limitations under the License.
 #include <algorithm>
 #include <vector>
 
+#include "tensorflow/lite/builtin_ops.h"
 #include "tensorflow/lite/context_util.h"
 #include "tensorflow/lite/core/c/common.h"
 
@@ -289,4 +290,75 @@ TfLiteStatus PartitionGraphIntoIndependentNodeSubsets(
   return kTfLiteOk;
 }
 
+TfLiteStatus ComputeExecutionWavefronts(GraphInfo* info,
+                                        std::vector<int>* order,
+                                        std::vector<int>* wavefront_ends) {
+  const int num_nodes = info->num_execution_nodes();
+  const TfLiteTensor* tensors = info->tensors();
+  // Level of each execution plan index, i.e. the index of its wavefront.
+  std::vector<int> level(num_nodes, 0);
+  // Per tensor, the last node that wrote it and the nodes that read it since.
+  std::vector<int> last_writer(info->num_tensors(), -1);
+  std::vector<std::vector<int>> readers(info->num_tensors());
+  int last_ordered_node = -1;
+  int num_levels = 0;
+  for (int i = 0; i < num_nodes; ++i) {
+    const TfLiteNode& node = info->node(i);
+    const TfLiteRegistration& registration = info->registration(i);
+    auto depend_on = [&](int other) {
+      if (other != -1) level[i] = std::max(level[i], level[other] + 1);
+    };
+    auto read = [&](int tensor_index) {
+      depend_on(last_writer[tensor_index]);
+      readers[tensor_index].push_back(i);
+    };
+    auto write = [&](int tensor_index) {
+      depend_on(last_writer[tensor_index]);
+      for (int reader : readers[tensor_index]) {
+        if (reader != i) depend_on(reader);
+      }
+      readers[tensor_index].clear();
+    };
+
+    if (node.might_have_side_effect ||
+        registration.builtin_code == kTfLiteBuiltinCustom) {
+      depend_on(last_ordered_node);
+      last_ordered_node = i;
+    }
+    for (int tensor_index : TfLiteIntArrayView(node.inputs)) {
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      if (tensors[tensor_index].is_variable) write(tensor_index);
+      read(tensor_index);
+    }
+    for (int tensor_index : TfLiteIntArrayView(node.outputs)) {
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      write(tensor_index);
+    }
+    // Record writes only once all of the node's dependencies are known, so
+    // that a tensor both read and written by the node isn't a self-edge.
+    for (int tensor_index : TfLiteIntArrayView(node.inputs)) {
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      if (tensors[tensor_index].is_variable) last_writer[tensor_index] = i;
+    }
+    for (int tensor_index : TfLiteIntArrayView(node.outputs)) {
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      last_writer[tensor_index] = i;
+    }
+    num_levels = std::max(num_levels, level[i] + 1);
+  }
+
+  // Counting sort of the nodes by level keeps the original relative order of
+  // the nodes within a wavefront.
+  wavefront_ends->assign(num_levels, 0);
+  for (int i = 0; i < num_nodes; ++i) ++(*wavefront_ends)[level[i]];
+  for (int k = 1; k < num_levels; ++k) {
+    (*wavefront_ends)[k] += (*wavefront_ends)[k - 1];
+  }
+  std::vector<int> next(num_levels, 0);
+  for (int k = 1; k < num_levels; ++k) next[k] = (*wavefront_ends)[k - 1];
+  order->assign(num_nodes, 0);
+  for (int i = 0; i < num_nodes; ++i) (*order)[next[level[i]]++] = i;
+  return kTfLiteOk;
+}
+
 }  // namespace tflite
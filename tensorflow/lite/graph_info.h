@@ -156,6 +156,26 @@ TfLiteStatus PartitionGraphIntoIndependentNodeSubsets(
     std::vector<NodeSubset>* node_subsets, bool greedily,
     const ControlEdges* control_edges = nullptr);
 
+// Groups the nodes of the execution plan of `info` into wavefronts of nodes
+// that don't depend on each other, so that the nodes of a wavefront may run
+// concurrently once all earlier wavefronts have completed.
+//
+// A node depends on the nodes that last wrote its inputs and, if it writes a
+// tensor, on all nodes that used the tensor since it was last written. Inputs
+// that are variable tensors count as written since stateful kernels update
+// them in place. Nodes that might have side effects and custom ops, whose
+// side effects aren't known, additionally keep their relative order. Wavefront
+// k holds the nodes whose longest dependency chain has k predecessors.
+//
+// On return, `order` lists the execution plan indices wavefront by wavefront,
+// keeping the original relative order within a wavefront, and
+// `wavefront_ends[k]` is one past the position in `order` of the last node of
+// wavefront k. Since wavefronts only grow from the execution plan's data
+// dependencies, `order` is a valid execution plan as well.
+TfLiteStatus ComputeExecutionWavefronts(GraphInfo* info,
+                                        std::vector<int>* order,
+                                        std::vector<int>* wavefront_ends);
+
 }  // namespace tflite
 
 #endif  // TENSORFLOW_LITE_GRAPH_INFO_H_
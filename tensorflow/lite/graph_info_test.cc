@@ -29,6 +29,7 @@ limitations under the License.
 namespace tflite {
 namespace {
 
+using ::testing::ElementsAre;
 using ::testing::Eq;
 using ::testing::ExplainMatchResult;
 using ::testing::Pointwise;
@@ -693,5 +694,89 @@ TEST(PartitionTest, ComplexNonGreedily) {
                                 })));
 }
 
+struct Wavefronts {
+  std::vector<int> order;
+  std::vector<int> ends;
+};
+
+Wavefronts ComputeWavefronts(SimpleTestGraph* graph) {
+  Wavefronts wavefronts;
+  EXPECT_EQ(ComputeExecutionWavefronts(graph, &wavefronts.order,
+                                       &wavefronts.ends),
+            kTfLiteOk);
+  return wavefronts;
+}
+
+// Two independent branches, interleaved in the execution plan:
+//
+//  (0)-->[0]-->(1)-->[1]-->(3)--\
+//    \                           [4]-->(5)
+//     \-->[2]-->(2)-->[3]-->(4)--/
+//
+TEST(WavefrontTest, IndependentBranches) {
+  SimpleTestGraph graph(
+      /*inputs=*/{0},
+      /*outputs=*/{5},
+      /*nodes=*/
+      {
+          {{0}, {1}, false},
+          {{1}, {3}, false},
+          {{0}, {2}, false},
+          {{2}, {4}, false},
+          {{3, 4}, {5}, false},
+      });
+  Wavefronts wavefronts = ComputeWavefronts(&graph);
+  EXPECT_THAT(wavefronts.order, ElementsAre(0, 2, 1, 3, 4));
+  EXPECT_THAT(wavefronts.ends, ElementsAre(2, 4, 5));
+}
+
+TEST(WavefrontTest, Chain) {
+  SimpleTestGraph graph(
+      /*inputs=*/{0},
+      /*outputs=*/{3},
+      /*nodes=*/
+      {
+          {{0}, {1}, false},
+          {{1}, {2}, false},
+          {{2}, {3}, false},
+      });
+  Wavefronts wavefronts = ComputeWavefronts(&graph);
+  EXPECT_THAT(wavefronts.order, ElementsAre(0, 1, 2));
+  EXPECT_THAT(wavefronts.ends, ElementsAre(1, 2, 3));
+}
+
+TEST(WavefrontTest, SideEffectsKeepTheirOrder) {
+  SimpleTestGraph graph(
+      /*inputs=*/{0},
+      /*outputs=*/{1, 2, 3},
+      /*nodes=*/
+      {
+          {{0}, {1}, true},
+          {{0}, {2}, false},
+          {{0}, {3}, true},
+      });
+  Wavefronts wavefronts = ComputeWavefronts(&graph);
+  EXPECT_THAT(wavefronts.order, ElementsAre(0, 1, 2));
+  EXPECT_THAT(wavefronts.ends, ElementsAre(2, 3));
+}
+
+TEST(WavefrontTest, VariableTensorsAreUpdatedInOrder) {
+  // Node 0 updates variable tensor 1, which node 1 reads afterwards and node 2
+  // updates again.
+  SimpleTestGraph graph(
+      /*inputs=*/{0},
+      /*outputs=*/{2, 3, 4},
+      /*nodes=*/
+      {
+          {{0, 1}, {2}, false},
+          {{1}, {3}, false},
+          {{0, 1}, {4}, false},
+      });
+  graph.tensor(1)->is_variable = true;
+  Wavefronts wavefronts = ComputeWavefronts(&graph);
+  EXPECT_THAT(wavefronts.order, ElementsAre(0, 1, 2));
+  EXPECT_THAT(wavefronts.ends, ElementsAre(1, 2, 3));
+}
+
 }  // namespace
 }  // namespace tflite
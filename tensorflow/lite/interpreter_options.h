@@ -103,12 +103,60 @@ class InterpreterOptions {
     return experimental_cache_constant_cast_op_;
   }
 
+  // Sets the number of threads, including the thread calling `Invoke()`, on
+  // which nodes of the execution plan that don't depend on each other run
+  // concurrently. Values below 2 keep executing nodes one after the other.
+  //
+  // Nodes are grouped into wavefronts of independent nodes, and the execution
+  // plan is reordered wavefront by wavefront. Each wavefront runs on the
+  // threads of a pool shared by all subgraphs and completes before the next
+  // one starts. The memory planner keeps the tensors of a
+  // wavefront from sharing memory, so the arena may grow. Subgraphs that
+  // have delegated nodes or dynamic tensors, or that have a profiler
+  // installed, keep running sequentially. This is independent of the threads
+  // that kernels use internally (see `Interpreter::SetNumThreads`), and each
+  // thread gets its own CPU backend context with that many threads.
+  //
+  // WARNING: This is an experimental API and subject to change.
+  void SetNumInterOpThreads(int num_threads) {
+    experimental_num_inter_op_threads_ = num_threads;
+  }
+
+  // Returns the number of threads set by `SetNumInterOpThreads`.
+  //
+  // WARNING: This is an experimental API and subject to change.
+  int GetNumInterOpThreads() const {
+    return experimental_num_inter_op_threads_;
+  }
+
+  // Sets the number of input shapes for which each subgraph keeps the arena
+  // plan computed by `AllocateTensors()`. When the inputs are resized back to
+  // one of these shapes, the tensors are placed at their recorded offsets
+  // instead of being planned again. This helps models whose inputs cycle
+  // through a few shapes, e.g. sequence length buckets. Kernels are still
+  // prepared for the new shapes. Once the cache is full, the plan used least
+  // recently is replaced. Zero, the default, disables the cache.
+  //
+  // WARNING: This is an experimental API and subject to change.
+  void SetArenaPlanCacheSize(int num_input_shapes) {
+    experimental_arena_plan_cache_size_ = num_input_shapes;
+  }
+
+  // Returns the number of input shapes set by `SetArenaPlanCacheSize`.
+  //
+  // WARNING: This is an experimental API and subject to change.
+  int GetArenaPlanCacheSize() const {
+    return experimental_arena_plan_cache_size_;
+  }
+
  private:
   bool experimental_preserve_all_tensors_ = false;
   bool experimental_ensure_dynamic_tensors_are_released_ = false;
   int experimental_optimize_memory_for_large_tensors_ = 0;
   bool experimental_disable_delegate_clustering_ = false;
   bool experimental_cache_constant_cast_op_ = false;
+  int experimental_num_inter_op_threads_ = 1;
+  int experimental_arena_plan_cache_size_ = 0;
 };
 
 }  // namespace tflite
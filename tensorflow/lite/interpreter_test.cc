@@ -40,6 +40,7 @@ limitations under the License.
 #include "tensorflow/lite/interpreter_options.h"
 #include "tensorflow/lite/interpreter_test_util.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/offline_arena_plan.h"
 #include "tensorflow/lite/string_util.h"
 #include "tensorflow/lite/testing/util.h"
 #include "tensorflow/lite/util.h"
@@ -1129,6 +1130,132 @@ TEST(BasicInterpreter, ReleaseDynamicTensors) {
   ASSERT_EQ(interpreter.tensor(3)->bytes, sizeof(float) * 6 * 6);
 }
 
+TEST(BasicInterpreter, InterOpParallelism) {
+  // Assemble a graph with two independent branches of two negate ops each.
+  Interpreter interpreter;
+  interpreter.AddTensors(5);
+  interpreter.SetInputs({0});
+  interpreter.SetOutputs({2, 4});
+  TfLiteQuantizationParams quant;
+  for (int i = 0; i < 5; ++i) {
+    interpreter.SetTensorParametersReadWrite(/*tensor_index=*/i,
+                                             /*type=*/kTfLiteFloat32,
+                                             /*name=*/"", /*dims=*/{64},
+                                             /*quantization=*/quant);
+  }
+  TfLiteRegistration* neg_op = tflite::ops::builtin::Register_NEG();
+  for (const auto& [input, output] :
+       std::vector<std::pair<int, int>>{{0, 1}, {1, 2}, {0, 3}, {3, 4}}) {
+    ASSERT_EQ(interpreter.AddNodeWithParameters(
+                  /*inputs=*/{input}, /*outputs=*/{output},
+                  /*init_data=*/nullptr, /*init_data_size=*/0,
+                  /*builtin_data=*/nullptr, /*registration=*/neg_op),
+              kTfLiteOk);
+  }
+
+  InterpreterOptions options;
+  options.SetNumInterOpThreads(2);
+  ASSERT_EQ(interpreter.ApplyOptions(&options), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+
+  // The first nodes of both branches run concurrently, and so do the last
+  // ones, so the tensors they use can't share memory.
+  EXPECT_THAT(interpreter.execution_plan(), ElementsAre(0, 2, 1, 3));
+  EXPECT_NE(interpreter.tensor(1)->data.raw, interpreter.tensor(3)->data.raw);
+  EXPECT_NE(interpreter.tensor(2)->data.raw, interpreter.tensor(4)->data.raw);
+
+  for (int run = 0; run < 3; ++run) {
+    float* input = interpreter.typed_tensor<float>(0);
+    for (int i = 0; i < 64; ++i) input[i] = run * 100 + i;
+    ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+    for (int i = 0; i < 64; ++i) {
+      EXPECT_EQ(interpreter.typed_tensor<float>(2)[i], run * 100 + i);
+      EXPECT_EQ(interpreter.typed_tensor<float>(4)[i], run * 100 + i);
+    }
+  }
+}
+
+TEST(BasicInterpreter, ArenaPlanCache) {
+  // Assemble a chain of three negate ops.
+  Interpreter interpreter;
+  interpreter.AddTensors(4);
+  interpreter.SetInputs({0});
+  interpreter.SetOutputs({3});
+  TfLiteQuantizationParams quant;
+  for (int i = 0; i < 4; ++i) {
+    interpreter.SetTensorParametersReadWrite(/*tensor_index=*/i,
+                                             /*type=*/kTfLiteFloat32,
+                                             /*name=*/"", /*dims=*/{8},
+                                             /*quantization=*/quant);
+  }
+  TfLiteRegistration* neg_op = tflite::ops::builtin::Register_NEG();
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_EQ(interpreter.AddNodeWithParameters(
+                  /*inputs=*/{i}, /*outputs=*/{i + 1},
+                  /*init_data=*/nullptr, /*init_data_size=*/0,
+                  /*builtin_data=*/nullptr, /*registration=*/neg_op),
+              kTfLiteOk);
+  }
+
+  InterpreterOptions options;
+  options.SetArenaPlanCacheSize(2);
+  ASSERT_EQ(interpreter.ApplyOptions(&options), kTfLiteOk);
+
+  // The runtime planner never places the tensors in reverse order, so a plan
+  // doing so shows that a cached plan is applied rather than a recomputed one.
+  OfflineArenaPlan reversed_plan;
+  for (int i = 0; i < 4; ++i) {
+    reversed_plan.push_back({/*tensor=*/i, /*first_node=*/0, /*last_node=*/2,
+                             /*offset=*/static_cast<size_t>((3 - i) * 64),
+                             /*size=*/8 * sizeof(float)});
+  }
+  const std::vector<ptrdiff_t> reversed_offsets = {-64, -128, -192};
+  ASSERT_EQ(InterpreterTest::SetMetadata(
+                &interpreter, {{kOfflineArenaPlanMetadataKey,
+                                SerializeOfflineArenaPlans({reversed_plan})}}),
+            kTfLiteOk);
+
+  auto offsets = [&interpreter] {
+    std::vector<ptrdiff_t> offsets;
+    for (int i = 1; i < 4; ++i) {
+      offsets.push_back(interpreter.tensor(i)->data.raw -
+                        interpreter.tensor(0)->data.raw);
+    }
+    return offsets;
+  };
+  auto run = [&interpreter](int size) {
+    ASSERT_EQ(interpreter.ResizeInputTensor(0, {size}), kTfLiteOk);
+    ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+    float* input = interpreter.typed_tensor<float>(0);
+    for (int i = 0; i < size; ++i) input[i] = i;
+    ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+    for (int i = 0; i < size; ++i) {
+      EXPECT_EQ(interpreter.typed_tensor<float>(3)[i], -i);
+    }
+  };
+
+  // The model's plan is used, and cached, for the shape it was made for.
+  run(8);
+  EXPECT_EQ(offsets(), reversed_offsets);
+  ASSERT_EQ(InterpreterTest::SetMetadata(&interpreter, {}), kTfLiteOk);
+  run(256);
+  const std::vector<ptrdiff_t> large_offsets = offsets();
+  EXPECT_NE(large_offsets, reversed_offsets);
+
+  // Without the model's plan, only the cache can place the tensors in reverse
+  // order when switching back.
+  run(8);
+  EXPECT_EQ(offsets(), reversed_offsets);
+  run(256);
+  EXPECT_EQ(offsets(), large_offsets);
+
+  // A new shape replaces the least recently used plan, the one for 8, which
+  // is then planned at runtime again.
+  run(64);
+  run(8);
+  EXPECT_NE(offsets(), reversed_offsets);
+}
+
 TEST(InterpreterTensorsCapacityTest, TestWithinHeadroom) {
   Interpreter interpreter;
   ASSERT_EQ(interpreter.AddTensors(Interpreter::kTensorsReservedCapacity),
@@ -42,6 +42,12 @@ class InterpreterTest : public ::testing::Test {
     return interpreter->ModifyGraphWithDelegate(std::move(delegate));
   }
 
+  static TfLiteStatus SetMetadata(
+      Interpreter* interpreter,
+      const std::map<std::string, std::string>& metadata) {
+    return interpreter->SetMetadata(metadata);
+  }
+
  protected:
   TfLiteContext* GetInterpreterContext() { return interpreter_->context_; }
 
@@ -44,6 +44,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/internal/tensor_utils.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/kernels/packed_weight_cache.h"
 #include "tensorflow/lite/kernels/padding.h"
 #include "tensorflow/lite/util.h"
 
@@ -107,6 +108,10 @@ struct OpData {
   int32_t row_sums_index;
 
   bool need_hwcn_weights = false;
+  // If true, the HWCN weights are shared with the other interpreters of the
+  // process instead of being stored in a temporary tensor.
+  bool share_hwcn_weights = false;
+  std::shared_ptr<const uint8_t> shared_hwcn_weights;
   bool have_weights_been_transposed = false;
   bool need_im2col = false;
   // If it's true, it means im2col is needed but gets disabled because the
@@ -157,11 +162,8 @@ void Free(TfLiteContext* context, void* buffer) {
 // Naive implementation of transpose for floats. Could be optimized to be more
 // cache friendly, but for now it's a one-time cost on first run, and we would
 // prefer to remove the need to do this at all eventually.
-void TransposeFloatTensor(const TfLiteTensor* input, TfLiteTensor* output) {
-  const int rows = output->dims->data[1];
-  const int cols = output->dims->data[0];
-  const float* input_data = GetTensorData<float>(input);
-  float* output_data = GetTensorData<float>(output);
+void TransposeFloatTensor(const float* input_data, int rows, int cols,
+                          float* output_data) {
   for (int i = 0; i < rows; ++i) {
     for (int j = 0; j < cols; ++j) {
       const float in_value = input_data[i * cols + j];
@@ -170,6 +172,11 @@ void TransposeFloatTensor(const TfLiteTensor* input, TfLiteTensor* output) {
   }
 }
 
+void TransposeFloatTensor(const TfLiteTensor* input, TfLiteTensor* output) {
+  TransposeFloatTensor(GetTensorData<float>(input), output->dims->data[1],
+                       output->dims->data[0], GetTensorData<float>(output));
+}
+
 // Check if im2col needs to be allocated, as some version of optimized Conv dont
 // use it. If any change is supporting im2col in any of the Conv versions, then
 // it should be updated here as well
@@ -242,6 +249,8 @@ static TfLiteStatus AllocateTemporaryTensorsIfRequired(
   // we're running with that data type.
   data->need_hwcn_weights =
       input->type == kTfLiteFloat32 && data->supports_multithreaded_kernel;
+  data->share_hwcn_weights =
+      data->need_hwcn_weights && PackedWeightCache::CanShare(filter);
 
   // We don't always need to allocate im2col. It is only used in some versions
   // of the optimized Conv. This test just mimics something that happens inside
@@ -269,7 +278,7 @@ static TfLiteStatus AllocateTemporaryTensorsIfRequired(
     }
     ++temporaries_count;
   }
-  if (data->need_hwcn_weights) {
+  if (data->need_hwcn_weights && !data->share_hwcn_weights) {
     data->hwcn_weights_index = temporaries_count;
     if (data->hwcn_weights_id == kTensorNotAllocated) {
       context->AddTensors(context, 1, &data->hwcn_weights_id);
@@ -530,7 +539,9 @@ TfLiteStatus Prepare(KernelType kernel_type, TfLiteContext* context,
     if (im2col_status != kTfLiteOk) return im2col_status;
   }
 
-  if (data->need_hwcn_weights) {
+  if (data->need_hwcn_weights && data->share_hwcn_weights) {
+    data->have_weights_been_transposed = false;
+  } else if (data->need_hwcn_weights) {
     node->temporaries->data[data->hwcn_weights_index] = data->hwcn_weights_id;
     TfLiteIntArray* hwcn_weights_size = TfLiteIntArrayCreate(2);
 
@@ -1004,7 +1015,10 @@ void EvalFloat(TfLiteContext* context, TfLiteNode* node,
     case kMultithreadOptimized: {
 #if defined(TFLITE_WITH_MULTITHREADED_EIGEN)
       const float* filter_data;
-      if (data->need_hwcn_weights) {
+      if (data->share_hwcn_weights) {
+        filter_data =
+            reinterpret_cast<const float*>(data->shared_hwcn_weights.get());
+      } else if (data->need_hwcn_weights) {
         filter_data = GetTensorData<float>(hwcn_weights);
       } else {
         filter_data = GetTensorData<float>(filter);
@@ -1269,12 +1283,25 @@ TfLiteStatus EvalImpl(TfLiteContext* context, TfLiteNode* node) {
           ? &context->tensors[node->temporaries->data[data->im2col_index]]
           : nullptr;
   TfLiteTensor* hwcn_weights =
-      data->need_hwcn_weights
+      data->need_hwcn_weights && !data->share_hwcn_weights
           ? &context->tensors[node->temporaries->data[data->hwcn_weights_index]]
           : nullptr;
 
   if (data->need_hwcn_weights && !data->have_weights_been_transposed) {
-    TransposeFloatTensor(filter, hwcn_weights);
+    if (data->share_hwcn_weights) {
+      // Interpreters running the same model share the transposed weights.
+      const int rows = filter->dims->data[0];
+      const int cols = filter->dims->data[1] * filter->dims->data[2] *
+                       filter->dims->data[3];
+      data->shared_hwcn_weights = PackedWeightCache::Get().GetOrPack(
+          {filter->data.raw_const, filter->bytes, "conv_hwcn_float32"},
+          filter->bytes, [filter, rows, cols](uint8_t* packed) {
+            TransposeFloatTensor(GetTensorData<float>(filter), rows, cols,
+                                 reinterpret_cast<float*>(packed));
+          });
+    } else {
+      TransposeFloatTensor(filter, hwcn_weights);
+    }
     data->have_weights_been_transposed = true;
   }
 
@@ -19,6 +19,7 @@ limitations under the License.
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "tensorflow/lite/core/c/builtin_op_data.h"
@@ -36,6 +37,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/tensor_utils.h"
 #include "tensorflow/lite/kernels/internal/types.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/kernels/packed_weight_cache.h"
 #include "tensorflow/lite/minimal_logging.h"
 
 #ifdef TFLITE_HAVE_CPUINFO
@@ -972,13 +974,31 @@ TfLiteStatus EvalHybridDense4Bit(
   const int dst_layout_cols = lhs_layout_rows;
   if (data->op_data_4bit->needs_prepack) {
     const int weight_size = lhs_layout_rows * lhs_layout_cols / 2;
-    const int required_size =
-        optimized_4bit::kDefaultAlignmentPadding + weight_size;
-    data->op_data_4bit->AllocatePackedRegion(required_size);
     const int8_t* weight_ptr = GetTensorData<int8_t>(filter);
-    optimized_4bit::api::Prepack(data->op_data_4bit->prepacked_cache,
-                                 weight_ptr, lhs_layout_rows, lhs_layout_cols,
-                                 output_depth, cols, lhs_width, depth);
+    auto prepack = [&](uint8_t* dest) {
+      optimized_4bit::api::Prepack(dest, weight_ptr, lhs_layout_rows,
+                                   lhs_layout_cols, output_depth, cols,
+                                   lhs_width, depth);
+    };
+    if (PackedWeightCache::CanShare(filter)) {
+      // Interpreters running the same model share the prepacked weights, which
+      // are also persisted if PackedWeightCache has a directory.
+      const std::string format =
+          std::string("fully_connected_4bit_") +
+          optimized_4bit::kImplementationName + ":" +
+          std::to_string(lhs_layout_rows) + "x" +
+          std::to_string(lhs_layout_cols) + "/" + std::to_string(lhs_width) +
+          "x" + std::to_string(depth);
+      data->op_data_4bit->shared_prepacked_cache =
+          PackedWeightCache::Get().GetOrPack(
+              {filter->data.raw_const, filter->bytes, format}, weight_size,
+              prepack);
+    } else {
+      const int required_size =
+          optimized_4bit::kDefaultAlignmentPadding + weight_size;
+      data->op_data_4bit->AllocatePackedRegion(required_size);
+      prepack(data->op_data_4bit->prepacked_cache);
+    }
     data->op_data_4bit->needs_prepack = false;
 #ifdef MADV_PAGEOUT
     // After prepacking, we will never use the weights from the model file. Mark
@@ -1026,7 +1046,7 @@ TfLiteStatus EvalHybridDense4Bit(
   optimized_4bit::api::AssignBiasAndComputeOffsets(
       input_offset_ptr, scaling_factors_ptr, filter_scales.data(), bias_ptr,
       GetTensorData<float>(output), output_depth, batch_size);
-  const uint8_t* lhs = data->op_data_4bit->prepacked_cache;
+  const uint8_t* lhs = data->op_data_4bit->prepacked_weights();
   int32_t* dst = GetTensorData<int32_t>(accum_scratch);
   optimized_4bit::api::RunAndUnpack(
       data->op_data_4bit->rows_right, lhs, quant_data, dst, output_depth,
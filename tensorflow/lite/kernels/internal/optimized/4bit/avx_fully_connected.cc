@@ -0,0 +1,255 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if defined(FC_4BIT_SSE) && defined(__SSSE3__)
+
+#include "tensorflow/lite/kernels/internal/optimized/4bit/sse_fully_connected_impl.h"
+
+#ifdef FC_4BIT_AVX_KERNELS
+
+#include <immintrin.h>
+#include <stdint.h>
+
+#include <algorithm>
+
+namespace tflite {
+namespace optimized_4bit {
+
+// These kernels compute the same thing as SseRunKernelSsse3, on the same
+// prepacked layout: for each block of 32 columns, a row of lhs is 16 bytes
+// whose upper nibbles hold columns 0-15 and lower nibbles columns 16-31, and
+// a row of rhs is 32 int8 values. The 4-bit values are unsigned, so they can
+// be multiplied directly with the signed rhs values by VPMADDUBSW and
+// VPDPBUSD.
+
+#define FC_4BIT_AVX2_TARGET __attribute__((target("avx2")))
+#define FC_4BIT_AVX512_VNNI_TARGET \
+  __attribute__((target("avx2,avx512f,avx512bw,avx512vnni")))
+
+namespace {
+
+// Reduces the 8 int32 values of each of a, b, c and d to
+// [sum(a), sum(b), sum(c), sum(d)].
+FC_4BIT_AVX2_TARGET
+inline __m128i ReduceInt32x8x4(__m256i a, __m256i b, __m256i c, __m256i d) {
+  // [a01, a23, b01, b23 | a45, a67, b45, b67]
+  const __m256i a_b = _mm256_hadd_epi32(a, b);
+  // [c01, c23, d01, d23 | c45, c67, d45, d67]
+  const __m256i c_d = _mm256_hadd_epi32(c, d);
+  // [a0123, b0123, c0123, d0123 | a4567, b4567, c4567, d4567]
+  const __m256i a_b_c_d = _mm256_hadd_epi32(a_b, c_d);
+  return _mm_add_epi32(_mm256_castsi256_si128(a_b_c_d),
+                       _mm256_extracti128_si256(a_b_c_d, 1));
+}
+
+// Unpacks the 32 4-bit values of a 16 byte lhs row into bytes, in column
+// order.
+FC_4BIT_AVX2_TARGET
+inline __m256i UnpackLhsRow(const uint8_t* lhs_row) {
+  const __m256i bitmask = _mm256_set1_epi8(15);
+  const __m256i nibble_shifts = _mm256_setr_epi32(4, 4, 4, 4, 0, 0, 0, 0);
+  const __m256i row = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs_row)));
+  return _mm256_and_si256(_mm256_srlv_epi32(row, nibble_shifts), bitmask);
+}
+
+// Same as UnpackLhsRow, for two consecutive rows.
+FC_4BIT_AVX512_VNNI_TARGET
+inline __m512i UnpackLhsRows(const uint8_t* lhs_rows) {
+  const __m512i bitmask = _mm512_set1_epi8(15);
+  const __m512i nibble_shifts =
+      _mm512_setr_epi32(4, 4, 4, 4, 0, 0, 0, 0, 4, 4, 4, 4, 0, 0, 0, 0);
+  const __m512i row_lanes = _mm512_setr_epi64(0, 1, 0, 1, 2, 3, 2, 3);
+  const __m256i rows =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs_rows));
+  const __m512i duplicated_rows =
+      _mm512_permutexvar_epi64(row_lanes, _mm512_castsi256_si512(rows));
+  return _mm512_and_si512(_mm512_srlv_epi32(duplicated_rows, nibble_shifts),
+                          bitmask);
+}
+
+template <int RowsLeft, int RowsRight, int Cols>
+FC_4BIT_AVX2_TARGET void Avx2Kernel(
+    const uint8_t* lhs, const int8_t* rhs, int32_t* dst, int lhs_layout_rows,
+    int lhs_layout_cols, int rhs_layout_rows, int rhs_layout_cols,
+    int dst_layout_rows, int dst_layout_cols) {
+  static_assert(RowsLeft == 4, "The reduction handles 4 lhs rows.");
+  static_assert(Cols == 32, "An lhs row must fit in 16 bytes.");
+  const int clamped_end_row = std::min(lhs_layout_rows, dst_layout_cols);
+  const int clamped_end_col = std::min(rhs_layout_rows, dst_layout_rows);
+  const int outer_rows = (clamped_end_row + RowsLeft - 1) / RowsLeft;
+  const int outer_cols = (clamped_end_col + RowsRight - 1) / RowsRight;
+  const int depth = std::min(lhs_layout_cols / Cols, rhs_layout_cols / Cols);
+  const __m256i ones = _mm256_set1_epi16(1);
+  int32_t* element_ptr = dst;
+  for (int i = 0; i < outer_rows; ++i) {
+    const uint8_t* lhs_val_data = lhs + i * RowsLeft * lhs_layout_cols / 2;
+    for (int j = 0; j < outer_cols; ++j) {
+      const uint8_t* lhs_val = lhs_val_data;
+      const int8_t* rhs_val = rhs + j * RowsRight * rhs_layout_cols;
+      __m256i accum[RowsRight * RowsLeft];
+      for (int m = 0; m < RowsRight * RowsLeft; ++m) {
+        accum[m] = _mm256_setzero_si256();
+      }
+      for (int k = 0; k < depth; ++k) {
+        __m256i lhs_row[RowsLeft];
+        for (int l = 0; l < RowsLeft; ++l) {
+          lhs_row[l] = UnpackLhsRow(lhs_val);
+          lhs_val += Cols / 2;
+        }
+        for (int r = 0; r < RowsRight; ++r) {
+          const __m256i rhs_row =
+              _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs_val));
+          rhs_val += Cols;
+          for (int l = 0; l < RowsLeft; ++l) {
+            // At most 2 * 15 * 128 per int16, so this can't saturate.
+            const __m256i sumprod_16x16 =
+                _mm256_maddubs_epi16(lhs_row[l], rhs_row);
+            accum[r * RowsLeft + l] =
+                _mm256_add_epi32(accum[r * RowsLeft + l],
+                                 _mm256_madd_epi16(sumprod_16x16, ones));
+          }
+        }
+      }
+      for (int r = 0; r < RowsRight; ++r) {
+        const __m256i* row_accum = accum + r * RowsLeft;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(element_ptr),
+                         ReduceInt32x8x4(row_accum[0], row_accum[1],
+                                         row_accum[2], row_accum[3]));
+        element_ptr += 4;
+      }
+    }
+  }
+}
+
+template <int RowsLeft, int RowsRight, int Cols>
+FC_4BIT_AVX512_VNNI_TARGET void Avx512VnniKernel(
+    const uint8_t* lhs, const int8_t* rhs, int32_t* dst, int lhs_layout_rows,
+    int lhs_layout_cols, int rhs_layout_rows, int rhs_layout_cols,
+    int dst_layout_rows, int dst_layout_cols) {
+  static_assert(RowsLeft == 4, "The reduction handles 4 lhs rows.");
+  static_assert(Cols == 32, "An lhs row must fit in 16 bytes.");
+  // Each 512-bit register holds two lhs rows.
+  constexpr int kRowPairs = RowsLeft / 2;
+  const int clamped_end_row = std::min(lhs_layout_rows, dst_layout_cols);
+  const int clamped_end_col = std::min(rhs_layout_rows, dst_layout_rows);
+  const int outer_rows = (clamped_end_row + RowsLeft - 1) / RowsLeft;
+  const int outer_cols = (clamped_end_col + RowsRight - 1) / RowsRight;
+  const int depth = std::min(lhs_layout_cols / Cols, rhs_layout_cols / Cols);
+  int32_t* element_ptr = dst;
+  for (int i = 0; i < outer_rows; ++i) {
+    const uint8_t* lhs_val_data = lhs + i * RowsLeft * lhs_layout_cols / 2;
+    for (int j = 0; j < outer_cols; ++j) {
+      const uint8_t* lhs_val = lhs_val_data;
+      const int8_t* rhs_val = rhs + j * RowsRight * rhs_layout_cols;
+      __m512i accum[RowsRight * kRowPairs];
+      for (int m = 0; m < RowsRight * kRowPairs; ++m) {
+        accum[m] = _mm512_setzero_si512();
+      }
+      for (int k = 0; k < depth; ++k) {
+        __m512i lhs_rows[kRowPairs];
+        for (int p = 0; p < kRowPairs; ++p) {
+          lhs_rows[p] = UnpackLhsRows(lhs_val);
+          lhs_val += Cols;
+        }
+        for (int r = 0; r < RowsRight; ++r) {
+          const __m512i rhs_row = _mm512_broadcast_i64x4(
+              _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs_val)));
+          rhs_val += Cols;
+          for (int p = 0; p < kRowPairs; ++p) {
+            accum[r * kRowPairs + p] =
+                _mm512_dpbusd_epi32(accum[r * kRowPairs + p], lhs_rows[p],
+                                    rhs_row);
+          }
+        }
+      }
+      for (int r = 0; r < RowsRight; ++r) {
+        const __m512i* row_accum = accum + r * kRowPairs;
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(element_ptr),
+            ReduceInt32x8x4(_mm512_castsi512_si256(row_accum[0]),
+                            _mm512_extracti64x4_epi64(row_accum[0], 1),
+                            _mm512_castsi512_si256(row_accum[1]),
+                            _mm512_extracti64x4_epi64(row_accum[1], 1)));
+        element_ptr += 4;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+#undef FC_4BIT_AVX2_TARGET
+#undef FC_4BIT_AVX512_VNNI_TARGET
+
+// The kernels are called through these functions, which are declared without
+// target attributes (GCC would treat declarations with different targets as
+// different versions of the function).
+template <int RowsLeft, int RowsRight, int Cols>
+void SseRunKernelAvx2(const uint8_t* lhs, const int8_t* rhs, int32_t* dst,
+                      int lhs_layout_rows, int lhs_layout_cols,
+                      int rhs_layout_rows, int rhs_layout_cols,
+                      int dst_layout_rows, int dst_layout_cols) {
+  Avx2Kernel<RowsLeft, RowsRight, Cols>(
+      lhs, rhs, dst, lhs_layout_rows, lhs_layout_cols, rhs_layout_rows,
+      rhs_layout_cols, dst_layout_rows, dst_layout_cols);
+}
+
+template <int RowsLeft, int RowsRight, int Cols>
+void SseRunKernelAvx512Vnni(const uint8_t* lhs, const int8_t* rhs,
+                            int32_t* dst, int lhs_layout_rows,
+                            int lhs_layout_cols, int rhs_layout_rows,
+                            int rhs_layout_cols, int dst_layout_rows,
+                            int dst_layout_cols) {
+  Avx512VnniKernel<RowsLeft, RowsRight, Cols>(
+      lhs, rhs, dst, lhs_layout_rows, lhs_layout_cols, rhs_layout_rows,
+      rhs_layout_cols, dst_layout_rows, dst_layout_cols);
+}
+
+template void SseRunKernelAvx2<4, 1, 32>(
+    const uint8_t* lhs, const int8_t* rhs, int32_t* dst, int lhs_layout_rows,
+    int lhs_layout_cols, int rhs_layout_rows, int rhs_layout_cols,
+    int dst_layout_rows, int dst_layout_cols);
+
+template void SseRunKernelAvx2<4, 2, 32>(
+    const uint8_t* lhs, const int8_t* rhs, int32_t* dst, int lhs_layout_rows,
+    int lhs_layout_cols, int rhs_layout_rows, int rhs_layout_cols,
+    int dst_layout_rows, int dst_layout_cols);
+
+template void SseRunKernelAvx2<4, 4, 32>(
+    const uint8_t* lhs, const int8_t* rhs, int32_t* dst, int lhs_layout_rows,
+    int lhs_layout_cols, int rhs_layout_rows, int rhs_layout_cols,
+    int dst_layout_rows, int dst_layout_cols);
+
+template void SseRunKernelAvx512Vnni<4, 1, 32>(
+    const uint8_t* lhs, const int8_t* rhs, int32_t* dst, int lhs_layout_rows,
+    int lhs_layout_cols, int rhs_layout_rows, int rhs_layout_cols,
+    int dst_layout_rows, int dst_layout_cols);
+
+template void SseRunKernelAvx512Vnni<4, 2, 32>(
+    const uint8_t* lhs, const int8_t* rhs, int32_t* dst, int lhs_layout_rows,
+    int lhs_layout_cols, int rhs_layout_rows, int rhs_layout_cols,
+    int dst_layout_rows, int dst_layout_cols);
+
+template void SseRunKernelAvx512Vnni<4, 4, 32>(
+    const uint8_t* lhs, const int8_t* rhs, int32_t* dst, int lhs_layout_rows,
+    int lhs_layout_cols, int rhs_layout_rows, int rhs_layout_cols,
+    int dst_layout_rows, int dst_layout_cols);
+
+}  // namespace optimized_4bit
+}  // namespace tflite
+
+#endif  // FC_4BIT_AVX_KERNELS
+#endif  // defined(FC_4BIT_SSE) && defined(__SSSE3__)
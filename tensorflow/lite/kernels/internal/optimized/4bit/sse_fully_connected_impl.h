@@ -51,12 +51,47 @@ extern void SseUnpack(float* output_ptr, const int32_t* dst, int batch_size,
                       const float* filter_scales, int dst_layout_rows,
                       int dst_layout_cols);
 
+// Runs the fastest of the kernels below that the CPU supports.
 template <int RowsLeft, int RowsRight, int Cols>
 extern void SseRunKernel(const uint8_t* lhs, const int8_t* rhs, int32_t* dst,
                          int lhs_layout_rows, int lhs_layout_cols,
                          int rhs_layout_rows, int rhs_layout_cols,
                          int dst_layout_rows, int dst_layout_cols);
 
+template <int RowsLeft, int RowsRight, int Cols>
+extern void SseRunKernelSsse3(const uint8_t* lhs, const int8_t* rhs,
+                              int32_t* dst, int lhs_layout_rows,
+                              int lhs_layout_cols, int rhs_layout_rows,
+                              int rhs_layout_cols, int dst_layout_rows,
+                              int dst_layout_cols);
+
+// The AVX2 and AVX-512 kernels are compiled with function target attributes,
+// so they are available whenever the compiler supports them, and only run on
+// CPUs that have the instructions.
+#if defined(__x86_64__) &&                           \
+    ((defined(__clang__) && __clang_major__ >= 6) || \
+     (!defined(__clang__) && defined(__GNUC__) && __GNUC__ >= 8))
+#define FC_4BIT_AVX_KERNELS
+#endif
+
+#ifdef FC_4BIT_AVX_KERNELS
+// Requires AVX2.
+template <int RowsLeft, int RowsRight, int Cols>
+extern void SseRunKernelAvx2(const uint8_t* lhs, const int8_t* rhs,
+                             int32_t* dst, int lhs_layout_rows,
+                             int lhs_layout_cols, int rhs_layout_rows,
+                             int rhs_layout_cols, int dst_layout_rows,
+                             int dst_layout_cols);
+
+// Requires AVX-512F, AVX-512BW and AVX-512 VNNI.
+template <int RowsLeft, int RowsRight, int Cols>
+extern void SseRunKernelAvx512Vnni(const uint8_t* lhs, const int8_t* rhs,
+                                   int32_t* dst, int lhs_layout_rows,
+                                   int lhs_layout_cols, int rhs_layout_rows,
+                                   int rhs_layout_cols, int dst_layout_rows,
+                                   int dst_layout_cols);
+#endif  // FC_4BIT_AVX_KERNELS
+
 }  // namespace optimized_4bit
 }  // namespace tflite
 
@@ -19,6 +19,12 @@ limitations under the License.
 #include <sys/auxv.h>
 #endif
 
+#if (defined __x86_64__ || defined __i386__) && \
+    (defined __GNUC__ || defined __clang__)
+#include <cpuid.h>
+#define TFLITE_CPU_CHECK_X86_CPUID
+#endif
+
 namespace tflite {
 
 namespace {
@@ -37,6 +43,26 @@ bool DetectDotprodByLinuxAuxvMethod() {
 }
 #endif
 
+#ifdef TFLITE_CPU_CHECK_X86_CPUID
+// Bits of the XCR0 register telling which register states the OS saves.
+constexpr unsigned kXcr0SseAvxState = 0x6;   // XMM, YMM.
+constexpr unsigned kXcr0Avx512State = 0xe0;  // Opmask, ZMM0-15, ZMM16-31.
+
+// Returns the XCR0 register, or 0 if the OS doesn't support XSAVE.
+unsigned GetXcr0() {
+  unsigned eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & (1u << 27))) {
+    return 0;  // No OSXSAVE.
+  }
+  unsigned xcr0_low, xcr0_high;
+  // XGETBV, spelled out for assemblers that don't know it.
+  __asm__(".byte 0x0f, 0x01, 0xd0" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+  return xcr0_low;
+}
+
+bool HasXcr0State(unsigned state) { return (GetXcr0() & state) == state; }
+#endif
+
 }  // namespace
 
 bool DetectArmNeonDotprod() {
@@ -47,4 +73,44 @@ bool DetectArmNeonDotprod() {
 #endif
 }
 
+bool DetectX86Avx512Vnni() {
+#ifdef TFLITE_CPU_CHECK_X86_CPUID
+  unsigned eax, ebx, ecx, edx;
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+  const bool avx512f = ebx & (1u << 16);
+  const bool avx512bw = ebx & (1u << 30);
+  const bool avx512_vnni = ecx & (1u << 11);
+  return avx512f && avx512bw && avx512_vnni &&
+         HasXcr0State(kXcr0SseAvxState | kXcr0Avx512State);
+#else
+  return false;
+#endif
+}
+
+bool DetectX86Avx2() {
+#ifdef TFLITE_CPU_CHECK_X86_CPUID
+  unsigned eax, ebx, ecx, edx;
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+  const bool avx2 = ebx & (1u << 5);
+  return avx2 && HasXcr0State(kXcr0SseAvxState);
+#else
+  return false;
+#endif
+}
+
+bool DetectX86AvxVnni() {
+#ifdef TFLITE_CPU_CHECK_X86_CPUID
+  unsigned eax, ebx, ecx, edx;
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+  const bool avx2 = ebx & (1u << 5);
+  if (eax < 1 || !__get_cpuid_count(7, 1, &eax, &ebx, &ecx, &edx)) {
+    return false;
+  }
+  const bool avx_vnni = eax & (1u << 4);
+  return avx2 && avx_vnni && HasXcr0State(kXcr0SseAvxState);
+#else
+  return false;
+#endif
+}
+
 }  // namespace tflite
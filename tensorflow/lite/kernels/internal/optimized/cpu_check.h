@@ -27,12 +27,31 @@ namespace tflite {
 // On other architectures, returns false unconditionally.
 bool DetectArmNeonDotprod();
 
+// On x86, returns true if the AVX-512 VNNI instructions (along with AVX-512F
+// and AVX-512BW) are present and enabled by the OS.
+// On other architectures, returns false unconditionally.
+bool DetectX86Avx512Vnni();
+
+// On x86, returns true if the AVX2 instructions are present and enabled by the
+// OS.
+// On other architectures, returns false unconditionally.
+bool DetectX86Avx2();
+
+// On x86, returns true if the VEX-encoded AVX-VNNI instructions (along with
+// AVX2) are present and enabled by the OS.
+// On other architectures, returns false unconditionally.
+bool DetectX86AvxVnni();
+
 struct CpuFlags {
   bool neon_dotprod = false;
+  bool avx512_vnni = false;
+  bool avx_vnni = false;
 };
 
 inline void GetCpuFlags(CpuFlags* cpu_flags) {
   cpu_flags->neon_dotprod = DetectArmNeonDotprod();
+  cpu_flags->avx512_vnni = DetectX86Avx512Vnni();
+  cpu_flags->avx_vnni = DetectX86AvxVnni();
 }
 
 }  // namespace tflite
@@ -38,6 +38,16 @@ namespace optimized_4bit {
 // Define 4-bit filter block size: 4x32 (64 bytes)
 constexpr int FilterWidth = 4;
 constexpr int FilterDepth = 32;
+
+// Name of the implementation included above, which prepacked weights are laid
+// out for.
+#if defined(FC_4BIT_SSE) && defined(__SSSE3__)
+constexpr char kImplementationName[] = "sse";
+#elif defined(FC_4BIT_NEON) && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+constexpr char kImplementationName[] = "neon";
+#else
+constexpr char kImplementationName[] = "reference";
+#endif
 constexpr int kDefaultAlignmentPadding = 63;
 
 struct Deleter {
@@ -62,6 +72,14 @@ struct OpData4Bit {
   uint8_t* prepacked_cache = nullptr;
   std::unique_ptr<uint8_t[], Deleter> prepacked_cache_buffer;
   size_t prepacked_cache_buffer_size = 0;
+  // Prepacked constant weights shared with the other interpreters of the
+  // process, used instead of `prepacked_cache` when set.
+  std::shared_ptr<const uint8_t> shared_prepacked_cache;
+
+  const uint8_t* prepacked_weights() const {
+    return shared_prepacked_cache ? shared_prepacked_cache.get()
+                                  : prepacked_cache;
+  }
 
   void AllocatePackedRegion(size_t required_size) {
 #ifdef TFLITE_MMAP_DISABLED
@@ -0,0 +1,216 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+// Benchmarks of the 4-bit fully connected kernels.
+//
+// Run with:
+//   bazel run -c opt \
+//     tensorflow/lite/kernels/internal:optimized_4bit_benchmark -- \
+//     --benchmark_filter=all
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"  // from @com_google_benchmark
+#include "tensorflow/lite/kernels/internal/optimized/cpu_check.h"
+#include "tensorflow/lite/kernels/internal/optimized/fully_connected_4bit.h"
+
+namespace tflite {
+namespace {
+
+// A hybrid fully connected layer with random 4-bit weights of shape
+// (output_depth, input_depth), applied to a batch of float inputs, laid out
+// the way the FullyConnected kernel does it.
+struct FullyConnected4Bit {
+  FullyConnected4Bit(int output_depth, int input_depth, int batch_size)
+      : output_depth(output_depth),
+        input_depth(input_depth),
+        batch_size(batch_size) {
+    for (int rows = optimized_4bit::GetMaxSupportedRows(); rows > 0;
+         rows /= 2) {
+      if (batch_size >= rows) {
+        rhs_width = rows;
+        break;
+      }
+    }
+    const int width = optimized_4bit::FilterWidth;
+    const int depth = optimized_4bit::FilterDepth;
+    lhs_layout_rows = (output_depth + (width - 1)) & ~(width - 1);
+    lhs_layout_cols = (input_depth + (depth - 1)) & ~(depth - 1);
+    rhs_layout_rows = (batch_size + (rhs_width - 1)) & ~(rhs_width - 1);
+
+    std::mt19937 random_engine(2024);
+    std::uniform_int_distribution<int32_t> int4_dist(-7, 7);
+    std::uniform_real_distribution<float> real_dist(-1.f, 1.f);
+    std::vector<int8_t> weights(output_depth * input_depth / 2);
+    for (int8_t& value : weights) {
+      value = static_cast<int8_t>((int4_dist(random_engine) << 4) |
+                                  (int4_dist(random_engine) & 15));
+    }
+    const int weight_size = lhs_layout_rows * lhs_layout_cols / 2;
+    packed_weights.AllocatePackedRegion(
+        optimized_4bit::kDefaultAlignmentPadding + weight_size);
+    optimized_4bit::api::Prepack(packed_weights.prepacked_cache,
+                                 weights.data(), lhs_layout_rows,
+                                 lhs_layout_cols, output_depth, input_depth,
+                                 width, depth);
+
+    input.resize(batch_size * input_depth);
+    for (float& value : input) {
+      value = real_dist(random_engine);
+    }
+    filter_scales.assign(lhs_layout_rows, 0.01f);
+    quantized_input.resize(rhs_layout_rows * lhs_layout_cols);
+    scaling_factors.resize(rhs_layout_rows);
+    input_offsets.resize(rhs_layout_rows);
+    accumulators.resize(rhs_layout_rows * lhs_layout_rows);
+    output.resize(batch_size * output_depth);
+  }
+
+  void QuantizeInput() {
+    optimized_4bit::api::BatchQuantizeFloats4Bit(
+        input.data(), batch_size, input_depth, quantized_input.data(),
+        scaling_factors.data(), rhs_width, optimized_4bit::FilterDepth,
+        input_offsets.data());
+  }
+
+  void Run() {
+    QuantizeInput();
+    optimized_4bit::api::AssignBiasAndComputeOffsets(
+        input_offsets.data(), scaling_factors.data(), filter_scales.data(),
+        /*bias_ptr=*/nullptr, output.data(), output_depth, batch_size);
+    optimized_4bit::api::RunAndUnpack(
+        rhs_width, packed_weights.prepacked_cache, quantized_input.data(),
+        accumulators.data(), output_depth, batch_size, lhs_layout_rows,
+        lhs_layout_cols, rhs_layout_rows, lhs_layout_cols, rhs_layout_rows,
+        lhs_layout_rows, output.data(), scaling_factors.data(),
+        filter_scales.data());
+  }
+
+  int output_depth;
+  int input_depth;
+  int batch_size;
+  int rhs_width = 1;
+  int lhs_layout_rows;
+  int lhs_layout_cols;
+  int rhs_layout_rows;
+  optimized_4bit::OpData4Bit packed_weights;
+  std::vector<float> input;
+  std::vector<float> filter_scales;
+  std::vector<int8_t> quantized_input;
+  std::vector<float> scaling_factors;
+  std::vector<int32_t> input_offsets;
+  std::vector<int32_t> accumulators;
+  std::vector<float> output;
+};
+
+void SetMultiplyAccumulates(benchmark::State& state,
+                            const FullyConnected4Bit& fc) {
+  state.SetItemsProcessed(state.iterations() * fc.output_depth *
+                          fc.input_depth * fc.batch_size);
+}
+
+// Shapes of the form (output_depth, input_depth, batch_size), similar to the
+// projections of small language models.
+void FullyConnectedShapes(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"output_depth", "input_depth", "batch"})
+      ->Args({256, 256, 1})
+      ->Args({2048, 2048, 1})
+      ->Args({2048, 2048, 4})
+      ->Args({4096, 4096, 1})
+      ->Args({4096, 4096, 2})
+      ->Args({4096, 4096, 8})
+      ->Args({11008, 4096, 1})
+      ->Args({4096, 11008, 1})
+      ->Args({4096, 4096, 32});
+}
+
+// The whole layer, with the kernels chosen for the CPU.
+void BM_FullyConnected4Bit(benchmark::State& state) {
+  FullyConnected4Bit fc(state.range(0), state.range(1), state.range(2));
+  for (auto _ : state) {
+    fc.Run();
+    benchmark::DoNotOptimize(fc.output.data());
+    benchmark::ClobberMemory();
+  }
+  SetMultiplyAccumulates(state, fc);
+}
+BENCHMARK(BM_FullyConnected4Bit)->Apply(FullyConnectedShapes);
+
+#ifdef FC_4BIT_AVX_KERNELS
+enum class X86Kernel { kSsse3, kAvx2, kAvx512Vnni };
+
+using RunKernelFn = void (*)(const uint8_t*, const int8_t*, int32_t*, int, int,
+                             int, int, int, int);
+
+template <int RowsRight>
+RunKernelFn GetX86Kernel(X86Kernel kernel) {
+  constexpr int kWidth = optimized_4bit::FilterWidth;
+  constexpr int kDepth = optimized_4bit::FilterDepth;
+  switch (kernel) {
+    case X86Kernel::kAvx512Vnni:
+      return optimized_4bit::SseRunKernelAvx512Vnni<kWidth, RowsRight, kDepth>;
+    case X86Kernel::kAvx2:
+      return optimized_4bit::SseRunKernelAvx2<kWidth, RowsRight, kDepth>;
+    case X86Kernel::kSsse3:
+      break;
+  }
+  return optimized_4bit::SseRunKernelSsse3<kWidth, RowsRight, kDepth>;
+}
+
+bool IsSupported(X86Kernel kernel) {
+  switch (kernel) {
+    case X86Kernel::kAvx512Vnni:
+      return DetectX86Avx512Vnni();
+    case X86Kernel::kAvx2:
+      return DetectX86Avx2();
+    case X86Kernel::kSsse3:
+      break;
+  }
+  return true;
+}
+
+// Only the integer matrix multiplication, with each of the x86 kernels.
+void BM_X86RunKernel4Bit(benchmark::State& state, X86Kernel kernel) {
+  if (!IsSupported(kernel)) {
+    state.SkipWithError("Kernel not supported by the CPU.");
+    return;
+  }
+  FullyConnected4Bit fc(state.range(0), state.range(1), state.range(2));
+  fc.QuantizeInput();
+  RunKernelFn run_kernel = fc.rhs_width == 4   ? GetX86Kernel<4>(kernel)
+                           : fc.rhs_width == 2 ? GetX86Kernel<2>(kernel)
+                                               : GetX86Kernel<1>(kernel);
+  for (auto _ : state) {
+    run_kernel(fc.packed_weights.prepacked_cache, fc.quantized_input.data(),
+               fc.accumulators.data(), fc.lhs_layout_rows, fc.lhs_layout_cols,
+               fc.rhs_layout_rows, fc.lhs_layout_cols, fc.rhs_layout_rows,
+               fc.lhs_layout_rows);
+    benchmark::DoNotOptimize(fc.accumulators.data());
+    benchmark::ClobberMemory();
+  }
+  SetMultiplyAccumulates(state, fc);
+}
+BENCHMARK_CAPTURE(BM_X86RunKernel4Bit, ssse3, X86Kernel::kSsse3)
+    ->Apply(FullyConnectedShapes);
+BENCHMARK_CAPTURE(BM_X86RunKernel4Bit, avx2, X86Kernel::kAvx2)
+    ->Apply(FullyConnectedShapes);
+BENCHMARK_CAPTURE(BM_X86RunKernel4Bit, avx512_vnni, X86Kernel::kAvx512Vnni)
+    ->Apply(FullyConnectedShapes);
+#endif  // FC_4BIT_AVX_KERNELS
+
+}  // namespace
+}  // namespace tflite
+
+BENCHMARK_MAIN();
@@ -20,6 +20,7 @@ limitations under the License.
 #include <vector>
 
 #include <gtest/gtest.h>
+#include "tensorflow/lite/kernels/internal/optimized/cpu_check.h"
 #include "tensorflow/lite/kernels/internal/optimized/fully_connected_4bit.h"
 
 namespace tflite {
@@ -502,7 +503,8 @@ TEST_P(RunKernelTests, RunKernelTests) {
 
   index = 0;
   switch (rhs_width) {
-#if defined(FC_4BIT_NEON) && defined(__aarch64__)
+#if (defined(FC_4BIT_NEON) && defined(__aarch64__)) || \
+    (defined(FC_4BIT_SSE) && defined(__SSSE3__))
     case 4:
       optimized_4bit::RunKernel<optimized_4bit::FilterWidth, 4,
                                 optimized_4bit::FilterDepth>(
@@ -543,7 +545,8 @@ INSTANTIATE_TEST_SUITE_P(
           std::make_tuple(1, 8, 1, 64), std::make_tuple(1, 16, 1, 64),
           std::make_tuple(1, 4, 5, 64), std::make_tuple(1, 8, 9, 64),
           std::make_tuple(1, 16, 17, 64),
-#if defined(FC_4BIT_NEON) && defined(__aarch64__)
+#if (defined(FC_4BIT_NEON) && defined(__aarch64__)) || \
+    (defined(FC_4BIT_SSE) && defined(__SSSE3__))
           std::make_tuple(2, 8, 2, 32), std::make_tuple(2, 16, 2, 32),
           std::make_tuple(2, 4, 4, 64), std::make_tuple(2, 8, 4, 64),
           std::make_tuple(2, 16, 4, 64), std::make_tuple(2, 4, 4, 64),
@@ -555,5 +558,84 @@ INSTANTIATE_TEST_SUITE_P(
           std::make_tuple(4, 16, 32, 64),
 #endif
     }));
+
+#ifdef FC_4BIT_AVX_KERNELS
+class X86RunKernelTests
+    : public ::testing::TestWithParam<::testing::tuple<int, int, int, int>> {};
+
+// The AVX kernels must give the same results as the SSSE3 one, which
+// RunKernelTests checks on CPUs without AVX2.
+TEST_P(X86RunKernelTests, AvxKernelsMatchSsse3) {
+  auto params = GetParam();
+  const int rhs_width = std::get<0>(params);
+  const int lhs_layout_rows = std::get<1>(params);
+  const int rhs_layout_rows = std::get<2>(params);
+  const int layout_cols = std::get<3>(params);
+  const bool has_avx2 = DetectX86Avx2();
+  const bool has_avx512_vnni = DetectX86Avx512Vnni();
+  if (!has_avx2 && !has_avx512_vnni) {
+    GTEST_SKIP() << "The CPU supports neither AVX2 nor AVX-512 VNNI.";
+  }
+
+  std::uniform_int_distribution<int32_t> byte_dist(-128, 127);
+  std::vector<uint8_t> lhs(lhs_layout_rows * layout_cols / 2);
+  for (uint8_t& value : lhs) {
+    value = static_cast<uint8_t>(byte_dist(random_engine));
+  }
+  std::vector<int8_t> rhs(rhs_layout_rows * layout_cols);
+  for (int8_t& value : rhs) {
+    value = static_cast<int8_t>(byte_dist(random_engine));
+  }
+  using Kernel = void (*)(const uint8_t*, const int8_t*, int32_t*, int, int,
+                          int, int, int, int);
+  const auto run = [&](Kernel kernel) {
+    std::vector<int32_t> dst(lhs_layout_rows * rhs_layout_rows, 0);
+    kernel(lhs.data(), rhs.data(), dst.data(), lhs_layout_rows, layout_cols,
+           rhs_layout_rows, layout_cols, rhs_layout_rows, lhs_layout_rows);
+    return dst;
+  };
+  constexpr int kWidth = optimized_4bit::FilterWidth;
+  constexpr int kDepth = optimized_4bit::FilterDepth;
+  Kernel ssse3 = nullptr, avx2 = nullptr, avx512_vnni = nullptr;
+  switch (rhs_width) {
+    case 4:
+      ssse3 = optimized_4bit::SseRunKernelSsse3<kWidth, 4, kDepth>;
+      avx2 = optimized_4bit::SseRunKernelAvx2<kWidth, 4, kDepth>;
+      avx512_vnni = optimized_4bit::SseRunKernelAvx512Vnni<kWidth, 4, kDepth>;
+      break;
+    case 2:
+      ssse3 = optimized_4bit::SseRunKernelSsse3<kWidth, 2, kDepth>;
+      avx2 = optimized_4bit::SseRunKernelAvx2<kWidth, 2, kDepth>;
+      avx512_vnni = optimized_4bit::SseRunKernelAvx512Vnni<kWidth, 2, kDepth>;
+      break;
+    default:
+      ssse3 = optimized_4bit::SseRunKernelSsse3<kWidth, 1, kDepth>;
+      avx2 = optimized_4bit::SseRunKernelAvx2<kWidth, 1, kDepth>;
+      avx512_vnni = optimized_4bit::SseRunKernelAvx512Vnni<kWidth, 1, kDepth>;
+      break;
+  }
+  const std::vector<int32_t> expected = run(ssse3);
+  if (has_avx2) {
+    EXPECT_EQ(run(avx2), expected);
+  }
+  if (has_avx512_vnni) {
+    EXPECT_EQ(run(avx512_vnni), expected);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    X86RunKernelTests, X86RunKernelTests,
+    ::testing::ValuesIn({
+        std::make_tuple(1, 4, 1, 32),
+        std::make_tuple(1, 16, 17, 64),
+        std::make_tuple(1, 64, 3, 1024),
+        std::make_tuple(2, 8, 2, 32),
+        std::make_tuple(2, 16, 16, 256),
+        std::make_tuple(4, 4, 4, 32),
+        std::make_tuple(4, 16, 32, 64),
+        std::make_tuple(4, 32, 8, 1024),
+    }));
+#endif  // FC_4BIT_AVX_KERNELS
+
 }  // namespace
 }  // namespace tflite
@@ -34,6 +34,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/cpu_backend_gemm.h"
 #include "tensorflow/lite/kernels/cpu_backend_gemm_params.h"
 #include "tensorflow/lite/kernels/internal/compatibility.h"
+#include "tensorflow/lite/kernels/internal/optimized/cpu_check.h"
 
 namespace tflite {
 namespace tensor_utils {
@@ -380,6 +381,46 @@ void SseMatrixBatchVectorMultiplyAccumulateImpl(
 #endif  // ifdef __AVX2__
 }
 
+namespace {
+
+// Runs the fastest of the kernels above for the CPU.
+void MatrixBatchVectorMultiplyAccumulateForCpu(
+    const int8_t* __restrict__ matrix, const int m_rows, const int m_cols,
+    const int8_t* __restrict__ vectors,
+    const float* __restrict__ scaling_factors, int n_batch,
+    float* __restrict__ result, const float* per_channel_scale,
+    const int32_t* input_offset, const int32_t* row_sums) {
+#if defined(TFLITE_X86_AVX512_VNNI_KERNELS) || \
+    defined(TFLITE_X86_AVX_VNNI_KERNELS)
+  static const CpuFlags cpu_flags = [] {
+    CpuFlags flags;
+    GetCpuFlags(&flags);
+    return flags;
+  }();
+#endif
+#ifdef TFLITE_X86_AVX512_VNNI_KERNELS
+  if (cpu_flags.avx512_vnni) {
+    Avx512VnniMatrixBatchVectorMultiplyAccumulateImpl(
+        matrix, m_rows, m_cols, vectors, scaling_factors, n_batch, result,
+        per_channel_scale, input_offset, row_sums);
+    return;
+  }
+#endif
+#ifdef TFLITE_X86_AVX_VNNI_KERNELS
+  if (cpu_flags.avx_vnni) {
+    AvxVnniMatrixBatchVectorMultiplyAccumulateImpl(
+        matrix, m_rows, m_cols, vectors, scaling_factors, n_batch, result,
+        per_channel_scale, input_offset, row_sums);
+    return;
+  }
+#endif
+  SseMatrixBatchVectorMultiplyAccumulateImpl(
+      matrix, m_rows, m_cols, vectors, scaling_factors, n_batch, result,
+      per_channel_scale, input_offset, row_sums);
+}
+
+}  // namespace
+
 void SseCpuBackendGemm(const int8_t* input, const int32_t* bias,
                        const int8_t* input_to_gate_weights, int32_t n_batch,
                        int32_t n_input, int32_t n_output, int32_t output_zp,
@@ -417,7 +458,7 @@ void SseMatrixBatchVectorMultiplyAccumulate(
     const int8_t* __restrict__ vectors,
     const float* __restrict__ scaling_factors, int n_batch,
     float* __restrict__ result) {
-  SseMatrixBatchVectorMultiplyAccumulateImpl(
+  MatrixBatchVectorMultiplyAccumulateForCpu(
       matrix, m_rows, m_cols, vectors, scaling_factors, n_batch, result,
       /*per_channel_scale=*/nullptr, /*input_offset=*/nullptr,
       /*row_sums=*/nullptr);
@@ -468,7 +509,7 @@ void SseMatrixBatchVectorMultiplyAccumulate(
     return;
   }
 
-  SseMatrixBatchVectorMultiplyAccumulateImpl(
+  MatrixBatchVectorMultiplyAccumulateForCpu(
       matrix, m_rows, m_cols, vectors, scaling_factors, n_batch, result,
       /*per_channel_scale=*/nullptr, /*input_offset=*/nullptr,
       /*row_sums=*/nullptr);
@@ -487,7 +528,7 @@ void SseMatrixBatchVectorMultiplyAccumulate(
       *compute_row_sums = false;
     }
   }
-  SseMatrixBatchVectorMultiplyAccumulateImpl(
+  MatrixBatchVectorMultiplyAccumulateForCpu(
       matrix, m_rows, m_cols, vectors, scaling_factors, n_batch, result,
       per_channel_scale, input_offset, row_sums);
 }
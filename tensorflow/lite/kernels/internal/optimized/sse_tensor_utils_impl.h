@@ -79,6 +79,53 @@ void SseSparseMatrixBatchVectorMultiplyAccumulate(
 void SseReductionSumVector(const int8_t* input_vector, int32_t* output_vector,
                            const int output_size, const int reduction_size);
 
+// Matrix multiplication for quantized values using asymmetric quantization,
+// with the SSE (or AVX2, if enabled at compile time) kernel regardless of the
+// VNNI support of the CPU.
+void SseMatrixBatchVectorMultiplyAccumulateImpl(
+    const int8_t* __restrict__ matrix, const int m_rows, const int m_cols,
+    const int8_t* __restrict__ vectors,
+    const float* __restrict__ scaling_factors, int n_batch,
+    float* __restrict__ result, const float* per_channel_scale,
+    const int32_t* input_offset, const int32_t* row_sums);
+
+// The VNNI kernels are built with function target attributes whenever the
+// compiler supports them, and selected at runtime on CPUs that have the
+// instructions (see `CpuFlags`).
+#if defined(__x86_64__) && !defined(TFLITE_DISABLE_X86_VNNI_KERNELS)
+#if (defined(__clang__) && __clang_major__ >= 6) || \
+    (!defined(__clang__) && defined(__GNUC__) && __GNUC__ >= 8)
+#define TFLITE_X86_AVX512_VNNI_KERNELS
+#endif
+#if (defined(__clang__) && !defined(__apple_build_version__) && \
+     __clang_major__ >= 12) ||                                  \
+    (!defined(__clang__) && defined(__GNUC__) && __GNUC__ >= 11)
+#define TFLITE_X86_AVX_VNNI_KERNELS
+#endif
+#endif
+
+#ifdef TFLITE_X86_AVX512_VNNI_KERNELS
+// Same as `SseMatrixBatchVectorMultiplyAccumulateImpl` with AVX-512 VNNI.
+// Must only be called if `DetectX86Avx512Vnni()` returns true.
+void Avx512VnniMatrixBatchVectorMultiplyAccumulateImpl(
+    const int8_t* __restrict__ matrix, const int m_rows, const int m_cols,
+    const int8_t* __restrict__ vectors,
+    const float* __restrict__ scaling_factors, int n_batch,
+    float* __restrict__ result, const float* per_channel_scale,
+    const int32_t* input_offset, const int32_t* row_sums);
+#endif  // TFLITE_X86_AVX512_VNNI_KERNELS
+
+#ifdef TFLITE_X86_AVX_VNNI_KERNELS
+// Same as `SseMatrixBatchVectorMultiplyAccumulateImpl` with AVX-VNNI.
+// Must only be called if `DetectX86AvxVnni()` returns true.
+void AvxVnniMatrixBatchVectorMultiplyAccumulateImpl(
+    const int8_t* __restrict__ matrix, const int m_rows, const int m_cols,
+    const int8_t* __restrict__ vectors,
+    const float* __restrict__ scaling_factors, int n_batch,
+    float* __restrict__ result, const float* per_channel_scale,
+    const int32_t* input_offset, const int32_t* row_sums);
+#endif  // TFLITE_X86_AVX_VNNI_KERNELS
+
 #endif  // __SSSE3__
 
 }  // namespace tensor_utils
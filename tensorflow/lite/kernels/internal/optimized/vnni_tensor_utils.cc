@@ -0,0 +1,180 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/kernels/internal/optimized/sse_tensor_utils_impl.h"
+
+#if defined(TFLITE_X86_AVX512_VNNI_KERNELS) || \
+    defined(TFLITE_X86_AVX_VNNI_KERNELS)
+
+#include <immintrin.h>
+
+#include <cstdint>
+
+// The kernels below are compiled for their instruction sets with function
+// attributes rather than -m flags, so that a binary built for a baseline CPU
+// can still use them on CPUs that support them (see cpu_check.h).
+
+namespace tflite {
+namespace tensor_utils {
+
+#ifdef TFLITE_X86_AVX512_VNNI_KERNELS
+
+namespace {
+
+#define TFLITE_AVX512_VNNI_TARGET \
+  __attribute__((target("avx512f,avx512bw,avx512vnni")))
+
+// Accumulates the dot products of the 16 groups of four int8 values in `a`
+// and `b` into the 16 int32 values of `acc`.
+TFLITE_AVX512_VNNI_TARGET
+inline __m512i DotProdInt8x4x16(__m512i acc, __m512i a_8x64, __m512i b_8x64) {
+  // VPDPBUSD multiplies unsigned bytes of its first operand with signed bytes
+  // of its second, so transfer the sign of 'a' to 'b'.
+  const __mmask64 a_negative = _mm512_movepi8_mask(a_8x64);
+  b_8x64 = _mm512_mask_sub_epi8(b_8x64, a_negative, _mm512_setzero_si512(),
+                                b_8x64);
+  a_8x64 = _mm512_abs_epi8(a_8x64);
+  return _mm512_dpbusd_epi32(acc, a_8x64, b_8x64);
+}
+
+}  // namespace
+
+TFLITE_AVX512_VNNI_TARGET
+void Avx512VnniMatrixBatchVectorMultiplyAccumulateImpl(
+    const int8_t* __restrict__ matrix, const int m_rows, const int m_cols,
+    const int8_t* __restrict__ vectors,
+    const float* __restrict__ scaling_factors, int n_batch,
+    float* __restrict__ result, const float* per_channel_scale,
+    const int32_t* input_offset, const int32_t* row_sums) {
+  // Columns past the last full block of 64 are loaded with a mask, which
+  // doesn't touch the masked out bytes.
+  const int main_cols = m_cols & ~63;
+  const __mmask64 tail_mask =
+      m_cols == main_cols ? 0 : (~0ull >> (64 - (m_cols - main_cols)));
+  for (std::intptr_t batch = 0; batch < n_batch; ++batch) {
+    const float batch_scaling_factor = scaling_factors[batch];
+    const int32_t batch_offset = input_offset ? input_offset[batch] : 0;
+    for (std::intptr_t row = 0; row < m_rows; ++row) {
+      const int8_t* __restrict__ row_ptr = matrix + row * m_cols;
+      const float row_scale =
+          per_channel_scale ? per_channel_scale[row] * batch_scaling_factor
+                            : batch_scaling_factor;
+      const int32_t row_offset =
+          row_sums && batch_offset ? batch_offset * row_sums[row] : 0;
+      __m512i dotprod_32x16 = _mm512_setzero_si512();
+      std::intptr_t col = 0;
+      for (; col < main_cols; col += 64) {
+        const __m512i vec_8x64 = _mm512_loadu_si512(vectors + col);
+        const __m512i row_8x64 = _mm512_loadu_si512(row_ptr + col);
+        dotprod_32x16 = DotProdInt8x4x16(dotprod_32x16, vec_8x64, row_8x64);
+      }
+      if (tail_mask) {
+        const __m512i vec_8x64 =
+            _mm512_maskz_loadu_epi8(tail_mask, vectors + col);
+        const __m512i row_8x64 =
+            _mm512_maskz_loadu_epi8(tail_mask, row_ptr + col);
+        dotprod_32x16 = DotProdInt8x4x16(dotprod_32x16, vec_8x64, row_8x64);
+      }
+      int32_t sum = _mm512_reduce_add_epi32(dotprod_32x16);
+      if (row_offset) {
+        sum -= row_offset;
+      }
+      *result += sum * row_scale;
+      ++result;
+    }  // for row
+    vectors += m_cols;
+  }  // for batch
+}
+
+#undef TFLITE_AVX512_VNNI_TARGET
+
+#endif  // TFLITE_X86_AVX512_VNNI_KERNELS
+
+#ifdef TFLITE_X86_AVX_VNNI_KERNELS
+
+namespace {
+
+#define TFLITE_AVX_VNNI_TARGET __attribute__((target("avx2,avxvnni")))
+
+// Accumulates the dot products of the 8 groups of four int8 values in `a`
+// and `b` into the 8 int32 values of `acc`.
+TFLITE_AVX_VNNI_TARGET
+inline __m256i DotProdInt8x4x8(__m256i acc, __m256i a_8x32, __m256i b_8x32) {
+  // Transfer the sign of 'a' to 'b', as VPDPBUSD treats 'a' as unsigned.
+  b_8x32 = _mm256_sign_epi8(b_8x32, a_8x32);
+  a_8x32 = _mm256_abs_epi8(a_8x32);
+  return _mm256_dpbusd_avx_epi32(acc, a_8x32, b_8x32);
+}
+
+}  // namespace
+
+TFLITE_AVX_VNNI_TARGET
+void AvxVnniMatrixBatchVectorMultiplyAccumulateImpl(
+    const int8_t* __restrict__ matrix, const int m_rows, const int m_cols,
+    const int8_t* __restrict__ vectors,
+    const float* __restrict__ scaling_factors, int n_batch,
+    float* __restrict__ result, const float* per_channel_scale,
+    const int32_t* input_offset, const int32_t* row_sums) {
+  const int main_cols = m_cols & ~31;
+  for (std::intptr_t batch = 0; batch < n_batch; ++batch) {
+    const float batch_scaling_factor = scaling_factors[batch];
+    const int32_t batch_offset = input_offset ? input_offset[batch] : 0;
+    for (std::intptr_t row = 0; row < m_rows; ++row) {
+      const int8_t* __restrict__ row_ptr = matrix + row * m_cols;
+      const float row_scale =
+          per_channel_scale ? per_channel_scale[row] * batch_scaling_factor
+                            : batch_scaling_factor;
+      const int32_t row_offset =
+          row_sums && batch_offset ? batch_offset * row_sums[row] : 0;
+      __m256i dotprod_32x8 = _mm256_setzero_si256();
+      std::intptr_t col = 0;
+      for (; col < main_cols; col += 32) {
+        const __m256i vec_8x32 =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(vectors + col));
+        const __m256i row_8x32 =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row_ptr + col));
+        dotprod_32x8 = DotProdInt8x4x8(dotprod_32x8, vec_8x32, row_8x32);
+      }
+      // Horizontally add the 8 intermediate sums.
+      __m128i dotprod_32x4 =
+          _mm_add_epi32(_mm256_castsi256_si128(dotprod_32x8),
+                        _mm256_extracti128_si256(dotprod_32x8, 1));
+      dotprod_32x4 = _mm_add_epi32(
+          dotprod_32x4, _mm_unpackhi_epi64(dotprod_32x4, dotprod_32x4));
+      const __m128i shuffled_32x4 =
+          _mm_shuffle_epi32(dotprod_32x4, _MM_SHUFFLE(2, 3, 0, 1));
+      dotprod_32x4 = _mm_add_epi32(dotprod_32x4, shuffled_32x4);
+      int32_t sum = _mm_cvtsi128_si32(dotprod_32x4);
+      // Postamble loop for <32x remaining 8-bit inputs.
+      for (; col < m_cols; ++col) {
+        sum += row_ptr[col] * vectors[col];
+      }
+      if (row_offset) {
+        sum -= row_offset;
+      }
+      *result += sum * row_scale;
+      ++result;
+    }  // for row
+    vectors += m_cols;
+  }  // for batch
+}
+
+#undef TFLITE_AVX_VNNI_TARGET
+
+#endif  // TFLITE_X86_AVX_VNNI_KERNELS
+
+}  // namespace tensor_utils
+}  // namespace tflite
+
+#endif  // TFLITE_X86_AVX512_VNNI_KERNELS || TFLITE_X86_AVX_VNNI_KERNELS
@@ -25,6 +25,11 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/quantization_util.h"
 #include "tensorflow/lite/kernels/test_util.h"
 
+#ifdef __SSSE3__
+#include "tensorflow/lite/kernels/internal/optimized/cpu_check.h"
+#include "tensorflow/lite/kernels/internal/optimized/sse_tensor_utils_impl.h"
+#endif  // __SSSE3__
+
 #ifdef DOTPROD_BENCHMARKS
 #include "testing/base/public/benchmark.h"
 #endif  // DOTPROD_BENCHMARKS
@@ -1349,6 +1354,55 @@ TEST(uKernels, DotprodSparseMatrixBatchVectorMultiplyAccumulate) {
               testing::ElementsAre(8764, 5196, 7204, 11148));
 }
 
+#if defined(TFLITE_X86_AVX512_VNNI_KERNELS) || \
+    defined(TFLITE_X86_AVX_VNNI_KERNELS)
+TEST(uKernels, X86VnniMatrixBatchVectorMultiplyAccumulateTest) {
+  CpuFlags cpu_flags;
+  GetCpuFlags(&cpu_flags);
+  if (!cpu_flags.avx512_vnni && !cpu_flags.avx_vnni) {
+    GTEST_SKIP() << "The CPU supports neither AVX-512 VNNI nor AVX-VNNI.";
+  }
+  // Exercises the main loops and the postambles of the kernels, which must
+  // match the SSE kernel exactly.
+  for (int cols : {4, 31, 32, 64, 100, 512, 1000}) {
+    const int rows = 5, batch = 3;
+    MatrixVectorData data =
+        SetupMatrixVectorData(rows, cols, batch, /*negative=*/true,
+                              /*is_per_channel=*/true, /*init_to_one=*/true);
+    std::vector<int32_t> row_sums(rows);
+    ReductionSumVector(data.matrix.data(), row_sums.data(), rows, cols);
+    std::vector<float> expected = data.results;
+    SseMatrixBatchVectorMultiplyAccumulateImpl(
+        data.matrix.data(), rows, cols, data.vectors.data(),
+        data.scale_factors.data(), batch, expected.data(),
+        data.per_channel_scales.data(), data.input_offsets.data(),
+        row_sums.data());
+#ifdef TFLITE_X86_AVX512_VNNI_KERNELS
+    if (cpu_flags.avx512_vnni) {
+      std::vector<float> results = data.results;
+      Avx512VnniMatrixBatchVectorMultiplyAccumulateImpl(
+          data.matrix.data(), rows, cols, data.vectors.data(),
+          data.scale_factors.data(), batch, results.data(),
+          data.per_channel_scales.data(), data.input_offsets.data(),
+          row_sums.data());
+      EXPECT_THAT(results, testing::ElementsAreArray(expected)) << cols;
+    }
+#endif  // TFLITE_X86_AVX512_VNNI_KERNELS
+#ifdef TFLITE_X86_AVX_VNNI_KERNELS
+    if (cpu_flags.avx_vnni) {
+      std::vector<float> results = data.results;
+      AvxVnniMatrixBatchVectorMultiplyAccumulateImpl(
+          data.matrix.data(), rows, cols, data.vectors.data(),
+          data.scale_factors.data(), batch, results.data(),
+          data.per_channel_scales.data(), data.input_offsets.data(),
+          row_sums.data());
+      EXPECT_THAT(results, testing::ElementsAreArray(expected)) << cols;
+    }
+#endif  // TFLITE_X86_AVX_VNNI_KERNELS
+  }
+}
+#endif  // TFLITE_X86_AVX512_VNNI_KERNELS || TFLITE_X86_AVX_VNNI_KERNELS
+
 #ifdef __ANDROID__
 TEST(uKernels, MatrixBatchVectorMultiplyAccumulateSymmetricQuantizedTest) {
   // Note we use 29 columns as this exercises all the neon kernel: the
@@ -2346,4 +2400,69 @@ BENCHMARK(BM_DotprodFloatMultiply)
     ->Args({2048, 2048, 5})
     ->Args({2048, 2048, 8});
 
+#if defined(TFLITE_X86_AVX512_VNNI_KERNELS) || \
+    defined(TFLITE_X86_AVX_VNNI_KERNELS)
+// Compares the x86 hybrid kernels that `MatrixBatchVectorMultiplyAccumulate`
+// chooses between at runtime.
+using HybridKernel = void (*)(const int8_t*, int, int, const int8_t*,
+                              const float*, int, float*, const float*,
+                              const int32_t*, const int32_t*);
+
+void BM_DotprodX86HybridMultiply(benchmark::State& state, HybridKernel kernel,
+                                 bool supported) {
+  if (!supported) {
+    state.SkipWithError("Kernel not supported by the CPU.");
+    return;
+  }
+  const int rows = state.range(0);
+  const int cols = state.range(1);
+  const int batch = state.range(2);
+  tflite::tensor_utils::MatrixVectorData data =
+      tflite::tensor_utils::SetupMatrixVectorData(rows, cols, batch,
+                                                  /*negative=*/true);
+  for (auto _ : state) {
+    kernel(data.matrix.data(), data.rows, data.cols, data.vectors.data(),
+           data.scale_factors.data(), data.batch, &data.results[0],
+           /*per_channel_scale=*/nullptr, /*input_offset=*/nullptr,
+           /*row_sums=*/nullptr);
+    testing::DoNotOptimize(data.results[2]);
+  }
+}
+
+bool X86CpuHas(bool tflite::CpuFlags::*flag) {
+  tflite::CpuFlags cpu_flags;
+  tflite::GetCpuFlags(&cpu_flags);
+  return cpu_flags.*flag;
+}
+
+void X86HybridMultiplyArgs(benchmark::internal::Benchmark* b) {
+  b->Args({16, 16, 1})
+      ->Args({32, 32, 4})
+      ->Args({64, 256, 1})
+      ->Args({64, 256, 4})
+      ->Args({512, 1024, 1})
+      ->Args({512, 1024, 4})
+      ->Args({2048, 2048, 1})
+      ->Args({2048, 2048, 8});
+}
+
+BENCHMARK_CAPTURE(
+    BM_DotprodX86HybridMultiply, sse,
+    &tflite::tensor_utils::SseMatrixBatchVectorMultiplyAccumulateImpl, true)
+    ->Apply(X86HybridMultiplyArgs);
+#ifdef TFLITE_X86_AVX512_VNNI_KERNELS
+BENCHMARK_CAPTURE(
+    BM_DotprodX86HybridMultiply, avx512_vnni,
+    &tflite::tensor_utils::Avx512VnniMatrixBatchVectorMultiplyAccumulateImpl,
+    X86CpuHas(&tflite::CpuFlags::avx512_vnni))
+    ->Apply(X86HybridMultiplyArgs);
+#endif  // TFLITE_X86_AVX512_VNNI_KERNELS
+#ifdef TFLITE_X86_AVX_VNNI_KERNELS
+BENCHMARK_CAPTURE(
+    BM_DotprodX86HybridMultiply, avx_vnni,
+    &tflite::tensor_utils::AvxVnniMatrixBatchVectorMultiplyAccumulateImpl,
+    X86CpuHas(&tflite::CpuFlags::avx_vnni))
+    ->Apply(X86HybridMultiplyArgs);
+#endif  // TFLITE_X86_AVX_VNNI_KERNELS
+#endif  // TFLITE_X86_AVX512_VNNI_KERNELS || TFLITE_X86_AVX_VNNI_KERNELS
 #endif  // DOTPROD_BENCHMARKS
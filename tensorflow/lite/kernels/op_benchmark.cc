@@ -0,0 +1,643 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+// Latency benchmarks of the builtin kernels, one op at a time, over grids of
+// shapes, types and thread counts. Unlike benchmark_tflite_model, which times
+// whole models, these catch regressions in individual kernels.
+//
+// Each benchmark is named <op>/<type>/<arguments>, with named arguments, and
+// reports the number of multiply-accumulates (for ops that do matrix
+// products) or output elements (for the others) per second as
+// items_per_second. Default delegates are not applied.
+//
+// Run with:
+//   bazel run -c opt tensorflow/lite/kernels:op_benchmark -- \
+//     --benchmark_out=ops.json --benchmark_out_format=json
+//
+// and compare two runs with compare.py from the benchmark library:
+//   compare.py benchmarks before.json after.json
+//
+// Builtin ops without benchmarks yet, by kind:
+//   Convolutions and matrix products: TRANSPOSE_CONV, CONV_3D,
+//     CONV_3D_TRANSPOSE.
+//   Recurrent: LSTM, UNIDIRECTIONAL_SEQUENCE_LSTM, BIDIRECTIONAL_SEQUENCE_LSTM,
+//     RNN, UNIDIRECTIONAL_SEQUENCE_RNN, BIDIRECTIONAL_SEQUENCE_RNN, SVDF.
+//   Elementwise: FLOOR_DIV, FLOOR_MOD, POW, ATAN2, PRELU, LEAKY_RELU, ELU,
+//     GELU, RELU_N1_TO_1, RELU_0_TO_1, NEG, SIN, COS, LOG, SQUARE, FLOOR,
+//     CEIL, ROUND, SIGN, CAST, QUANTIZE, DEQUANTIZE, FAKE_QUANT, comparisons,
+//     logical and bitwise ops, SELECT, SELECT_V2, ADD_N.
+//   Reductions and normalizations: SUM, REDUCE_PROD, REDUCE_MAX, REDUCE_MIN,
+//     REDUCE_ANY, REDUCE_ALL, ARG_MAX, ARG_MIN, CUMSUM, LOG_SOFTMAX,
+//     L2_NORMALIZATION, LOCAL_RESPONSE_NORMALIZATION, L2_POOL_2D,
+//     REDUCE_WINDOW.
+//   Data movement: RESHAPE, SQUEEZE, EXPAND_DIMS, PAD, PADV2, MIRROR_PAD,
+//     SLICE, STRIDED_SLICE, SPLIT, SPLIT_V, PACK, UNPACK, TILE, BROADCAST_TO,
+//     REVERSE_V2, GATHER, GATHER_ND, SCATTER_ND, DEPTH_TO_SPACE,
+//     SPACE_TO_DEPTH, BATCH_TO_SPACE_ND, SPACE_TO_BATCH_ND, RESIZE_BILINEAR,
+//     RESIZE_NEAREST_NEIGHBOR, DYNAMIC_UPDATE_SLICE, ONE_HOT.
+//   Others: embedding and hashtable lookups, segment ops, TOPK_V2, UNIQUE,
+//     NON_MAX_SUPPRESSION_V4/V5, RFFT2D, random ops, control flow (IF,
+//     WHILE, CALL_ONCE), resource variables and the STABLEHLO_* ops.
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"  // from @com_google_benchmark
+#include "flatbuffers/flatbuffers.h"  // from @flatbuffers
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/kernels/test_util.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+namespace {
+
+// Scale of all int8 tensors, with a zero point of 0, so that every quantized
+// kernel accepts them.
+constexpr float kInt8Scale = 1.0f / 64;
+
+int NumElements(const std::vector<int>& shape) {
+  int num_elements = 1;
+  for (int dim : shape) num_elements *= dim;
+  return num_elements;
+}
+
+TensorData Tensor(TensorType type, const std::vector<int>& shape) {
+  if (type == TensorType_INT8) {
+    return TensorData(type, shape, /*min=*/0, /*max=*/0, kInt8Scale,
+                      /*zero_point=*/0);
+  }
+  return TensorData(type, shape);
+}
+
+// Bias of an op whose input and weights are both `Tensor(type, ...)`.
+TensorData BiasTensor(TensorType type, const std::vector<int>& shape) {
+  if (type == TensorType_INT8) {
+    return TensorData(TensorType_INT32, shape, /*min=*/0, /*max=*/0,
+                      kInt8Scale * kInt8Scale, /*zero_point=*/0);
+  }
+  return TensorData(type, shape);
+}
+
+// Int8 output with fixed quantization parameters, as required by some ops.
+TensorData Output(TensorType type, const std::vector<int>& shape,
+                  float int8_scale, int32_t int8_zero_point) {
+  if (type == TensorType_INT8) {
+    return TensorData(type, shape, /*min=*/0, /*max=*/0, int8_scale,
+                      int8_zero_point);
+  }
+  return TensorData(type, shape);
+}
+
+// A model with a single builtin op, whose inputs are filled with random
+// values.
+class OpBenchmarkModel : public SingleOpModel {
+ public:
+  using OptionsFn =
+      std::function<flatbuffers::Offset<void>(flatbuffers::FlatBufferBuilder&)>;
+
+  OpBenchmarkModel() { SetBypassDefaultDelegates(); }
+
+  void AddRandomInput(const TensorData& t) {
+    random_inputs_.push_back(AddInput(t));
+  }
+
+  void AddRandomConstInput(const TensorData& t) {
+    const int num_elements = NumElements(t.shape);
+    switch (t.type) {
+      case TensorType_INT8:
+        AddConstInput(t, RandomValues<int8_t>(num_elements));
+        break;
+      case TensorType_INT32:
+        AddConstInput(t, RandomValues<int32_t>(num_elements));
+        break;
+      default:
+        AddConstInput(t, RandomValues<float>(num_elements));
+        break;
+    }
+  }
+
+  void SetOp(BuiltinOperator op, BuiltinOptions options_type,
+             const OptionsFn& options) {
+    SetBuiltinOp(op, options_type, options(builder_));
+  }
+
+  void Build(int num_threads) {
+    BuildInterpreter(/*input_shapes=*/{}, num_threads,
+                     /*allow_fp32_relax_to_fp16=*/false,
+                     /*apply_delegate=*/false);
+    for (int input : random_inputs_) {
+      const int num_elements = GetTensorSize(input);
+      switch (interpreter_->tensor(input)->type) {
+        case kTfLiteInt8:
+          PopulateTensor(input, RandomValues<int8_t>(num_elements));
+          break;
+        case kTfLiteInt32:
+          PopulateTensor(input, RandomValues<int32_t>(num_elements));
+          break;
+        default:
+          PopulateTensor(input, RandomValues<float>(num_elements));
+          break;
+      }
+    }
+  }
+
+ private:
+  template <typename T>
+  std::vector<T> RandomValues(int num_elements) {
+    std::vector<T> values(num_elements);
+    if constexpr (std::is_floating_point_v<T>) {
+      std::uniform_real_distribution<float> dist(-1.f, 1.f);
+      for (T& value : values) value = dist(random_engine_);
+    } else {
+      std::uniform_int_distribution<int32_t> dist(-127, 127);
+      for (T& value : values) value = dist(random_engine_);
+    }
+    return values;
+  }
+
+  std::mt19937 random_engine_{2024};
+  std::vector<int> random_inputs_;
+};
+
+// Invokes the model in a loop. `items` is the amount of work done by one
+// invocation.
+void Run(benchmark::State& state, OpBenchmarkModel& model, int64_t items) {
+  for (auto _ : state) {
+    if (model.Invoke() != kTfLiteOk) {
+      state.SkipWithError("Invoke failed.");
+      return;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * items);
+}
+
+// Registers each of `shapes` with 1 and 4 threads, the thread count being
+// the last argument.
+void WithThreads(benchmark::internal::Benchmark* b,
+                 std::vector<std::string> arg_names,
+                 const std::vector<std::vector<int64_t>>& shapes) {
+  arg_names.push_back("threads");
+  b->ArgNames(arg_names);
+  for (const std::vector<int64_t>& shape : shapes) {
+    for (int threads : {1, 4}) {
+      std::vector<int64_t> args = shape;
+      args.push_back(threads);
+      b->Args(args);
+    }
+  }
+  b->UseRealTime();
+}
+
+int SameOutputSize(int input_size, int stride) {
+  return (input_size + stride - 1) / stride;
+}
+
+void BM_Conv2D(benchmark::State& state, TensorType type) {
+  const int size = state.range(0);
+  const int input_channels = state.range(1);
+  const int output_channels = state.range(2);
+  const int kernel = state.range(3);
+  const int stride = state.range(4);
+  const int output_size = SameOutputSize(size, stride);
+  OpBenchmarkModel model;
+  model.AddRandomInput(Tensor(type, {1, size, size, input_channels}));
+  model.AddRandomConstInput(
+      Tensor(type, {output_channels, kernel, kernel, input_channels}));
+  model.AddRandomConstInput(BiasTensor(type, {output_channels}));
+  model.AddOutput(Tensor(type, {1, output_size, output_size, output_channels}));
+  model.SetOp(BuiltinOperator_CONV_2D, BuiltinOptions_Conv2DOptions,
+              [&](flatbuffers::FlatBufferBuilder& b) {
+                return CreateConv2DOptions(b, Padding_SAME, stride, stride,
+                                           ActivationFunctionType_NONE)
+                    .Union();
+              });
+  model.Build(state.range(5));
+  Run(state, model,
+      int64_t{output_size} * output_size * output_channels * kernel * kernel *
+          input_channels);
+}
+
+void Conv2DShapes(benchmark::internal::Benchmark* b) {
+  WithThreads(b, {"size", "in_channels", "out_channels", "kernel", "stride"},
+              {
+                  {224, 3, 32, 3, 2},
+                  {112, 32, 64, 1, 1},
+                  {56, 64, 64, 3, 1},
+                  {28, 128, 128, 3, 1},
+                  {14, 256, 256, 3, 1},
+                  {7, 512, 1024, 1, 1},
+              });
+}
+
+BENCHMARK_CAPTURE(BM_Conv2D, float32, TensorType_FLOAT32)->Apply(Conv2DShapes);
+BENCHMARK_CAPTURE(BM_Conv2D, int8, TensorType_INT8)->Apply(Conv2DShapes);
+
+void BM_DepthwiseConv2D(benchmark::State& state, TensorType type) {
+  const int size = state.range(0);
+  const int channels = state.range(1);
+  const int kernel = state.range(2);
+  const int stride = state.range(3);
+  const int output_size = SameOutputSize(size, stride);
+  OpBenchmarkModel model;
+  model.AddRandomInput(Tensor(type, {1, size, size, channels}));
+  model.AddRandomConstInput(Tensor(type, {1, kernel, kernel, channels}));
+  model.AddRandomConstInput(BiasTensor(type, {channels}));
+  model.AddOutput(Tensor(type, {1, output_size, output_size, channels}));
+  model.SetOp(BuiltinOperator_DEPTHWISE_CONV_2D,
+              BuiltinOptions_DepthwiseConv2DOptions,
+              [&](flatbuffers::FlatBufferBuilder& b) {
+                return CreateDepthwiseConv2DOptions(
+                           b, Padding_SAME, stride, stride,
+                           /*depth_multiplier=*/1, ActivationFunctionType_NONE)
+                    .Union();
+              });
+  model.Build(state.range(4));
+  Run(state, model,
+      int64_t{output_size} * output_size * channels * kernel * kernel);
+}
+
+void DepthwiseConv2DShapes(benchmark::internal::Benchmark* b) {
+  WithThreads(b, {"size", "channels", "kernel", "stride"},
+              {
+                  {112, 32, 3, 1},
+                  {112, 64, 3, 2},
+                  {56, 128, 3, 1},
+                  {28, 256, 3, 1},
+                  {14, 512, 3, 1},
+                  {14, 576, 5, 1},
+                  {7, 1024, 3, 1},
+              });
+}
+
+BENCHMARK_CAPTURE(BM_DepthwiseConv2D, float32, TensorType_FLOAT32)
+    ->Apply(DepthwiseConv2DShapes);
+BENCHMARK_CAPTURE(BM_DepthwiseConv2D, int8, TensorType_INT8)
+    ->Apply(DepthwiseConv2DShapes);
+
+void BM_FullyConnected(benchmark::State& state, TensorType type) {
+  const int batch = state.range(0);
+  const int input_depth = state.range(1);
+  const int output_depth = state.range(2);
+  OpBenchmarkModel model;
+  model.AddRandomInput(Tensor(type, {batch, input_depth}));
+  model.AddRandomConstInput(Tensor(type, {output_depth, input_depth}));
+  model.AddRandomConstInput(BiasTensor(type, {output_depth}));
+  model.AddOutput(Tensor(type, {batch, output_depth}));
+  model.SetOp(BuiltinOperator_FULLY_CONNECTED,
+              BuiltinOptions_FullyConnectedOptions,
+              [](flatbuffers::FlatBufferBuilder& b) {
+                return CreateFullyConnectedOptions(b,
+                                                   ActivationFunctionType_NONE)
+                    .Union();
+              });
+  model.Build(state.range(3));
+  Run(state, model, int64_t{batch} * input_depth * output_depth);
+}
+
+void FullyConnectedShapes(benchmark::internal::Benchmark* b) {
+  WithThreads(b, {"batch", "input_depth", "output_depth"},
+              {
+                  {1, 256, 256},
+                  {1, 1024, 1000},
+                  {1, 2048, 2048},
+                  {8, 2048, 2048},
+                  {1, 4096, 4096},
+                  {32, 1024, 4096},
+                  {128, 512, 512},
+              });
+}
+
+BENCHMARK_CAPTURE(BM_FullyConnected, float32, TensorType_FLOAT32)
+    ->Apply(FullyConnectedShapes);
+BENCHMARK_CAPTURE(BM_FullyConnected, int8, TensorType_INT8)
+    ->Apply(FullyConnectedShapes);
+
+void BM_BatchMatMul(benchmark::State& state, TensorType type) {
+  const int batch = state.range(0);
+  const int m = state.range(1);
+  const int k = state.range(2);
+  const int n = state.range(3);
+  OpBenchmarkModel model;
+  model.AddRandomInput(Tensor(type, {batch, m, k}));
+  model.AddRandomInput(Tensor(type, {batch, k, n}));
+  model.AddOutput(Tensor(type, {batch, m, n}));
+  model.SetOp(BuiltinOperator_BATCH_MATMUL, BuiltinOptions_BatchMatMulOptions,
+              [](flatbuffers::FlatBufferBuilder& b) {
+                return CreateBatchMatMulOptions(b, /*adj_x=*/false,
+                                                /*adj_y=*/false)
+                    .Union();
+              });
+  model.Build(state.range(4));
+  Run(state, model, int64_t{batch} * m * k * n);
+}
+
+void BatchMatMulShapes(benchmark::internal::Benchmark* b) {
+  WithThreads(b, {"batch", "m", "k", "n"},
+              {
+                  {1, 1, 512, 512},
+                  {1, 128, 128, 128},
+                  {8, 128, 64, 128},
+                  {12, 128, 64, 128},
+                  {12, 384, 64, 384},
+                  {4, 512, 512, 512},
+              });
+}
+
+BENCHMARK_CAPTURE(BM_BatchMatMul, float32, TensorType_FLOAT32)
+    ->Apply(BatchMatMulShapes);
+BENCHMARK_CAPTURE(BM_BatchMatMul, int8, TensorType_INT8)
+    ->Apply(BatchMatMulShapes);
+
+// Returns the options of the elementwise binary ops below.
+std::pair<BuiltinOptions, OpBenchmarkModel::OptionsFn> BinaryOptions(
+    BuiltinOperator op) {
+  switch (op) {
+    case BuiltinOperator_ADD:
+      return {BuiltinOptions_AddOptions,
+              [](flatbuffers::FlatBufferBuilder& b) {
+                return CreateAddOptions(b).Union();
+              }};
+    case BuiltinOperator_SUB:
+      return {BuiltinOptions_SubOptions,
+              [](flatbuffers::FlatBufferBuilder& b) {
+                return CreateSubOptions(b).Union();
+              }};
+    case BuiltinOperator_MUL:
+      return {BuiltinOptions_MulOptions,
+              [](flatbuffers::FlatBufferBuilder& b) {
+                return CreateMulOptions(b).Union();
+              }};
+    case BuiltinOperator_DIV:
+      return {BuiltinOptions_DivOptions,
+              [](flatbuffers::FlatBufferBuilder& b) {
+                return CreateDivOptions(b).Union();
+              }};
+    case BuiltinOperator_SQUARED_DIFFERENCE:
+      return {BuiltinOptions_SquaredDifferenceOptions,
+              [](flatbuffers::FlatBufferBuilder& b) {
+                return CreateSquaredDifferenceOptions(b).Union();
+              }};
+    default:
+      return {BuiltinOptions_MaximumMinimumOptions,
+              [](flatbuffers::FlatBufferBuilder& b) {
+                return CreateMaximumMinimumOptions(b).Union();
+              }};
+  }
+}
+
+void BM_Binary(benchmark::State& state, BuiltinOperator op, TensorType type) {
+  const int rows = state.range(0);
+  const int cols = state.range(1);
+  const bool broadcast = state.range(2);
+  OpBenchmarkModel model;
+  model.AddRandomInput(Tensor(type, {1, rows, cols}));
+  model.AddRandomInput(Tensor(type, {1, broadcast ? 1 : rows, cols}));
+  model.AddOutput(Tensor(type, {1, rows, cols}));
+  const auto [options_type, options] = BinaryOptions(op);
+  model.SetOp(op, options_type, options);
+  model.Build(state.range(3));
+  Run(state, model, int64_t{rows} * cols);
+}
+
+void BinaryShapes(benchmark::internal::Benchmark* b) {
+  WithThreads(b, {"rows", "cols", "broadcast"},
+              {
+                  {1, 1024, 0},
+                  {64, 1024, 0},
+                  {1024, 1024, 0},
+                  {64, 1024, 1},
+                  {1024, 1024, 1},
+              });
+}
+
+#define BINARY_BENCHMARK(op, name)                                        \
+  BENCHMARK_CAPTURE(BM_Binary, name##_float32, BuiltinOperator_##op,      \
+                    TensorType_FLOAT32)                                   \
+      ->Apply(BinaryShapes);                                              \
+  BENCHMARK_CAPTURE(BM_Binary, name##_int8, BuiltinOperator_##op,         \
+                    TensorType_INT8)                                      \
+      ->Apply(BinaryShapes)
+
+BINARY_BENCHMARK(ADD, add);
+BINARY_BENCHMARK(SUB, sub);
+BINARY_BENCHMARK(MUL, mul);
+BINARY_BENCHMARK(MAXIMUM, maximum);
+BINARY_BENCHMARK(MINIMUM, minimum);
+BINARY_BENCHMARK(SQUARED_DIFFERENCE, squared_difference);
+// DIV has no int8 kernel.
+BENCHMARK_CAPTURE(BM_Binary, div_float32, BuiltinOperator_DIV,
+                  TensorType_FLOAT32)
+    ->Apply(BinaryShapes);
+
+#undef BINARY_BENCHMARK
+
+void BM_Unary(benchmark::State& state, BuiltinOperator op, TensorType type) {
+  const int size = state.range(0);
+  OpBenchmarkModel model;
+  model.AddRandomInput(Tensor(type, {1, size}));
+  // The quantized LOGISTIC and TANH kernels have fixed output ranges.
+  switch (op) {
+    case BuiltinOperator_LOGISTIC:
+      model.AddOutput(Output(type, {1, size}, 1.0f / 256, -128));
+      break;
+    case BuiltinOperator_TANH:
+      model.AddOutput(Output(type, {1, size}, 1.0f / 128, 0));
+      break;
+    default:
+      model.AddOutput(Tensor(type, {1, size}));
+      break;
+  }
+  model.SetOp(op, BuiltinOptions_NONE,
+              [](flatbuffers::FlatBufferBuilder&) {
+                return flatbuffers::Offset<void>();
+              });
+  model.Build(state.range(1));
+  Run(state, model, size);
+}
+
+void UnaryShapes(benchmark::internal::Benchmark* b) {
+  WithThreads(b, {"size"}, {{1024}, {65536}, {1048576}});
+}
+
+#define UNARY_BENCHMARK(op, name)                                         \
+  BENCHMARK_CAPTURE(BM_Unary, name##_float32, BuiltinOperator_##op,       \
+                    TensorType_FLOAT32)                                   \
+      ->Apply(UnaryShapes);                                               \
+  BENCHMARK_CAPTURE(BM_Unary, name##_int8, BuiltinOperator_##op,          \
+                    TensorType_INT8)                                      \
+      ->Apply(UnaryShapes)
+
+UNARY_BENCHMARK(RELU, relu);
+UNARY_BENCHMARK(RELU6, relu6);
+UNARY_BENCHMARK(LOGISTIC, logistic);
+UNARY_BENCHMARK(TANH, tanh);
+UNARY_BENCHMARK(HARD_SWISH, hard_swish);
+UNARY_BENCHMARK(ABS, abs);
+UNARY_BENCHMARK(EXP, exp);
+BENCHMARK_CAPTURE(BM_Unary, sqrt_float32, BuiltinOperator_SQRT,
+                  TensorType_FLOAT32)
+    ->Apply(UnaryShapes);
+BENCHMARK_CAPTURE(BM_Unary, rsqrt_float32, BuiltinOperator_RSQRT,
+                  TensorType_FLOAT32)
+    ->Apply(UnaryShapes);
+
+#undef UNARY_BENCHMARK
+
+void BM_Softmax(benchmark::State& state, TensorType type) {
+  const int batch = state.range(0);
+  const int size = state.range(1);
+  OpBenchmarkModel model;
+  model.AddRandomInput(Tensor(type, {batch, size}));
+  model.AddOutput(Output(type, {batch, size}, 1.0f / 256, -128));
+  model.SetOp(BuiltinOperator_SOFTMAX, BuiltinOptions_SoftmaxOptions,
+              [](flatbuffers::FlatBufferBuilder& b) {
+                return CreateSoftmaxOptions(b, /*beta=*/1.0f).Union();
+              });
+  model.Build(state.range(2));
+  Run(state, model, int64_t{batch} * size);
+}
+
+void SoftmaxShapes(benchmark::internal::Benchmark* b) {
+  WithThreads(b, {"batch", "size"},
+              {{1, 1000}, {1, 32000}, {128, 128}, {1536, 384}});
+}
+
+BENCHMARK_CAPTURE(BM_Softmax, float32, TensorType_FLOAT32)
+    ->Apply(SoftmaxShapes);
+BENCHMARK_CAPTURE(BM_Softmax, int8, TensorType_INT8)->Apply(SoftmaxShapes);
+
+void BM_Pool2D(benchmark::State& state, BuiltinOperator op, TensorType type) {
+  const int size = state.range(0);
+  const int channels = state.range(1);
+  const int kernel = state.range(2);
+  const int stride = state.range(3);
+  const int output_size = SameOutputSize(size, stride);
+  OpBenchmarkModel model;
+  model.AddRandomInput(Tensor(type, {1, size, size, channels}));
+  model.AddOutput(Tensor(type, {1, output_size, output_size, channels}));
+  model.SetOp(op, BuiltinOptions_Pool2DOptions,
+              [&](flatbuffers::FlatBufferBuilder& b) {
+                return CreatePool2DOptions(b, Padding_SAME, stride, stride,
+                                           kernel, kernel)
+                    .Union();
+              });
+  model.Build(state.range(4));
+  Run(state, model,
+      int64_t{output_size} * output_size * channels * kernel * kernel);
+}
+
+void Pool2DShapes(benchmark::internal::Benchmark* b) {
+  WithThreads(b, {"size", "channels", "kernel", "stride"},
+              {{112, 64, 3, 2}, {56, 128, 2, 2}, {7, 1024, 7, 1}});
+}
+
+BENCHMARK_CAPTURE(BM_Pool2D, average_float32, BuiltinOperator_AVERAGE_POOL_2D,
+                  TensorType_FLOAT32)
+    ->Apply(Pool2DShapes);
+BENCHMARK_CAPTURE(BM_Pool2D, average_int8, BuiltinOperator_AVERAGE_POOL_2D,
+                  TensorType_INT8)
+    ->Apply(Pool2DShapes);
+BENCHMARK_CAPTURE(BM_Pool2D, max_float32, BuiltinOperator_MAX_POOL_2D,
+                  TensorType_FLOAT32)
+    ->Apply(Pool2DShapes);
+BENCHMARK_CAPTURE(BM_Pool2D, max_int8, BuiltinOperator_MAX_POOL_2D,
+                  TensorType_INT8)
+    ->Apply(Pool2DShapes);
+
+// Mean over the spatial dimensions, as at the end of image classifiers.
+void BM_Mean(benchmark::State& state, TensorType type) {
+  const int size = state.range(0);
+  const int channels = state.range(1);
+  OpBenchmarkModel model;
+  model.AddRandomInput(Tensor(type, {1, size, size, channels}));
+  model.AddConstInput(TensorData(TensorType_INT32, {2}),
+                      std::vector<int32_t>{1, 2});
+  model.AddOutput(Tensor(type, {1, 1, 1, channels}));
+  model.SetOp(BuiltinOperator_MEAN, BuiltinOptions_ReducerOptions,
+              [](flatbuffers::FlatBufferBuilder& b) {
+                return CreateReducerOptions(b, /*keep_dims=*/true).Union();
+              });
+  model.Build(state.range(2));
+  Run(state, model, int64_t{size} * size * channels);
+}
+
+void MeanShapes(benchmark::internal::Benchmark* b) {
+  WithThreads(b, {"size", "channels"}, {{7, 1280}, {14, 512}, {56, 128}});
+}
+
+BENCHMARK_CAPTURE(BM_Mean, float32, TensorType_FLOAT32)->Apply(MeanShapes);
+BENCHMARK_CAPTURE(BM_Mean, int8, TensorType_INT8)->Apply(MeanShapes);
+
+// Concatenation of two NHWC tensors along the channels.
+void BM_Concatenation(benchmark::State& state, TensorType type) {
+  const int size = state.range(0);
+  const int channels = state.range(1);
+  OpBenchmarkModel model;
+  model.AddRandomInput(Tensor(type, {1, size, size, channels}));
+  model.AddRandomInput(Tensor(type, {1, size, size, channels}));
+  model.AddOutput(Tensor(type, {1, size, size, 2 * channels}));
+  model.SetOp(BuiltinOperator_CONCATENATION,
+              BuiltinOptions_ConcatenationOptions,
+              [](flatbuffers::FlatBufferBuilder& b) {
+                return CreateConcatenationOptions(b, /*axis=*/3).Union();
+              });
+  model.Build(state.range(2));
+  Run(state, model, int64_t{size} * size * 2 * channels);
+}
+
+void ConcatenationShapes(benchmark::internal::Benchmark* b) {
+  WithThreads(b, {"size", "channels"}, {{56, 64}, {28, 128}, {7, 512}});
+}
+
+BENCHMARK_CAPTURE(BM_Concatenation, float32, TensorType_FLOAT32)
+    ->Apply(ConcatenationShapes);
+BENCHMARK_CAPTURE(BM_Concatenation, int8, TensorType_INT8)
+    ->Apply(ConcatenationShapes);
+
+// Transpose of the two middle dimensions, as done to split attention heads.
+void BM_Transpose(benchmark::State& state, TensorType type) {
+  const int heads = state.range(0);
+  const int sequence = state.range(1);
+  const int head_size = state.range(2);
+  OpBenchmarkModel model;
+  model.AddRandomInput(Tensor(type, {1, sequence, heads, head_size}));
+  model.AddConstInput(TensorData(TensorType_INT32, {4}),
+                      std::vector<int32_t>{0, 2, 1, 3});
+  model.AddOutput(Tensor(type, {1, heads, sequence, head_size}));
+  model.SetOp(BuiltinOperator_TRANSPOSE, BuiltinOptions_TransposeOptions,
+              [](flatbuffers::FlatBufferBuilder& b) {
+                return CreateTransposeOptions(b).Union();
+              });
+  model.Build(state.range(3));
+  Run(state, model, int64_t{heads} * sequence * head_size);
+}
+
+void TransposeShapes(benchmark::internal::Benchmark* b) {
+  WithThreads(b, {"heads", "sequence", "head_size"},
+              {{12, 128, 64}, {12, 384, 64}, {32, 1024, 128}});
+}
+
+BENCHMARK_CAPTURE(BM_Transpose, float32, TensorType_FLOAT32)
+    ->Apply(TransposeShapes);
+BENCHMARK_CAPTURE(BM_Transpose, int8, TensorType_INT8)
+    ->Apply(TransposeShapes);
+
+}  // namespace
+}  // namespace tflite
+
+BENCHMARK_MAIN();
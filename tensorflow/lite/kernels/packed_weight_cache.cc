@@ -0,0 +1,303 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/kernels/packed_weight_cache.h"
+
+#if !defined(TFLITE_MMAP_DISABLED) && !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TFLITE_PACKED_WEIGHT_CACHE_USE_MMAP
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/minimal_logging.h"
+
+namespace tflite {
+namespace {
+
+constexpr size_t kAlignment = 64;
+
+// Bump when the file layout changes.
+constexpr char kFileMagic[8] = {'T', 'F', 'L', 'P', 'W', 'C', '0', '1'};
+
+// Precedes the packed weights in a file. Its size keeps them aligned.
+struct FileHeader {
+  char magic[8];
+  uint64_t fingerprint;
+  uint64_t cpu_features;
+  uint64_t source_bytes;
+  uint64_t packed_bytes;
+  char padding[kAlignment - 8 - 4 * sizeof(uint64_t)];
+};
+static_assert(sizeof(FileHeader) == kAlignment, "Header must keep alignment");
+
+uint64_t Hash(const void* data, size_t bytes, uint64_t hash) {
+  constexpr uint64_t kPrime = 0x100000001b3ull;
+  const uint8_t* bytes_data = static_cast<const uint8_t*>(data);
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= bytes; i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, bytes_data + i, sizeof(word));
+    hash = (hash ^ word) * kPrime;
+    hash ^= hash >> 29;
+  }
+  for (; i < bytes; ++i) hash = (hash ^ bytes_data[i]) * kPrime;
+  return hash;
+}
+
+uint64_t Hash(const std::string& value, uint64_t hash) {
+  return Hash(value.data(), value.size(), hash);
+}
+
+// Describes the features of the CPU that packing routines may depend on.
+uint64_t CpuFeatures() {
+  static const uint64_t cpu_features = [] {
+    std::string features;
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+    features = "x86";
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("ssse3")) features += ",ssse3";
+    if (__builtin_cpu_supports("avx")) features += ",avx";
+    if (__builtin_cpu_supports("avx2")) features += ",avx2";
+    if (__builtin_cpu_supports("fma")) features += ",fma";
+    if (__builtin_cpu_supports("avx512f")) features += ",avx512f";
+    if (__builtin_cpu_supports("avx512bw")) features += ",avx512bw";
+#endif
+#elif defined(__aarch64__) || defined(__arm__)
+    features = "arm";
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    features += ",neon";
+#endif
+#if defined(__ARM_FEATURE_DOTPROD)
+    features += ",dotprod";
+#endif
+#if defined(__ARM_FEATURE_MATMUL_INT8)
+    features += ",i8mm";
+#endif
+#else
+    features = "other";
+#endif
+    return Hash(features, 0xcbf29ce484222325ull);
+  }();
+  return cpu_features;
+}
+
+std::string FilePath(const std::string& directory, uint64_t fingerprint) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.packed",
+                static_cast<unsigned long long>(fingerprint));  // NOLINT
+  return directory + "/" + name;
+}
+
+bool IsValid(const FileHeader& header, uint64_t fingerprint,
+             const PackedWeightCache::Key& key, size_t packed_bytes) {
+  return std::memcmp(header.magic, kFileMagic, sizeof(kFileMagic)) == 0 &&
+         header.fingerprint == fingerprint &&
+         header.cpu_features == CpuFeatures() &&
+         header.source_bytes == key.bytes &&
+         header.packed_bytes == packed_bytes;
+}
+
+}  // namespace
+
+struct PackedWeightCache::Entry {
+  Entry() = default;
+  Entry(const Entry&) = delete;
+  Entry& operator=(const Entry&) = delete;
+  ~Entry() {
+#ifdef TFLITE_PACKED_WEIGHT_CACHE_USE_MMAP
+    if (mapped != nullptr) munmap(mapped, mapped_size);
+#endif
+  }
+
+  void Allocate(size_t packed_bytes) {
+    storage.reset(new uint8_t[packed_bytes + kAlignment - 1]);
+    const uintptr_t address = reinterpret_cast<uintptr_t>(storage.get());
+    data = storage.get() + (kAlignment - address % kAlignment) % kAlignment;
+  }
+
+  std::once_flag packed;
+  std::unique_ptr<uint8_t[]> storage;
+  // The file the packed weights are mapped from, if any.
+  void* mapped = nullptr;
+  size_t mapped_size = 0;
+  uint8_t* data = nullptr;
+};
+
+PackedWeightCache& PackedWeightCache::Get() {
+  // Never destroyed, so that kernels freed during static destruction can
+  // still release their entries.
+  static PackedWeightCache* cache = new PackedWeightCache();
+  return *cache;
+}
+
+bool PackedWeightCache::CanShare(const TfLiteTensor* tensor) {
+  return tensor != nullptr && tensor->allocation_type == kTfLiteMmapRo &&
+         tensor->data.raw_const != nullptr;
+}
+
+void PackedWeightCache::SetDirectory(const std::string& directory) {
+  std::lock_guard<std::mutex> lock(mu_);
+  directory_ = directory;
+}
+
+std::shared_ptr<const uint8_t> PackedWeightCache::GetOrPack(
+    const Key& key, size_t packed_bytes,
+    const std::function<void(uint8_t*)>& pack) {
+  // Hashing the source weights is much cheaper than packing them.
+  const uint64_t source_fingerprint =
+      Hash(key.data, key.bytes, 0xcbf29ce484222325ull);
+
+  std::shared_ptr<Entry> entry;
+  std::string directory;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    directory = directory_;
+    std::weak_ptr<Entry>& cached = entries_[{key, source_fingerprint}];
+    entry = cached.lock();
+    if (entry == nullptr) {
+      // Not std::make_shared, so that the packed weights are freed as soon as
+      // the last kernel releases them rather than with the weak references.
+      entry = std::shared_ptr<Entry>(new Entry());
+      cached = entry;
+      for (auto it = entries_.begin(); it != entries_.end();) {
+        it = it->second.expired() ? entries_.erase(it) : std::next(it);
+      }
+    }
+  }
+  // Packing happens outside of the lock so that different weights can be
+  // packed concurrently.
+  std::call_once(entry->packed, [&] {
+    uint64_t fingerprint = 0;
+    if (!directory.empty()) {
+      // Files are named after the contents of the weights rather than their
+      // address, which differs between processes.
+      fingerprint = Hash(key.format, source_fingerprint) ^ CpuFeatures();
+      if (Load(directory, key, fingerprint, packed_bytes, entry.get())) {
+        return;
+      }
+    }
+    entry->Allocate(packed_bytes);
+    pack(entry->data);
+    if (!directory.empty()) {
+      Store(directory, key, fingerprint, packed_bytes, *entry);
+    }
+  });
+  return std::shared_ptr<const uint8_t>(entry, entry->data);
+}
+
+bool PackedWeightCache::Load(const std::string& directory, const Key& key,
+                             uint64_t fingerprint, size_t packed_bytes,
+                             Entry* entry) {
+  const std::string path = FilePath(directory, fingerprint);
+  const size_t file_size = sizeof(FileHeader) + packed_bytes;
+#ifdef TFLITE_PACKED_WEIGHT_CACHE_USE_MMAP
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1) return false;
+  struct stat file_stat;
+  void* mapped = MAP_FAILED;
+  if (fstat(fd, &file_stat) == 0 &&
+      static_cast<size_t>(file_stat.st_size) == file_size) {
+    mapped = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (mapped == MAP_FAILED) return false;
+  if (!IsValid(*static_cast<const FileHeader*>(mapped), fingerprint, key,
+               packed_bytes)) {
+    munmap(mapped, file_size);
+    return false;
+  }
+  entry->mapped = mapped;
+  entry->mapped_size = file_size;
+  entry->data = static_cast<uint8_t*>(mapped) + sizeof(FileHeader);
+  return true;
+#else
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file || static_cast<size_t>(file.tellg()) != file_size) return false;
+  file.seekg(0);
+  FileHeader header;
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      !IsValid(header, fingerprint, key, packed_bytes)) {
+    return false;
+  }
+  entry->Allocate(packed_bytes);
+  if (!file.read(reinterpret_cast<char*>(entry->data), packed_bytes)) {
+    entry->storage.reset();
+    entry->data = nullptr;
+    return false;
+  }
+  return true;
+#endif
+}
+
+void PackedWeightCache::Store(const std::string& directory, const Key& key,
+                              uint64_t fingerprint, size_t packed_bytes,
+                              const Entry& entry) {
+  FileHeader header = {};
+  std::memcpy(header.magic, kFileMagic, sizeof(kFileMagic));
+  header.fingerprint = fingerprint;
+  header.cpu_features = CpuFeatures();
+  header.source_bytes = key.bytes;
+  header.packed_bytes = packed_bytes;
+
+  // Written to a temporary file first so that other processes never map a
+  // partially written one.
+  const std::string path = FilePath(directory, fingerprint);
+  std::string temporary_path =
+      path + ".tmp" + std::to_string(reinterpret_cast<uintptr_t>(&entry));
+#ifdef TFLITE_PACKED_WEIGHT_CACHE_USE_MMAP
+  temporary_path += "." + std::to_string(getpid());
+#endif
+  {
+    std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(entry.data), packed_bytes);
+    if (!file.flush()) {
+      TFLITE_LOG_PROD(TFLITE_LOG_WARNING,
+                      "Could not write packed weights to %s.",
+                      temporary_path.c_str());
+      file.close();
+      std::remove(temporary_path.c_str());
+      return;
+    }
+  }
+  if (std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+    std::remove(temporary_path.c_str());
+  }
+}
+
+int PackedWeightCache::num_entries() {
+  std::lock_guard<std::mutex> lock(mu_);
+  int num_entries = 0;
+  for (const auto& key_and_entry : entries_) {
+    if (!key_and_entry.second.expired()) ++num_entries;
+  }
+  return num_entries;
+}
+
+}  // namespace tflite
@@ -0,0 +1,113 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_KERNELS_PACKED_WEIGHT_CACHE_H_
+#define TENSORFLOW_LITE_KERNELS_PACKED_WEIGHT_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include "tensorflow/lite/core/c/common.h"
+
+namespace tflite {
+
+// A process-wide cache of constant weights that kernels repack into a layout
+// of their own (e.g. transposed or prepacked for a GEMM library).
+//
+// Interpreters built from the same `FlatBufferModel` see the same buffers for
+// their constant tensors, so the packed weights only need to be computed and
+// stored once, however many interpreters (typically one per thread) run the
+// model. Entries are reference counted and freed when the last kernel holding
+// them is freed.
+//
+// Packed weights can also be persisted in a directory (see `SetDirectory()`),
+// so that later processes map them from disk instead of packing them again.
+// Files are only reused if they were written for weights with the same
+// contents, the same packing format and a CPU with the same features.
+class PackedWeightCache {
+ public:
+  // Identifies packed weights: the source buffer and a description of the
+  // packing, including any parameter the packed layout depends on. The cache
+  // also matches the contents of the source buffer, so that a buffer whose
+  // address is reused by another model never gets stale packed weights.
+  struct Key {
+    const void* data;
+    size_t bytes;
+    std::string format;
+
+    bool operator<(const Key& other) const {
+      return std::tie(data, bytes, format) <
+             std::tie(other.data, other.bytes, other.format);
+    }
+  };
+
+  // Returns the instance shared by all interpreters of the process.
+  static PackedWeightCache& Get();
+
+  // Returns true if the packed weights of `tensor` can be shared, i.e. if its
+  // buffer is read-only and lives as long as the model.
+  static bool CanShare(const TfLiteTensor* tensor);
+
+  PackedWeightCache() = default;
+  PackedWeightCache(const PackedWeightCache&) = delete;
+  PackedWeightCache& operator=(const PackedWeightCache&) = delete;
+
+  // Persists packed weights in `directory`, which must exist, or stops
+  // persisting them if `directory` is empty. Only affects weights that aren't
+  // held by any kernel yet. Thread-safe.
+  void SetDirectory(const std::string& directory);
+
+  // Returns the `packed_bytes` packed weights identified by `key`, calling
+  // `pack` to fill a new 64-byte aligned buffer if no other kernel holds them
+  // and they can't be loaded from the directory. Concurrent calls for the same
+  // key pack the weights once. Thread-safe.
+  std::shared_ptr<const uint8_t> GetOrPack(
+      const Key& key, size_t packed_bytes,
+      const std::function<void(uint8_t*)>& pack);
+
+  // Returns the number of packed weights currently held by kernels.
+  int num_entries();
+
+ private:
+  struct Entry;
+
+  // Packed weights are looked up by key and a fingerprint of the contents of
+  // the source buffer.
+  using EntryKey = std::pair<Key, uint64_t>;
+
+  // Fills `entry` from the file for `key` in `directory`, returning false if
+  // there is no valid one.
+  static bool Load(const std::string& directory, const Key& key,
+                   uint64_t fingerprint, size_t packed_bytes, Entry* entry);
+  // Writes the packed weights of `entry` to the file for `key` in
+  // `directory`.
+  static void Store(const std::string& directory, const Key& key,
+                    uint64_t fingerprint, size_t packed_bytes,
+                    const Entry& entry);
+
+  std::mutex mu_;
+  std::string directory_;
+  std::map<EntryKey, std::weak_ptr<Entry>> entries_;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_PACKED_WEIGHT_CACHE_H_
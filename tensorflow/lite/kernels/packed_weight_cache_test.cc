@@ -0,0 +1,194 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/kernels/packed_weight_cache.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/core/c/common.h"
+
+namespace tflite {
+namespace {
+
+TEST(PackedWeightCacheTest, SharesPackedWeights) {
+  PackedWeightCache cache;
+  const float weights[] = {1, 2, 3, 4};
+  int num_packs = 0;
+  auto pack = [&](uint8_t* packed) {
+    ++num_packs;
+    std::memcpy(packed, weights, sizeof(weights));
+  };
+  const PackedWeightCache::Key key = {weights, sizeof(weights), "copy"};
+
+  auto first = cache.GetOrPack(key, sizeof(weights), pack);
+  auto second = cache.GetOrPack(key, sizeof(weights), pack);
+  EXPECT_EQ(num_packs, 1);
+  EXPECT_EQ(first.get(), second.get());
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(first.get()) % 64, 0);
+  EXPECT_EQ(std::memcmp(first.get(), weights, sizeof(weights)), 0);
+  EXPECT_EQ(cache.num_entries(), 1);
+
+  // Other formats of the same weights are packed separately.
+  auto other = cache.GetOrPack({weights, sizeof(weights), "other"},
+                               sizeof(weights), pack);
+  EXPECT_EQ(num_packs, 2);
+  EXPECT_NE(other.get(), first.get());
+  EXPECT_EQ(cache.num_entries(), 2);
+}
+
+TEST(PackedWeightCacheTest, FreesUnusedWeights) {
+  PackedWeightCache cache;
+  const int weights[] = {1, 2};
+  int num_packs = 0;
+  auto pack = [&](uint8_t* packed) { ++num_packs; };
+  const PackedWeightCache::Key key = {weights, sizeof(weights), "copy"};
+
+  auto packed = cache.GetOrPack(key, sizeof(weights), pack);
+  EXPECT_EQ(cache.num_entries(), 1);
+  packed.reset();
+  EXPECT_EQ(cache.num_entries(), 0);
+
+  packed = cache.GetOrPack(key, sizeof(weights), pack);
+  EXPECT_EQ(num_packs, 2);
+}
+
+TEST(PackedWeightCacheTest, MatchesSourceContents) {
+  PackedWeightCache cache;
+  // Stands for a buffer whose address is reused by another model.
+  float weights[] = {1, 2, 3, 4};
+  int num_packs = 0;
+  auto pack = [&](uint8_t* packed) {
+    ++num_packs;
+    std::memcpy(packed, weights, sizeof(weights));
+  };
+  const PackedWeightCache::Key key = {weights, sizeof(weights), "copy"};
+
+  auto first = cache.GetOrPack(key, sizeof(weights), pack);
+  weights[0] = 5;
+  auto second = cache.GetOrPack(key, sizeof(weights), pack);
+  EXPECT_EQ(num_packs, 2);
+  EXPECT_NE(first.get(), second.get());
+  EXPECT_EQ(reinterpret_cast<const float*>(first.get())[0], 1);
+  EXPECT_EQ(reinterpret_cast<const float*>(second.get())[0], 5);
+  EXPECT_EQ(cache.num_entries(), 2);
+}
+
+TEST(PackedWeightCacheTest, PacksOnceAcrossThreads) {
+  PackedWeightCache cache;
+  const int weights[] = {1, 2, 3};
+  std::atomic<int> num_packs{0};
+  constexpr int kNumThreads = 8;
+  std::vector<std::shared_ptr<const uint8_t>> packed(kNumThreads);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&, i] {
+      packed[i] = cache.GetOrPack(
+          {weights, sizeof(weights), "copy"}, sizeof(weights),
+          [&](uint8_t* data) {
+            ++num_packs;
+            std::memcpy(data, weights, sizeof(weights));
+          });
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  EXPECT_EQ(num_packs, 1);
+  for (int i = 0; i < kNumThreads; ++i) {
+    EXPECT_EQ(packed[i].get(), packed[0].get());
+  }
+  EXPECT_EQ(std::memcmp(packed[0].get(), weights, sizeof(weights)), 0);
+}
+
+TEST(PackedWeightCacheTest, LoadsPackedWeightsFromDirectory) {
+  const std::string directory = ::testing::TempDir();
+  const std::vector<float> weights = {1, 2, 3, 4, 5};
+  const size_t bytes = weights.size() * sizeof(float);
+  auto reverse = [&weights](uint8_t* packed) {
+    std::vector<float> reversed(weights.rbegin(), weights.rend());
+    std::memcpy(packed, reversed.data(), reversed.size() * sizeof(float));
+  };
+  {
+    PackedWeightCache cache;
+    cache.SetDirectory(directory);
+    cache.GetOrPack({weights.data(), bytes, "reverse"}, bytes, reverse);
+  }
+
+  // Stands in for the same weights loaded by another process.
+  const std::vector<float> same_weights = weights;
+  PackedWeightCache cache;
+  cache.SetDirectory(directory);
+  int num_packs = 0;
+  auto count_packs = [&num_packs](uint8_t*) { ++num_packs; };
+  auto packed = cache.GetOrPack({same_weights.data(), bytes, "reverse"},
+                                bytes, count_packs);
+  EXPECT_EQ(num_packs, 0);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(packed.get()) % 64, 0);
+  const float expected[] = {5, 4, 3, 2, 1};
+  EXPECT_EQ(std::memcmp(packed.get(), expected, bytes), 0);
+
+  // Weights with other contents or formats are packed again.
+  const std::vector<float> other_weights = {6, 2, 3, 4, 5};
+  cache.GetOrPack({other_weights.data(), bytes, "reverse"}, bytes,
+                  count_packs);
+  EXPECT_EQ(num_packs, 1);
+  cache.GetOrPack({same_weights.data(), bytes, "other"}, bytes, count_packs);
+  EXPECT_EQ(num_packs, 2);
+}
+
+TEST(PackedWeightCacheTest, IgnoresMismatchingFiles) {
+  const std::string directory = ::testing::TempDir();
+  const int weights[] = {7, 8, 9};
+  {
+    PackedWeightCache cache;
+    cache.SetDirectory(directory);
+    cache.GetOrPack({weights, sizeof(weights), "mismatch"}, sizeof(weights),
+                    [](uint8_t*) {});
+  }
+
+  // The file for the same weights and format has the wrong size.
+  PackedWeightCache cache;
+  cache.SetDirectory(directory);
+  int num_packs = 0;
+  auto packed = cache.GetOrPack({weights, sizeof(weights), "mismatch"},
+                                2 * sizeof(weights), [&](uint8_t* data) {
+                                  ++num_packs;
+                                  std::memcpy(data, weights, sizeof(weights));
+                                });
+  EXPECT_EQ(num_packs, 1);
+  EXPECT_EQ(std::memcmp(packed.get(), weights, sizeof(weights)), 0);
+}
+
+TEST(PackedWeightCacheTest, CanShare) {
+  float data[] = {1};
+  TfLiteTensor tensor = {};
+  tensor.data.raw = reinterpret_cast<char*>(data);
+  tensor.allocation_type = kTfLiteMmapRo;
+  EXPECT_TRUE(PackedWeightCache::CanShare(&tensor));
+  tensor.allocation_type = kTfLiteArenaRw;
+  EXPECT_FALSE(PackedWeightCache::CanShare(&tensor));
+  tensor.allocation_type = kTfLiteMmapRo;
+  tensor.data.raw = nullptr;
+  EXPECT_FALSE(PackedWeightCache::CanShare(&tensor));
+  EXPECT_FALSE(PackedWeightCache::CanShare(nullptr));
+}
+
+}  // namespace
+}  // namespace tflite
@@ -18,6 +18,7 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/offline_arena_plan.h"
 
 namespace tflite {
 
@@ -44,6 +45,31 @@ class MemoryPlanner {
   // Invalidates allocations after the given node execution.
   virtual TfLiteStatus ResetAllocationsAfter(int node) = 0;
 
+  // Declares that the nodes of each wavefront of the execution plan may run
+  // concurrently. Wavefront k covers the execution plan indices
+  // [wavefront_ends[k - 1], wavefront_ends[k]), and an empty vector restores
+  // sequential execution. Takes effect on the next call to PlanAllocations().
+  // Planners that can't keep allocations valid under concurrent execution
+  // return an error, in which case nodes must run sequentially.
+  virtual TfLiteStatus SetExecutionWavefronts(
+      const std::vector<int>& wavefront_ends) {
+    return wavefront_ends.empty() ? kTfLiteOk : kTfLiteError;
+  }
+
+  // Declares offsets computed ahead of time for the non-persistent arena
+  // tensors. They are used instead of the offsets planned at runtime whenever
+  // they cover all the tensors being allocated, with their current sizes and
+  // lifetimes. An empty plan restores runtime planning. Planners without an
+  // arena ignore the plan.
+  virtual TfLiteStatus SetOfflineArenaPlan(OfflineArenaPlan plan) {
+    return kTfLiteOk;
+  }
+
+  // Returns the current allocations of the non-persistent arena tensors, from
+  // which an offline plan can be computed. Empty for planners without an
+  // arena.
+  virtual OfflineArenaPlan GetArenaAllocations() const { return {}; }
+
   // NOTE: The following two methods modify the data pointers for all tensors on
   // the non-persistent arena (inputs, outputs, intermediates). If the user has
   // manually set the pointers for any of these, they would need to be set
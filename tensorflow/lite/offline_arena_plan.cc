@@ -0,0 +1,164 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/offline_arena_plan.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tflite {
+namespace {
+
+// Bump when the serialization changes.
+constexpr uint32_t kVersion = 1;
+
+// Integers are serialized in little-endian order, regardless of the host.
+void AppendUint(uint64_t value, int bytes, std::string* out) {
+  for (int i = 0; i < bytes; ++i) {
+    out->push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+class Reader {
+ public:
+  Reader(const char* data, size_t size) : data_(data), size_(size) {}
+
+  bool ReadUint(int bytes, uint64_t* value) {
+    if (size_ - position_ < static_cast<size_t>(bytes)) return false;
+    *value = 0;
+    for (int i = 0; i < bytes; ++i) {
+      *value |= static_cast<uint64_t>(static_cast<uint8_t>(data_[position_++]))
+                << (8 * i);
+    }
+    return true;
+  }
+
+  bool ReadInt32(int32_t* value) {
+    uint64_t bits;
+    if (!ReadUint(4, &bits)) return false;
+    *value = static_cast<int32_t>(static_cast<uint32_t>(bits));
+    return true;
+  }
+
+  size_t remaining() const { return size_ - position_; }
+
+ private:
+  const char* data_;
+  size_t size_;
+  size_t position_ = 0;
+};
+
+// Number of serialized bytes per allocation.
+constexpr size_t kAllocBytes = 3 * 4 + 2 * 8;
+
+}  // namespace
+
+std::string SerializeOfflineArenaPlans(
+    const std::vector<OfflineArenaPlan>& plans) {
+  std::string out;
+  AppendUint(kVersion, 4, &out);
+  AppendUint(plans.size(), 4, &out);
+  for (const OfflineArenaPlan& plan : plans) {
+    AppendUint(plan.size(), 4, &out);
+    for (const OfflineArenaAllocation& alloc : plan) {
+      AppendUint(static_cast<uint32_t>(alloc.tensor), 4, &out);
+      AppendUint(static_cast<uint32_t>(alloc.first_node), 4, &out);
+      AppendUint(static_cast<uint32_t>(alloc.last_node), 4, &out);
+      AppendUint(alloc.offset, 8, &out);
+      AppendUint(alloc.size, 8, &out);
+    }
+  }
+  return out;
+}
+
+bool ParseOfflineArenaPlans(const char* data, size_t size,
+                            std::vector<OfflineArenaPlan>* plans) {
+  Reader reader(data, size);
+  uint64_t version, num_plans;
+  if (!reader.ReadUint(4, &version) || version != kVersion ||
+      !reader.ReadUint(4, &num_plans)) {
+    return false;
+  }
+  std::vector<OfflineArenaPlan> parsed_plans;
+  for (uint64_t i = 0; i < num_plans; ++i) {
+    uint64_t num_allocs;
+    if (!reader.ReadUint(4, &num_allocs) ||
+        num_allocs > reader.remaining() / kAllocBytes) {
+      return false;
+    }
+    OfflineArenaPlan plan(num_allocs);
+    for (OfflineArenaAllocation& alloc : plan) {
+      uint64_t offset, alloc_size;
+      if (!reader.ReadInt32(&alloc.tensor) ||
+          !reader.ReadInt32(&alloc.first_node) ||
+          !reader.ReadInt32(&alloc.last_node) ||
+          !reader.ReadUint(8, &offset) || !reader.ReadUint(8, &alloc_size) ||
+          offset > std::numeric_limits<size_t>::max() ||
+          alloc_size > std::numeric_limits<size_t>::max() - offset ||
+          alloc.tensor < 0 || alloc.first_node < 0 ||
+          alloc.last_node < alloc.first_node) {
+        return false;
+      }
+      alloc.offset = offset;
+      alloc.size = alloc_size;
+    }
+    parsed_plans.push_back(std::move(plan));
+  }
+  if (reader.remaining() != 0) return false;
+  *plans = std::move(parsed_plans);
+  return true;
+}
+
+bool IsValidOfflineArenaPlan(const OfflineArenaPlan& plan, size_t alignment) {
+  OfflineArenaPlan sorted = plan;
+  std::sort(sorted.begin(), sorted.end(),
+            [](const OfflineArenaAllocation& a,
+               const OfflineArenaAllocation& b) {
+              return a.offset < b.offset;
+            });
+  // Allocations sorted by offset that may still overlap the next ones.
+  std::vector<const OfflineArenaAllocation*> open;
+  for (const OfflineArenaAllocation& alloc : sorted) {
+    if (alignment != 0 && alloc.offset % alignment != 0) return false;
+    if (alloc.size == 0) continue;
+    open.erase(std::remove_if(open.begin(), open.end(),
+                              [&alloc](const OfflineArenaAllocation* o) {
+                                return o->offset + o->size <= alloc.offset;
+                              }),
+               open.end());
+    for (const OfflineArenaAllocation* other : open) {
+      if (other->first_node <= alloc.last_node &&
+          alloc.first_node <= other->last_node) {
+        return false;
+      }
+    }
+    open.push_back(&alloc);
+  }
+  return true;
+}
+
+size_t OfflineArenaPlanSize(const OfflineArenaPlan& plan) {
+  size_t size = 0;
+  for (const OfflineArenaAllocation& alloc : plan) {
+    size = std::max(size, alloc.offset + alloc.size);
+  }
+  return size;
+}
+
+}  // namespace tflite
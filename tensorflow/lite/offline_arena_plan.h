@@ -0,0 +1,62 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_OFFLINE_ARENA_PLAN_H_
+#define TENSORFLOW_LITE_OFFLINE_ARENA_PLAN_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tflite {
+
+// Name of the model metadata that holds the offline arena plans of the
+// subgraphs of a model, as written by
+// `tensorflow/lite/tools/arena_plan:embed_arena_plan`.
+constexpr char kOfflineArenaPlanMetadataKey[] = "tflite_offline_arena_plan";
+
+// The offset of a non-persistent arena tensor, computed ahead of time along
+// with the first and last execution plan indices at which the tensor is used
+// and the size it was planned for.
+struct OfflineArenaAllocation {
+  int32_t tensor;
+  int32_t first_node;
+  int32_t last_node;
+  size_t offset;
+  size_t size;
+};
+
+// The offline allocations of the arena tensors of a subgraph.
+using OfflineArenaPlan = std::vector<OfflineArenaAllocation>;
+
+// Serializes the plans of all subgraphs of a model, indexed by subgraph.
+std::string SerializeOfflineArenaPlans(
+    const std::vector<OfflineArenaPlan>& plans);
+
+// Parses plans serialized by `SerializeOfflineArenaPlans()`. Returns false if
+// `data` isn't a valid serialization.
+bool ParseOfflineArenaPlans(const char* data, size_t size,
+                            std::vector<OfflineArenaPlan>* plans);
+
+// Returns true if every offset of `plan` is a multiple of `alignment` and no
+// two allocations that are used at the same node overlap.
+bool IsValidOfflineArenaPlan(const OfflineArenaPlan& plan, size_t alignment);
+
+// Returns the size of the arena needed by `plan`.
+size_t OfflineArenaPlanSize(const OfflineArenaPlan& plan);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_OFFLINE_ARENA_PLAN_H_
@@ -0,0 +1,97 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/offline_arena_plan.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace tflite {
+namespace {
+
+OfflineArenaAllocation Alloc(int32_t tensor, int32_t first_node,
+                             int32_t last_node, size_t offset, size_t size) {
+  return {tensor, first_node, last_node, offset, size};
+}
+
+TEST(OfflineArenaPlanTest, SerializesPlans) {
+  const std::vector<OfflineArenaPlan> plans = {
+      {Alloc(0, 0, 1, 0, 64), Alloc(3, 1, 2, 64, 128)},
+      {},
+      {Alloc(7, 2, 5, 1ull << 33, 16)},
+  };
+  const std::string serialized = SerializeOfflineArenaPlans(plans);
+
+  std::vector<OfflineArenaPlan> parsed;
+  ASSERT_TRUE(
+      ParseOfflineArenaPlans(serialized.data(), serialized.size(), &parsed));
+  ASSERT_EQ(parsed.size(), plans.size());
+  for (size_t i = 0; i < plans.size(); ++i) {
+    ASSERT_EQ(parsed[i].size(), plans[i].size());
+    for (size_t j = 0; j < plans[i].size(); ++j) {
+      EXPECT_EQ(parsed[i][j].tensor, plans[i][j].tensor);
+      EXPECT_EQ(parsed[i][j].first_node, plans[i][j].first_node);
+      EXPECT_EQ(parsed[i][j].last_node, plans[i][j].last_node);
+      EXPECT_EQ(parsed[i][j].offset, plans[i][j].offset);
+      EXPECT_EQ(parsed[i][j].size, plans[i][j].size);
+    }
+  }
+}
+
+TEST(OfflineArenaPlanTest, RejectsCorruptData) {
+  const std::string serialized =
+      SerializeOfflineArenaPlans({{Alloc(0, 0, 1, 0, 64)}});
+  std::vector<OfflineArenaPlan> parsed;
+  for (size_t size = 0; size < serialized.size(); ++size) {
+    EXPECT_FALSE(ParseOfflineArenaPlans(serialized.data(), size, &parsed));
+  }
+  EXPECT_FALSE(ParseOfflineArenaPlans((serialized + "x").data(),
+                                      serialized.size() + 1, &parsed));
+  std::string bad_version = serialized;
+  bad_version[0] = 2;
+  EXPECT_FALSE(
+      ParseOfflineArenaPlans(bad_version.data(), bad_version.size(), &parsed));
+  const std::string bad_lifetime =
+      SerializeOfflineArenaPlans({{Alloc(0, 2, 1, 0, 64)}});
+  EXPECT_FALSE(ParseOfflineArenaPlans(bad_lifetime.data(),
+                                      bad_lifetime.size(), &parsed));
+}
+
+TEST(OfflineArenaPlanTest, ValidatesPlans) {
+  // Tensors used at different nodes may share memory.
+  EXPECT_TRUE(IsValidOfflineArenaPlan(
+      {Alloc(0, 0, 1, 0, 64), Alloc(1, 2, 3, 0, 128), Alloc(2, 1, 2, 128, 64)},
+      64));
+  // Overlapping tensors used at the same node may not.
+  EXPECT_FALSE(IsValidOfflineArenaPlan(
+      {Alloc(0, 0, 1, 0, 128), Alloc(1, 1, 3, 64, 64)}, 64));
+  EXPECT_FALSE(IsValidOfflineArenaPlan({Alloc(0, 0, 4, 0, 512),
+                                        Alloc(1, 1, 1, 256, 64),
+                                        Alloc(2, 4, 5, 448, 64)},
+                                       64));
+  // Offsets must be aligned.
+  EXPECT_FALSE(IsValidOfflineArenaPlan({Alloc(0, 0, 1, 32, 64)}, 64));
+  EXPECT_TRUE(IsValidOfflineArenaPlan({Alloc(0, 0, 1, 32, 64)}, 32));
+
+  EXPECT_EQ(OfflineArenaPlanSize({Alloc(0, 0, 1, 0, 64),
+                                  Alloc(1, 2, 3, 64, 100)}),
+            164);
+}
+
+}  // namespace
+}  // namespace tflite
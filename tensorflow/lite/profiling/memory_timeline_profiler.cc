@@ -0,0 +1,211 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/memory_timeline_profiler.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/subgraph.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/offline_arena_plan.h"
+
+namespace tflite::profiling {
+
+MemoryTimelineProfiler::MemoryTimelineProfiler(const Interpreter& interpreter)
+    : interpreter_(interpreter) {}
+
+uint32_t MemoryTimelineProfiler::BeginEvent(const char* tag,
+                                            EventType event_type,
+                                            int64_t event_metadata1,
+                                            int64_t event_metadata2) {
+  if (!enabled_) return 0;
+  const int subgraph_index = static_cast<int>(event_metadata2);
+  // The arena is planned by the time Subgraph::Invoke() starts, but it may be
+  // planned again if tensors are resized, so read it on every invocation.
+  if (event_type == EventType::DEFAULT && tag && !strcmp(tag, "Invoke")) {
+    UpdateLayout(subgraph_index);
+    return 0;
+  }
+  if (event_type != EventType::OPERATOR_INVOKE_EVENT) return 0;
+  auto layout = layouts_.find(subgraph_index);
+  if (layout == layouts_.end()) return 0;
+
+  const int node_index = static_cast<int>(event_metadata1);
+  const std::vector<int>& execution_plan_index_of_node =
+      layout->second.execution_plan_index_of_node;
+  if (node_index < 0 ||
+      node_index >= static_cast<int>(execution_plan_index_of_node.size()) ||
+      execution_plan_index_of_node[node_index] < 0) {
+    return 0;
+  }
+  OpMemoryUsage usage =
+      layout->second.arena_usage[execution_plan_index_of_node[node_index]];
+  usage.node_index = node_index;
+  usage.op_name = tag ? tag : "";
+  timeline_.push_back(std::move(usage));
+  pending_.push_back(timeline_.size() - 1);
+  return pending_.size();
+}
+
+void MemoryTimelineProfiler::EndEvent(uint32_t event_handle) {
+  if (!event_handle || event_handle > pending_.size()) return;
+  OpMemoryUsage& usage = timeline_[pending_[event_handle - 1]];
+  pending_.resize(event_handle - 1);
+
+  const Subgraph* subgraph = interpreter_.subgraph(usage.subgraph_index);
+  if (subgraph == nullptr) return;
+  for (int i = 0; i < subgraph->tensors_size(); ++i) {
+    const TfLiteTensor* tensor = subgraph->tensor(i);
+    if (tensor->allocation_type == kTfLiteDynamic &&
+        tensor->data.raw != nullptr) {
+      usage.dynamic_bytes += tensor->bytes;
+    }
+  }
+}
+
+void MemoryTimelineProfiler::Reset() {
+  layouts_.clear();
+  timeline_.clear();
+  pending_.clear();
+}
+
+void MemoryTimelineProfiler::UpdateLayout(int subgraph_index) {
+  const Subgraph* subgraph = interpreter_.subgraph(subgraph_index);
+  if (subgraph == nullptr) return;
+  SubgraphLayout& layout = layouts_[subgraph_index];
+
+  Subgraph::SubgraphAllocInfo alloc_info;
+  subgraph->GetMemoryAllocInfo(&alloc_info);
+  layout.arena_bytes = alloc_info.arena_size;
+  layout.persistent_arena_bytes = alloc_info.arena_persist_size;
+  layout.allocations = subgraph->GetArenaAllocations();
+
+  const std::vector<int>& execution_plan = subgraph->execution_plan();
+  layout.execution_plan_index_of_node.assign(subgraph->nodes_size(), -1);
+  layout.arena_usage.assign(execution_plan.size(), OpMemoryUsage());
+  for (int i = 0; i < static_cast<int>(execution_plan.size()); ++i) {
+    if (execution_plan[i] <
+        static_cast<int>(layout.execution_plan_index_of_node.size())) {
+      layout.execution_plan_index_of_node[execution_plan[i]] = i;
+    }
+    layout.arena_usage[i].subgraph_index = subgraph_index;
+    layout.arena_usage[i].execution_plan_index = i;
+  }
+  for (const OfflineArenaAllocation& allocation : layout.allocations) {
+    const int first = std::max<int>(allocation.first_node, 0);
+    const int last = std::min<int>(allocation.last_node,
+                                   static_cast<int>(execution_plan.size()) - 1);
+    for (int i = first; i <= last; ++i) {
+      OpMemoryUsage& usage = layout.arena_usage[i];
+      usage.arena_live_bytes += allocation.size;
+      usage.arena_high_water_bytes = std::max(
+          usage.arena_high_water_bytes, allocation.offset + allocation.size);
+      if (allocation.size > usage.largest_tensor_bytes) {
+        usage.largest_tensor = allocation.tensor;
+        usage.largest_tensor_bytes = allocation.size;
+      }
+    }
+  }
+}
+
+const OfflineArenaPlan& MemoryTimelineProfiler::GetArenaLayout(
+    int subgraph_index) const {
+  static const OfflineArenaPlan* const kEmptyLayout = new OfflineArenaPlan();
+  auto layout = layouts_.find(subgraph_index);
+  return layout == layouts_.end() ? *kEmptyLayout : layout->second.allocations;
+}
+
+std::vector<SubgraphMemorySummary> MemoryTimelineProfiler::GetSummaries()
+    const {
+  std::vector<SubgraphMemorySummary> summaries;
+  for (const auto& [subgraph_index, layout] : layouts_) {
+    SubgraphMemorySummary summary;
+    summary.subgraph_index = subgraph_index;
+    summary.arena_bytes = layout.arena_bytes;
+    summary.persistent_arena_bytes = layout.persistent_arena_bytes;
+    summary.planned_arena_bytes = OfflineArenaPlanSize(layout.allocations);
+    for (const OpMemoryUsage& usage : timeline_) {
+      if (usage.subgraph_index != subgraph_index) continue;
+      if (summary.peak_node_index == -1 ||
+          usage.arena_live_bytes > summary.peak_live_bytes) {
+        summary.peak_live_bytes = usage.arena_live_bytes;
+        summary.peak_node_index = usage.node_index;
+        summary.peak_op_name = usage.op_name;
+      }
+      summary.peak_dynamic_bytes =
+          std::max(summary.peak_dynamic_bytes, usage.dynamic_bytes);
+    }
+    if (summary.planned_arena_bytes > 0) {
+      summary.fragmentation =
+          1.0 - static_cast<double>(summary.peak_live_bytes) /
+                    summary.planned_arena_bytes;
+    }
+    summaries.push_back(summary);
+  }
+  return summaries;
+}
+
+std::string MemoryTimelineProfiler::GetCsvOutput() const {
+  std::stringstream stream;
+  stream << "Subgraph memory summary\n"
+         << "subgraph,arena_bytes,persistent_arena_bytes,planned_arena_bytes,"
+            "peak_live_bytes,peak_node,peak_op,fragmentation,"
+            "peak_dynamic_bytes\n";
+  for (const SubgraphMemorySummary& summary : GetSummaries()) {
+    stream << summary.subgraph_index << "," << summary.arena_bytes << ","
+           << summary.persistent_arena_bytes << ","
+           << summary.planned_arena_bytes << "," << summary.peak_live_bytes
+           << "," << summary.peak_node_index << "," << summary.peak_op_name
+           << "," << summary.fragmentation << ","
+           << summary.peak_dynamic_bytes << "\n";
+  }
+
+  stream << "\nOp memory timeline\n"
+         << "subgraph,node,execution_plan_index,op,arena_live_bytes,"
+            "arena_high_water_bytes,largest_tensor,largest_tensor_bytes,"
+            "dynamic_bytes\n";
+  for (const OpMemoryUsage& usage : timeline_) {
+    stream << usage.subgraph_index << "," << usage.node_index << ","
+           << usage.execution_plan_index << "," << usage.op_name << ","
+           << usage.arena_live_bytes << "," << usage.arena_high_water_bytes
+           << "," << usage.largest_tensor << "," << usage.largest_tensor_bytes
+           << "," << usage.dynamic_bytes << "\n";
+  }
+
+  stream << "\nArena layout\n"
+         << "subgraph,tensor,name,offset,size,first_execution_plan_index,"
+            "last_execution_plan_index\n";
+  for (const auto& [subgraph_index, layout] : layouts_) {
+    const Subgraph* subgraph = interpreter_.subgraph(subgraph_index);
+    for (const OfflineArenaAllocation& allocation : layout.allocations) {
+      const TfLiteTensor* tensor =
+          subgraph ? subgraph->tensor(allocation.tensor) : nullptr;
+      stream << subgraph_index << "," << allocation.tensor << ",\""
+             << (tensor && tensor->name ? tensor->name : "") << "\","
+             << allocation.offset << "," << allocation.size << ","
+             << allocation.first_node << "," << allocation.last_node << "\n";
+    }
+  }
+  return stream.str();
+}
+
+}  // namespace tflite::profiling
@@ -0,0 +1,130 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_PROFILING_MEMORY_TIMELINE_PROFILER_H_
+#define TENSORFLOW_LITE_PROFILING_MEMORY_TIMELINE_PROFILER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/core/api/profiler.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/offline_arena_plan.h"
+
+namespace tflite::profiling {
+
+// Memory in use while an op runs.
+struct OpMemoryUsage {
+  int subgraph_index = 0;
+  int node_index = 0;
+  int execution_plan_index = 0;
+  std::string op_name;
+  // Total size of the arena tensors that are live while the op runs.
+  size_t arena_live_bytes = 0;
+  // End of the highest arena tensor that is live while the op runs, i.e. the
+  // part of the arena that has to be resident.
+  size_t arena_high_water_bytes = 0;
+  // The largest arena tensor that is live while the op runs, or -1.
+  int largest_tensor = -1;
+  size_t largest_tensor_bytes = 0;
+  // Total size of the dynamic tensors of the subgraph once the op is done,
+  // which includes the memory the op allocated itself.
+  size_t dynamic_bytes = 0;
+};
+
+// The arena of a subgraph and how well it is used.
+struct SubgraphMemorySummary {
+  int subgraph_index = 0;
+  // Size of the non-persistent arena and of the persistent arena, as
+  // allocated.
+  size_t arena_bytes = 0;
+  size_t persistent_arena_bytes = 0;
+  // Size of the non-persistent arena needed by the planned offsets.
+  size_t planned_arena_bytes = 0;
+  // Largest total size of the arena tensors live at any op, the op at which
+  // it is reached, and the part of the planned arena it leaves unused.
+  size_t peak_live_bytes = 0;
+  int peak_node_index = -1;
+  std::string peak_op_name;
+  double fragmentation = 0;
+  // Largest total size of the dynamic tensors after any op.
+  size_t peak_dynamic_bytes = 0;
+};
+
+// Records which arena tensors are live at each op of each subgraph that is
+// invoked, from the offsets and lifetimes planned by the memory planner, along
+// with the memory held by dynamic tensors after each op. This gives a per-op
+// memory timeline, from which the ops that set the peak memory use can be
+// found.
+//
+// Recording scans the tensors of the subgraph after every op, so it is meant
+// for diagnostics rather than for timing runs.
+class MemoryTimelineProfiler : public tflite::Profiler {
+ public:
+  explicit MemoryTimelineProfiler(const Interpreter& interpreter);
+
+  uint32_t BeginEvent(const char* tag, EventType event_type,
+                      int64_t event_metadata1,
+                      int64_t event_metadata2) override;
+
+  void EndEvent(uint32_t event_handle) override;
+
+  void StartProfiling() { enabled_ = true; }
+  void StopProfiling() { enabled_ = false; }
+  bool IsProfiling() const { return enabled_; }
+
+  // Clears everything recorded so far.
+  void Reset();
+
+  // Returns the ops in the order they started.
+  const std::vector<OpMemoryUsage>& GetTimeline() const { return timeline_; }
+
+  // Returns the arena layout of the given subgraph as of its last invocation.
+  const OfflineArenaPlan& GetArenaLayout(int subgraph_index) const;
+
+  // Returns a summary of each subgraph that was invoked.
+  std::vector<SubgraphMemorySummary> GetSummaries() const;
+
+  // Returns the summaries, the timeline and the arena layouts as CSV tables,
+  // each preceded by its title.
+  std::string GetCsvOutput() const;
+
+ private:
+  // Memory use at each execution plan index of a subgraph, derived from its
+  // arena layout.
+  struct SubgraphLayout {
+    size_t arena_bytes = 0;
+    size_t persistent_arena_bytes = 0;
+    OfflineArenaPlan allocations;
+    std::vector<int> execution_plan_index_of_node;
+    std::vector<OpMemoryUsage> arena_usage;
+  };
+
+  void UpdateLayout(int subgraph_index);
+
+  const Interpreter& interpreter_;
+  bool enabled_ = false;
+  std::map<int, SubgraphLayout> layouts_;
+  std::vector<OpMemoryUsage> timeline_;
+  // Indices in `timeline_` of the ops that have begun but not ended, indexed
+  // by event handle - 1. Ops nest when they invoke subgraphs.
+  std::vector<size_t> pending_;
+};
+
+}  // namespace tflite::profiling
+
+#endif  // TENSORFLOW_LITE_PROFILING_MEMORY_TIMELINE_PROFILER_H_
@@ -0,0 +1,192 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/memory_timeline_profiler.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/kernels/subgraph_test_util.h"
+#include "tensorflow/lite/offline_arena_plan.h"
+
+namespace tflite::profiling {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Field;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+
+// `cond ? a + b : a * b`, where the ADD and the MUL are in subgraphs 1 and 2.
+class MemoryTimelineProfilerTest
+    : public subgraph_test_util::ControlFlowOpTest {
+ protected:
+  void SetUp() override {
+    AddSubgraphs(2);
+    builder_->BuildAddSubgraph(interpreter_->subgraph(1));
+    builder_->BuildMulSubgraph(interpreter_->subgraph(2));
+    builder_->BuildIfSubgraph(&interpreter_->primary_subgraph());
+
+    interpreter_->ResizeInputTensor(interpreter_->inputs()[0], {1});
+    interpreter_->ResizeInputTensor(interpreter_->inputs()[1], {2});
+    interpreter_->ResizeInputTensor(interpreter_->inputs()[2], {1, 2});
+    ASSERT_EQ(interpreter_->AllocateTensors(), kTfLiteOk);
+
+    subgraph_test_util::FillIntTensor(
+        interpreter_->tensor(interpreter_->inputs()[1]), {5, 7});
+    subgraph_test_util::FillIntTensor(
+        interpreter_->tensor(interpreter_->inputs()[2]), {1, 2});
+    interpreter_->typed_input_tensor<bool>(0)[0] = true;
+  }
+};
+
+TEST_F(MemoryTimelineProfilerTest, RecordsOpsOfInvokedSubgraphs) {
+  MemoryTimelineProfiler profiler(*interpreter_);
+  interpreter_->AddProfiler(&profiler);
+  profiler.StartProfiling();
+  ASSERT_EQ(interpreter_->Invoke(), kTfLiteOk);
+
+  // The IF op starts before the ADD op of the branch it invokes.
+  const std::vector<OpMemoryUsage>& timeline = profiler.GetTimeline();
+  EXPECT_THAT(timeline,
+              ElementsAre(Field(&OpMemoryUsage::op_name, std::string("IF")),
+                          Field(&OpMemoryUsage::op_name, std::string("ADD"))));
+  EXPECT_EQ(timeline[0].subgraph_index, 0);
+  EXPECT_EQ(timeline[1].subgraph_index, 1);
+
+  for (const OpMemoryUsage& usage : timeline) {
+    size_t live_bytes = 0;
+    size_t high_water_bytes = 0;
+    for (const OfflineArenaAllocation& allocation :
+         profiler.GetArenaLayout(usage.subgraph_index)) {
+      if (allocation.first_node <= usage.execution_plan_index &&
+          allocation.last_node >= usage.execution_plan_index) {
+        live_bytes += allocation.size;
+        high_water_bytes =
+            std::max(high_water_bytes, allocation.offset + allocation.size);
+      }
+    }
+    EXPECT_EQ(usage.arena_live_bytes, live_bytes);
+    EXPECT_EQ(usage.arena_high_water_bytes, high_water_bytes);
+  }
+  // The bool condition, the {2} and {1, 2} int32 inputs and the {1, 2} int32
+  // output of the IF op are in the arena of the primary subgraph.
+  EXPECT_EQ(timeline[0].arena_live_bytes, 1 + 8 + 8 + 8);
+  EXPECT_EQ(timeline[0].largest_tensor_bytes, 8);
+  EXPECT_EQ(timeline[0].dynamic_bytes, 0);
+  // The inputs and the output of the branch share the buffers of the IF op.
+  EXPECT_EQ(timeline[1].arena_live_bytes, 0);
+  EXPECT_EQ(timeline[1].dynamic_bytes, 0);
+}
+
+// `cond ? a + b : pad(a, b)`, where the PAD in subgraph 2 has a dynamic
+// output, so that the output of the IF op is dynamic too.
+class DynamicMemoryTimelineProfilerTest
+    : public subgraph_test_util::ControlFlowOpTest {
+ protected:
+  void SetUp() override {
+    AddSubgraphs(2);
+    builder_->BuildAddSubgraph(interpreter_->subgraph(1));
+    builder_->BuildPadSubgraph(interpreter_->subgraph(2));
+    builder_->BuildIfSubgraph(&interpreter_->primary_subgraph());
+
+    interpreter_->ResizeInputTensor(interpreter_->inputs()[0], {1});
+    interpreter_->ResizeInputTensor(interpreter_->inputs()[1], {2});
+    interpreter_->ResizeInputTensor(interpreter_->inputs()[2], {1, 2});
+    ASSERT_EQ(interpreter_->AllocateTensors(), kTfLiteOk);
+
+    subgraph_test_util::FillIntTensor(
+        interpreter_->tensor(interpreter_->inputs()[1]), {5, 7});
+    subgraph_test_util::FillIntTensor(
+        interpreter_->tensor(interpreter_->inputs()[2]), {1, 2});
+    interpreter_->typed_input_tensor<bool>(0)[0] = false;
+  }
+};
+
+TEST_F(DynamicMemoryTimelineProfilerTest, RecordsDynamicTensors) {
+  MemoryTimelineProfiler profiler(*interpreter_);
+  interpreter_->AddProfiler(&profiler);
+  profiler.StartProfiling();
+  ASSERT_EQ(interpreter_->Invoke(), kTfLiteOk);
+
+  const std::vector<OpMemoryUsage>& timeline = profiler.GetTimeline();
+  EXPECT_THAT(timeline,
+              ElementsAre(Field(&OpMemoryUsage::op_name, std::string("IF")),
+                          Field(&OpMemoryUsage::op_name, std::string("PAD"))));
+  // Only the bool condition and the {2} and {1, 2} int32 inputs of the IF op
+  // are in the arena.
+  EXPECT_EQ(timeline[0].arena_live_bytes, 1 + 8 + 8);
+  EXPECT_EQ(timeline[0].largest_tensor_bytes, 8);
+  // Padding {5, 7} by 1 before and 2 after gives 5 int32 elements, held by
+  // the output of the PAD op and then by a copy in the output of the IF op.
+  EXPECT_EQ(timeline[0].dynamic_bytes, 5 * 4);
+  EXPECT_EQ(timeline[1].subgraph_index, 2);
+  EXPECT_EQ(timeline[1].arena_live_bytes, 0);
+  EXPECT_EQ(timeline[1].dynamic_bytes, 5 * 4);
+
+  const std::vector<SubgraphMemorySummary> summaries = profiler.GetSummaries();
+  ASSERT_EQ(summaries.size(), 2);
+  EXPECT_EQ(summaries[0].peak_live_bytes, 1 + 8 + 8);
+  EXPECT_EQ(summaries[0].peak_dynamic_bytes, 5 * 4);
+  EXPECT_EQ(summaries[1].peak_dynamic_bytes, 5 * 4);
+}
+
+TEST_F(MemoryTimelineProfilerTest, SummarizesInvokedSubgraphs) {
+  MemoryTimelineProfiler profiler(*interpreter_);
+  interpreter_->AddProfiler(&profiler);
+  profiler.StartProfiling();
+  ASSERT_EQ(interpreter_->Invoke(), kTfLiteOk);
+
+  const std::vector<SubgraphMemorySummary> summaries = profiler.GetSummaries();
+  ASSERT_EQ(summaries.size(), 2);
+  EXPECT_EQ(summaries[0].subgraph_index, 0);
+  EXPECT_EQ(summaries[0].peak_op_name, "IF");
+  EXPECT_EQ(summaries[1].subgraph_index, 1);
+  EXPECT_EQ(summaries[1].peak_op_name, "ADD");
+  for (const SubgraphMemorySummary& summary : summaries) {
+    EXPECT_LE(summary.peak_live_bytes, summary.planned_arena_bytes);
+    EXPECT_GE(summary.fragmentation, 0);
+    EXPECT_LE(summary.fragmentation, 1);
+  }
+
+  const std::string csv = profiler.GetCsvOutput();
+  EXPECT_THAT(csv, HasSubstr("Subgraph memory summary"));
+  EXPECT_THAT(csv, HasSubstr("Op memory timeline"));
+  EXPECT_THAT(csv, HasSubstr("Arena layout"));
+}
+
+TEST_F(MemoryTimelineProfilerTest, RecordsNothingUnlessProfiling) {
+  MemoryTimelineProfiler profiler(*interpreter_);
+  interpreter_->AddProfiler(&profiler);
+  ASSERT_EQ(interpreter_->Invoke(), kTfLiteOk);
+  EXPECT_THAT(profiler.GetTimeline(), IsEmpty());
+
+  profiler.StartProfiling();
+  ASSERT_EQ(interpreter_->Invoke(), kTfLiteOk);
+  profiler.StopProfiling();
+  ASSERT_EQ(interpreter_->Invoke(), kTfLiteOk);
+  EXPECT_EQ(profiler.GetTimeline().size(), 2);
+
+  profiler.Reset();
+  EXPECT_THAT(profiler.GetTimeline(), IsEmpty());
+  EXPECT_THAT(profiler.GetSummaries(), IsEmpty());
+}
+
+}  // namespace
+}  // namespace tflite::profiling
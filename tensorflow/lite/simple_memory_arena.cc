@@ -274,9 +274,27 @@ TfLiteStatus SimpleMemoryArena::Allocate(
     best_offset = AlignTo(alignment, current_offset);
   }
 
+  return AllocateAt(context, best_offset, size, tensor, first_node, last_node,
+                    new_alloc);
+}
+
+TfLiteStatus SimpleMemoryArena::AllocateAt(
+    TfLiteContext* context, size_t offset, size_t size, int32_t tensor,
+    int32_t first_node, int32_t last_node,
+    ArenaAllocWithUsageInterval* new_alloc) {
+  TF_LITE_ENSURE(context, offset <= std::numeric_limits<size_t>::max() - size);
+  new_alloc->tensor = tensor;
+  new_alloc->first_node = first_node;
+  new_alloc->last_node = last_node;
+  new_alloc->size = size;
+  if (size == 0) {
+    new_alloc->offset = 0;
+    return kTfLiteOk;
+  }
+
   // Update the required buffer size.
-  high_water_mark_ = std::max(high_water_mark_, best_offset + size);
-  new_alloc->offset = best_offset;
+  high_water_mark_ = std::max(high_water_mark_, offset + size);
+  new_alloc->offset = offset;
 
   auto insertion_it = std::upper_bound(active_allocs_.begin(),
                                        active_allocs_.end(), *new_alloc);
@@ -142,6 +142,14 @@ class SimpleMemoryArena {
                         int32_t tensor, int32_t first_node, int32_t last_node,
                         ArenaAllocWithUsageInterval* new_alloc);
 
+  // Schedules memory allocation for a tensor at a given offset, e.g. one
+  // planned ahead of time. The caller must ensure that it doesn't overlap
+  // allocations whose usage interval intersects [first_node, last_node].
+  TfLiteStatus AllocateAt(TfLiteContext* context, size_t offset, size_t size,
+                          int32_t tensor, int32_t first_node,
+                          int32_t last_node,
+                          ArenaAllocWithUsageInterval* new_alloc);
+
   TfLiteStatus Commit(bool* arena_reallocated);
 
   TfLiteStatus ResolveAlloc(TfLiteContext* context,
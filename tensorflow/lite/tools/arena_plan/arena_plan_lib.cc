@@ -0,0 +1,228 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/tools/arena_plan/arena_plan_lib.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "flatbuffers/flatbuffer_builder.h"  // from @flatbuffers
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/interpreter.h"
+#include "tensorflow/lite/core/interpreter_builder.h"
+#include "tensorflow/lite/core/subgraph.h"
+#include "tensorflow/lite/minimal_logging.h"
+#include "tensorflow/lite/model_builder.h"
+#include "tensorflow/lite/offline_arena_plan.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/util.h"
+
+namespace tflite {
+namespace {
+
+using AllocationOrder = std::function<bool(const OfflineArenaAllocation&,
+                                           const OfflineArenaAllocation&)>;
+
+size_t AlignTo(size_t alignment, size_t offset) {
+  return offset % alignment == 0 ? offset
+                                 : offset + (alignment - offset % alignment);
+}
+
+// Tensors that are never deallocated have a last node of `kNodeNotAssigned`.
+int64_t Lifetime(const OfflineArenaAllocation& alloc) {
+  return static_cast<int64_t>(alloc.last_node) - alloc.first_node + 1;
+}
+
+// Places the allocations one at a time, in the given order, into the smallest
+// gap left between the already placed allocations whose lifetimes overlap
+// theirs, or after them all.
+OfflineArenaPlan PlaceInOrder(OfflineArenaPlan allocations, size_t alignment,
+                              const AllocationOrder& order) {
+  std::stable_sort(allocations.begin(), allocations.end(), order);
+  OfflineArenaPlan placed;
+  placed.reserve(allocations.size());
+  std::vector<const OfflineArenaAllocation*> live;
+  for (OfflineArenaAllocation alloc : allocations) {
+    live.clear();
+    for (const OfflineArenaAllocation& other : placed) {
+      if (other.first_node <= alloc.last_node &&
+          alloc.first_node <= other.last_node) {
+        live.push_back(&other);
+      }
+    }
+    std::sort(live.begin(), live.end(),
+              [](const OfflineArenaAllocation* a,
+                 const OfflineArenaAllocation* b) {
+                return a->offset < b->offset;
+              });
+    size_t best_offset = std::numeric_limits<size_t>::max();
+    size_t best_gap = std::numeric_limits<size_t>::max();
+    size_t current_offset = 0;
+    for (const OfflineArenaAllocation* other : live) {
+      if (other->offset >= current_offset + alloc.size) {
+        const size_t gap = other->offset - current_offset;
+        if (gap < best_gap) {
+          best_gap = gap;
+          best_offset = current_offset;
+        }
+      }
+      current_offset = std::max(
+          current_offset, AlignTo(alignment, other->offset + other->size));
+    }
+    alloc.offset = best_offset != std::numeric_limits<size_t>::max()
+                       ? best_offset
+                       : current_offset;
+    placed.push_back(alloc);
+  }
+  return placed;
+}
+
+const Metadata* FindOfflineArenaPlanMetadata(const Model* model) {
+  if (model == nullptr || model->metadata() == nullptr) return nullptr;
+  for (const Metadata* metadata : *model->metadata()) {
+    if (metadata->name() != nullptr &&
+        metadata->name()->str() == kOfflineArenaPlanMetadataKey) {
+      return metadata;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+OfflineArenaPlan ComputeOfflineArenaPlan(const OfflineArenaPlan& allocations,
+                                         size_t alignment) {
+  if (alignment == 0) alignment = 1;
+  const AllocationOrder orders[] = {
+      // Largest first, the order ArenaPlanner uses at runtime.
+      [](const OfflineArenaAllocation& a, const OfflineArenaAllocation& b) {
+        if (a.size != b.size) return a.size > b.size;
+        return a.first_node < b.first_node;
+      },
+      // Largest footprint over the whole plan first.
+      [](const OfflineArenaAllocation& a, const OfflineArenaAllocation& b) {
+        return static_cast<uint64_t>(a.size) * Lifetime(a) >
+               static_cast<uint64_t>(b.size) * Lifetime(b);
+      },
+      // Longest lived first.
+      [](const OfflineArenaAllocation& a, const OfflineArenaAllocation& b) {
+        if (Lifetime(a) != Lifetime(b)) return Lifetime(a) > Lifetime(b);
+        return a.size > b.size;
+      },
+      // Execution order.
+      [](const OfflineArenaAllocation& a, const OfflineArenaAllocation& b) {
+        if (a.first_node != b.first_node) return a.first_node < b.first_node;
+        return a.size > b.size;
+      },
+  };
+  OfflineArenaPlan best;
+  size_t best_size = std::numeric_limits<size_t>::max();
+  if (IsValidOfflineArenaPlan(allocations, alignment)) {
+    best = allocations;
+    best_size = OfflineArenaPlanSize(allocations);
+  }
+  for (const AllocationOrder& order : orders) {
+    OfflineArenaPlan plan = PlaceInOrder(allocations, alignment, order);
+    const size_t size = OfflineArenaPlanSize(plan);
+    if (size < best_size) {
+      best = std::move(plan);
+      best_size = size;
+    }
+  }
+  // Keep the plan sorted by tensor, which makes it easier to inspect.
+  std::sort(best.begin(), best.end(),
+            [](const OfflineArenaAllocation& a,
+               const OfflineArenaAllocation& b) {
+              return a.tensor < b.tensor;
+            });
+  return best;
+}
+
+TfLiteStatus EmbedOfflineArenaPlan(const FlatBufferModel& model,
+                                   const OpResolver& resolver,
+                                   std::string* output) {
+  std::unique_ptr<Interpreter> interpreter;
+  if (InterpreterBuilder(model, resolver)(&interpreter) != kTfLiteOk ||
+      interpreter == nullptr) {
+    TFLITE_LOG(TFLITE_LOG_ERROR, "Failed to build the interpreter.");
+    return kTfLiteError;
+  }
+  if (interpreter->AllocateTensors() != kTfLiteOk) {
+    TFLITE_LOG(TFLITE_LOG_ERROR, "Failed to allocate tensors.");
+    return kTfLiteError;
+  }
+
+  std::vector<OfflineArenaPlan> plans(interpreter->subgraphs_size());
+  for (size_t i = 0; i < plans.size(); ++i) {
+    const Subgraph* subgraph = interpreter->subgraph(i);
+    const OfflineArenaPlan allocations = subgraph->GetArenaAllocations();
+    plans[i] = ComputeOfflineArenaPlan(allocations, kDefaultTensorAlignment);
+    TFLITE_LOG(TFLITE_LOG_INFO,
+               "Subgraph %zu: arena of %zu bytes planned offline, %zu bytes "
+               "at runtime.",
+               i, OfflineArenaPlanSize(plans[i]),
+               OfflineArenaPlanSize(allocations));
+  }
+  const std::string serialized_plans = SerializeOfflineArenaPlans(plans);
+
+  const Model* input_model = model.GetModel();
+  auto mutable_model = std::make_unique<ModelT>();
+  input_model->UnPackTo(mutable_model.get(), nullptr);
+  int buffer_id = mutable_model->buffers.size();
+  const Metadata* metadata = FindOfflineArenaPlanMetadata(input_model);
+  if (metadata != nullptr) {
+    buffer_id = metadata->buffer();
+  } else {
+    mutable_model->buffers.emplace_back(std::make_unique<BufferT>());
+    auto plan_metadata = std::make_unique<MetadataT>();
+    plan_metadata->buffer = buffer_id;
+    plan_metadata->name = kOfflineArenaPlanMetadataKey;
+    mutable_model->metadata.emplace_back(std::move(plan_metadata));
+  }
+  mutable_model->buffers[buffer_id]->data.assign(serialized_plans.begin(),
+                                                 serialized_plans.end());
+
+  flatbuffers::FlatBufferBuilder builder;
+  auto packed_model = Model::Pack(builder, mutable_model.get());
+  FinishModelBuffer(builder, packed_model);
+  output->assign(reinterpret_cast<const char*>(builder.GetBufferPointer()),
+                 builder.GetSize());
+  return kTfLiteOk;
+}
+
+std::vector<OfflineArenaPlan> GetOfflineArenaPlans(const Model* model) {
+  const Metadata* metadata = FindOfflineArenaPlanMetadata(model);
+  std::vector<OfflineArenaPlan> plans;
+  if (metadata == nullptr || model->buffers() == nullptr ||
+      metadata->buffer() >= model->buffers()->size()) {
+    return plans;
+  }
+  const Buffer* buffer = model->buffers()->Get(metadata->buffer());
+  if (buffer->data() == nullptr ||
+      !ParseOfflineArenaPlans(
+          reinterpret_cast<const char*>(buffer->data()->data()),
+          buffer->data()->size(), &plans)) {
+    return {};
+  }
+  return plans;
+}
+
+}  // namespace tflite
@@ -0,0 +1,55 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_TOOLS_ARENA_PLAN_ARENA_PLAN_LIB_H_
+#define TENSORFLOW_LITE_TOOLS_ARENA_PLAN_ARENA_PLAN_LIB_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/core/api/op_resolver.h"
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/model_builder.h"
+#include "tensorflow/lite/offline_arena_plan.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+
+// Computes new offsets for `allocations`, keeping their sizes and lifetimes.
+// Several placement orders are tried and the plan with the smallest arena is
+// returned; it is never larger than `allocations` itself if that is a valid
+// plan. Offsets are multiples of `alignment`.
+OfflineArenaPlan ComputeOfflineArenaPlan(const OfflineArenaPlan& allocations,
+                                         size_t alignment);
+
+// Allocates the tensors of `model` with `resolver`, computes an offline arena
+// plan for each of its subgraphs and returns a copy of the model in `output`
+// with the plans stored in its `kOfflineArenaPlanMetadataKey` metadata,
+// replacing any previous plans.
+//
+// The plans are computed for the execution plans the interpreter ends up
+// with, so `resolver` should apply the same delegates (usually none) as the
+// runtime that will load the model.
+TfLiteStatus EmbedOfflineArenaPlan(const FlatBufferModel& model,
+                                   const OpResolver& resolver,
+                                   std::string* output);
+
+// Returns the offline arena plans stored in `model`, or an empty vector if it
+// has none.
+std::vector<OfflineArenaPlan> GetOfflineArenaPlans(const Model* model);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_TOOLS_ARENA_PLAN_ARENA_PLAN_LIB_H_
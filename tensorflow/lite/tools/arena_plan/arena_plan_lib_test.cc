@@ -0,0 +1,115 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/tools/arena_plan/arena_plan_lib.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/core/interpreter.h"
+#include "tensorflow/lite/core/interpreter_builder.h"
+#include "tensorflow/lite/core/kernels/register.h"
+#include "tensorflow/lite/model_builder.h"
+#include "tensorflow/lite/offline_arena_plan.h"
+
+namespace tflite {
+namespace {
+
+OfflineArenaAllocation Alloc(int32_t tensor, int32_t first_node,
+                             int32_t last_node, size_t offset, size_t size) {
+  return {tensor, first_node, last_node, offset, size};
+}
+
+TEST(ArenaPlanLibTest, ComputesValidSmallerPlan) {
+  // A runtime plan that placed the short lived tensor 1 first, leaving a hole
+  // that tensor 2 doesn't fit in.
+  const OfflineArenaPlan allocations = {
+      Alloc(0, 0, 1, 128, 64),
+      Alloc(1, 0, 0, 0, 64),
+      Alloc(2, 1, 2, 192, 128),
+  };
+  ASSERT_TRUE(IsValidOfflineArenaPlan(allocations, 64));
+
+  const OfflineArenaPlan plan = ComputeOfflineArenaPlan(allocations, 64);
+  EXPECT_TRUE(IsValidOfflineArenaPlan(plan, 64));
+  EXPECT_EQ(OfflineArenaPlanSize(plan), 192);
+  ASSERT_EQ(plan.size(), allocations.size());
+  for (size_t i = 0; i < plan.size(); ++i) {
+    EXPECT_EQ(plan[i].tensor, allocations[i].tensor);
+    EXPECT_EQ(plan[i].first_node, allocations[i].first_node);
+    EXPECT_EQ(plan[i].last_node, allocations[i].last_node);
+    EXPECT_EQ(plan[i].size, allocations[i].size);
+  }
+}
+
+TEST(ArenaPlanLibTest, KeepsOptimalPlan) {
+  const OfflineArenaPlan allocations = {
+      Alloc(0, 0, 0, 0, 64),
+      Alloc(1, 1, 1, 0, 64),
+  };
+  const OfflineArenaPlan plan = ComputeOfflineArenaPlan(allocations, 64);
+  EXPECT_EQ(OfflineArenaPlanSize(plan), 64);
+}
+
+TEST(ArenaPlanLibTest, EmbedsPlanUsedByInterpreter) {
+  auto model = FlatBufferModel::BuildFromFile(
+      "tensorflow/lite/testdata/multi_add.bin");
+  ASSERT_NE(model, nullptr);
+  EXPECT_TRUE(GetOfflineArenaPlans(model->GetModel()).empty());
+
+  ops::builtin::BuiltinOpResolverWithoutDefaultDelegates resolver;
+  std::string output;
+  ASSERT_EQ(EmbedOfflineArenaPlan(*model, resolver, &output), kTfLiteOk);
+  auto planned_model =
+      FlatBufferModel::BuildFromBuffer(output.data(), output.size());
+  ASSERT_NE(planned_model, nullptr);
+  const std::vector<OfflineArenaPlan> plans =
+      GetOfflineArenaPlans(planned_model->GetModel());
+  ASSERT_EQ(plans.size(), 1);
+  ASSERT_FALSE(plans[0].empty());
+
+  std::unique_ptr<Interpreter> interpreter;
+  ASSERT_EQ(InterpreterBuilder(*planned_model, resolver)(&interpreter),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+  OfflineArenaPlan allocations =
+      interpreter->subgraph(0)->GetArenaAllocations();
+  std::sort(allocations.begin(), allocations.end(),
+            [](const OfflineArenaAllocation& a,
+               const OfflineArenaAllocation& b) {
+              return a.tensor < b.tensor;
+            });
+  ASSERT_EQ(allocations.size(), plans[0].size());
+  for (size_t i = 0; i < allocations.size(); ++i) {
+    EXPECT_EQ(allocations[i].tensor, plans[0][i].tensor);
+    EXPECT_EQ(allocations[i].offset, plans[0][i].offset);
+  }
+
+  // Embedding again replaces the plans rather than adding new ones.
+  std::string replanned;
+  ASSERT_EQ(EmbedOfflineArenaPlan(*planned_model, resolver, &replanned),
+            kTfLiteOk);
+  auto replanned_model =
+      FlatBufferModel::BuildFromBuffer(replanned.data(), replanned.size());
+  ASSERT_NE(replanned_model, nullptr);
+  EXPECT_EQ(replanned_model->GetModel()->metadata()->size(),
+            planned_model->GetModel()->metadata()->size());
+}
+
+}  // namespace
+}  // namespace tflite
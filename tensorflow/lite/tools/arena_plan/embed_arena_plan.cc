@@ -0,0 +1,90 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+// Binary that embeds an offline arena plan into a TFLite model.
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/kernels/register.h"
+#include "tensorflow/lite/minimal_logging.h"
+#include "tensorflow/lite/model_builder.h"
+#include "tensorflow/lite/tools/arena_plan/arena_plan_lib.h"
+#include "tensorflow/lite/tools/command_line_flags.h"
+
+namespace tflite {
+
+constexpr char kInputModelFlag[] = "input_model";
+constexpr char kOutputModelFlag[] = "output_model";
+constexpr char kUseDefaultDelegatesFlag[] = "use_default_delegates";
+
+int Main(int argc, char* argv[]) {
+  std::string input_model_path;
+  std::string output_model_path;
+  bool use_default_delegates = false;
+  std::vector<Flag> flag_list = {
+      Flag::CreateFlag(kInputModelFlag, &input_model_path,
+                       "Path to the input TFLite model."),
+      Flag::CreateFlag(kOutputModelFlag, &output_model_path,
+                       "Path to write the model with the arena plan to."),
+      Flag::CreateFlag(
+          kUseDefaultDelegatesFlag, &use_default_delegates,
+          "Whether to plan for the execution plan the default delegates (e.g. "
+          "XNNPack) produce. A plan only applies to the execution plan it was "
+          "made for, so this should match the runtime that loads the model: "
+          "without it, the plan is ignored by interpreters that apply the "
+          "default delegates, and with it, by those that do not."),
+  };
+  if (!Flags::Parse(&argc, const_cast<const char**>(argv), flag_list) ||
+      input_model_path.empty() || output_model_path.empty()) {
+    TFLITE_LOG(TFLITE_LOG_ERROR, "%s",
+               Flags::Usage(argv[0], flag_list).c_str());
+    return 1;
+  }
+
+  auto model = FlatBufferModel::BuildFromFile(input_model_path.c_str());
+  if (model == nullptr) {
+    TFLITE_LOG(TFLITE_LOG_ERROR, "Failed to load %s.",
+               input_model_path.c_str());
+    return 1;
+  }
+
+  std::string output;
+  TfLiteStatus status;
+  if (use_default_delegates) {
+    ops::builtin::BuiltinOpResolver resolver;
+    status = EmbedOfflineArenaPlan(*model, resolver, &output);
+  } else {
+    // Without delegates, the plan is made for the execution plan the
+    // interpreter also falls back to when a delegate rejects the model.
+    ops::builtin::BuiltinOpResolverWithoutDefaultDelegates resolver;
+    status = EmbedOfflineArenaPlan(*model, resolver, &output);
+  }
+  if (status != kTfLiteOk) return 1;
+
+  std::ofstream output_file(output_model_path, std::ios::binary);
+  output_file.write(output.data(), output.size());
+  if (!output_file.flush()) {
+    TFLITE_LOG(TFLITE_LOG_ERROR, "Failed to write %s.",
+               output_model_path.c_str());
+    return 1;
+  }
+  return 0;
+}
+
+}  // namespace tflite
+
+int main(int argc, char* argv[]) { return tflite::Main(argc, argv); }
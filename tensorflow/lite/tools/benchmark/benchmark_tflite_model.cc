@@ -50,8 +50,10 @@ limitations under the License.
 #include "tensorflow/lite/core/subgraph.h"
 #include "tensorflow/lite/interpreter.h"
 #include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/packed_weight_cache.h"
 #include "tensorflow/lite/op_resolver.h"
 #include "tensorflow/lite/optional_debug_tools.h"
+#include "tensorflow/lite/profiling/memory_timeline_profiler.h"
 #include "tensorflow/lite/profiling/model_runtime_info.h"
 #include "tensorflow/lite/profiling/profile_summary_formatter.h"
 #include "tensorflow/lite/string_util.h"
@@ -264,6 +266,48 @@ class ModelRuntimeInfoListener : public BenchmarkListener {
   Interpreter* const interpreter_ = nullptr;  // not own the memory.
 };
 
+// Records the memory timeline of an extra run after the benchmark runs when
+// enable_memory_timeline is set to true. Invocations with a profiler attached
+// run their ops sequentially, so the profiler is only attached for that run.
+class MemoryTimelineListener : public BenchmarkListener {
+ public:
+  MemoryTimelineListener(Interpreter* interpreter,
+                         BenchmarkInterpreterRunner* runner)
+      : interpreter_(interpreter), runner_(runner), profiler_(*interpreter) {}
+
+  void OnBenchmarkStart(const BenchmarkParams& params) override {
+    output_file_path_ = params.Get<std::string>("memory_timeline_output_file");
+  }
+
+  void OnBenchmarkEnd(const BenchmarkResults& results) override {
+    interpreter_->AddProfiler(&profiler_);
+    profiler_.StartProfiling();
+    const TfLiteStatus status = runner_->Invoke();
+    profiler_.StopProfiling();
+    if (status != kTfLiteOk) {
+      TFLITE_LOG(ERROR) << "Failed to record the memory timeline.";
+      return;
+    }
+    const std::string output = profiler_.GetCsvOutput();
+    if (output_file_path_.empty()) {
+      TFLITE_LOG(INFO) << "Memory timeline:\n" << output;
+      return;
+    }
+    std::ofstream output_file(output_file_path_);
+    output_file << output;
+    if (!output_file.good()) {
+      TFLITE_LOG(ERROR) << "Failed to write the memory timeline to "
+                        << output_file_path_;
+    }
+  }
+
+ private:
+  Interpreter* const interpreter_;             // not own the memory.
+  BenchmarkInterpreterRunner* const runner_;  // not own the memory.
+  profiling::MemoryTimelineProfiler profiler_;
+  std::string output_file_path_;
+};
+
 std::vector<std::string> Split(const std::string& str, const char delim) {
   if (str.empty()) {
     return {};
@@ -599,6 +643,10 @@ BenchmarkParams BenchmarkTfLiteModel::DefaultParams() {
                           BenchmarkParam::Create<bool>(false));
   default_params.AddParam("model_runtime_info_output_file",
                           BenchmarkParam::Create<std::string>(""));
+  default_params.AddParam("enable_memory_timeline",
+                          BenchmarkParam::Create<bool>(false));
+  default_params.AddParam("memory_timeline_output_file",
+                          BenchmarkParam::Create<std::string>(""));
   default_params.AddParam("print_preinvoke_state",
                           BenchmarkParam::Create<bool>(false));
   default_params.AddParam("print_postinvoke_state",
@@ -611,6 +659,10 @@ BenchmarkParams BenchmarkTfLiteModel::DefaultParams() {
                           BenchmarkParam::Create<bool>(false));
   default_params.AddParam("enable_builtin_cast_constant_cache",
                           BenchmarkParam::Create<bool>(false));
+  default_params.AddParam("num_inter_op_threads",
+                          BenchmarkParam::Create<int32_t>(1));
+  default_params.AddParam("packed_weight_cache_dir",
+                          BenchmarkParam::Create<std::string>(""));
   default_params.AddParam("output_filepath",
                           BenchmarkParam::Create<std::string>(""));
   default_params.AddParam("output_proto_filepath",
@@ -699,6 +751,14 @@ std::vector<Flag> BenchmarkTfLiteModel::GetFlags() {
                        "Enable Model Runtime Info Export"),
       CreateFlag<std::string>("model_runtime_info_output_file", &params_,
                               "Proto File to export model runtime info to"),
+      CreateFlag<bool>("enable_memory_timeline", &params_,
+                       "Record the arena tensors live at each op and the "
+                       "dynamic allocations made by each op during an extra "
+                       "run after the benchmark runs, and report them with a "
+                       "per-subgraph fragmentation summary."),
+      CreateFlag<std::string>("memory_timeline_output_file", &params_,
+                              "CSV file to write the memory timeline to, if "
+                              "not set prints to stdout."),
       CreateFlag<bool>(
           "print_preinvoke_state", &params_,
           "print out the interpreter internals just before calling Invoke. The "
@@ -720,6 +780,12 @@ std::vector<Flag> BenchmarkTfLiteModel::GetFlags() {
           "enable_builtin_cast_constant_cache", &params_,
           "Cache the output of the builtin cast operation when its input "
           "is a constant tensor."),
+      CreateFlag<int32_t>(
+          "num_inter_op_threads", &params_,
+          "Number of threads used to run independent ops concurrently."),
+      CreateFlag<std::string>(
+          "packed_weight_cache_dir", &params_,
+          "Directory in which builtin kernels persist their packed weights."),
       CreateFlag<std::string>(
           "output_filepath", &params_,
           "File path to export outputs layer as binary data."),
@@ -794,6 +860,10 @@ void BenchmarkTfLiteModel::LogParams() {
                       "Enable Model Runtime Info Export", verbose);
   LOG_BENCHMARK_PARAM(std::string, "model_runtime_info_output_file",
                       "Proto File to export model runtime info to", verbose);
+  LOG_BENCHMARK_PARAM(bool, "enable_memory_timeline",
+                      "Enable memory timeline", verbose);
+  LOG_BENCHMARK_PARAM(std::string, "memory_timeline_output_file",
+                      "Memory timeline output file", verbose);
   LOG_BENCHMARK_PARAM(bool, "print_preinvoke_state",
                       "Print pre-invoke interpreter state", verbose);
   LOG_BENCHMARK_PARAM(bool, "print_postinvoke_state",
@@ -806,6 +876,10 @@ void BenchmarkTfLiteModel::LogParams() {
                       "Disable delegate clustering", verbose);
   LOG_BENCHMARK_PARAM(bool, "enable_builtin_cast_constant_cache",
                       "Constant CAST output cache", verbose);
+  LOG_BENCHMARK_PARAM(int32_t, "num_inter_op_threads", "Num inter-op threads",
+                      verbose);
+  LOG_BENCHMARK_PARAM(std::string, "packed_weight_cache_dir",
+                      "Packed weight cache directory", verbose);
   LOG_BENCHMARK_PARAM(std::string, "output_filepath",
                       "File path to export outputs layer to", verbose);
   LOG_BENCHMARK_PARAM(std::string, "output_proto_filepath",
@@ -1035,6 +1109,9 @@ TfLiteStatus BenchmarkTfLiteModel::InitInterpreter() {
       params_.Get<bool>("disable_delegate_clustering"));
   options.SetCacheConstantCastOp(
       params_.Get<bool>("enable_builtin_cast_constant_cache"));
+  options.SetNumInterOpThreads(params_.Get<int32_t>("num_inter_op_threads"));
+  PackedWeightCache::Get().SetDirectory(
+      params_.Get<std::string>("packed_weight_cache_dir"));
 
   tflite::InterpreterBuilder builder(*model_, *resolver, &options);
   if (builder.SetNumThreads(num_threads) != kTfLiteOk) {
@@ -1115,6 +1192,12 @@ TfLiteStatus BenchmarkTfLiteModel::Init() {
   TF_LITE_ENSURE_STATUS(status_and_runner.first);
   interpreter_runner_ = std::move(status_and_runner.second);
 
+  if (params_.Get<bool>("enable_memory_timeline")) {
+    AddOwnedListener(std::unique_ptr<BenchmarkListener>(
+        new MemoryTimelineListener(interpreter_.get(),
+                                   interpreter_runner_.get())));
+  }
+
   const std::vector<int>& runner_inputs = interpreter_runner_->inputs();
 
   if (!inputs_.empty()) {
@@ -50,6 +50,8 @@ struct ThreadPoolDevice;
 
 namespace xla::cpu {
 
+class ThunkProfiler;
+
 // WARNING: This is under construction. Long term plan for XLA is to unify
 // runtimes between different backends and have a shared Thunk interface,
 // however for now we chose to have separate Thunk implementations in xla::cpu
@@ -94,6 +96,9 @@ class Thunk {
     std::string op_name;
     std::string module_name;
     int64_t module_id;
+    // Estimated execution time in nanoseconds (see ThunkEmitter). Zero if the
+    // thunk has no cost estimate.
+    int64_t cost = 0;
   };
 
   using Task = std::function<void()>;
@@ -292,6 +297,8 @@ class Thunk {
     TaskRunner* task_runner = nullptr;
     CollectiveExecuteParams* collective_params = nullptr;
     CustomCallExecuteParams* custom_call_params = nullptr;
+    // If set, thunk executors record the execution of every thunk.
+    ThunkProfiler* profiler = nullptr;
     ExecuteSession session = ExecuteSession(ExecuteSession::kMaxWorkers,
                                             ExecuteSession::kSplitThreshold);
   };
@@ -15,10 +15,12 @@ limitations under the License.
 
 #include "xla/backends/cpu/runtime/thunk_executor.h"
 
+#include <algorithm>
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -34,6 +36,7 @@ limitations under the License.
 #include "absl/types/span.h"
 #include "xla/backends/cpu/runtime/resource_use.h"
 #include "xla/backends/cpu/runtime/thunk.h"
+#include "xla/backends/cpu/runtime/thunk_profiler.h"
 #include "xla/runtime/buffer_use.h"
 #include "xla/tsl/concurrency/async_value_ref.h"
 #include "tsl/platform/logging.h"
@@ -48,7 +51,8 @@ ThunkExecutor::ThunkExecutor(ThunkSequence thunk_sequence,
       options_(options),
       num_thunks_(thunk_sequence_.size()),
       nodes_defs_(std::move(nodes_defs)),
-      is_sequential_(true) {
+      is_sequential_(true),
+      use_priority_ready_queue_(options.use_priority_ready_queue) {
   for (NodeId i = 0; i < nodes_defs_.size(); ++i) {
     // Mark nodes with empty in-edges as source nodes.
     if (nodes_defs_[i].in_edges.empty()) {
@@ -84,11 +88,22 @@ ThunkExecutor::ThunkExecutor(ThunkSequence thunk_sequence,
   is_sequential_ |=
       thunk_sequence_.size() <= options.execute_sequential_num_thunks_threshold;
 
+  // Prefer executing nodes on the critical path first if we have cost
+  // estimates and enough nodes can execute concurrently to compete for
+  // threads.
+  bool has_cost_estimates = UpdateCriticalPathPriorities();
+  int64_t width = Width();
+  use_priority_ready_queue_ |=
+      has_cost_estimates &&
+      width >= options.priority_ready_queue_width_threshold;
+
   VLOG(2) << absl::StreamFormat(
       "Constructed ThunkExecutor with %d nodes: #source_nodes=%d "
-      "#sink_nodes=%d, #erased_edges=%d, is_sequential=%v, small_buffers=%v",
+      "#sink_nodes=%d, #erased_edges=%d, is_sequential=%v, small_buffers=%v, "
+      "width=%d, has_cost_estimates=%v, use_priority_ready_queue=%v",
       nodes_defs_.size(), source_.size(), sink_.size(), num_erased_edges,
-      is_sequential_, small_buffers);
+      is_sequential_, small_buffers, width, has_cost_estimates,
+      use_priority_ready_queue_);
 
   // Sanity check that all vectors are empty or all vectors are non-empty.
   DCHECK((!source_.empty() && !sink_.empty() && !thunk_sequence_.empty()) ||
@@ -138,10 +153,14 @@ ThunkExecutor::ExecuteState::Node::Node(const NodeDef& node_def)
     : counter(node_def.in_edges.size()), out_edges(&node_def.out_edges) {}
 
 ThunkExecutor::ExecuteState::ExecuteState(ThunkExecutor* executor,
-                                          Thunk::TaskRunner* runner)
+                                          Thunk::TaskRunner* runner,
+                                          ThunkProfiler* profiler)
     : executor(executor),
       runner(runner),
+      profiler(profiler),
       nodes(executor->nodes_defs().size()),
+      ready_ns(profiler ? nodes.size() : 0,
+               profiler ? ThunkProfiler::Now() : 0),
       execute_event(tsl::MakeConstructedAsyncValueRef<ExecuteEvent>()),
       pending_sink_nodes(executor->sink().size()),
       abort(false) {
@@ -157,7 +176,7 @@ tsl::AsyncValueRef<ThunkExecutor::ExecuteEvent> ThunkExecutor::Execute(
   if (ABSL_PREDICT_FALSE(num_thunks_ == 0)) {
     return Thunk::OkExecuteEventSingleton();
   }
-  if (ABSL_PREDICT_FALSE(num_thunks_ == 1)) {
+  if (ABSL_PREDICT_FALSE(num_thunks_ == 1 && params.profiler == nullptr)) {
     return thunk_sequence_[0]->Execute(params);
   }
 
@@ -170,14 +189,15 @@ tsl::AsyncValueRef<ThunkExecutor::ExecuteEvent> ThunkExecutor::Execute(
   }
 
   // Create async execution state on heap and kick-off execution.
-  auto state = std::make_unique<ExecuteState>(this, params.task_runner);
+  auto state = std::make_unique<ExecuteState>(this, params.task_runner,
+                                              params.profiler);
 
   // When we kick-off execution we don't have to grab the session lock, as the
   // main thread is not counted towards the number of concurrent workers limit.
   // This also works for thunks with nested thunk executors (i.e., WhileThunk),
   // as launching nested thunk sequence must not reduce the available
   // concurrency for the other thunks executing in parallel.
-  if (options_.use_priority_ready_queue) {
+  if (use_priority_ready_queue_) {
     Execute(state.get(), params, PriorityReadyQueue(nodes_defs_, source_),
             /*lock=*/nullptr);
   } else {
@@ -204,14 +224,45 @@ tsl::AsyncValueRef<ThunkExecutor::ExecuteEvent> ThunkExecutor::Execute(
   return execute_event;
 }
 
+// Returns the id of the task runner worker running the caller, if any.
+static std::optional<int64_t> CurrentWorkerId(
+    const Thunk::ExecuteParams& params) {
+  return params.task_runner ? params.task_runner->current_worker_id()
+                            : std::nullopt;
+}
+
+// Records a sequentially executed thunk that finished just now, and returns
+// the time it finished, i.e. when the next thunk became ready.
+static int64_t RecordSequential(const Thunk::ExecuteParams& params,
+                                const Thunk& thunk,
+                                std::optional<int64_t> worker_id,
+                                int64_t ready_ns, int64_t start_ns) {
+  int64_t end_ns = ThunkProfiler::Now();
+  params.profiler->Record(thunk, worker_id, ready_ns, start_ns, end_ns);
+  return end_ns;
+}
+
 tsl::AsyncValueRef<ThunkExecutor::ExecuteEvent>
 ThunkExecutor::ExecuteSequential(const Thunk::ExecuteParams& params) {
+  ThunkProfiler* profiler = params.profiler;
+  std::optional<int64_t> worker_id;
+  int64_t ready_ns = 0, start_ns = 0;
+  if (ABSL_PREDICT_FALSE(profiler)) {
+    worker_id = CurrentWorkerId(params);
+    ready_ns = ThunkProfiler::Now();
+  }
+
   for (auto it = thunk_sequence_.begin(); it != thunk_sequence_.end(); ++it) {
     Thunk& thunk = **it;
+    if (ABSL_PREDICT_FALSE(profiler)) start_ns = ThunkProfiler::Now();
     auto execute_event = thunk.Execute(params);
 
     // Fast path for thunks executed inline and returned OkExecuteEvent.
     if (ABSL_PREDICT_TRUE(thunk.IsOkExecuteEvent(execute_event))) {
+      if (ABSL_PREDICT_FALSE(profiler)) {
+        ready_ns =
+            RecordSequential(params, thunk, worker_id, ready_ns, start_ns);
+      }
       continue;
     }
 
@@ -219,8 +270,12 @@ ThunkExecutor::ExecuteSequential(const Thunk::ExecuteParams& params) {
     // resume sequential execution starting from the next thunk.
     if (ABSL_PREDICT_FALSE(!execute_event.IsAvailable())) {
       auto event = tsl::MakeConstructedAsyncValueRef<ExecuteEvent>();
-      execute_event.AndThen([this, &params, it, event](absl::Status status) {
+      execute_event.AndThen([this, &params, it, event, worker_id, ready_ns,
+                             start_ns](absl::Status status) {
         Thunk::TaskRunner* runner = params.task_runner;
+        if (ABSL_PREDICT_FALSE(params.profiler)) {
+          RecordSequential(params, **it, worker_id, ready_ns, start_ns);
+        }
 
         if (ABSL_PREDICT_FALSE(!status.ok())) {
           event.SetError(std::move(status));
@@ -238,6 +293,10 @@ ThunkExecutor::ExecuteSequential(const Thunk::ExecuteParams& params) {
       return event;
     }
 
+    if (ABSL_PREDICT_FALSE(profiler)) {
+      ready_ns = RecordSequential(params, thunk, worker_id, ready_ns, start_ns);
+    }
+
     // Abort execution if any of the thunks failed.
     if (ABSL_PREDICT_FALSE(execute_event.IsError())) {
       return execute_event;
@@ -252,12 +311,25 @@ ThunkExecutor::ExecuteSequential(const Thunk::ExecuteParams& params) {
 void ThunkExecutor::ResumeExecuteSequential(
     ThunkIterator it, const Thunk::ExecuteParams& params,
     tsl::AsyncValueRef<ExecuteEvent> event) {
+  ThunkProfiler* profiler = params.profiler;
+  std::optional<int64_t> worker_id;
+  int64_t ready_ns = 0, start_ns = 0;
+  if (ABSL_PREDICT_FALSE(profiler)) {
+    worker_id = CurrentWorkerId(params);
+    ready_ns = ThunkProfiler::Now();
+  }
+
   for (; it != thunk_sequence_.end(); ++it) {
     Thunk& thunk = **it;
+    if (ABSL_PREDICT_FALSE(profiler)) start_ns = ThunkProfiler::Now();
     auto execute_event = thunk.Execute(params);
 
     // Fast path for thunks executed inline and returned OkExecuteEvent.
     if (ABSL_PREDICT_TRUE(thunk.IsOkExecuteEvent(execute_event))) {
+      if (ABSL_PREDICT_FALSE(profiler)) {
+        ready_ns =
+            RecordSequential(params, thunk, worker_id, ready_ns, start_ns);
+      }
       continue;
     }
 
@@ -265,8 +337,12 @@ void ThunkExecutor::ResumeExecuteSequential(
     // resume sequential execution starting from the next thunk.
     if (ABSL_PREDICT_FALSE(!execute_event.IsAvailable())) {
       execute_event.AndThen(
-          [this, &params, it, event = std::move(event)](absl::Status status) {
+          [this, &params, it, event = std::move(event), worker_id, ready_ns,
+           start_ns](absl::Status status) {
             Thunk::TaskRunner* runner = params.task_runner;
+            if (ABSL_PREDICT_FALSE(params.profiler)) {
+              RecordSequential(params, **it, worker_id, ready_ns, start_ns);
+            }
 
             if (ABSL_PREDICT_FALSE(!status.ok())) {
               event.SetError(std::move(status));
@@ -284,6 +360,10 @@ void ThunkExecutor::ResumeExecuteSequential(
       return;
     }
 
+    if (ABSL_PREDICT_FALSE(profiler)) {
+      ready_ns = RecordSequential(params, thunk, worker_id, ready_ns, start_ns);
+    }
+
     // Abort execution if any of the thunks failed.
     if (ABSL_PREDICT_FALSE(execute_event.IsError())) {
       event.SetError(execute_event.GetError());
@@ -329,15 +409,28 @@ void ThunkExecutor::Execute(ExecuteState* state,
       SplitReadyQueue(state, params, ready_queue, split_threshold);
     }
 
+    // Record where and when the thunk starts executing if profiling.
+    std::optional<int64_t> worker_id;
+    int64_t start_ns = 0;
+    if (ABSL_PREDICT_FALSE(state->profiler)) {
+      worker_id = CurrentWorkerId(params);
+      start_ns = ThunkProfiler::Now();
+    }
+
     // Execute thunk for the given node id. If execution is aborted, we keep
     // processing the nodes DAG without executing thunks.
     Thunk& thunk = *state->executor->thunk_sequence_[id];
+    bool aborted = state->abort.load(std::memory_order_relaxed);
     tsl::AsyncValueRef<ExecuteEvent> execute_event =
-        ABSL_PREDICT_FALSE(state->abort.load(std::memory_order_relaxed))
-            ? Thunk::OkExecuteEventSingleton()
-            : thunk.Execute(params);
+        ABSL_PREDICT_FALSE(aborted) ? Thunk::OkExecuteEventSingleton()
+                                    : thunk.Execute(params);
 
     if (ABSL_PREDICT_TRUE(execute_event.IsAvailable())) {
+      if (ABSL_PREDICT_FALSE(state->profiler && !aborted)) {
+        state->profiler->Record(thunk, worker_id, state->ready_ns[id],
+                                start_ns, ThunkProfiler::Now());
+      }
+
       // If thunk execution is completed, process out edges in the current
       // thread and keep working on the ready queue.
       ProcessOutEdges(state, execute_event.AsPtr(), node, ready_queue);
@@ -354,10 +447,18 @@ void ThunkExecutor::Execute(ExecuteState* state,
       // queue, we will forward the lock that we already hold (note that the
       // lock might be empty, if `Execute` was called by the main thread).
       execute_event.AndThen(
-          [&params, &node, state, execute_event = execute_event.AsPtr(),
+          [&params, &node, &thunk, state, id, worker_id, start_ns,
+           execute_event = execute_event.AsPtr(),
            ready_queue = ready_queue.CreateEmptyReadyQueue(),
            lock = ready_queue.Empty() ? std::move(lock)
                                       : params.session.Join()]() mutable {
+            // Record the thunk before processing out edges, as it might
+            // complete the execution and destroy the `state`.
+            if (ABSL_PREDICT_FALSE(state->profiler)) {
+              state->profiler->Record(thunk, worker_id, state->ready_ns[id],
+                                      start_ns, ThunkProfiler::Now());
+            }
+
             state->executor->ProcessOutEdges(state, execute_event, node,
                                              ready_queue);
 
@@ -439,7 +540,12 @@ void ThunkExecutor::ProcessOutEdges(
 
     int64_t cnt = out_node.counter.fetch_sub(1, std::memory_order_release);
     DCHECK_GE(cnt, 1) << "Node counter can't drop below 0";
-    if (cnt == 1) ready_queue.Push(out_edge);
+    if (cnt == 1) {
+      if (ABSL_PREDICT_FALSE(state->profiler)) {
+        state->ready_ns[out_edge] = ThunkProfiler::Now();
+      }
+      ready_queue.Push(out_edge);
+    }
   }
 
   // Drop the pending sink nodes counter if the node is a sink.
@@ -564,6 +670,42 @@ int64_t ThunkExecutor::RunTransitiveReductionAndUpdatePriorities() {
   return num_erased_edges;
 }
 
+bool ThunkExecutor::UpdateCriticalPathPriorities() {
+  bool has_cost_estimates =
+      absl::c_any_of(thunk_sequence_, [](const std::unique_ptr<Thunk>& thunk) {
+        return thunk->info().cost > 0;
+      });
+  if (!has_cost_estimates) return false;
+
+  // Out edges always point to nodes later in the sequence, so in reverse order
+  // we visit all out nodes before the node itself.
+  for (int64_t i = nodes_defs_.size() - 1; i >= 0; --i) {
+    NodeDef& node = nodes_defs_[i];
+    int64_t downstream_cost = 0;
+    for (NodeId out_id : node.out_edges) {
+      downstream_cost = std::max(downstream_cost, nodes_defs_[out_id].priority);
+    }
+    node.priority = thunk_sequence_[i]->info().cost + downstream_cost;
+  }
+  return true;
+}
+
+int64_t ThunkExecutor::Width() const {
+  std::vector<int64_t> depth(nodes_defs_.size(), 0);
+  std::vector<int64_t> num_nodes_at_depth;
+  for (NodeId i = 0; i < nodes_defs_.size(); ++i) {
+    for (NodeId in_id : nodes_defs_[i].in_edges) {
+      depth[i] = std::max(depth[i], depth[in_id] + 1);
+    }
+    if (depth[i] >= num_nodes_at_depth.size()) {
+      num_nodes_at_depth.resize(depth[i] + 1, 0);
+    }
+    ++num_nodes_at_depth[depth[i]];
+  }
+  return num_nodes_at_depth.empty() ? 0
+                                    : *absl::c_max_element(num_nodes_at_depth);
+}
+
 std::string ThunkExecutor::ToString() const {
   std::string str = absl::StrFormat(
       "ThunkExecutor: #thunks=%d #source_nodes=%d #sink_nodes=%d", num_thunks_,
@@ -55,6 +55,12 @@ struct ThunkExecutorOptions {
   // Use priority ready queue to execute nodes according to their priority. By
   // default we use FIFO ready queue.
   bool use_priority_ready_queue = false;
+
+  // If thunks have cost estimates, node priorities are the estimated cost of
+  // the critical path from the node to a sink, and we use the priority ready
+  // queue if at least this many nodes can execute concurrently (have the same
+  // depth in the DAG). For narrow DAGs the order of ready nodes hardly matters.
+  size_t priority_ready_queue_width_threshold = 4;
 };
 }  // namespace internal
 
@@ -107,6 +113,7 @@ class ThunkExecutor {
   std::string ToString() const;
 
   bool is_sequential() const { return is_sequential_; }
+  bool use_priority_ready_queue() const { return use_priority_ready_queue_; }
 
   // A ready queue that executes nodes in FIFO order.
   class FifoReadyQueue {
@@ -187,14 +194,19 @@ class ThunkExecutor {
     // memory and do not pay the cost of default initializing all nodes.
     using NodeStorage = std::aligned_storage_t<sizeof(Node), alignof(Node)>;
 
-    ExecuteState(ThunkExecutor* executor, Thunk::TaskRunner* runner);
+    ExecuteState(ThunkExecutor* executor, Thunk::TaskRunner* runner,
+                 ThunkProfiler* profiler);
 
     Node& node(NodeId id) { return *reinterpret_cast<Node*>(&nodes[id]); }
 
     ThunkExecutor* executor;
     Thunk::TaskRunner* runner;
+    ThunkProfiler* profiler;
 
     absl::FixedArray<NodeStorage> nodes;
+
+    // If profiling, the time each node became ready to execute.
+    absl::FixedArray<int64_t> ready_ns;
     tsl::AsyncValueRef<ExecuteEvent> execute_event;
 
     // Once the number of pending sink nodes drops to zero, the execution is
@@ -246,6 +258,15 @@ class ThunkExecutor {
   // See: https://en.wikipedia.org/wiki/Transitive_reduction
   int64_t RunTransitiveReductionAndUpdatePriorities();
 
+  // Updates nodes priorities to the estimated cost of the longest path from
+  // the node to a sink. Returns false and keeps the priorities unchanged if
+  // thunks don't have cost estimates.
+  bool UpdateCriticalPathPriorities();
+
+  // Returns the largest number of nodes that have the same depth, i.e. the
+  // same longest path from a source node.
+  int64_t Width() const;
+
   ThunkSequence thunk_sequence_;
   Options options_;
 
@@ -260,6 +281,9 @@ class ThunkExecutor {
   // opportunities for executing thunks concurrently, we skip the expensive
   // async execution and simply run thunks in the `thunk_sequence_` one by one.
   bool is_sequential_;
+
+  // Whether to execute ready nodes in priority order instead of FIFO order.
+  bool use_priority_ready_queue_;
 };
 
 }  // namespace xla::cpu
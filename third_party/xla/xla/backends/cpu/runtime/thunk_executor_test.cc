@@ -20,6 +20,7 @@ limitations under the License.
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <memory>
 #include <optional>
 #include <random>
@@ -29,13 +30,18 @@ limitations under the License.
 #include <vector>
 
 #include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "xla/backends/cpu/runtime/buffer_allocations.h"
 #include "xla/backends/cpu/runtime/resource_use.h"
 #include "xla/backends/cpu/runtime/thread_pool_task_runner.h"
 #include "xla/backends/cpu/runtime/thunk.h"
+#include "xla/backends/cpu/runtime/thunk_profiler.h"
 #include "xla/runtime/buffer_use.h"
 #include "xla/service/buffer_assignment.h"
 #include "xla/service/maybe_owning_device_memory.h"
@@ -512,6 +518,57 @@ TEST(ThunkExecutorTest, Execute) {
                                 2, 2, 2, 2, 2));               // slice1
 }
 
+TEST(ThunkExecutorTest, ExecuteWithProfiler) {
+  BufferAllocation alloc(/*index=*/0, /*size=*/80, /*color=*/0);
+
+  BufferAllocation::Slice slice0(&alloc, /*offset=*/0, /*size=*/40);
+  BufferAllocation::Slice slice1(&alloc, /*offset=*/40, /*size=*/40);
+  BufferAllocation::Slice slice2(&alloc, /*offset=*/20, /*size=*/40);
+
+  ThunkSequence sequence;
+  sequence.push_back(AddI32Thunk::Create("a", {slice0}, {slice0}));
+  sequence.push_back(AddI32Thunk::Create("b", {slice1}, {slice1}));
+  sequence.push_back(AddI32Thunk::Create("c", {slice2}, {slice2}));
+
+  TF_ASSERT_OK_AND_ASSIGN(
+      ThunkExecutor executor,
+      ThunkExecutor::Create(std::move(sequence), OptionsForTest()));
+
+  std::vector<int32_t> data(20, 1);  // shared src and dst allocation
+
+  auto buffers = AsDeviceMemory<int32_t>({&data});
+  BufferAllocations allocations(buffers);
+
+  auto task_runner = MakeTaskRunnerFrom([&](Thunk::Task task) { task(); },
+                                        // Always return current worker id as 0.
+                                        [] { return 0; });
+
+  ThunkProfiler profiler;
+  Thunk::ExecuteParams params = {nullptr, &allocations};
+  params.task_runner = &task_runner;
+  params.profiler = &profiler;
+
+  auto execute_event = executor.Execute(params);
+
+  tsl::BlockUntilReady(execute_event);
+  ASSERT_TRUE(execute_event.IsConcrete());
+
+  std::vector<ThunkProfiler::Event> events = profiler.events();
+  ASSERT_EQ(events.size(), 3);
+
+  absl::flat_hash_map<absl::string_view, ThunkProfiler::Event> by_name;
+  for (const ThunkProfiler::Event& event : events) {
+    EXPECT_LE(event.ready_ns, event.start_ns);
+    EXPECT_LE(event.start_ns, event.end_ns);
+    by_name.emplace(event.op_name, event);
+  }
+
+  // `c` becomes ready once both `a` and `b` have completed.
+  ASSERT_TRUE(by_name.contains("c"));
+  EXPECT_GE(by_name.at("c").ready_ns, by_name.at("a").end_ns);
+  EXPECT_GE(by_name.at("c").ready_ns, by_name.at("b").end_ns);
+}
+
 //===----------------------------------------------------------------------===//
 // ThunkExecutor resource isolation testing
 //===----------------------------------------------------------------------===//
@@ -601,6 +658,94 @@ TEST(ThunkExecutorTest, ExecuteOnCorrectThreadPool) {
   EXPECT_GE(num_tasks, 90);
 }
 
+//===----------------------------------------------------------------------===//
+// ThunkExecutor critical path priorities
+//===----------------------------------------------------------------------===//
+
+// A thunk with a cost estimate that writes to `slice` and busy-waits for the
+// estimated time, to simulate kernels of known cost.
+class BusyThunk final : public Thunk {
+ public:
+  BusyThunk(std::string name, BufferAllocation::Slice slice, int64_t cost_ns)
+      : Thunk(Kind::kKernel, Info{std::move(name), /*module_name=*/"",
+                                  /*module_id=*/0, cost_ns}),
+        slice_(slice) {}
+
+  static std::unique_ptr<BusyThunk> Create(std::string name,
+                                           BufferAllocation::Slice slice,
+                                           int64_t cost_ns) {
+    return std::make_unique<BusyThunk>(std::move(name), slice, cost_ns);
+  }
+
+  tsl::AsyncValueRef<ExecuteEvent> Execute(const ExecuteParams&) final {
+    absl::Time deadline = absl::Now() + absl::Nanoseconds(info().cost);
+    while (absl::Now() < deadline) {
+    }
+    return OkExecuteEvent();
+  }
+
+  BufferUses buffer_uses() const final {
+    return BufferUses{BufferUse::Write(slice_)};
+  }
+
+ private:
+  BufferAllocation::Slice slice_;
+};
+
+TEST(ThunkExecutorTest, CriticalPathPriorities) {
+  BufferAllocation alloc(/*index=*/0, /*size=*/60, /*color=*/0);
+
+  BufferAllocation::Slice slice0(&alloc, /*offset=*/0, /*size=*/20);
+  BufferAllocation::Slice slice1(&alloc, /*offset=*/20, /*size=*/20);
+  BufferAllocation::Slice slice2(&alloc, /*offset=*/40, /*size=*/20);
+
+  // `b` and `c` write to the same slice and form a chain.
+  ThunkSequence sequence;
+  sequence.push_back(BusyThunk::Create("a", slice0, /*cost_ns=*/10));
+  sequence.push_back(BusyThunk::Create("b", slice1, /*cost_ns=*/1));
+  sequence.push_back(BusyThunk::Create("c", slice1, /*cost_ns=*/5));
+  sequence.push_back(BusyThunk::Create("d", slice2, /*cost_ns=*/1));
+
+  ThunkExecutor::Options options = OptionsForTest();
+  TF_ASSERT_OK_AND_ASSIGN(ThunkExecutor executor,
+                          ThunkExecutor::Create(std::move(sequence), options));
+
+  EXPECT_EQ(executor.node_def(0).priority, 10);
+  EXPECT_EQ(executor.node_def(1).priority, 6);
+  EXPECT_EQ(executor.node_def(2).priority, 5);
+  EXPECT_EQ(executor.node_def(3).priority, 1);
+
+  // Only three thunks can execute concurrently.
+  EXPECT_FALSE(executor.use_priority_ready_queue());
+}
+
+TEST(ThunkExecutorTest, PriorityReadyQueueForWideDags) {
+  BufferAllocation alloc(/*index=*/0, /*size=*/80, /*color=*/0);
+
+  auto make_sequence = [&](bool with_costs) {
+    ThunkSequence sequence;
+    for (int i = 0; i < 4; ++i) {
+      BufferAllocation::Slice slice(&alloc, /*offset=*/i * 20, /*size=*/20);
+      if (with_costs) {
+        sequence.push_back(BusyThunk::Create(absl::StrCat(i), slice, i + 1));
+      } else {
+        sequence.push_back(AddI32Thunk::Create(absl::StrCat(i), {}, {slice}));
+      }
+    }
+    return sequence;
+  };
+
+  TF_ASSERT_OK_AND_ASSIGN(
+      ThunkExecutor with_costs,
+      ThunkExecutor::Create(make_sequence(true), OptionsForTest()));
+  EXPECT_TRUE(with_costs.use_priority_ready_queue());
+
+  TF_ASSERT_OK_AND_ASSIGN(
+      ThunkExecutor without_costs,
+      ThunkExecutor::Create(make_sequence(false), OptionsForTest()));
+  EXPECT_FALSE(without_costs.use_priority_ready_queue());
+}
+
 //===----------------------------------------------------------------------===//
 // ThunkExecutor stress testing
 //===----------------------------------------------------------------------===//
@@ -943,6 +1088,57 @@ static void BM_AsyncThunkExecutor(benchmark::State& state) {
   }
 }
 
+// A wide DAG with `num_cheap` independent cheap thunks followed (in sequence
+// order) by a chain of expensive thunks. FIFO scheduling starts the chain
+// after the cheap thunks, while critical path priorities start it first.
+static void BM_CriticalPathThunkExecutor(benchmark::State& state) {
+  const bool use_priorities = state.range(0);
+  const size_t num_cheap = state.range(1);
+
+  tsl::thread::ThreadPool thread_pool(tsl::Env::Default(), "thunk-executor", 4);
+  Eigen::ThreadPoolDevice device(thread_pool.AsEigenThreadPool(),
+                                 thread_pool.NumThreads());
+
+  BufferAllocation alloc(/*index=*/0, /*size=*/(num_cheap + 1) * 4,
+                         /*color=*/0);
+  ThunkSequence sequence;
+  for (size_t i = 0; i < num_cheap; ++i) {
+    BufferAllocation::Slice slice(&alloc, /*offset=*/i * 4, /*size=*/4);
+    sequence.push_back(BusyThunk::Create(absl::StrCat("cheap", i), slice,
+                                         /*cost_ns=*/10'000));
+  }
+  BufferAllocation::Slice chain_slice(&alloc, /*offset=*/num_cheap * 4,
+                                      /*size=*/4);
+  for (int i = 0; i < 8; ++i) {
+    sequence.push_back(BusyThunk::Create(absl::StrCat("chain", i), chain_slice,
+                                         /*cost_ns=*/50'000));
+  }
+
+  ThunkExecutor::Options options = OptionsForTest();
+  if (!use_priorities) {
+    options.priority_ready_queue_width_threshold =
+        std::numeric_limits<size_t>::max();
+  }
+  auto e = ThunkExecutor::Create(std::move(sequence), options).value();
+
+  BufferAllocations allocations(absl::Span<const MaybeOwningDeviceMemory>{});
+  ThreadPoolTaskRunner task_runner(thread_pool.AsEigenThreadPool());
+
+  Thunk::ExecuteParams params = {nullptr, &allocations, nullptr, &device,
+                                 &task_runner};
+
+  for (auto _ : state) {
+    auto execute_event = e.Execute(params);
+    tsl::BlockUntilReady(execute_event);
+    CHECK(execute_event.IsConcrete());
+  }
+}
+
+BENCHMARK(BM_CriticalPathThunkExecutor)
+    ->UseRealTime()
+    ->ArgNames({"use_priorities", "num_cheap"})
+    ->ArgsProduct({{0, 1}, {16, 64}});
+
 #define BENCHMARK_THUNK_EXECUTOR(name) \
   BENCHMARK(name)                      \
       ->MeasureProcessCPUTime()        \
@@ -0,0 +1,119 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/backends/cpu/runtime/thunk_profiler.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/btree_set.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "xla/backends/cpu/runtime/thunk.h"
+
+namespace xla::cpu {
+
+int64_t ThunkProfiler::Now() { return absl::GetCurrentTimeNanos(); }
+
+void ThunkProfiler::Record(const Thunk& thunk, std::optional<int64_t> worker_id,
+                           int64_t ready_ns, int64_t start_ns,
+                           int64_t end_ns) {
+  int64_t worker = worker_id.value_or(kCallerThread);
+  Shard& shard = shards_[(worker + 1) % kNumShards];
+
+  absl::MutexLock lock(&shard.mu);
+  shard.events.push_back(Event{thunk.info().op_name, thunk.kind(), worker,
+                               ready_ns, start_ns, end_ns});
+}
+
+std::vector<ThunkProfiler::Event> ThunkProfiler::events() const {
+  std::vector<Event> events;
+  for (const Shard& shard : shards_) {
+    absl::MutexLock lock(&shard.mu);
+    events.insert(events.end(), shard.events.begin(), shard.events.end());
+  }
+  absl::c_stable_sort(events, [](const Event& a, const Event& b) {
+    return a.start_ns < b.start_ns;
+  });
+  return events;
+}
+
+// Escapes `str` for use in a JSON string literal.
+static std::string JsonEscape(absl::string_view str) {
+  std::string escaped;
+  escaped.reserve(str.size());
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      absl::StrAppend(&escaped, "\\", absl::string_view(&c, 1));
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      absl::StrAppendFormat(&escaped, "\\u%04x", static_cast<int>(c));
+    } else {
+      escaped.push_back(c);
+    }
+  }
+  return escaped;
+}
+
+std::string ThunkProfiler::ToChromeTrace() const {
+  std::vector<Event> events = this->events();
+
+  // Timestamps are relative to the first ready thunk, in microseconds.
+  int64_t origin_ns = 0;
+  if (!events.empty()) {
+    origin_ns = absl::c_min_element(events, [](const Event& a, const Event& b) {
+                  return a.ready_ns < b.ready_ns;
+                })->ready_ns;
+  }
+  auto us = [&](int64_t ns) { return (ns - origin_ns) / 1000.0; };
+
+  std::vector<std::string> trace_events;
+  absl::btree_set<int64_t> workers;
+  for (const Event& event : events) {
+    workers.insert(event.worker_id);
+    trace_events.push_back(absl::StrFormat(
+        R"({"name":"%s","cat":"%s","ph":"X","pid":0,"tid":%d,"ts":%.3f,)"
+        R"("dur":%.3f,"args":{"wait_us":%.3f}})",
+        JsonEscape(event.op_name), Thunk::KindToString(event.kind),
+        event.worker_id, us(event.start_ns),
+        (event.end_ns - event.start_ns) / 1000.0, event.wait_ns() / 1000.0));
+  }
+
+  // Name the threads after the workers, and sort the caller thread first.
+  for (int64_t worker : workers) {
+    std::string name = worker == kCallerThread
+                           ? std::string("caller")
+                           : absl::StrCat("worker #", worker);
+    trace_events.push_back(absl::StrFormat(
+        R"({"name":"thread_name","ph":"M","pid":0,"tid":%d,)"
+        R"("args":{"name":"%s"}})",
+        worker, name));
+    trace_events.push_back(absl::StrFormat(
+        R"({"name":"thread_sort_index","ph":"M","pid":0,"tid":%d,)"
+        R"("args":{"sort_index":%d}})",
+        worker, worker));
+  }
+
+  return absl::StrCat(R"({"displayTimeUnit":"ns","traceEvents":[)",
+                      absl::StrJoin(trace_events, ",\n"), "]}\n");
+}
+
+}  // namespace xla::cpu
@@ -0,0 +1,92 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_BACKENDS_CPU_RUNTIME_THUNK_PROFILER_H_
+#define XLA_BACKENDS_CPU_RUNTIME_THUNK_PROFILER_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "xla/backends/cpu/runtime/thunk.h"
+
+namespace xla::cpu {
+
+// Records when thunks become ready, start and finish executing, and on which
+// task runner worker, for the executions it is passed to via
+// `Thunk::ExecuteParams::profiler`. Thunks executed by nested thunk executors
+// (i.e. in while loops and conditionals) are recorded as well.
+//
+// Recording takes a timestamp when a thunk starts and when it finishes, and an
+// uncontended lock per thunk, so it is cheap enough to profile real workloads,
+// but it is not free and must be enabled explicitly.
+class ThunkProfiler {
+ public:
+  // Worker id of the threads that are not managed by the task runner, e.g. the
+  // thread that launched the execution.
+  static constexpr int64_t kCallerThread = -1;
+
+  struct Event {
+    absl::string_view op_name;
+    Thunk::Kind kind;
+    int64_t worker_id;
+
+    // Timestamps in nanoseconds: when all the dependencies of the thunk
+    // completed, when the thunk started executing, and when its execute event
+    // became available.
+    int64_t ready_ns;
+    int64_t start_ns;
+    int64_t end_ns;
+
+    // Time the thunk spent ready but waiting for a worker.
+    int64_t wait_ns() const { return start_ns - ready_ns; }
+  };
+
+  // Returns the current time in nanoseconds.
+  static int64_t Now();
+
+  // Records an execution of `thunk`, which must outlive the profiler.
+  void Record(const Thunk& thunk, std::optional<int64_t> worker_id,
+              int64_t ready_ns, int64_t start_ns, int64_t end_ns);
+
+  // Returns all recorded events sorted by start time.
+  std::vector<Event> events() const;
+
+  // Returns the recorded events in the Chrome trace event format, which can
+  // be loaded into Perfetto or chrome://tracing. Each worker is a thread, and
+  // the time every thunk waited for a worker is attached to its event.
+  std::string ToChromeTrace() const;
+
+ private:
+  // Events are sharded by worker so that workers don't contend on one lock.
+  static constexpr size_t kNumShards = 16;
+
+  struct alignas(64) Shard {
+    mutable absl::Mutex mu;
+    std::vector<Event> events ABSL_GUARDED_BY(mu);
+  };
+
+  std::array<Shard, kNumShards> shards_;
+};
+
+}  // namespace xla::cpu
+
+#endif  // XLA_BACKENDS_CPU_RUNTIME_THUNK_PROFILER_H_
@@ -0,0 +1,70 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/backends/cpu/runtime/thunk_profiler.h"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "xla/backends/cpu/runtime/thunk.h"
+#include "xla/backends/cpu/runtime/thunk_testlib.h"
+#include "xla/runtime/buffer_use.h"
+#include "xla/service/buffer_assignment.h"
+#include "tsl/platform/test.h"
+
+namespace xla::cpu {
+namespace {
+
+using ::testing::HasSubstr;
+
+TEST(ThunkProfilerTest, RecordsEventsSortedByStartTime) {
+  BufferUseThunk a(BufferUse::Read(BufferAllocation::Slice()));
+  BufferUseThunk b(BufferUse::Read(BufferAllocation::Slice()));
+
+  ThunkProfiler profiler;
+  profiler.Record(b, /*worker_id=*/3, /*ready_ns=*/100, /*start_ns=*/250,
+                  /*end_ns=*/300);
+  profiler.Record(a, /*worker_id=*/std::nullopt, /*ready_ns=*/100,
+                  /*start_ns=*/100, /*end_ns=*/200);
+
+  std::vector<ThunkProfiler::Event> events = profiler.events();
+  ASSERT_EQ(events.size(), 2);
+
+  EXPECT_EQ(events[0].worker_id, ThunkProfiler::kCallerThread);
+  EXPECT_EQ(events[0].wait_ns(), 0);
+
+  EXPECT_EQ(events[1].worker_id, 3);
+  EXPECT_EQ(events[1].op_name, "buffer-use");
+  EXPECT_EQ(events[1].kind, Thunk::Kind::kKernel);
+  EXPECT_EQ(events[1].wait_ns(), 150);
+}
+
+TEST(ThunkProfilerTest, ToChromeTrace) {
+  BufferUseThunk thunk(BufferUse::Read(BufferAllocation::Slice()));
+
+  ThunkProfiler profiler;
+  profiler.Record(thunk, /*worker_id=*/0, /*ready_ns=*/1000,
+                  /*start_ns=*/3000, /*end_ns=*/7500);
+
+  std::string trace = profiler.ToChromeTrace();
+  EXPECT_THAT(trace, HasSubstr(R"("name":"buffer-use","cat":"kernel")"));
+  EXPECT_THAT(trace, HasSubstr(R"("tid":0,"ts":2.000,"dur":4.500)"));
+  EXPECT_THAT(trace, HasSubstr(R"("args":{"wait_us":2.000})"));
+  EXPECT_THAT(trace, HasSubstr(R"("args":{"name":"worker #0"})"));
+}
+
+}  // namespace
+}  // namespace xla::cpu
@@ -91,6 +91,8 @@ DebugOptions DefaultDebugOptionsIgnoringFlags() {
   opts.set_xla_cpu_enable_concurrency_optimized_scheduler(false);
   opts.set_xla_cpu_prefer_vector_width(256);
   opts.set_xla_cpu_max_isa("");
+  opts.set_xla_cpu_enable_kernel_object_cache(false);
+  opts.set_xla_cpu_memory_limit_bytes(0);
 
   opts.set_xla_cpu_enable_fast_math(false);
   // Disable forms of fast math that have caused users problems in the past.
@@ -918,6 +920,33 @@ void MakeDebugOptionsFlags(std::vector<tsl::Flag>* flag_list,
       "use newer instructions. Available values: SSE4_2, AVX, AVX2, AVX512, "
       "AVX512_VNNI, AVX512_BF16, AMX, and AMX_FP16. (`AMX` will enable both "
       "`AMX_BF16` and `AMX_INT8` instructions.)"));
+  flag_list->push_back(tsl::Flag(
+      "xla_cpu_thunk_profile_dir",
+      string_setter_for(&DebugOptions::set_xla_cpu_thunk_profile_dir),
+      debug_options->xla_cpu_thunk_profile_dir(),
+      "If non-empty, XLA:CPU dumps a Chrome trace of the thunks executed by "
+      "every execution to this directory, including the time each thunk "
+      "waited for a worker thread. Only used by the thunk runtime."));
+  flag_list->push_back(tsl::Flag(
+      "xla_cpu_memory_limit_bytes",
+      int64_setter_for(&DebugOptions::set_xla_cpu_memory_limit_bytes),
+      debug_options->xla_cpu_memory_limit_bytes(),
+      "If positive, XLA:CPU uses a memory-minimizing schedule and "
+      "rematerializes instructions to keep the peak memory of the compiled "
+      "program below this many bytes."));
+  flag_list->push_back(tsl::Flag(
+      "xla_cpu_enable_kernel_object_cache",
+      bool_setter_for(&DebugOptions::set_xla_cpu_enable_kernel_object_cache),
+      debug_options->xla_cpu_enable_kernel_object_cache(),
+      "If true, XLA:CPU caches the object code of compiled kernels and reuses "
+      "it when an identical kernel is compiled again."));
+  flag_list->push_back(tsl::Flag(
+      "xla_cpu_kernel_object_cache_dir",
+      string_setter_for(&DebugOptions::set_xla_cpu_kernel_object_cache_dir),
+      debug_options->xla_cpu_kernel_object_cache_dir(),
+      "If non-empty, XLA:CPU also stores cached kernel object code in this "
+      "directory to share it across processes. Only used when "
+      "--xla_cpu_enable_kernel_object_cache is true."));
   flag_list->push_back(tsl::Flag(
       "xla_gpu_crash_on_verification_failures",
       bool_setter_for(
@@ -243,7 +243,9 @@ HloInstruction* HloComputation::AddInstruction(
 
 HloInstruction* HloComputation::AddInstructionInternal(
     std::unique_ptr<HloInstruction> instruction) {
-  if (parent() != nullptr) {
+  if (parent() != nullptr && next_provisional_id_ >= 0) {
+    instruction->SetUniqueId(next_provisional_id_++);
+  } else if (parent() != nullptr) {
     instruction->UniquifyName(&parent()->instruction_name_uniquer());
     instruction->SetUniqueId(parent()->NewUniqueInstructionId());
   }
@@ -1815,6 +1817,29 @@ bool HloComputation::IsEntryComputation() const {
   return parent()->entry_computation() == this;
 }
 
+// Provisional unique ids are allocated above the ids the module hands out, so
+// they can't clash with the ids of existing instructions.
+static constexpr int kFirstProvisionalId = 1 << 30;
+
+void HloComputation::StartConcurrentModification() {
+  CHECK_EQ(next_provisional_id_, -1) << "Already modified concurrently";
+  next_provisional_id_ = kFirstProvisionalId;
+}
+
+void HloComputation::FinishConcurrentModification() {
+  CHECK_GE(next_provisional_id_, 0) << "Not modified concurrently";
+  next_provisional_id_ = -1;
+  if (parent() == nullptr) return;
+
+  for (HloInstruction* instruction : instructions()) {
+    if (instruction->unique_id() >= kFirstProvisionalId) {
+      instruction->ClearUniqueIdInternal();
+      instruction->UniquifyName(parent());
+      instruction->UniquifyId(parent());
+    }
+  }
+}
+
 bool HloComputation::CanExpandIntoSingleInstruction() const {
   return absl::c_all_of(
       instructions(), [root = root_instruction()](const HloInstruction* instr) {
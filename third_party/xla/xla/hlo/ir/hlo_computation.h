@@ -944,6 +944,18 @@ class HloComputation {
   // Returns true iff this computation can be inlined as a single instruction.
   bool CanExpandIntoSingleInstruction() const;
 
+  // Allows a pass to modify this computation concurrently with other
+  // computations of the same module. Instruction names and unique ids are
+  // allocated by the module, which is not thread safe, so until
+  // FinishConcurrentModification is called, added instructions get provisional
+  // unique ids (unique within this computation) and keep their names as is.
+  void StartConcurrentModification();
+
+  // Assigns final names and unique ids to the instructions added since
+  // StartConcurrentModification, in the order they appear in the computation.
+  // Must not be called concurrently with any other modification of the module.
+  void FinishConcurrentModification();
+
  private:
   explicit HloComputation(
       const std::string& name, int parameter_count,
@@ -1026,6 +1038,10 @@ class HloComputation {
   // Number of not-marked-for-deletion entries in instructions_.
   int64_t instruction_count_;
 
+  // Next provisional unique id for added instructions while the computation is
+  // modified concurrently with other computations, or -1 otherwise.
+  int next_provisional_id_ = -1;
+
   // Removed instructions are moved into to_be_deleted_ first and then
   // deallocated when Cleanup is called.
   PtrVec<HloInstruction*> to_be_deleted_;
@@ -1788,6 +1788,13 @@ bool HloConstantInstruction::IsElementwiseImpl(
   return true;
 }
 
+void HloConstantInstruction::set_shared_literal(
+    std::shared_ptr<Literal> literal) {
+  CHECK(literal_ != nullptr && literal != nullptr);
+  DCHECK(literal_->Equal(*literal, /*layout_sensitive=*/true));
+  literal_ = std::move(literal);
+}
+
 void HloConstantInstruction::RelayoutConstant(const Layout& new_layout,
                                               const ShapeIndex& shape_index) {
   Shape* mutable_array_subshape =
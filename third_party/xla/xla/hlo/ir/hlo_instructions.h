@@ -1330,6 +1330,12 @@ class HloConstantInstruction : public HloInstruction {
   }
   // Returns whether there is literal associated with this instruction.
   bool HasLiteral() const { return static_cast<bool>(literal_); }
+  // Returns the literal associated with this instruction, which may be shared
+  // with other constant instructions.
+  const std::shared_ptr<Literal>& shared_literal() const { return literal_; }
+  // Replaces the literal with `literal`, which must be equal to the current
+  // one, so that this instruction shares its storage with other constants.
+  void set_shared_literal(std::shared_ptr<Literal> literal);
   // Returns a serialized representation of this instruction.
   HloInstructionProto ToProto() const override;
 
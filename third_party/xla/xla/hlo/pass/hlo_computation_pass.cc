@@ -0,0 +1,122 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/hlo/pass/hlo_computation_pass.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "xla/hlo/ir/hlo_computation.h"
+#include "xla/hlo/ir/hlo_instruction.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "tsl/platform/logging.h"
+#include "tsl/platform/statusor.h"
+
+namespace xla {
+
+// Groups computations into waves such that no computation calls another
+// computation of the same wave, and all computations called by a computation
+// are in earlier waves. Computations keep their post order within a wave.
+static std::vector<std::vector<HloComputation*>> ComputationWaves(
+    HloModule* module,
+    const absl::flat_hash_set<absl::string_view>& execution_threads) {
+  std::vector<std::vector<HloComputation*>> waves;
+  absl::flat_hash_map<const HloComputation*, size_t> wave_of;
+
+  for (HloComputation* computation :
+       module->MakeComputationPostOrder(execution_threads)) {
+    size_t wave = 0;
+    for (HloInstruction* instruction : computation->instructions()) {
+      for (HloComputation* callee : instruction->called_computations()) {
+        if (auto it = wave_of.find(callee); it != wave_of.end()) {
+          wave = std::max(wave, it->second + 1);
+        }
+      }
+    }
+    wave_of[computation] = wave;
+    if (waves.size() <= wave) waves.resize(wave + 1);
+    waves[wave].push_back(computation);
+  }
+
+  return waves;
+}
+
+absl::StatusOr<bool> HloComputationPass::Run(
+    HloModule* module,
+    const absl::flat_hash_set<absl::string_view>& execution_threads) {
+  if (thread_pool_ != nullptr && thread_pool_->NumThreads() > 1) {
+    return RunInParallel(module, execution_threads);
+  }
+
+  bool changed = false;
+  for (HloComputation* computation :
+       module->MakeComputationPostOrder(execution_threads)) {
+    TF_ASSIGN_OR_RETURN(bool computation_changed,
+                        RunOnComputation(computation));
+    changed |= computation_changed;
+  }
+  return changed;
+}
+
+absl::StatusOr<bool> HloComputationPass::RunInParallel(
+    HloModule* module,
+    const absl::flat_hash_set<absl::string_view>& execution_threads) {
+  bool changed = false;
+
+  for (const std::vector<HloComputation*>& wave :
+       ComputationWaves(module, execution_threads)) {
+    // Don't pay for synchronization if there is nothing to run concurrently.
+    if (wave.size() == 1) {
+      TF_ASSIGN_OR_RETURN(bool computation_changed, RunOnComputation(wave[0]));
+      changed |= computation_changed;
+      continue;
+    }
+
+    VLOG(3) << "Run " << name() << " on " << wave.size()
+            << " computations in parallel";
+
+    std::vector<absl::StatusOr<bool>> results(wave.size());
+    absl::BlockingCounter counter(wave.size());
+    for (size_t i = 0; i < wave.size(); ++i) {
+      wave[i]->StartConcurrentModification();
+      thread_pool_->Schedule([&, i] {
+        results[i] = RunOnComputation(wave[i]);
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+
+    // Assign names and unique ids to the added instructions in a fixed order,
+    // so that the result doesn't depend on thread scheduling.
+    for (HloComputation* computation : wave) {
+      computation->FinishConcurrentModification();
+    }
+
+    for (absl::StatusOr<bool>& result : results) {
+      TF_RETURN_IF_ERROR(result.status());
+      changed |= *result;
+    }
+  }
+
+  return changed;
+}
+
+}  // namespace xla
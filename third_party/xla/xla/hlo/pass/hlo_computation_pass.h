@@ -0,0 +1,71 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_HLO_PASS_HLO_COMPUTATION_PASS_H_
+#define XLA_HLO_PASS_HLO_COMPUTATION_PASS_H_
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "xla/hlo/ir/hlo_computation.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/hlo/pass/hlo_pass_interface.h"
+#include "tsl/platform/threadpool.h"
+
+namespace xla {
+
+// Base class for passes which transform each computation of a module
+// independently of the others.
+//
+// A computation pass may only modify the computation it runs on: it must not
+// add or remove computations, and it must not touch instructions of other
+// computations, except for reading the computations called by the one it runs
+// on. That allows running it over the computations of a module in parallel:
+// when a thread pool is set, computations that don't (transitively) call each
+// other are transformed concurrently, callees before their callers. The result
+// doesn't depend on the number of threads or on the order in which the threads
+// run, but names and unique ids of added instructions may differ from a serial
+// run.
+class HloComputationPass : public HloModulePass {
+ public:
+  // Runs the pass on a single computation. Returns whether the computation was
+  // changed. Must be safe to call concurrently for different computations.
+  virtual absl::StatusOr<bool> RunOnComputation(
+      HloComputation* computation) = 0;
+
+  // Runs the pass on all computations of the module with the given execution
+  // threads, callees before callers, in parallel if a thread pool is set.
+  using HloPassInterface::Run;
+  absl::StatusOr<bool> Run(
+      HloModule* module,
+      const absl::flat_hash_set<absl::string_view>& execution_threads) override;
+
+  // Sets the thread pool to run the pass on. If null, the pass runs on the
+  // computations of a module one by one, on the calling thread.
+  void set_thread_pool(tsl::thread::ThreadPool* thread_pool) {
+    thread_pool_ = thread_pool;
+  }
+
+ private:
+  absl::StatusOr<bool> RunInParallel(
+      HloModule* module,
+      const absl::flat_hash_set<absl::string_view>& execution_threads);
+
+  tsl::thread::ThreadPool* thread_pool_ = nullptr;
+};
+
+}  // namespace xla
+
+#endif  // XLA_HLO_PASS_HLO_COMPUTATION_PASS_H_
@@ -0,0 +1,169 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/hlo/pass/hlo_computation_pass.h"
+
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "xla/hlo/ir/hlo_computation.h"
+#include "xla/hlo/ir/hlo_instruction.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/hlo/ir/hlo_opcode.h"
+#include "xla/hlo/pass/hlo_pass_pipeline.h"
+#include "xla/hlo/testlib/hlo_hardware_independent_test_base.h"
+#include "xla/tsl/lib/core/status_test_util.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/statusor.h"
+#include "tsl/platform/threadpool.h"
+
+namespace xla {
+namespace {
+
+using HloComputationPassTest = HloHardwareIndependentTestBase;
+
+// Negates the root of every non-entry computation, and records the thread it
+// ran on for each computation.
+class NegateRootPass : public HloComputationPass {
+ public:
+  absl::string_view name() const override { return "negate-root"; }
+
+  absl::StatusOr<bool> RunOnComputation(HloComputation* computation) override {
+    {
+      absl::MutexLock lock(&mu_);
+      threads_[computation->name()] = std::this_thread::get_id();
+    }
+    if (computation->IsEntryComputation()) {
+      return false;
+    }
+    HloInstruction* root = computation->root_instruction();
+    computation->set_root_instruction(
+        computation->AddInstruction(HloInstruction::CreateUnary(
+            root->shape(), HloOpcode::kNegate, root)));
+    return true;
+  }
+
+  std::thread::id thread(absl::string_view computation) {
+    absl::MutexLock lock(&mu_);
+    return threads_.at(computation);
+  }
+
+ private:
+  absl::Mutex mu_;
+  absl::flat_hash_map<std::string, std::thread::id> threads_;
+};
+
+constexpr absl::string_view kHlo = R"(
+  HloModule m
+
+  f0 {
+    p = f32[] parameter(0)
+    ROOT add = f32[] add(p, p)
+  }
+
+  f1 {
+    p = f32[] parameter(0)
+    ROOT add = f32[] add(p, p)
+  }
+
+  f2 {
+    p = f32[] parameter(0)
+    ROOT add = f32[] add(p, p)
+  }
+
+  f3 {
+    p = f32[] parameter(0)
+    ROOT call = f32[] call(p), to_apply=f0
+  }
+
+  ENTRY e {
+    p = f32[] parameter(0)
+    c0 = f32[] call(p), to_apply=f0
+    c1 = f32[] call(p), to_apply=f1
+    c2 = f32[] call(p), to_apply=f2
+    c3 = f32[] call(p), to_apply=f3
+    ROOT tuple = (f32[], f32[], f32[], f32[]) tuple(c0, c1, c2, c3)
+  }
+)";
+
+TEST_F(HloComputationPassTest, RunsInParallel) {
+  tsl::thread::ThreadPool thread_pool(tsl::Env::Default(), "test", 4);
+
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kHlo));
+  NegateRootPass pass;
+  pass.set_thread_pool(&thread_pool);
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunHloPass(&pass, module.get()));
+  EXPECT_TRUE(changed);
+
+  // Computations that don't call each other run on the thread pool, and the
+  // entry computation runs after all of them on the calling thread.
+  EXPECT_NE(pass.thread("f0"), std::this_thread::get_id());
+  EXPECT_NE(pass.thread("f1"), std::this_thread::get_id());
+  EXPECT_EQ(pass.thread("e"), std::this_thread::get_id());
+
+  // Added instructions have unique names and ids.
+  absl::flat_hash_set<std::string> names;
+  absl::flat_hash_set<int> ids;
+  int next_id = module->NewUniqueInstructionId();
+  for (HloComputation* computation : module->computations()) {
+    for (HloInstruction* instruction : computation->instructions()) {
+      EXPECT_TRUE(names.insert(instruction->name()).second);
+      EXPECT_TRUE(ids.insert(instruction->unique_id()).second);
+      EXPECT_LT(instruction->unique_id(), next_id);
+    }
+    if (!computation->IsEntryComputation()) {
+      EXPECT_EQ(computation->root_instruction()->opcode(), HloOpcode::kNegate);
+    }
+  }
+}
+
+TEST_F(HloComputationPassTest, ParallelRunIsDeterministic) {
+  tsl::thread::ThreadPool thread_pool(tsl::Env::Default(), "test", 4);
+
+  std::string expected;
+  for (int i = 0; i < 10; ++i) {
+    TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kHlo));
+    NegateRootPass pass;
+    pass.set_thread_pool(&thread_pool);
+    TF_ASSERT_OK(RunHloPass(&pass, module.get()).status());
+
+    std::string result = module->ToString();
+    if (i == 0) expected = result;
+    EXPECT_EQ(result, expected);
+  }
+}
+
+TEST_F(HloComputationPassTest, PipelinePropagatesThreadPool) {
+  tsl::thread::ThreadPool thread_pool(tsl::Env::Default(), "test", 4);
+
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kHlo));
+  HloPassPipeline pipeline("pipeline");
+  pipeline.set_thread_pool(&thread_pool);
+  NegateRootPass& pass =
+      pipeline.AddPass<HloPassPipeline>("nested").AddPass<NegateRootPass>();
+  TF_ASSERT_OK(RunHloPass(&pipeline, module.get()).status());
+  EXPECT_NE(pass.thread("f0"), std::this_thread::get_id());
+}
+
+}  // namespace
+}  // namespace xla
@@ -24,6 +24,7 @@ limitations under the License.
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
+#include "xla/hlo/pass/hlo_computation_pass.h"
 #include "xla/service/dump.h"
 #include "xla/service/hlo_graph_dumper.h"
 #include "xla/service/hlo_proto_util.h"
@@ -182,6 +183,7 @@ absl::StatusOr<bool> HloPassPipeline::RunPassesInternal(
       compilation_stats_->StartPass(pass_name);
     }
     RecordPassStartMetadata(*hlo, pass_name, pipeline_name);
+    PropagateThreadPool(pass);
     auto status_or_changed = RunHelper(pass, hlo, execution_threads);
     if (auto status = status_or_changed.status(); !status.ok()) {
       compilation_stats_->RecordPassError(
@@ -213,6 +215,19 @@ absl::StatusOr<bool> HloPassPipeline::RunPassesInternal(
   return changed;
 }
 
+void HloPassPipeline::PropagateThreadPool(HloPassInterface* pass) {
+  if (thread_pool_ == nullptr) {
+    return;
+  }
+  if (auto* computation_pass = dynamic_cast<HloComputationPass*>(pass)) {
+    computation_pass->set_thread_pool(thread_pool_);
+  } else if (auto* pipeline = dynamic_cast<HloPassPipeline*>(pass)) {
+    if (pipeline->thread_pool_ == nullptr) {
+      pipeline->thread_pool_ = thread_pool_;
+    }
+  }
+}
+
 std::vector<HloPassInterface*> HloPassPipeline::GetEnabledPasses(
     const DebugOptions& debug_options) {
   if (debug_options.xla_disable_all_hlo_passes()) {
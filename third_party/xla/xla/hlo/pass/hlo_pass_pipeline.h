@@ -32,6 +32,7 @@ limitations under the License.
 #include "xla/service/compilation_stats.h"
 #include "xla/types.h"
 #include "xla/xla.pb.h"
+#include "tsl/platform/threadpool.h"
 
 namespace xla {
 
@@ -94,6 +95,14 @@ class HloPassPipeline : public HloPassInterface {
 
   bool IsPassPipeline() const override { return true; }
 
+  // Sets the thread pool used to run computation passes (see
+  // HloComputationPass) of this pipeline, and of nested pipelines that don't
+  // have a thread pool of their own, over independent computations in
+  // parallel. If null, all passes run on the calling thread.
+  void set_thread_pool(tsl::thread::ThreadPool* thread_pool) {
+    thread_pool_ = thread_pool;
+  }
+
   // Return size of passes_.
   int PassesSize() { return passes_.size(); }
   // Return reference to pass specified by index.
@@ -105,6 +114,10 @@ class HloPassPipeline : public HloPassInterface {
   std::vector<HloPassInterface*> GetEnabledPasses(
       const DebugOptions& debug_options);
 
+  // Passes the thread pool of this pipeline on to `pass`, if it can run in
+  // parallel.
+  void PropagateThreadPool(HloPassInterface* pass);
+
   // Maybe dumps the given module or module group depending on flag values
   // contained in DebugOptions of module config. If it is dumped, saves the
   // filenames of the dumps into module metadata.
@@ -160,6 +173,7 @@ class HloPassPipeline : public HloPassInterface {
   std::vector<std::unique_ptr<HloPassInterface>> passes_;
   std::vector<std::unique_ptr<HloPassInterface>> invariant_checkers_;
   bool run_called_ = false;
+  tsl::thread::ThreadPool* thread_pool_ = nullptr;
 
   CompilationStats* compilation_stats_;
   // Default stats instance for when one is not passed in the constructor.
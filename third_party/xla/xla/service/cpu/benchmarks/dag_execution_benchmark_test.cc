@@ -100,4 +100,107 @@ BENCHMARK(BM_DagExecution)
     ->Arg(8192)
     ->Arg(16384);
 
+static void BM_UnbalancedDagExecution(benchmark::State& state) {
+  int64_t d0 = state.range(0);
+
+  // A chain of dependent dots next to many short independent reductions. The
+  // chain is the critical path, so the executor should start it as early as
+  // possible and run the reductions alongside it, rather than in the order in
+  // which the thunks become ready.
+  std::string_view hlo = R"(
+    HloModule unbalanced_dag_$d0
+
+    add {
+      p0 = f32[] parameter(0)
+      p1 = f32[] parameter(1)
+      ROOT add = f32[] add(p0, p1)
+    }
+
+    ENTRY e {
+      p0 = f32[$d0,256] parameter(0)
+      p1 = f32[256,256] parameter(1)
+      c0 = f32[] constant(0)
+
+      c1 = f32[] constant(1)
+      bcast1 = f32[$d0,256] broadcast(c1), dimensions={}
+      add1 = f32[$d0,256] add(p0, bcast1)
+      r1 = f32[] reduce(add1, c0), dimensions={0,1}, to_apply=add
+
+      c2 = f32[] constant(2)
+      bcast2 = f32[$d0,256] broadcast(c2), dimensions={}
+      add2 = f32[$d0,256] add(p0, bcast2)
+      r2 = f32[] reduce(add2, c0), dimensions={0,1}, to_apply=add
+
+      c3 = f32[] constant(3)
+      bcast3 = f32[$d0,256] broadcast(c3), dimensions={}
+      add3 = f32[$d0,256] add(p0, bcast3)
+      r3 = f32[] reduce(add3, c0), dimensions={0,1}, to_apply=add
+
+      c4 = f32[] constant(4)
+      bcast4 = f32[$d0,256] broadcast(c4), dimensions={}
+      add4 = f32[$d0,256] add(p0, bcast4)
+      r4 = f32[] reduce(add4, c0), dimensions={0,1}, to_apply=add
+
+      c5 = f32[] constant(5)
+      bcast5 = f32[$d0,256] broadcast(c5), dimensions={}
+      add5 = f32[$d0,256] add(p0, bcast5)
+      r5 = f32[] reduce(add5, c0), dimensions={0,1}, to_apply=add
+
+      c6 = f32[] constant(6)
+      bcast6 = f32[$d0,256] broadcast(c6), dimensions={}
+      add6 = f32[$d0,256] add(p0, bcast6)
+      r6 = f32[] reduce(add6, c0), dimensions={0,1}, to_apply=add
+
+      c7 = f32[] constant(7)
+      bcast7 = f32[$d0,256] broadcast(c7), dimensions={}
+      add7 = f32[$d0,256] add(p0, bcast7)
+      r7 = f32[] reduce(add7, c0), dimensions={0,1}, to_apply=add
+
+      c8 = f32[] constant(8)
+      bcast8 = f32[$d0,256] broadcast(c8), dimensions={}
+      add8 = f32[$d0,256] add(p0, bcast8)
+      r8 = f32[] reduce(add8, c0), dimensions={0,1}, to_apply=add
+
+      dot1 = f32[$d0,256] dot(p0, p1),
+          lhs_contracting_dims={1}, rhs_contracting_dims={0}
+      dot2 = f32[$d0,256] dot(dot1, p1),
+          lhs_contracting_dims={1}, rhs_contracting_dims={0}
+      dot3 = f32[$d0,256] dot(dot2, p1),
+          lhs_contracting_dims={1}, rhs_contracting_dims={0}
+      dot4 = f32[$d0,256] dot(dot3, p1),
+          lhs_contracting_dims={1}, rhs_contracting_dims={0}
+      dot5 = f32[$d0,256] dot(dot4, p1),
+          lhs_contracting_dims={1}, rhs_contracting_dims={0}
+      dot6 = f32[$d0,256] dot(dot5, p1),
+          lhs_contracting_dims={1}, rhs_contracting_dims={0}
+      dot7 = f32[$d0,256] dot(dot6, p1),
+          lhs_contracting_dims={1}, rhs_contracting_dims={0}
+      dot8 = f32[$d0,256] dot(dot7, p1),
+          lhs_contracting_dims={1}, rhs_contracting_dims={0}
+
+      ROOT out = (f32[$d0,256], f32[], f32[], f32[], f32[], f32[], f32[], f32[],
+                  f32[]) tuple(dot8, r1, r2, r3, r4, r5, r6, r7, r8)
+    }
+  )";
+
+  std::minstd_rand0 engine;
+
+  auto lhs_shape = ShapeUtil::MakeShape(F32, {d0, 256});
+  auto rhs_shape = ShapeUtil::MakeShape(F32, {256, 256});
+  auto p0 =
+      *LiteralUtil::CreateRandomLiteral<F32>(lhs_shape, &engine, 1.0f, 0.1f);
+  // Keeps the values of the chain from overflowing.
+  auto p1 =
+      *LiteralUtil::CreateRandomLiteral<F32>(rhs_shape, &engine, 0.0f, 0.05f);
+
+  std::vector<const Literal*> args = {&p0, &p1};
+  CHECK_OK(RunHloBenchmark(state, hlo, args, {{"$d0", absl::StrCat(d0)}}));
+}
+
+BENCHMARK(BM_UnbalancedDagExecution)
+    ->MeasureProcessCPUTime()
+    ->Arg(128)
+    ->Arg(512)
+    ->Arg(2048);
+
 }  // namespace xla::cpu
@@ -119,4 +119,24 @@ absl::Status RunHloBenchmark(benchmark::State& state,
   return absl::OkStatus();
 }
 
+absl::Status CompileHloBenchmark(benchmark::State& state,
+                                 std::string_view hlo_module,
+                                 StrToStrMapping replacements) {
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<PjRtClient> client,
+                      GetTfrtCpuClient(CpuClientOptions()));
+
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<HloModule> module,
+                      ParseAndReturnUnverifiedModule(
+                          absl::StrReplaceAll(hlo_module, replacements),
+                          HloModuleConfig() /* unused */));
+
+  XlaComputation computation(module->ToProto());
+
+  for (auto _ : state) {
+    TF_RETURN_IF_ERROR(client->Compile(computation, CompileOptions()).status());
+  }
+
+  return absl::OkStatus();
+}
+
 }  // namespace xla::cpu
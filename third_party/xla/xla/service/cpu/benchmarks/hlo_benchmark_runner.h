@@ -45,6 +45,12 @@ absl::Status RunHloBenchmark(benchmark::State& state,
                              StrToStrMapping replacements = {},
                              bool disable_parallel_task_assigner = false);
 
+// Benchmarks the compilation of the given HLO module. The HLO text can be
+// interpolated in the same way as for RunHloBenchmark.
+absl::Status CompileHloBenchmark(benchmark::State& state,
+                                 std::string_view hlo_module,
+                                 StrToStrMapping replacements = {});
+
 }  // namespace xla::cpu
 
 #endif  // XLA_SERVICE_CPU_BENCHMARKS_HLO_BENCHMARK_RUNNER_H_
@@ -15,10 +15,12 @@ limitations under the License.
 
 #include <cstdint>
 #include <random>
+#include <string>
 #include <string_view>
 #include <vector>
 
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_replace.h"
 #include "absl/types/span.h"
 #include "xla/literal.h"
 #include "xla/literal_util.h"
@@ -110,6 +112,65 @@ static void BM_Optimizer0(benchmark::State& state) {
   CHECK_OK(RunHloBenchmark(state, hlo, args, {{"$d0", absl::StrCat(d0)}}));
 }
 
+// Measures the compile time of a module with many independent computations,
+// which HLO passes can process in parallel.
+static void BM_OptimizeManyComputations(benchmark::State& state) {
+  int64_t num_loops = state.range(0);
+
+  std::string_view loop = R"(
+    body$i {
+      p = (s32[], s32[], f32[1024]) parameter(0)
+      i = s32[] get-tuple-element(p), index=0
+      n = s32[] get-tuple-element(p), index=1
+      x = f32[1024] get-tuple-element(p), index=2
+      one = s32[] constant(1)
+      next_i = s32[] add(i, one)
+      x0 = f32[1024] multiply(x, x)
+      x1 = f32[1024] multiply(x, x)
+      ROOT result = (s32[], s32[], f32[1024]) tuple(next_i, n, add(x0, x1))
+    }
+
+    cond$i {
+      p = (s32[], s32[], f32[1024]) parameter(0)
+      i = s32[] get-tuple-element(p), index=0
+      n = s32[] get-tuple-element(p), index=1
+      ROOT lt = pred[] compare(i, n), direction=LT
+    }
+  )";
+
+  std::string computations;
+  std::string entry = R"(
+    ENTRY e {
+      x0 = f32[1024] parameter(0)
+      n = s32[] parameter(1)
+      zero = s32[] constant(0)
+  )";
+
+  for (int64_t i = 0; i < num_loops; ++i) {
+    std::string id = absl::StrCat(i);
+    absl::StrAppend(&computations, absl::StrReplaceAll(loop, {{"$i", id}}));
+    absl::StrAppend(
+        &entry,
+        absl::StrReplaceAll(
+            R"(
+      init$i = (s32[], s32[], f32[1024]) tuple(zero, n, x$i)
+      while$i = (s32[], s32[], f32[1024]) while(init$i), condition=cond$i,
+                                                         body=body$i
+      x$next = f32[1024] get-tuple-element(while$i), index=2
+  )",
+            {{"$i", id}, {"$next", absl::StrCat(i + 1)}}));
+  }
+  absl::StrAppend(&entry, "    ROOT result = f32[1024] copy(x", num_loops,
+                  ")
+    }
+");
+
+  std::string hlo = absl::StrCat("HloModule many_computations
+", computations,
+                                 entry);
+  CHECK_OK(CompileHloBenchmark(state, hlo));
+}
+
 BENCHMARK(BM_Optimizer0)
     ->MeasureProcessCPUTime()
     ->Arg(128)
@@ -119,4 +180,11 @@ BENCHMARK(BM_Optimizer0)
     ->Arg(8192)
     ->Arg(16384);
 
+BENCHMARK(BM_OptimizeManyComputations)
+    ->MeasureProcessCPUTime()
+    ->UseRealTime()
+    ->Arg(16)
+    ->Arg(64)
+    ->Arg(256);
+
 }  // namespace xla::cpu
@@ -86,6 +86,70 @@ static void BM_ReduceAddBF16(benchmark::State& state) {
   CHECK_OK(RunHloBenchmark(state, hlo, args, {{"$d0", absl::StrCat(d0)}}));
 }
 
+// Reduces the rows of a [batch, hidden] matrix, i.e. the mean in layer norm.
+static void BM_RowReduceAddF32(benchmark::State& state) {
+  int64_t d0 = state.range(0);
+  int64_t d1 = state.range(1);
+
+  std::string_view hlo = R"(
+    HloModule row_reduce_add_f32_$d0_$d1
+
+    add {
+      p0 = f32[] parameter(0)
+      p1 = f32[] parameter(1)
+      ROOT add = f32[] add(p0, p1)
+    }
+
+    ENTRY e {
+      p0 = f32[$d0,$d1] parameter(0)
+      c0 = f32[] constant(0)
+      ROOT reduce = f32[$d0] reduce(p0, c0), dimensions={1}, to_apply=add
+    }
+  )";
+
+  std::minstd_rand0 engine;
+
+  auto shape = ShapeUtil::MakeShape(F32, {d0, d1});
+  auto p0 = *LiteralUtil::CreateRandomLiteral<F32>(shape, &engine, 1.0f, 0.1f);
+
+  std::vector<const Literal*> args = {&p0};
+  CHECK_OK(RunHloBenchmark(
+      state, hlo, args,
+      {{"$d0", absl::StrCat(d0)}, {"$d1", absl::StrCat(d1)}}));
+}
+
+// Reduces the rows of a [batch, classes] matrix, i.e. the max in softmax.
+static void BM_RowReduceMaxF32(benchmark::State& state) {
+  int64_t d0 = state.range(0);
+  int64_t d1 = state.range(1);
+
+  std::string_view hlo = R"(
+    HloModule row_reduce_max_f32_$d0_$d1
+
+    max {
+      p0 = f32[] parameter(0)
+      p1 = f32[] parameter(1)
+      ROOT max = f32[] maximum(p0, p1)
+    }
+
+    ENTRY e {
+      p0 = f32[$d0,$d1] parameter(0)
+      c0 = f32[] constant(-inf)
+      ROOT reduce = f32[$d0] reduce(p0, c0), dimensions={1}, to_apply=max
+    }
+  )";
+
+  std::minstd_rand0 engine;
+
+  auto shape = ShapeUtil::MakeShape(F32, {d0, d1});
+  auto p0 = *LiteralUtil::CreateRandomLiteral<F32>(shape, &engine, 1.0f, 0.1f);
+
+  std::vector<const Literal*> args = {&p0};
+  CHECK_OK(RunHloBenchmark(
+      state, hlo, args,
+      {{"$d0", absl::StrCat(d0)}, {"$d1", absl::StrCat(d1)}}));
+}
+
 #define BENCHMARK_SIZES(NAME)   \
   BENCHMARK(NAME)               \
       ->MeasureProcessCPUTime() \
@@ -99,4 +163,15 @@ static void BM_ReduceAddBF16(benchmark::State& state) {
 BENCHMARK_SIZES(BM_ReduceAddF32);
 BENCHMARK_SIZES(BM_ReduceAddBF16);
 
+#define BENCHMARK_ROW_SIZES(NAME) \
+  BENCHMARK(NAME)                 \
+      ->MeasureProcessCPUTime()   \
+      ->Args({128, 768})          \
+      ->Args({512, 1024})         \
+      ->Args({2048, 1000})        \
+      ->Args({4096, 4096})
+
+BENCHMARK_ROW_SIZES(BM_RowReduceAddF32);
+BENCHMARK_ROW_SIZES(BM_RowReduceMaxF32);
+
 }  // namespace xla::cpu
@@ -0,0 +1,114 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/cpu/constant_pool.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/hash/hash.h"
+#include "absl/synchronization/mutex.h"
+#include "xla/literal.h"
+#include "tsl/platform/logging.h"
+
+namespace xla::cpu {
+namespace {
+
+// Hashes the shape (including layout) and the full contents of a literal.
+struct LayoutSensitiveLiteral {
+  const Literal& literal;
+
+  template <typename H>
+  friend H AbslHashValue(H h, const LayoutSensitiveLiteral& wrapper) {
+    return Literal::Hash<H, /*kIsLayoutSensitive=*/true>(std::move(h),
+                                                         wrapper.literal);
+  }
+};
+
+// Removes expired literals from the pool once this many were added since the
+// last sweep, so that the pool doesn't accumulate dead references.
+constexpr int64_t kRemoveExpiredPeriod = 64;
+
+}  // namespace
+
+ConstantPool& ConstantPool::Global() {
+  static auto* pool = new ConstantPool();
+  return *pool;
+}
+
+std::shared_ptr<Literal> ConstantPool::Intern(
+    std::shared_ptr<Literal> literal) {
+  if (!literal->shape().IsArray() || literal->size_bytes() < kMinSizeBytes) {
+    return literal;
+  }
+
+  // Hash outside of the lock, it touches every byte of the literal.
+  size_t hash = absl::HashOf(LayoutSensitiveLiteral{*literal});
+
+  absl::MutexLock lock(&mu_);
+  std::vector<std::weak_ptr<Literal>>& bucket = literals_[hash];
+
+  for (auto it = bucket.begin(); it != bucket.end();) {
+    std::shared_ptr<Literal> pooled = it->lock();
+    if (pooled == nullptr) {
+      it = bucket.erase(it);
+      continue;
+    }
+    if (pooled == literal ||
+        pooled->Equal(*literal, /*layout_sensitive=*/true)) {
+      VLOG(3) << "Share constant literal of " << literal->size_bytes()
+              << " bytes; shape=" << literal->shape();
+      return pooled;
+    }
+    ++it;
+  }
+
+  bucket.push_back(literal);
+  if (++num_added_ >= kRemoveExpiredPeriod) {
+    RemoveExpired();
+  }
+  return literal;
+}
+
+size_t ConstantPool::size() const {
+  absl::MutexLock lock(&mu_);
+  size_t size = 0;
+  for (const auto& [hash, bucket] : literals_) {
+    for (const std::weak_ptr<Literal>& literal : bucket) {
+      size += !literal.expired();
+    }
+  }
+  return size;
+}
+
+void ConstantPool::RemoveExpired() {
+  num_added_ = 0;
+  absl::erase_if(literals_, [](auto& entry) {
+    std::vector<std::weak_ptr<Literal>>& bucket = entry.second;
+    bucket.erase(std::remove_if(bucket.begin(), bucket.end(),
+                                [](const std::weak_ptr<Literal>& literal) {
+                                  return literal.expired();
+                                }),
+                 bucket.end());
+    return bucket.empty();
+  });
+}
+
+}  // namespace xla::cpu
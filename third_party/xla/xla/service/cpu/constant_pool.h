@@ -0,0 +1,74 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_SERVICE_CPU_CONSTANT_POOL_H_
+#define XLA_SERVICE_CPU_CONSTANT_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "xla/literal.h"
+
+namespace xla::cpu {
+
+// A content-addressed pool of constant literals shared by CPU executables.
+//
+// Related executables (e.g. compilations of the same model for different
+// input shapes) often embed identical large constants, such as folded weights
+// or lookup tables. Interning the literals of their constant allocations makes
+// all of them share a single copy of the data.
+//
+// The pool does not own the literals: it only keeps weak references, and a
+// literal is freed when the last executable that uses it is destroyed. Shared
+// literals must not be mutated in place (HloConstantInstruction copies a
+// shared literal on write).
+class ConstantPool {
+ public:
+  // Constants smaller than this are not worth hashing and are never shared.
+  static constexpr int64_t kMinSizeBytes = 1024;
+
+  // Returns the process-wide constant pool.
+  static ConstantPool& Global();
+
+  // Returns a literal equal to `literal` (layout sensitive) that is shared
+  // with every other user of the pool. If there is no such literal in the
+  // pool, or `literal` is too small, returns `literal` itself.
+  std::shared_ptr<Literal> Intern(std::shared_ptr<Literal> literal);
+
+  // Returns the number of live literals in the pool.
+  size_t size() const;
+
+ private:
+  // Drops references to literals that were freed.
+  void RemoveExpired() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  mutable absl::Mutex mu_;
+
+  // Literals bucketed by the hash of their shape and contents.
+  absl::flat_hash_map<size_t, std::vector<std::weak_ptr<Literal>>> literals_
+      ABSL_GUARDED_BY(mu_);
+
+  // Number of literals added since the last time expired ones were removed.
+  int64_t num_added_ ABSL_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace xla::cpu
+
+#endif  // XLA_SERVICE_CPU_CONSTANT_POOL_H_
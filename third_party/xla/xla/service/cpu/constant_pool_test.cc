@@ -0,0 +1,76 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/cpu/constant_pool.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "xla/literal.h"
+#include "xla/literal_util.h"
+#include "tsl/platform/test.h"
+
+namespace xla::cpu {
+namespace {
+
+std::shared_ptr<Literal> MakeLiteral(int64_t size, float value) {
+  return std::make_shared<Literal>(
+      LiteralUtil::CreateR1<float>(std::vector<float>(size, value)));
+}
+
+TEST(ConstantPoolTest, SharesEqualLiterals) {
+  ConstantPool pool;
+
+  auto a = MakeLiteral(1024, 1.0f);
+  auto b = MakeLiteral(1024, 1.0f);
+  auto c = MakeLiteral(1024, 2.0f);
+
+  EXPECT_EQ(pool.Intern(a), a);
+  EXPECT_EQ(pool.Intern(b), a);
+  EXPECT_EQ(pool.Intern(c), c);
+  EXPECT_EQ(pool.Intern(a), a);
+  EXPECT_EQ(pool.size(), 2);
+}
+
+TEST(ConstantPoolTest, DoesNotShareSmallLiterals) {
+  ConstantPool pool;
+
+  auto a = MakeLiteral(4, 1.0f);
+  auto b = MakeLiteral(4, 1.0f);
+
+  EXPECT_EQ(pool.Intern(a), a);
+  EXPECT_EQ(pool.Intern(b), b);
+  EXPECT_EQ(pool.size(), 0);
+}
+
+TEST(ConstantPoolTest, DoesNotKeepLiteralsAlive) {
+  ConstantPool pool;
+
+  auto a = MakeLiteral(1024, 1.0f);
+  EXPECT_EQ(pool.Intern(a), a);
+
+  std::weak_ptr<Literal> weak_a = a;
+  a.reset();
+  EXPECT_TRUE(weak_a.expired());
+  EXPECT_EQ(pool.size(), 0);
+
+  auto b = MakeLiteral(1024, 1.0f);
+  EXPECT_EQ(pool.Intern(b), b);
+  EXPECT_EQ(pool.size(), 1);
+}
+
+}  // namespace
+}  // namespace xla::cpu
@@ -49,9 +49,13 @@ limitations under the License.
 #include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/ExecutionEngine/Orc/ThreadSafeModule.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalValue.h"
 #include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Mangler.h"
 #include "llvm/IR/Module.h"
@@ -61,6 +65,7 @@ limitations under the License.
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/CodeGen.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/MemoryBufferRef.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/raw_ostream.h"
@@ -68,7 +73,9 @@ limitations under the License.
 #include "llvm/Target/TargetOptions.h"
 #include "llvm/TargetParser/Host.h"
 #include "llvm/TargetParser/Triple.h"
+#include "llvm/Transforms/Utils/Cloning.h"
 #include "llvm/Transforms/Utils/SplitModule.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "mlir/Dialect/Vector/IR/VectorOps.h"
 #include "mlir/Pass/PassManager.h"
@@ -123,6 +130,7 @@ limitations under the License.
 #include "xla/hlo/transforms/simplifiers/hlo_constant_folding.h"
 #include "xla/hlo/transforms/simplifiers/hlo_dce.h"
 #include "xla/hlo/transforms/simplifiers/hlo_memory_scheduler.h"
+#include "xla/hlo/transforms/simplifiers/hlo_rematerialization.h"
 #include "xla/hlo/transforms/simplifiers/optimize_input_output_buffer_alias.h"
 #include "xla/hlo/transforms/simplifiers/reduce_window_rewriter.h"
 #include "xla/hlo/transforms/simplifiers/reshape_mover.h"
@@ -151,6 +159,7 @@ limitations under the License.
 #include "xla/service/conditional_to_select.h"
 #include "xla/service/copy_insertion.h"
 #include "xla/service/cpu/buffer_info_util.h"
+#include "xla/service/cpu/constant_pool.h"
 #include "xla/service/cpu/conv_canonicalization.h"
 #include "xla/service/cpu/cpu_executable.h"
 #include "xla/service/cpu/cpu_instruction_fusion.h"
@@ -160,6 +169,7 @@ limitations under the License.
 #include "xla/service/cpu/executable.pb.h"
 #include "xla/service/cpu/ir_emitter.h"
 #include "xla/service/cpu/ir_emitter2.h"
+#include "xla/service/cpu/kernel_object_cache.h"
 #include "xla/service/cpu/metrics.h"
 #include "xla/service/cpu/parallel_task_assignment.h"
 #include "xla/service/cpu/runtime_symbol_generator.h"
@@ -213,6 +223,7 @@ limitations under the License.
 #include "tsl/platform/cpu_info.h"
 #include "tsl/platform/env.h"
 #include "tsl/platform/errors.h"
+#include "tsl/platform/fingerprint.h"
 #include "tsl/platform/logging.h"  // IWYU pragma: keep
 #include "tsl/platform/status.h"
 #include "tsl/platform/statusor.h"
@@ -521,6 +532,8 @@ absl::Status CpuCompiler::RunHloPassesThroughLayoutAssn(
     TF_RETURN_IF_ERROR(subbyte_packer_pipeline.Run(module).status());
   }
   HloPassPipeline pipeline("HLO passes through layout assignment");
+  // Run computation passes over independent computations in parallel.
+  pipeline.set_thread_pool(GetCompilationThreadPool());
   AddHloVerifier(&pipeline);
 
   pipeline.AddPass<ResultCaster>();
@@ -766,6 +779,8 @@ absl::Status CpuCompiler::RunHloPassesAfterLayoutAssn(
     TargetMachineFeatures* target_machine_features,
     const CompileOptions& compile_options, bool is_mlir_compile) {
   HloPassPipeline pipeline("HLO passes after layout assignment");
+  // Run computation passes over independent computations in parallel.
+  pipeline.set_thread_pool(GetCompilationThreadPool());
 
   // CopyInsertion is still needed by BufferAssignment. MLIR passes will handle
   // everything else done by XLA, but CopyInsertion is needed to interface with
@@ -1111,7 +1126,8 @@ std::vector<ComputationToEmit> SubcomputationEmissionOrder(
 
 static absl::StatusOr<CpuExecutable::ConstantAllocation>
 LiteralToConstantAllocation(BufferAllocation::Index index,
-                            const Literal& literal) {
+                            const Literal& literal,
+                            int64_t* shared_size_bytes) {
   // TODO(ezhulenev): This code is almost identical to code in XLA:GPU, we
   // should standardize it. See `xla/service/gpu/ir_emission_utils.cc`.
   PrimitiveType element_type = literal.shape().element_type();
@@ -1131,7 +1147,7 @@ LiteralToConstantAllocation(BufferAllocation::Index index,
     // Use Literal as a storage for packed data as it allocates underlying
     // buffer with correct alignment. Keep it allocated on heap to avoid
     // capturing stack address that will be invalidated by a move below.
-    auto packed = std::make_unique<Literal>(
+    auto packed = std::make_shared<Literal>(
         ShapeUtil::MakeShape(U8, {packed_size_bytes}));
 
     PackIntN(
@@ -1140,7 +1156,11 @@ LiteralToConstantAllocation(BufferAllocation::Index index,
         absl::MakeSpan(reinterpret_cast<char*>(packed->untyped_data()),
                        packed->size_bytes()));
 
-    return CpuExecutable::ConstantAllocation{index, std::move(packed)};
+    // Share packed data with other executables that have the same constant.
+    std::shared_ptr<Literal> shared = ConstantPool::Global().Intern(packed);
+    if (shared != packed) *shared_size_bytes += shared->size_bytes();
+
+    return CpuExecutable::ConstantAllocation{index, std::move(shared)};
   }
 
   // Create a constant allocation from the literal's untyped data.
@@ -1150,9 +1170,15 @@ LiteralToConstantAllocation(BufferAllocation::Index index,
 }
 
 // Creates a vector of constant allocations from the given buffer assignment.
+//
+// Constant literals are interned in the process-wide constant pool, so that
+// identical constants of different executables share their storage. Returns
+// the number of bytes shared with other executables in `shared_size_bytes`.
 static absl::StatusOr<std::vector<CpuExecutable::ConstantAllocation>>
-CreateConstantAllocations(const BufferAssignment& assignment) {
+CreateConstantAllocations(const BufferAssignment& assignment,
+                          int64_t* shared_size_bytes) {
   std::vector<CpuExecutable::ConstantAllocation> constants;
+  *shared_size_bytes = 0;
 
   for (const BufferAllocation& allocation : assignment.Allocations()) {
     if (!allocation.is_constant()) {
@@ -1179,14 +1205,25 @@ CreateConstantAllocations(const BufferAssignment& assignment) {
                        allocation.ToString()));
     }
 
+    // Replace the literal with an identical one owned by another executable.
+    auto* constant = Cast<HloConstantInstruction>(const_instr);
+    std::shared_ptr<Literal> shared =
+        ConstantPool::Global().Intern(constant->shared_literal());
+    if (shared != constant->shared_literal()) {
+      *shared_size_bytes += shared->size_bytes();
+      constant->set_shared_literal(std::move(shared));
+    }
+
     VLOG(3) << "Create constant allocation for index " << allocation.index()
             << " from constant literal " << const_instr->name()
             << "; shape=" << const_instr->literal().shape();
-    TF_ASSIGN_OR_RETURN(constants.emplace_back(),
-                        LiteralToConstantAllocation(allocation.index(),
-                                                    const_instr->literal()));
+    TF_ASSIGN_OR_RETURN(
+        constants.emplace_back(),
+        LiteralToConstantAllocation(allocation.index(), constant->literal(),
+                                    shared_size_bytes));
   }
 
+  RecordCpuSharedConstantsBytes(*shared_size_bytes);
   return constants;
 }
 
@@ -1222,7 +1259,7 @@ static void RemoveUnusedSymbols(llvm::Module& module) {
 // separate LLVM context. We take each part of the original module after a
 // split, and clone it into a new LLVM context.
 static llvm::orc::ThreadSafeModule CloneAsThreadSafeModule(
-    int64_t part, std::unique_ptr<llvm::Module> module) {
+    int64_t part, const llvm::Module& module) {
   TraceMe trace([&] {
     return TraceMeEncode("CpuCompiler::CloneAsThreadSafeModule",
                          {{"part", part}});
@@ -1232,7 +1269,7 @@ static llvm::orc::ThreadSafeModule CloneAsThreadSafeModule(
   // to serialize the module to bitcode and parse it back into the new context.
   llvm::SmallString<0> bc;
   llvm::raw_svector_ostream bcos(bc);
-  llvm::WriteBitcodeToFile(*module, bcos);
+  llvm::WriteBitcodeToFile(module, bcos);
 
   // Parse module back into its own LLVM context.
   auto clone_context = std::make_unique<llvm::LLVMContext>();
@@ -1252,6 +1289,25 @@ struct CompiledSymbolsPart {
   std::vector<IrEmitter2::KernelInfo> kernels;
   std::vector<IrEmitter2::ComparatorInfo> comparators;
 };
+
+// Runs cost analysis on all non-fusion computations of the module, so that the
+// thunk emitter can estimate costs of thunks in nested computations (e.g.
+// while loop bodies) too. Returns nullptr if cost analysis fails, as thunk
+// cost estimates are only used as a scheduling hint.
+std::unique_ptr<HloCostAnalysis> RunThunkCostAnalysis(
+    const HloModule& module) {
+  auto cost_analysis =
+      std::make_unique<HloCostAnalysis>(CpuExecutable::ShapeSizeBytes);
+  for (const HloComputation* computation :
+       module.MakeNonfusionComputations()) {
+    if (absl::Status status = computation->Accept(cost_analysis.get());
+        !status.ok()) {
+      VLOG(1) << "Failed to estimate thunk costs: " << status;
+      return nullptr;
+    }
+  }
+  return cost_analysis;
+}
 }  // namespace
 
 // Collect IrEmitter2 symbols that got into the LLVM module part. We issue
@@ -1312,6 +1368,243 @@ static bool HasLargeConstants(llvm::Module& module) {
   return false;
 }
 
+// Prefix of the symbols of kernels that are compiled into their own object
+// files, so that they can be shared through the kernel object cache.
+static constexpr std::string_view kCachedKernelPrefix =
+    "__xla_cpu_cached_kernel_";
+
+namespace {
+// A kernel extracted from the XLA LLVM module into its own LLVM module.
+struct CachedKernel {
+  std::string symbol;
+
+  // Object file from the kernel object cache, or null on a cache miss.
+  std::shared_ptr<const std::string> obj_file;
+
+  // LLVM module with the kernel that has to be compiled on a cache miss.
+  std::unique_ptr<llvm::Module> module;
+};
+
+// Kernels extracted from the XLA LLVM module for caching.
+struct CachedKernels {
+  // Extracted kernels by cache key. Identical kernels share one entry.
+  absl::flat_hash_map<std::string, CachedKernel> kernels;
+
+  // Cache keys of extracted kernels by kernel name.
+  absl::flat_hash_map<std::string, std::string> keys;
+};
+}  // namespace
+
+// Returns a string that identifies the target machine and the compiler options
+// that, together with the LLVM IR, determine the object code of a kernel.
+static std::string KernelObjectCacheTarget(
+    const llvm::TargetMachine& target_machine,
+    const IrCompiler::Options& options) {
+  std::string fast_math_flags;
+  llvm::raw_string_ostream fmf_os(fast_math_flags);
+  options.fast_math_flags.print(fmf_os);
+  fmf_os.flush();
+
+  return absl::StrCat(
+      "llvm=", LLVM_VERSION_STRING,
+      ";triple=", target_machine.getTargetTriple().str(),
+      ";cpu=", target_machine.getTargetCPU().str(),
+      ";features=", target_machine.getTargetFeatureString().str(),
+      ";opt_level=", static_cast<int>(options.opt_level),
+      ";optimize_for_size=", options.optimize_for_size,
+      ";fast_math_flags=", fast_math_flags,
+      ";disable_expensive_passes=", options.disable_expensive_passes,
+      ";disable_slp_vectorizer=", options.disable_slp_vectorizer,
+      ";dfsan=", options.dfsan_enabled);
+}
+
+// Collects all global values (functions and global variables) that are
+// transitively used by `function`, including the function itself.
+static absl::flat_hash_set<const llvm::GlobalValue*> CollectUsedGlobals(
+    const llvm::Function& function) {
+  absl::flat_hash_set<const llvm::GlobalValue*> used = {&function};
+  absl::flat_hash_set<const llvm::Constant*> visited_constants;
+
+  std::vector<const llvm::GlobalValue*> globals = {&function};
+  std::vector<const llvm::Constant*> constants;
+
+  auto visit = [&](const llvm::Value* value) {
+    if (auto* gv = llvm::dyn_cast<llvm::GlobalValue>(value)) {
+      if (used.insert(gv).second) globals.push_back(gv);
+    } else if (auto* c = llvm::dyn_cast<llvm::Constant>(value)) {
+      if (visited_constants.insert(c).second) constants.push_back(c);
+    }
+  };
+
+  while (!globals.empty()) {
+    const llvm::GlobalValue* gv = globals.back();
+    globals.pop_back();
+
+    if (auto* f = llvm::dyn_cast<llvm::Function>(gv)) {
+      for (const llvm::BasicBlock& block : *f) {
+        for (const llvm::Instruction& instruction : block) {
+          for (const llvm::Use& operand : instruction.operands()) {
+            visit(operand.get());
+          }
+        }
+      }
+    } else if (auto* var = llvm::dyn_cast<llvm::GlobalVariable>(gv)) {
+      if (var->hasInitializer()) visit(var->getInitializer());
+    }
+
+    // Constant expressions and aggregates can refer to other globals.
+    while (!constants.empty()) {
+      const llvm::Constant* c = constants.back();
+      constants.pop_back();
+      for (const llvm::Use& operand : c->operands()) visit(operand.get());
+    }
+  }
+
+  return used;
+}
+
+// Extracts `kernel` together with all globals it uses into a new LLVM module,
+// and replaces the body of `kernel` in `module` with a tail call to the
+// extracted kernel. Returns the cache key of the extracted kernel.
+//
+// All globals in the extracted module except for the kernel become internal
+// and anonymous, and the kernel is named after the fingerprint of the LLVM IR
+// and the `target`, so identical kernels emitted for different HLO modules
+// end up with the same cache key and symbol name. The kernel has weak ODR
+// linkage, as every dynamic library that calls it gets its own definition.
+static std::pair<std::string, std::unique_ptr<llvm::Module>> ExtractKernel(
+    llvm::Module& module, llvm::Function& kernel, std::string_view target) {
+  absl::flat_hash_set<const llvm::GlobalValue*> used =
+      CollectUsedGlobals(kernel);
+
+  llvm::ValueToValueMapTy vmap;
+  std::unique_ptr<llvm::Module> extracted = llvm::CloneModule(
+      module, vmap,
+      [&](const llvm::GlobalValue* gv) { return used.contains(gv); });
+  RemoveUnusedSymbols(*extracted);
+
+  auto* extracted_kernel = llvm::cast<llvm::Function>(vmap[&kernel]);
+  for (llvm::GlobalValue& gv : extracted->global_values()) {
+    if (&gv == extracted_kernel || gv.isDeclaration()) continue;
+    gv.setLinkage(llvm::GlobalValue::InternalLinkage);
+    gv.setName("");
+  }
+  extracted_kernel->setLinkage(llvm::GlobalValue::WeakODRLinkage);
+
+  // Local value names are derived from HLO instruction names.
+  for (llvm::Function& f : extracted->functions()) {
+    for (llvm::Argument& arg : f.args()) arg.setName("");
+    for (llvm::BasicBlock& block : f) {
+      block.setName("");
+      for (llvm::Instruction& instruction : block) instruction.setName("");
+    }
+  }
+
+  // Fingerprint the LLVM IR without any names that depend on the HLO module.
+  extracted_kernel->setName(kCachedKernelPrefix);
+  extracted->setModuleIdentifier("");
+  extracted->setSourceFileName("");
+
+  std::string ir;
+  llvm::raw_string_ostream ir_os(ir);
+  extracted->print(ir_os, /*AAW=*/nullptr);
+  ir_os.flush();
+
+  tsl::Fprint128 fingerprint = tsl::Fingerprint128(absl::StrCat(target, ir));
+  std::string key =
+      absl::StrFormat("%016x%016x", fingerprint.high64, fingerprint.low64);
+
+  std::string symbol = absl::StrCat(kCachedKernelPrefix, key);
+  extracted_kernel->setName(symbol);
+  extracted->setModuleIdentifier(symbol);
+
+  // Forward the original kernel to the extracted one.
+  kernel.deleteBody();
+  llvm::FunctionCallee callee =
+      module.getOrInsertFunction(symbol, kernel.getFunctionType());
+
+  llvm::IRBuilder<> b(
+      llvm::BasicBlock::Create(module.getContext(), "entry", &kernel));
+  llvm::SmallVector<llvm::Value*> args;
+  for (llvm::Argument& arg : kernel.args()) args.push_back(&arg);
+
+  llvm::CallInst* call = b.CreateCall(callee, args);
+  call->setTailCall();
+  if (kernel.getReturnType()->isVoidTy()) {
+    b.CreateRetVoid();
+  } else {
+    b.CreateRet(call);
+  }
+
+  return {std::move(key), std::move(extracted)};
+}
+
+// Extracts all kernels emitted by `ir_emitter` from `module` into their own
+// LLVM modules, and looks up their object code in the kernel object cache.
+static CachedKernels ExtractCachedKernels(llvm::Module& module,
+                                          const IrEmitter2& ir_emitter,
+                                          std::string_view target,
+                                          std::string_view cache_dir) {
+  TraceMe trace([&] {
+    return TraceMeEncode("CpuCompiler::ExtractCachedKernels",
+                         {{"num_kernels", ir_emitter.kernels().size()}});
+  });
+
+  CachedKernels cached_kernels;
+  size_t num_cache_hits = 0;
+
+  for (const IrEmitter2::KernelInfo& kernel_info : ir_emitter.kernels()) {
+    llvm::Function* kernel = module.getFunction(kernel_info.name);
+    if (kernel == nullptr || kernel->isDeclaration()) continue;
+
+    auto [key, extracted] = ExtractKernel(module, *kernel, target);
+    cached_kernels.keys[kernel_info.name] = key;
+
+    auto [it, inserted] = cached_kernels.kernels.try_emplace(key);
+    if (!inserted) continue;
+
+    CachedKernel& cached = it->second;
+    cached.symbol = absl::StrCat(kCachedKernelPrefix, key);
+    cached.obj_file = KernelObjectCache::Global().Lookup(key, cache_dir);
+    if (cached.obj_file) {
+      ++num_cache_hits;
+    } else {
+      cached.module = std::move(extracted);
+    }
+  }
+
+  VLOG(2) << "Found " << num_cache_hits << " of "
+          << cached_kernels.kernels.size()
+          << " unique kernels in the kernel object cache";
+
+  return cached_kernels;
+}
+
+// Returns the cache key of the kernel extracted for caching that is defined in
+// the object file, or nullopt if the object file doesn't define one.
+static std::optional<std::string> CachedKernelKey(
+    const llvm::object::ObjectFile& obj_file) {
+  for (const llvm::object::SymbolRef& symbol : obj_file.symbols()) {
+    llvm::Expected<uint32_t> flags = symbol.getFlags();
+    llvm::Expected<llvm::StringRef> name = symbol.getName();
+    if (!flags || !name) {
+      llvm::consumeError(flags.takeError());
+      llvm::consumeError(name.takeError());
+      continue;
+    }
+
+    // Object files with wrapper kernels only refer to cached kernels.
+    if (*flags & llvm::object::SymbolRef::SF_Undefined) continue;
+
+    // Symbol names might be mangled with a platform-specific prefix.
+    size_t pos = name->find(kCachedKernelPrefix);
+    if (pos == llvm::StringRef::npos) continue;
+
+    return name->substr(pos + kCachedKernelPrefix.size()).str();
+  }
+  return std::nullopt;
+}
+
 inline void VlogMaxIsa(absl::string_view max_cpu_isa) {
   if (VLOG_IS_ON(1) && !max_cpu_isa.empty()) {
     if (tsl::port::IsX86CPU()) {
@@ -1324,6 +1617,77 @@ inline void VlogMaxIsa(absl::string_view max_cpu_isa) {
   }
 }
 
+// Returns a module scheduler that minimizes memory usage if the module has a
+// memory limit, and otherwise the scheduler selected by the debug options.
+static ModuleSchedulerAlgorithm CpuModuleScheduler(
+    const DebugOptions& debug_options) {
+  if (debug_options.xla_cpu_memory_limit_bytes() > 0) {
+    return ComputationSchedulerToModuleScheduler(DefaultMemoryScheduler);
+  }
+  // Select a memory scheduler optimized for concurrency vs minimal memory.
+  return ComputationSchedulerToModuleScheduler(
+      debug_options.xla_cpu_enable_concurrency_optimized_scheduler()
+          ? BFSMemoryScheduler
+          : DFSMemoryScheduler);
+}
+
+// Rematerializes instructions of the scheduled module to bring its peak memory
+// usage below the memory limit from the debug options, at the cost of
+// recomputing some values. Does nothing if the module has no memory limit.
+static absl::Status RematerializeForMemoryLimit(HloModule* module) {
+  int64_t memory_limit_bytes =
+      module->config().debug_options().xla_cpu_memory_limit_bytes();
+  if (memory_limit_bytes <= 0) return absl::OkStatus();
+
+  TraceMe trace([&] {
+    return TraceMeEncode("CpuCompiler::RematerializeForMemoryLimit",
+                         {{"memory_limit_bytes", memory_limit_bytes}});
+  });
+
+  HloCostAnalysis cost_analysis(CpuExecutable::ShapeSizeBytes);
+  HloRematerialization::RematerializationSizes sizes;
+  HloRematerialization::Options options(
+      cost_analysis,
+      HloRematerialization::RematerializationModeConfig(
+          /*recompute=*/true, /*compress=*/false, /*host_offload=*/false),
+      memory_limit_bytes, /*block_size_limit=*/1,
+      /*block_rematerialization_factor=*/1, /*min_remat_size=*/0,
+      /*compact_shape_function=*/nullptr);
+
+  HloRematerialization rematerialization(std::move(options), sizes);
+  TF_ASSIGN_OR_RETURN(bool changed, rematerialization.Run(module));
+
+  if (changed) {
+    VLOG(1) << "Rematerialization reduced peak memory of " << module->name()
+            << " from " << HumanReadableNumBytes(sizes.before_bytes) << " to "
+            << HumanReadableNumBytes(sizes.after_bytes) << " (limit: "
+            << HumanReadableNumBytes(memory_limit_bytes) << ")";
+  }
+  return absl::OkStatus();
+}
+
+// Reports the peak memory of the compiled program, which is the total size of
+// all buffer allocations, and warns if it exceeds the memory limit. Returns the
+// peak memory.
+static int64_t ReportCompiledPeakMemory(const HloModule& module,
+                                        const BufferAssignment& assignment) {
+  int64_t peak_memory_bytes = assignment.GetStats().total_allocation_bytes;
+  RecordCpuCompiledPeakMemoryBytes(peak_memory_bytes);
+
+  int64_t memory_limit_bytes =
+      module.config().debug_options().xla_cpu_memory_limit_bytes();
+  if (memory_limit_bytes > 0 && peak_memory_bytes > memory_limit_bytes) {
+    LOG(WARNING) << "Compiled peak memory of " << module.name() << " is "
+                 << HumanReadableNumBytes(peak_memory_bytes)
+                 << ", which exceeds the memory limit of "
+                 << HumanReadableNumBytes(memory_limit_bytes);
+  } else {
+    VLOG(1) << "Compiled peak memory of " << module.name() << " is "
+            << HumanReadableNumBytes(peak_memory_bytes);
+  }
+  return peak_memory_bytes;
+}
+
 absl::StatusOr<std::unique_ptr<CpuExecutable>>
 CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
   TraceMe trace([&] {
@@ -1367,11 +1731,41 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
       /*slp_vectorizer_disabled=*/options::SlpVectorizerDisabled(config),
   };
 
+  // Compile kernels into separate object files that can be shared with other
+  // compilations through the kernel object cache.
+  const bool enable_kernel_object_cache =
+      debug_options.xla_cpu_enable_kernel_object_cache() &&
+      debug_options.xla_cpu_use_thunk_runtime();
+  const std::string kernel_object_cache_dir =
+      debug_options.xla_cpu_kernel_object_cache_dir();
+
+  auto post_compilation_hook =
+      CreateOrcJITPostCompilationHook(module.get(), &obj_files);
+  if (enable_kernel_object_cache) {
+    // A kernel called from several LLVM module parts is compiled into each of
+    // their dynamic libraries, but we export and cache only one of the copies.
+    // Post compilation hooks are never called concurrently.
+    auto compiled_kernels =
+        std::make_shared<absl::flat_hash_set<std::string>>();
+    post_compilation_hook = [hook = std::move(post_compilation_hook),
+                             kernel_object_cache_dir, compiled_kernels](
+                                const llvm::object::ObjectFile& obj_file) {
+      std::optional<std::string> key = CachedKernelKey(obj_file);
+      if (key.has_value() && !compiled_kernels->insert(*key).second) return;
+
+      hook(obj_file);
+      if (key.has_value()) {
+        KernelObjectCache::Global().Insert(*key, obj_file.getData().str(),
+                                           kernel_object_cache_dir);
+      }
+    };
+  }
+
   // Compiler hooks to intercept compiled LLVM IR modules.
   IrCompiler::CompilationHooks ir_compiler_hooks{
       pre_optimization_ir_hook,
       post_optimization_ir_hook,
-      CreateOrcJITPostCompilationHook(module.get(), &obj_files),
+      std::move(post_compilation_hook),
   };
 
   // Definition generator to link with XLA:CPU host runtime symbols.
@@ -1383,7 +1777,7 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
 
   // Options for orchestrating the JIT compilation process.
   JitCompiler::Options jit_compiler_options{
-      std::move(ir_compiler_options),
+      ir_compiler_options,
       std::move(ir_compiler_hooks),
       /*num_dylibs=*/parallel_codegen_split_count,
       /*definition_generator=*/std::move(definition_generator),
@@ -1414,21 +1808,18 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
   const bool embed_ir_in_executable =
       debug_options.xla_embed_ir_in_executable();
 
-  // Select a memory scheduler optimized for concurrency vs minimal memory.
-  auto scheduler =
-      debug_options.xla_cpu_enable_concurrency_optimized_scheduler()
-          ? BFSMemoryScheduler
-          : DFSMemoryScheduler;
-
   // Select an order for emitting the HLO instructions for each
   // computation. Using this sequence enables tighter buffer liveness analysis
   // and reduced memory usage (as compared to using `DependencyHloOrdering`).
-  TF_ASSIGN_OR_RETURN(
-      HloSchedule schedule,
-      ScheduleModule(module.get(), BufferSizeBytesFunction(),
-                     ComputationSchedulerToModuleScheduler(scheduler)));
+  TF_ASSIGN_OR_RETURN(HloSchedule schedule,
+                      ScheduleModule(module.get(), BufferSizeBytesFunction(),
+                                     CpuModuleScheduler(debug_options)));
   TF_RETURN_IF_ERROR(module->set_schedule(schedule));
 
+  // Rematerialization adds instructions to the module schedule.
+  TF_RETURN_IF_ERROR(RematerializeForMemoryLimit(module.get()));
+  schedule = module->schedule();
+
   // Run buffer allocation on the HLO graph.
   TF_ASSIGN_OR_RETURN(
       std::unique_ptr<BufferAssignment> assignment,
@@ -1436,6 +1827,7 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
                           std::make_unique<SequentialHloOrdering>(schedule),
                           BufferSizeBytesFunction(), memory_alignment,
                           /*allocate_buffers_for_constants=*/true));
+  int64_t peak_memory_bytes = ReportCompiledPeakMemory(*module, *assignment);
   DumpHloModuleIfEnabled(*module, *assignment,
                          absl::StrCat("cpu_", kAfterOptimizationsDumpName));
 
@@ -1492,8 +1884,11 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
     // Thunk emitter is responsible for building a Thunk sequence that will
     // resolved kernels in the compiled LLVM module and execute them together
     // with Thunks implemented as library calls (e.g. oneDNN or Eigen).
+    std::unique_ptr<HloCostAnalysis> cost_analysis =
+        RunThunkCostAnalysis(*module);
     ThunkEmitter thunk_emitter(ir_emitter2, *assignment,
-                               target_machine_features, module->config());
+                               target_machine_features, module->config(),
+                               cost_analysis.get());
     TF_ASSIGN_OR_RETURN(ThunkSequence thunks,
                         thunk_emitter.EmitEntryComputation(*module));
 
@@ -1527,11 +1922,62 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
             << " kernels and " << ir_emitter2.comparators().size()
             << " comparators";
 
-    if (HasLargeConstants(*llvm_module)) {
+    bool has_large_constants = HasLargeConstants(*llvm_module);
+    if (has_large_constants) {
       VLOG(3) << "Skip parallel compilation due to large constants";
       num_parts = 1;
     }
 
+    // Extract kernels into their own LLVM modules and look them up in the
+    // kernel object cache. We don't cache kernels if the module has large
+    // constants, as we would have to copy them into every kernel module.
+    CachedKernels cached_kernels;
+    if (enable_kernel_object_cache && !has_large_constants) {
+      cached_kernels = ExtractCachedKernels(
+          *llvm_module, ir_emitter2,
+          KernelObjectCacheTarget(*jit_compiler.target_machine(),
+                                  ir_compiler_options),
+          kernel_object_cache_dir);
+
+      // Cached object files don't go through the post compilation hook, so
+      // we have to collect them for exporting the executable explicitly.
+      for (auto& [key, cached_kernel] : cached_kernels.kernels) {
+        if (cached_kernel.obj_file) {
+          obj_files.push_back(*cached_kernel.obj_file);
+        }
+      }
+    }
+
+    // Adds extracted kernels called from the module part to the same dynamic
+    // library, as wrapper kernels can only call into their own library.
+    auto add_cached_kernels = [&](const CompiledSymbolsPart& part,
+                                  size_t dylib_index) -> absl::Status {
+      absl::flat_hash_set<std::string_view> added;
+      for (const IrEmitter2::KernelInfo& kernel : part.kernels) {
+        auto key = cached_kernels.keys.find(kernel.name);
+        if (key == cached_kernels.keys.end()) continue;
+        if (!added.insert(key->second).second) continue;
+
+        const CachedKernel& cached_kernel =
+            cached_kernels.kernels.at(key->second);
+        if (cached_kernel.obj_file) {
+          TF_RETURN_IF_ERROR(jit_compiler.AddObjFile(
+              llvm::MemoryBuffer::getMemBufferCopy(*cached_kernel.obj_file,
+                                                   cached_kernel.symbol),
+              dylib_index));
+        } else {
+          auto tsm =
+              CloneAsThreadSafeModule(dylib_index, *cached_kernel.module);
+          tsm.withModuleDo([&](llvm::Module& m) {
+            m.setModuleIdentifier(cached_kernel.symbol);
+          });
+          TF_RETURN_IF_ERROR(jit_compiler.AddModule(std::move(tsm),
+                                                    dylib_index));
+        }
+      }
+      return absl::OkStatus();
+    };
+
     if (num_parts > 1) {
       VLOG(3) << "Split LLVM module into " << num_parts
               << " parts before codegen to enable parallel compilation"
@@ -1549,14 +1995,18 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
             compiled_parts.push_back(
                 CollectCompiledSymbolsPart(ir_emitter2, *llvm_module_part));
 
+            TF_CHECK_OK(add_cached_kernels(compiled_parts.back(), n));
+
             // Clone LLVM module part into its own thread safe context.
-            auto tsm = CloneAsThreadSafeModule(n, std::move(llvm_module_part));
+            auto tsm = CloneAsThreadSafeModule(n, *llvm_module_part);
             TF_CHECK_OK(
                 jit_compiler.AddModule(std::move(tsm), /*dylib_index=*/n++));
           },
           /*PreserveLocals=*/true, /*RoundRobin=*/true);
 
-      // Free resources used by the original LLVM module.
+      // Free resources used by the original LLVM module. Extracted kernel
+      // modules live in the same LLVM context and must be destroyed first.
+      cached_kernels.kernels.clear();
       llvm_module.reset();
       llvm_context.reset();
 
@@ -1565,6 +2015,8 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
               << parallel_codegen_split_count << ")";
       compiled_parts.push_back(
           CollectCompiledSymbolsPart(ir_emitter2, *llvm_module));
+      TF_RETURN_IF_ERROR(add_cached_kernels(compiled_parts.back(), 0));
+      cached_kernels.kernels.clear();
       TF_CHECK_OK(jit_compiler.AddModule(llvm::orc::ThreadSafeModule(
           std::move(llvm_module), std::move(llvm_context))));
     }
@@ -1595,9 +2047,10 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
                         std::move(jit_compiler).Compile(compiled_symbols));
 
     // Create constant allocations from the buffer assignment.
+    int64_t shared_constants_size_bytes = 0;
     TF_ASSIGN_OR_RETURN(
         std::vector<CpuExecutable::ConstantAllocation> constants,
-        CreateConstantAllocations(*assignment));
+        CreateConstantAllocations(*assignment, &shared_constants_size_bytes));
 
     TF_ASSIGN_OR_RETURN(
         auto cpu_executable,
@@ -1610,6 +2063,9 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
     // Save object files to be able to export them to AOT compilation
     // result.
     cpu_executable->set_obj_files(std::move(obj_files));
+    cpu_executable->set_shared_constants_size_bytes(
+        shared_constants_size_bytes);
+    cpu_executable->set_compiled_peak_memory_bytes(peak_memory_bytes);
 
     if (embed_ir_in_executable) {
       cpu_executable->set_ir_module_string(ir_module_string);
@@ -1675,6 +2131,7 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
                             std::move(hlo_profile_index_map)));
 
   cpu_executable->set_obj_files(std::move(obj_files));
+  cpu_executable->set_compiled_peak_memory_bytes(peak_memory_bytes);
 
   if (embed_ir_in_executable) {
     cpu_executable->set_ir_module_string(ir_module_string);
@@ -1813,8 +2270,15 @@ CpuCompiler::CompileAheadOfTime(std::unique_ptr<HloModuleGroup> module_group,
                        /*dummy*/ CompileOptions{},
                        /*is_mlir_compile=*/options.use_mlir_hlo_lowering()));
 
-      TF_ASSIGN_OR_RETURN(HloSchedule schedule,
-                          ScheduleModule(module, BufferSizeBytesFunction()));
+      TF_ASSIGN_OR_RETURN(
+          HloSchedule schedule,
+          ScheduleModule(module, BufferSizeBytesFunction(),
+                         CpuModuleScheduler(module->config().debug_options())));
+      TF_RETURN_IF_ERROR(module->set_schedule(schedule));
+
+      // Rematerialization adds instructions to the module schedule.
+      TF_RETURN_IF_ERROR(RematerializeForMemoryLimit(module));
+      schedule = module->schedule();
 
       // Run buffer analysis on the HLO graph. This analysis figures out which
       // temporary buffers are required to run the computation.
@@ -1824,6 +2288,7 @@ CpuCompiler::CompileAheadOfTime(std::unique_ptr<HloModuleGroup> module_group,
                               std::make_unique<SequentialHloOrdering>(schedule),
                               BufferSizeBytesFunction(), memory_alignment,
                               /*allocate_buffers_for_constants=*/true));
+      ReportCompiledPeakMemory(*module, *assignment);
       // BufferAssignment::ToString() includes a header, so no need for us to
       // print one ourselves.
       if (DumpingEnabledForHloModule(*module)) {
@@ -2130,8 +2595,11 @@ CpuExecutableAotCompilationResult::LoadExecutable(
 
     IrEmitter2 ir_emitter2(*module, llvm_module.get(), &nested_ir_emitter);
 
+    std::unique_ptr<HloCostAnalysis> cost_analysis =
+        RunThunkCostAnalysis(*module);
     ThunkEmitter thunk_emitter(ir_emitter2, *buffer_assignment,
-                               target_machine_features, module->config());
+                               target_machine_features, module->config(),
+                               cost_analysis.get());
     TF_ASSIGN_OR_RETURN(ThunkSequence thunks,
                         thunk_emitter.EmitEntryComputation(*module));
 
@@ -2152,9 +2620,11 @@ CpuExecutableAotCompilationResult::LoadExecutable(
                         std::move(jit_compiler).Compile(compiled_symbols));
 
     // Create constant allocations from the buffer assignment.
+    int64_t shared_constants_size_bytes = 0;
     TF_ASSIGN_OR_RETURN(
         std::vector<CpuExecutable::ConstantAllocation> constants,
-        CreateConstantAllocations(*buffer_assignment));
+        CreateConstantAllocations(*buffer_assignment,
+                                  &shared_constants_size_bytes));
 
     TF_ASSIGN_OR_RETURN(
         cpu_executable,
@@ -2162,6 +2632,8 @@ CpuExecutableAotCompilationResult::LoadExecutable(
                               std::move(buffer_assignment), std::move(module),
                               std::move(thunks), std::move(constants), nullptr,
                               nullptr));
+    cpu_executable->set_shared_constants_size_bytes(
+        shared_constants_size_bytes);
 
   } else if (proto_.obj_files_kind() == CompilationResultProto::CLASSIC) {
     // Create a "classic" CPU executable.
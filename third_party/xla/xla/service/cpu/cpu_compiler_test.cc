@@ -10,11 +10,16 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <utility>
 
+#include "xla/error_spec.h"
 #include "xla/pjrt/pjrt_client.h"
+#include "xla/service/cpu/kernel_object_cache.h"
+#include "xla/service/cpu/metrics.h"
 #include "xla/service/hlo_runner.h"
 #include "xla/service/hlo_runner_interface.h"
 #include "xla/service/hlo_runner_pjrt.h"
@@ -83,6 +88,91 @@ TEST_F(CpuCompilerTest, RecordsStreamzStackTrace) {
       0);
 }
 
+TEST_F(CpuCompilerTest, SharesKernelsThroughObjectCache) {
+  // Two modules with identical fusions that only differ in names.
+  const char* hlo_text_0 = R"(
+    HloModule test_0
+    ENTRY main {
+      p0 = f32[1024]{0} parameter(0)
+      p1 = f32[1024]{0} parameter(1)
+      mul = f32[1024]{0} multiply(p0, p1)
+      ROOT add = f32[1024]{0} add(mul, p0)
+    }
+  )";
+
+  const char* hlo_text_1 = R"(
+    HloModule test_1
+    ENTRY entry {
+      x = f32[1024]{0} parameter(0)
+      y = f32[1024]{0} parameter(1)
+      x_times_y = f32[1024]{0} multiply(x, y)
+      ROOT result = f32[1024]{0} add(x_times_y, x)
+    }
+  )";
+
+  auto enable_kernel_object_cache = [](HloModule* module) {
+    module->mutable_config()
+        .mutable_debug_options()
+        .set_xla_cpu_enable_kernel_object_cache(true);
+  };
+
+  TF_ASSERT_OK_AND_ASSIGN(auto module_0,
+                          ParseAndReturnVerifiedModule(hlo_text_0));
+  EXPECT_TRUE(RunAndCompare(std::move(module_0), ErrorSpec{1e-5},
+                            /*reference_preprocessor=*/nullptr,
+                            enable_kernel_object_cache));
+
+  size_t num_cached_kernels = KernelObjectCache::Global().size();
+  EXPECT_GT(num_cached_kernels, 0);
+
+  // The second module reuses the kernels compiled for the first one.
+  TF_ASSERT_OK_AND_ASSIGN(auto module_1,
+                          ParseAndReturnVerifiedModule(hlo_text_1));
+  EXPECT_TRUE(RunAndCompare(std::move(module_1), ErrorSpec{1e-5},
+                            /*reference_preprocessor=*/nullptr,
+                            enable_kernel_object_cache));
+  EXPECT_EQ(KernelObjectCache::Global().size(), num_cached_kernels);
+}
+
+TEST_F(CpuCompilerTest, RematerializesForMemoryLimit) {
+  // Broadcast `b` is a candidate for rematerialization: it is cheap to
+  // recompute, and it is used at the start and at the end of the computation.
+  // We skip HLO passes, so that `b` isn't simplified or fused into its users.
+  const char* hlo_text = R"(
+    HloModule test
+    ENTRY main {
+      p0 = f32[] parameter(0)
+      p1 = f32[512,512]{1,0} parameter(1)
+      b = f32[512,512]{1,0} broadcast(p0), dimensions={}
+      d0 = f32[512,512]{1,0} dot(p1, b), lhs_contracting_dims={1},
+                                         rhs_contracting_dims={0}
+      d1 = f32[512,512]{1,0} dot(d0, p1), lhs_contracting_dims={1},
+                                          rhs_contracting_dims={0}
+      d2 = f32[512,512]{1,0} dot(d1, p1), lhs_contracting_dims={1},
+                                          rhs_contracting_dims={0}
+      ROOT add = f32[512,512]{1,0} add(d2, b)
+    }
+  )";
+
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(hlo_text));
+  EXPECT_TRUE(Run(std::move(module), /*run_hlo_passes=*/false));
+  int64_t peak_memory_bytes = GetCpuCompiledPeakMemoryBytes();
+  EXPECT_GT(peak_memory_bytes, 0);
+
+  // The limit is below what rematerialization can achieve, so the compiler
+  // rematerializes as much as it can and still produces a valid executable.
+  // Recomputing `b` before `add` frees its buffer while the dots run, which
+  // saves one 512x512 temporary.
+  TF_ASSERT_OK_AND_ASSIGN(module, ParseAndReturnVerifiedModule(hlo_text));
+  EXPECT_TRUE(Run(std::move(module), /*run_hlo_passes=*/false,
+                  [](HloModule* module) {
+                    module->mutable_config()
+                        .mutable_debug_options()
+                        .set_xla_cpu_memory_limit_bytes(1);
+                  }));
+  EXPECT_LT(GetCpuCompiledPeakMemoryBytes(), peak_memory_bytes);
+}
+
 }  // namespace
 }  // namespace cpu
 }  // namespace xla
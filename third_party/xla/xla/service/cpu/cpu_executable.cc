@@ -20,6 +20,7 @@ limitations under the License.
 #include <stdint.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <memory>
 #include <optional>
@@ -47,6 +48,7 @@ limitations under the License.
 #include "xla/backends/cpu/runtime/thread_pool_task_runner.h"
 #include "xla/backends/cpu/runtime/thunk.h"
 #include "xla/backends/cpu/runtime/thunk_executor.h"
+#include "xla/backends/cpu/runtime/thunk_profiler.h"
 #include "xla/executable_run_options.h"
 #include "xla/hlo/ir/hlo_computation.h"
 #include "xla/hlo/ir/hlo_input_output_alias_config.h"
@@ -75,6 +77,7 @@ limitations under the License.
 #include "xla/xla_data.pb.h"
 #include "tsl/platform/env.h"
 #include "tsl/platform/logging.h"
+#include "tsl/platform/path.h"
 #include "tsl/platform/statusor.h"
 
 namespace xla {
@@ -105,8 +108,8 @@ se::DeviceMemoryBase ConstantAllocation::AsDeviceMemoryBase() const {
     return se::DeviceMemoryBase();
   }
 
-  if (auto* owned = std::get_if<std::unique_ptr<Literal>>(&data)) {
-    return se::DeviceMemoryBase((*owned)->untyped_data(),
+  if (auto* owned = std::get_if<std::shared_ptr<const Literal>>(&data)) {
+    return se::DeviceMemoryBase(const_cast<void*>((*owned)->untyped_data()),
                                 (*owned)->size_bytes());
   }
 
@@ -314,6 +317,30 @@ absl::Status CpuExecutable::ExecuteComputeFunction(
   return absl::OkStatus();
 }
 
+// Writes the Chrome trace recorded by `profiler` to a new file in `dir`.
+// Failing to dump the profile does not fail the execution.
+static void DumpThunkProfile(const ThunkProfiler& profiler,
+                             absl::string_view module_name,
+                             const std::string& dir) {
+  static std::atomic<int64_t> next_profile_id{0};
+
+  tsl::Env* env = tsl::Env::Default();
+  std::string path = tsl::io::JoinPath(
+      dir, absl::StrFormat("%s.%d.thunk_trace.json", module_name,
+                           next_profile_id.fetch_add(1)));
+
+  absl::Status status = env->RecursivelyCreateDir(dir);
+  if (status.ok()) {
+    status = tsl::WriteStringToFile(env, path, profiler.ToChromeTrace());
+  }
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to dump XLA:CPU thunk profile to " << path << ": "
+                 << status;
+  } else {
+    VLOG(1) << "Dumped XLA:CPU thunk profile to " << path;
+  }
+}
+
 absl::Status CpuExecutable::ExecuteThunks(
     const ExecutableRunOptions* run_options,
     absl::Span<MaybeOwningDeviceMemory const> buffers) {
@@ -359,9 +386,21 @@ absl::Status CpuExecutable::ExecuteThunks(
       &collective_execute_params,
       &custom_call_execute_params};
 
+  // Record the execution of every thunk if requested by the debug options.
+  const std::string& profile_dir =
+      module().config().debug_options().xla_cpu_thunk_profile_dir();
+  std::optional<ThunkProfiler> profiler;
+  if (!profile_dir.empty()) {
+    execute_params.profiler = &profiler.emplace();
+  }
+
   auto executed_event = thunks_->Execute(execute_params);
   tsl::BlockUntilReady(executed_event);
 
+  if (profiler.has_value()) {
+    DumpThunkProfile(*profiler, module_name(), profile_dir);
+  }
+
   if (run_options->execution_profile()) {
     uint64_t end_ns = tsl::Env::Default()->NowNanos();
     run_options->execution_profile()->set_compute_time_ns(
@@ -60,7 +60,7 @@ class CpuExecutable : public Executable {
     se::DeviceMemoryBase AsDeviceMemoryBase() const;
 
     BufferAllocation::Index index = -1;
-    std::variant<std::monostate, std::unique_ptr<Literal>,
+    std::variant<std::monostate, std::shared_ptr<const Literal>,
                  absl::Span<const uint8_t>>
         data;
   };
@@ -116,6 +116,27 @@ class CpuExecutable : public Executable {
 
   const std::string& module_name() const { return module_name_; }
 
+  // Size of the constants shared with other executables, which this executable
+  // would otherwise keep a copy of.
+  int64_t shared_constants_size_bytes() const {
+    return shared_constants_size_bytes_;
+  }
+
+  void set_shared_constants_size_bytes(int64_t size_bytes) {
+    shared_constants_size_bytes_ = size_bytes;
+  }
+
+  // Peak memory of the compiled program, i.e. the total size of its buffer
+  // allocations, as reported against xla_cpu_memory_limit_bytes. Zero for
+  // executables loaded from an AOT compilation result.
+  int64_t compiled_peak_memory_bytes() const {
+    return compiled_peak_memory_bytes_;
+  }
+
+  void set_compiled_peak_memory_bytes(int64_t peak_memory_bytes) {
+    compiled_peak_memory_bytes_ = peak_memory_bytes;
+  }
+
   static int64_t ShapeSizeBytes(const Shape& shape);
 
   // Type of the computation function we expect in the JIT.
@@ -208,6 +229,12 @@ class CpuExecutable : public Executable {
   // Unique identifier.
   std::string module_name_;
 
+  // Size of the constants shared with other executables via the constant pool.
+  int64_t shared_constants_size_bytes_ = 0;
+
+  // Total size of the buffer allocations when this executable was compiled.
+  int64_t compiled_peak_memory_bytes_ = 0;
+
   // We have two execution modes:
   //
   //   (1) HLO module compiled to a single function using LLVM JIT and we get
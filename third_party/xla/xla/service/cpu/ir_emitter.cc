@@ -80,6 +80,7 @@ limitations under the License.
 #include "xla/service/llvm_ir/buffer_assignment_util.h"
 #include "xla/service/llvm_ir/dynamic_update_slice_util.h"
 #include "xla/service/llvm_ir/ir_array.h"
+#include "xla/service/llvm_ir/kernel_support_library.h"
 #include "xla/service/llvm_ir/llvm_loop.h"
 #include "xla/service/llvm_ir/llvm_type_conversion_util.h"
 #include "xla/service/llvm_ir/llvm_util.h"
@@ -1787,9 +1788,27 @@ absl::StatusOr<bool> IrEmitter::EmitVectorizedReduce(
       MinimumAlignmentForPrimitiveType(reduce->shape().element_type())));
 
   if (is_reduction_over_minor_dimension) {
-    // TODO(sanjoy): Implement vectorized reduction over the minor dimension.
-    *failure_reason = "reduction over minor dimension not implemented";
-    return false;
+    // A partitioned root reduction only reduces the rows of its partition,
+    // which EmitTiledRowReduction supports along the most major dimension.
+    const bool is_partitioned = ShouldEmitParallelLoopFor(*reduce);
+    if (is_partitioned && num_dynamic_loop_bounds_ > 1) {
+      *failure_reason =
+          "tiled row reduction of more than one partitioned dimension not "
+          "implemented";
+      return false;
+    }
+    if (!CanEmitTiledRowReduction(reduce, failure_reason)) {
+      return false;
+    }
+    std::optional<std::pair<llvm::Value*, llvm::Value*>> outer_bounds;
+    if (is_partitioned) {
+      outer_bounds = compute_function()->GetDynamicLoopBounds()[0];
+    }
+    TF_RETURN_IF_ERROR(EmitTargetAddressForOp(reduce));
+    TF_RETURN_IF_ERROR(EmitTiledRowReduction(
+        reduce, GetIrArrayFor(arg), GetIrArrayFor(init_value),
+        GetIrArrayFor(reduce), outer_bounds));
+    return true;
   }
 
   CHECK(!reduce->shape().IsTuple());
@@ -1911,6 +1930,270 @@ absl::StatusOr<bool> IrEmitter::EmitVectorizedReduce(
   return true;
 }
 
+// Number of rows reduced together by EmitTiledRowReduction, and number of
+// vector accumulators per row. The 4x2 accumulators and the vectors loaded into
+// them fit into the 16 vector registers of AVX2.
+static constexpr int64_t kTiledRowReductionRows = 4;
+static constexpr int64_t kTiledRowReductionAccumulators = 2;
+
+// Bytes of each row reduced by a column block of EmitTiledRowReduction. A
+// column block of a row tile takes half of a 32KiB L1 data cache.
+static constexpr int64_t kTiledRowReductionColumnBlockBytes =
+    16 * 1024 / kTiledRowReductionRows;
+
+// Returns the number of elements reduced into each element of `reduce`.
+static int64_t RowReductionSize(const HloInstruction& reduce) {
+  int64_t row_size = 1;
+  for (int64_t dimension : reduce.dimensions()) {
+    row_size *= reduce.operand(0)->shape().dimensions(dimension);
+  }
+  return row_size;
+}
+
+bool IrEmitter::CanEmitTiledRowReduction(const HloInstruction* reduce,
+                                         std::string* failure_reason) const {
+  if (reduce->opcode() != HloOpcode::kReduce) {
+    *failure_reason = "not a reduce";
+    return false;
+  }
+  if (!reduce->shape().IsArray()) {
+    *failure_reason = "vectorization of variadic reduce not implemented";
+    return false;
+  }
+
+  const Shape& arg_shape = reduce->operand(0)->shape();
+  if (!arg_shape.is_static()) {
+    *failure_reason = "reduction of a dynamic shape not implemented";
+    return false;
+  }
+  if (!ReductionPreservesLayout(*reduce)) {
+    *failure_reason = "reduction does not preserve layout";
+    return false;
+  }
+
+  // Rows are contiguous in memory only if the reduced dimensions are the most
+  // minor ones.
+  absl::Span<const int64_t> dimensions = reduce->dimensions();
+  for (size_t i = 0; i < dimensions.size(); ++i) {
+    if (!absl::c_linear_search(dimensions,
+                               LayoutUtil::Minor(arg_shape.layout(), i))) {
+      *failure_reason = "reduced dimensions are not the most minor dimensions";
+      return false;
+    }
+  }
+
+  if (RowReductionSize(*reduce) < kTiledRowReductionAccumulators) {
+    *failure_reason = "rows are too short to vectorize";
+    return false;
+  }
+
+  return MatchReductionGenerator(reduce->to_apply(), failure_reason) !=
+         nullptr;
+}
+
+absl::Status IrEmitter::EmitTiledRowReduction(
+    const HloInstruction* reduce, const llvm_ir::IrArray& arg_array,
+    const llvm_ir::IrArray& init_value_array,
+    const llvm_ir::IrArray& output_array,
+    std::optional<std::pair<llvm::Value*, llvm::Value*>> outer_bounds) {
+  std::string failure_reason;
+  ReductionGenerator reduction_generator =
+      MatchReductionGenerator(reduce->to_apply(), &failure_reason);
+  TF_RET_CHECK(reduction_generator) << failure_reason;
+
+  PrimitiveType element_type = reduce->shape().element_type();
+  int64_t num_rows = ShapeUtil::ElementsIn(reduce->shape());
+  int64_t row_size = RowReductionSize(*reduce);
+
+  // Use the widest vectors that fit into a register and still give every
+  // accumulator at least one full vector of each row.
+  int64_t vector_size = std::max<int64_t>(
+      1, target_machine_features_.vector_register_byte_size(
+             *compute_function()->function()) /
+             ShapeUtil::ByteSizeOfPrimitiveType(element_type));
+  while (vector_size > 1 &&
+         vector_size * kTiledRowReductionAccumulators > row_size) {
+    vector_size /= 2;
+  }
+  const int64_t step = vector_size * kTiledRowReductionAccumulators;
+  const int64_t vectorized_row_size = row_size / step * step;
+
+  llvm::Type* element_ir_type = llvm_ir::PrimitiveTypeToIrType(
+      element_type, b()->GetInsertBlock()->getModule());
+  llvm::Type* accumulator_type =
+      vector_size == 1 ? element_ir_type
+                       : llvm::VectorType::get(element_ir_type, vector_size,
+                                               /*Scalable=*/false);
+  llvm::Align element_alignment(tsl::MathUtil::GCD<unsigned>(
+      ShapeUtil::ByteSizeOfPrimitiveType(element_type),
+      MinimumAlignmentForPrimitiveType(element_type)));
+
+  std::vector<llvm::AllocaInst*> accumulators;
+  for (int64_t i = 0;
+       i < kTiledRowReductionRows * kTiledRowReductionAccumulators; ++i) {
+    accumulators.push_back(llvm_ir::EmitAllocaAtFunctionEntry(
+        accumulator_type, "row_accumulator", b()));
+  }
+  llvm::AllocaInst* row_result =
+      llvm_ir::EmitAllocaAtFunctionEntry(element_ir_type, "row_result", b());
+  auto accumulator = [&](int64_t row, int64_t i) {
+    return accumulators[row * kTiledRowReductionAccumulators + i];
+  };
+
+  llvm::Value* init_value = Load(
+      element_ir_type, init_value_array.GetBasePointer(), "init_value");
+
+  auto load_input = [&](llvm::Type* type, llvm::Value* row_address,
+                        llvm::Value* column) {
+    llvm::LoadInst* load = AlignedLoad(
+        type, InBoundsGEP(element_ir_type, row_address, {column}),
+        element_alignment);
+    arg_array.AnnotateLoadStoreInstructionWithMetadata(load);
+    return load;
+  };
+
+  KernelSupportLibrary ksl(b());
+
+  // Reduces the columns [column_begin, column_end) of `rows` rows starting at
+  // `first_row`:
+  //
+  //   acc[r][i] = input[first_row + r, column_begin + i * VS : ... + VS]
+  //   for (col = column_begin + step; col < column_end; col += step)
+  //     for (i in accumulators)
+  //       for (r in rows)
+  //         acc[r][i] = reduce(acc[r][i], input[first_row + r, col + i * VS])
+  //   output[first_row + r] = reduce(partial, horizontal_reduce(acc[r]))
+  //
+  // where `partial` is the init value in the first column block, which also
+  // reduces the tail columns of the rows, and the output of the previous
+  // column blocks in all others. Accumulators start from the first vectors of the block rather than
+  // from the init value, so that the init value is reduced into each row once.
+  auto emit_rows = [&](llvm::Value* first_row, int64_t rows,
+                       llvm::Value* column_begin, llvm::Value* column_end,
+                       bool is_first_block) {
+    std::vector<llvm::Value*> row_addresses;
+    for (int64_t r = 0; r < rows; ++r) {
+      llvm::Value* row = Add(first_row, b()->getInt64(r));
+      row_addresses.push_back(
+          InBoundsGEP(element_ir_type, arg_array.GetBasePointer(),
+                      {Mul(row, b()->getInt64(row_size))}));
+    }
+
+    for (int64_t i = 0; i < kTiledRowReductionAccumulators; ++i) {
+      for (int64_t r = 0; r < rows; ++r) {
+        Store(load_input(accumulator_type, row_addresses[r],
+                         Add(column_begin, b()->getInt64(i * vector_size))),
+              accumulator(r, i));
+      }
+    }
+
+    auto emit_columns = [&](llvm::Value* column) {
+      for (int64_t i = 0; i < kTiledRowReductionAccumulators; ++i) {
+        llvm::Value* offset = Add(column, b()->getInt64(i * vector_size));
+        for (int64_t r = 0; r < rows; ++r) {
+          Store(reduction_generator(
+                    b(), Load(accumulator_type, accumulator(r, i)),
+                    load_input(accumulator_type, row_addresses[r], offset)),
+                accumulator(r, i));
+        }
+      }
+    };
+    ksl.For("row_reduction.column", Add(column_begin, b()->getInt64(step)),
+            column_end, step, emit_columns);
+
+    for (int64_t r = 0; r < rows; ++r) {
+      llvm::Value* result = Load(accumulator_type, accumulator(r, 0));
+      for (int64_t i = 1; i < kTiledRowReductionAccumulators; ++i) {
+        result = reduction_generator(b(), result,
+                                     Load(accumulator_type, accumulator(r, i)));
+      }
+      if (vector_size > 1) {
+        llvm::Value* vector = result;
+        result = b()->CreateExtractElement(vector, b()->getInt32(0));
+        for (int64_t lane = 1; lane < vector_size; ++lane) {
+          result = reduction_generator(
+              b(), result, b()->CreateExtractElement(vector, lane));
+        }
+      }
+
+      if (is_first_block && vectorized_row_size < row_size) {
+        Store(result, row_result);
+        ksl.For("row_reduction.column_tail", vectorized_row_size, row_size,
+                /*step=*/1, [&](llvm::Value* column) {
+                  Store(reduction_generator(
+                            b(), Load(element_ir_type, row_result),
+                            load_input(element_ir_type, row_addresses[r],
+                                       column)),
+                        row_result);
+                });
+        result = Load(element_ir_type, row_result);
+      }
+
+      llvm::Value* output_address =
+          InBoundsGEP(element_ir_type, output_array.GetBasePointer(),
+                      {Add(first_row, b()->getInt64(r))});
+      llvm::Value* partial = init_value;
+      if (!is_first_block) {
+        llvm::LoadInst* load =
+            AlignedLoad(element_ir_type, output_address, element_alignment);
+        output_array.AnnotateLoadStoreInstructionWithMetadata(load);
+        partial = load;
+      }
+      llvm::StoreInst* store =
+          AlignedStore(reduction_generator(b(), partial, result),
+                       output_address, element_alignment);
+      output_array.AnnotateLoadStoreInstructionWithMetadata(store);
+    }
+  };
+
+  llvm::Value* row_begin = b()->getInt64(0);
+  llvm::Value* row_end = b()->getInt64(num_rows);
+  if (outer_bounds.has_value()) {
+    const Shape& shape = reduce->shape();
+    int64_t rows_per_outer_index =
+        num_rows / shape.dimensions(LayoutUtil::Major(shape.layout(), 0));
+    row_begin = Mul(outer_bounds->first, b()->getInt64(rows_per_outer_index));
+    row_end = Mul(outer_bounds->second, b()->getInt64(rows_per_outer_index));
+  }
+
+  llvm::Value* tiled_row_end = Add(
+      row_begin,
+      Mul(UDiv(Sub(row_end, row_begin), b()->getInt64(kTiledRowReductionRows)),
+          b()->getInt64(kTiledRowReductionRows)));
+
+  // Rows longer than a column block are reduced one column block at a time,
+  // over all rows, so that the block of a row tile being reduced fits into L1
+  // and the partial results of the rows, kept in the output, stay in L2.
+  const int64_t column_block_size = std::max<int64_t>(
+      step, kTiledRowReductionColumnBlockBytes /
+                ShapeUtil::ByteSizeOfPrimitiveType(element_type) / step *
+                step);
+
+  ksl.For(
+      "row_reduction.column_block", /*start=*/0, /*end=*/vectorized_row_size,
+      /*step=*/column_block_size,
+      [&](llvm::Value* column_begin, bool is_first_block) {
+        llvm::Value* column_end =
+            Add(column_begin, b()->getInt64(column_block_size));
+        if (column_block_size < vectorized_row_size) {
+          column_end = Select(
+              ICmpULT(column_end, b()->getInt64(vectorized_row_size)),
+              column_end, b()->getInt64(vectorized_row_size));
+        }
+        ksl.For("row_reduction.rows", row_begin, tiled_row_end,
+                kTiledRowReductionRows, [&](llvm::Value* first_row) {
+                  emit_rows(first_row, kTiledRowReductionRows, column_begin,
+                            column_end, is_first_block);
+                });
+        ksl.For("row_reduction.row_tail", tiled_row_end, row_end, 1,
+                [&](llvm::Value* row) {
+                  emit_rows(row, 1, column_begin, column_end, is_first_block);
+                });
+      });
+
+  return absl::OkStatus();
+}
+
 absl::Status IrEmitter::HandleReduce(HloInstruction* reduce) {
   auto arg = reduce->mutable_operand(0);
   auto init_value = reduce->mutable_operand(1);
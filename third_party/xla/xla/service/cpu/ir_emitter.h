@@ -306,6 +306,26 @@ class IrEmitter : public DfsHloVisitorWithDefault,
                          const llvm_ir::IrArray& padding_value_array,
                          const llvm_ir::IrArray& output_array);
 
+  // Returns true if `reduce` is a kReduce that reduces the most minor
+  // (contiguous) dimensions of its operand with a reducer that
+  // EmitTiledRowReduction can vectorize. On failure, this stores a reason
+  // string into "failure_reason".
+  bool CanEmitTiledRowReduction(const HloInstruction* reduce,
+                                std::string* failure_reason) const;
+
+  // Emits a reduction over rows of contiguous elements. Several rows are
+  // reduced together, each into its own set of vector accumulators, so that
+  // independent loads and reductions hide each other's latency. Long rows are
+  // reduced one L1-sized column block at a time across all rows. If
+  // `outer_bounds` is set, only the rows within these bounds of the most major
+  // output dimension are reduced (used by parallel host kernels).
+  absl::Status EmitTiledRowReduction(
+      const HloInstruction* reduce, const llvm_ir::IrArray& arg_array,
+      const llvm_ir::IrArray& init_value_array,
+      const llvm_ir::IrArray& output_array,
+      std::optional<std::pair<llvm::Value*, llvm::Value*>> outer_bounds =
+          std::nullopt);
+
   // A convenient helper for calling BufferAssignment::GetUniqueSlice.
   BufferAllocation::Slice GetAllocationSlice(
       const HloInstruction& hlo, const ShapeIndex& index = {}) const {
@@ -59,6 +59,7 @@ limitations under the License.
 #include "xla/layout_util.h"
 #include "xla/service/buffer_assignment.h"
 #include "xla/service/cpu/backend_config.pb.h"
+#include "xla/service/cpu/cpu_options.h"
 #include "xla/service/cpu/dot_op_emitter.h"
 #include "xla/service/cpu/elemental_math_emitter.h"
 #include "xla/service/cpu/ir_emitter.h"
@@ -356,8 +357,56 @@ absl::StatusOr<IrEmitter2::KernelInfo> IrEmitter2::EmitReductionHostKernel(
     const HloInstruction* instr) {
   VLOG(2) << "Emit reduction host kernel: " << instr->name();
 
-  // TODO(ezhulenev): Port vectorized reduction emitter from IrEmitter.
-  return EmitElementalHostKernel(instr);
+  // Row reductions (i.e. softmax and layer norm) are emitted as tiled loops
+  // over contiguous rows. Parallel kernels are supported if they only
+  // partition the most major output dimension. Reduce-window is always
+  // emitted by the elemental emitter.
+  // TODO(ezhulenev): Port vectorized column reduction emitter from IrEmitter.
+  std::string failure_reason;
+  auto parallel_config = GetParallelConfig(instr);
+  bool can_emit_tiled_row_reduction =
+      instr->opcode() == HloOpcode::kReduce &&
+      !options::VectorizedReduceDisabled(hlo_module_.config()) &&
+      (!parallel_config ||
+       parallel_config->outer_dimension_partitions.size() == 1) &&
+      nested_ir_emitter_->CanEmitTiledRowReduction(instr, &failure_reason);
+
+  if (!can_emit_tiled_row_reduction) {
+    VLOG(2) << "Emit elemental reduction " << instr->name() << ": "
+            << failure_reason;
+    return EmitElementalHostKernel(instr);
+  }
+
+  TF_ASSIGN_OR_RETURN(KernelPrototype kernel_prototype,
+                      EmitKernelPrototype(instr));
+
+  llvm::LLVMContext& ctx = module_->getContext();
+  llvm::IRBuilder<> b(ctx);
+  auto builder_overwrite = nested_ir_emitter_->WithBuilder(b);
+
+  nested_ir_emitter_->PushComputeFunction(
+      &b, module_,
+      /*num_dynamic_loop_bounds=*/0, kernel_prototype.function,
+      /*dynamic_loop_bounds_arg=*/nullptr, kernel_prototype.return_block);
+
+  std::optional<std::pair<llvm::Value*, llvm::Value*>> outer_bounds;
+  se::ThreadDim thread_dims;
+  if (parallel_config) {
+    outer_bounds = EmitParallelPartitionBounds(b, kernel_prototype,
+                                               *parallel_config, instr->shape(),
+                                               instr->name())[0];
+    thread_dims = se::ThreadDim(ShapePartitionAssigner::GetTotalPartitionCount(
+        parallel_config->outer_dimension_partitions));
+  }
+
+  TF_RETURN_IF_ERROR(nested_ir_emitter_->EmitTiledRowReduction(
+      instr, kernel_prototype.arguments[0], kernel_prototype.arguments[1],
+      kernel_prototype.results[0], outer_bounds));
+
+  nested_ir_emitter_->PopComputeFunction();
+
+  return kernels_.emplace_back(
+      KernelInfo(std::move(kernel_prototype), se::BlockDim(), thread_dims));
 }
 
 // Dot (fusion) host kernel only supports strategies that emit LLVM IR.
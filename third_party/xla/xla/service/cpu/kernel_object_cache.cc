@@ -0,0 +1,141 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/cpu/kernel_object_cache.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/errors.h"
+#include "tsl/platform/logging.h"
+#include "tsl/platform/path.h"
+
+namespace xla::cpu {
+
+static std::string ObjFilePath(std::string_view dir, std::string_view key) {
+  return tsl::io::JoinPath(dir, absl::StrCat(key, ".o"));
+}
+
+// Writes the object file to a temporary file first, and then renames it, so
+// that concurrent readers never see a partially written object file.
+static absl::Status WriteObjFile(std::string_view dir, std::string_view key,
+                                 const std::string& obj_file) {
+  tsl::Env* env = tsl::Env::Default();
+  TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(std::string(dir)));
+
+  std::string path = ObjFilePath(dir, key);
+  std::string tmp_path = path;
+  if (!env->CreateUniqueFileName(&tmp_path, ".tmp")) {
+    return absl::InternalError(
+        absl::StrCat("Failed to create a temporary file name for ", path));
+  }
+
+  TF_RETURN_IF_ERROR(tsl::WriteStringToFile(env, tmp_path, obj_file));
+  return env->RenameFile(tmp_path, path);
+}
+
+KernelObjectCache::KernelObjectCache(size_t capacity_bytes)
+    : capacity_bytes_(capacity_bytes) {}
+
+KernelObjectCache& KernelObjectCache::Global() {
+  static auto* cache = new KernelObjectCache();
+  return *cache;
+}
+
+std::shared_ptr<const std::string> KernelObjectCache::Lookup(
+    std::string_view key, std::string_view dir) {
+  {
+    absl::MutexLock lock(&mu_);
+    if (auto it = obj_files_.find(key); it != obj_files_.end()) {
+      return it->second;
+    }
+  }
+
+  if (dir.empty()) return nullptr;
+
+  tsl::Env* env = tsl::Env::Default();
+  std::string path = ObjFilePath(dir, key);
+  if (!env->FileExists(path).ok()) return nullptr;
+
+  auto obj_file = std::make_shared<std::string>();
+  if (absl::Status status = tsl::ReadFileToString(env, path, obj_file.get());
+      !status.ok()) {
+    LOG(WARNING) << "Failed to read kernel object file " << path << ": "
+                 << status;
+    return nullptr;
+  }
+
+  VLOG(3) << "Loaded kernel object file " << path << " ("
+          << obj_file->size() << " bytes)";
+
+  absl::MutexLock lock(&mu_);
+  InsertInMemory(key, obj_file);
+  return obj_file;
+}
+
+void KernelObjectCache::Insert(std::string_view key, std::string obj_file,
+                               std::string_view dir) {
+  auto shared_obj_file =
+      std::make_shared<const std::string>(std::move(obj_file));
+
+  {
+    absl::MutexLock lock(&mu_);
+    if (!InsertInMemory(key, shared_obj_file)) return;
+  }
+
+  if (dir.empty()) return;
+
+  if (absl::Status status = WriteObjFile(dir, key, *shared_obj_file);
+      !status.ok()) {
+    LOG(WARNING) << "Failed to write kernel object file to " << dir << ": "
+                 << status;
+  }
+}
+
+bool KernelObjectCache::InsertInMemory(
+    std::string_view key, std::shared_ptr<const std::string> obj_file) {
+  if (obj_files_.contains(key)) return false;
+
+  size_bytes_ += obj_file->size();
+  insertion_order_.emplace_back(key);
+  obj_files_.emplace(key, std::move(obj_file));
+
+  while (size_bytes_ > capacity_bytes_ && !insertion_order_.empty()) {
+    auto it = obj_files_.find(insertion_order_.front());
+    size_bytes_ -= it->second->size();
+    obj_files_.erase(it);
+    insertion_order_.pop_front();
+  }
+  return true;
+}
+
+size_t KernelObjectCache::size() const {
+  absl::MutexLock lock(&mu_);
+  return obj_files_.size();
+}
+
+size_t KernelObjectCache::size_bytes() const {
+  absl::MutexLock lock(&mu_);
+  return size_bytes_;
+}
+
+}  // namespace xla::cpu
@@ -0,0 +1,87 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_SERVICE_CPU_KERNEL_OBJECT_CACHE_H_
+#define XLA_SERVICE_CPU_KERNEL_OBJECT_CACHE_H_
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+
+namespace xla::cpu {
+
+// A cache of object files with the machine code of XLA:CPU kernels.
+//
+// Each kernel is compiled into its own object file, and keyed by a fingerprint
+// of its LLVM IR, the target machine and the compiler options. Compiling a
+// model for a new shape bucket, or a model that shares fusions with one that
+// was compiled before, reuses the object code of all identical kernels instead
+// of running LLVM optimizations and codegen again.
+//
+// The cache keeps object files in memory, up to a capacity, and evicts the
+// oldest entries first. Callers can pass a directory to also persist object
+// files on disk and share them across processes. Object files are opaque
+// bytes for the cache: validating them is up to the caller.
+class KernelObjectCache {
+ public:
+  static constexpr size_t kDefaultCapacityBytes = 256 * 1024 * 1024;
+
+  explicit KernelObjectCache(size_t capacity_bytes = kDefaultCapacityBytes);
+
+  // Returns the process-wide kernel object cache.
+  static KernelObjectCache& Global();
+
+  // Returns the object file for `key`, or nullptr if it is not in the cache.
+  // If `dir` is not empty and the object file is not in memory, looks it up
+  // in `dir` and adds it to the in-memory cache.
+  std::shared_ptr<const std::string> Lookup(std::string_view key,
+                                            std::string_view dir = "");
+
+  // Adds the object file for `key` to the cache. If `dir` is not empty, also
+  // writes it to `dir`. Failures to write to disk are logged and ignored.
+  void Insert(std::string_view key, std::string obj_file,
+              std::string_view dir = "");
+
+  // Returns the number of object files and their total size in memory.
+  size_t size() const;
+  size_t size_bytes() const;
+
+ private:
+  // Adds the object file to the in-memory cache and evicts the oldest entries
+  // if the cache is over capacity. Returns false if `key` is already cached.
+  bool InsertInMemory(std::string_view key,
+                      std::shared_ptr<const std::string> obj_file)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  size_t capacity_bytes_;
+
+  mutable absl::Mutex mu_;
+  absl::flat_hash_map<std::string, std::shared_ptr<const std::string>>
+      obj_files_ ABSL_GUARDED_BY(mu_);
+
+  // Keys in the order they were added to the cache, oldest first.
+  std::deque<std::string> insertion_order_ ABSL_GUARDED_BY(mu_);
+  size_t size_bytes_ ABSL_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace xla::cpu
+
+#endif  // XLA_SERVICE_CPU_KERNEL_OBJECT_CACHE_H_
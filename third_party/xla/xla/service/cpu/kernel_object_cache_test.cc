@@ -0,0 +1,78 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/cpu/kernel_object_cache.h"
+
+#include <memory>
+#include <string>
+
+#include "tsl/platform/env.h"
+#include "tsl/platform/path.h"
+#include "tsl/platform/test.h"
+
+namespace xla::cpu {
+namespace {
+
+TEST(KernelObjectCacheTest, LookupInMemory) {
+  KernelObjectCache cache;
+  EXPECT_EQ(cache.Lookup("a"), nullptr);
+
+  cache.Insert("a", "object a");
+  std::shared_ptr<const std::string> obj_file = cache.Lookup("a");
+  ASSERT_NE(obj_file, nullptr);
+  EXPECT_EQ(*obj_file, "object a");
+
+  // Inserting the same key again keeps the original object file.
+  cache.Insert("a", "another object a");
+  EXPECT_EQ(cache.Lookup("a"), obj_file);
+  EXPECT_EQ(cache.size(), 1);
+  EXPECT_EQ(cache.size_bytes(), 8);
+}
+
+TEST(KernelObjectCacheTest, EvictsOldestObjectFiles) {
+  KernelObjectCache cache(/*capacity_bytes=*/10);
+
+  cache.Insert("a", "aaaa");
+  cache.Insert("b", "bbbb");
+  cache.Insert("c", "cccc");
+
+  EXPECT_EQ(cache.Lookup("a"), nullptr);
+  EXPECT_NE(cache.Lookup("b"), nullptr);
+  EXPECT_NE(cache.Lookup("c"), nullptr);
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(cache.size_bytes(), 8);
+}
+
+TEST(KernelObjectCacheTest, LookupOnDisk) {
+  std::string dir = tsl::io::JoinPath(testing::TempDir(), "kernel_cache");
+
+  KernelObjectCache writer;
+  writer.Insert("a", "object a", dir);
+  EXPECT_TRUE(
+      tsl::Env::Default()->FileExists(tsl::io::JoinPath(dir, "a.o")).ok());
+
+  // A fresh cache (e.g. in another process) finds the object file on disk.
+  KernelObjectCache reader;
+  EXPECT_EQ(reader.Lookup("a"), nullptr);
+  std::shared_ptr<const std::string> obj_file = reader.Lookup("a", dir);
+  ASSERT_NE(obj_file, nullptr);
+  EXPECT_EQ(*obj_file, "object a");
+  EXPECT_EQ(reader.size(), 1);
+
+  EXPECT_EQ(reader.Lookup("b", dir), nullptr);
+}
+
+}  // namespace
+}  // namespace xla::cpu
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "xla/service/cpu/metrics.h"
 
+#include <cstdint>
 #include <deque>
 #include <string>
 
@@ -23,6 +24,7 @@ limitations under the License.
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "xla/tsl/lib/monitoring/counter.h"
+#include "xla/tsl/lib/monitoring/gauge.h"
 #include "tsl/platform/stacktrace.h"
 
 namespace xla {
@@ -32,6 +34,16 @@ auto* cpu_compiler_stacktrace_count = tsl::monitoring::Counter<1>::New(
     "/xla/service/cpu/compiler_stacktrace_count",
     "The number of times a compiler stacktrace was called.", "stacktrace");
 
+auto* cpu_shared_constants_bytes = tsl::monitoring::Counter<0>::New(
+    "/xla/service/cpu/shared_constants_bytes",
+    "The number of bytes of constants that CPU executables share with "
+    "previously compiled executables.");
+
+auto* cpu_compiled_peak_memory_bytes = tsl::monitoring::Gauge<int64_t, 0>::New(
+    "/xla/service/cpu/compiled_peak_memory_bytes",
+    "The total size of buffer allocations of the most recently compiled CPU "
+    "executable.");
+
 void RecordCpuCompilerStacktrace() {
   std::string tsl_stacktrace = tsl::CurrentStackTrace();
 
@@ -59,6 +71,22 @@ void RecordCpuCompilerStacktrace() {
   cpu_compiler_stacktrace_count->GetCell(stacktrace)->IncrementBy(1);
 }
 
+void RecordCpuSharedConstantsBytes(int64_t bytes) {
+  cpu_shared_constants_bytes->GetCell()->IncrementBy(bytes);
+}
+
+int64_t GetCpuSharedConstantsBytes() {
+  return cpu_shared_constants_bytes->GetCell()->value();
+}
+
+void RecordCpuCompiledPeakMemoryBytes(int64_t bytes) {
+  cpu_compiled_peak_memory_bytes->GetCell()->Set(bytes);
+}
+
+int64_t GetCpuCompiledPeakMemoryBytes() {
+  return cpu_compiled_peak_memory_bytes->GetCell()->value();
+}
+
 int GetCpuCompilerStacktraceCount(absl::string_view stacktrace) {
   return cpu_compiler_stacktrace_count->GetCell(std::string(stacktrace))
       ->value();
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef XLA_SERVICE_CPU_METRICS_H_
 #define XLA_SERVICE_CPU_METRICS_H_
 
+#include <cstdint>
+
 #include "absl/strings/string_view.h"
 
 namespace xla {
@@ -28,6 +30,20 @@ void RecordCpuCompilerStacktrace();
 // stacktrace.
 int GetCpuCompilerStacktraceCount(absl::string_view stacktrace);
 
+// Records the number of bytes of constants that a CPU executable shares with
+// previously compiled executables instead of keeping its own copy.
+void RecordCpuSharedConstantsBytes(int64_t bytes);
+
+// Returns the total number of bytes of constants shared by CPU executables.
+int64_t GetCpuSharedConstantsBytes();
+
+// Records the peak memory of the most recently compiled CPU executable, i.e.
+// the total size of its buffer allocations.
+void RecordCpuCompiledPeakMemoryBytes(int64_t bytes);
+
+// Returns the peak memory of the most recently compiled CPU executable.
+int64_t GetCpuCompiledPeakMemoryBytes();
+
 }  // namespace cpu
 }  // namespace xla
 
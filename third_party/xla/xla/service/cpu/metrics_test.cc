@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "xla/service/cpu/metrics.h"
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -44,6 +45,19 @@ TEST(MetricsTest, RecordsCpuCompilerStacktrace) {
       1);
 }
 
+TEST(MetricsTest, RecordsCpuSharedConstantsBytes) {
+  int64_t bytes = GetCpuSharedConstantsBytes();
+  RecordCpuSharedConstantsBytes(1024);
+  EXPECT_EQ(GetCpuSharedConstantsBytes(), bytes + 1024);
+}
+
+TEST(MetricsTest, RecordsCpuCompiledPeakMemoryBytes) {
+  RecordCpuCompiledPeakMemoryBytes(4096);
+  EXPECT_EQ(GetCpuCompiledPeakMemoryBytes(), 4096);
+  RecordCpuCompiledPeakMemoryBytes(1024);
+  EXPECT_EQ(GetCpuCompiledPeakMemoryBytes(), 1024);
+}
+
 }  // namespace
 }  // namespace cpu
 }  // namespace xla
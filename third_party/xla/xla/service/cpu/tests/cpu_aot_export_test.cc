@@ -13,32 +13,41 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include <gtest/gtest.h>
+#include "absl/container/flat_hash_set.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/string_view.h"
 #include "xla/hlo/ir/hlo_module.h"
 #include "xla/hlo/ir/hlo_module_group.h"
 #include "xla/service/compiler.h"
+#include "xla/service/cpu/cpu_executable.h"
 #include "xla/service/executable.h"
 #include "xla/service/platform_util.h"
 #include "xla/stream_executor/platform.h"
 #include "xla/stream_executor/platform_manager.h"
 #include "xla/stream_executor/stream_executor.h"
 #include "xla/tests/hlo_test_base.h"
+#include "xla/xla.pb.h"
 #include "tsl/platform/statusor.h"
 
 namespace xla::cpu {
 
 class CpuAotCompilationTest : public HloTestBase {
  protected:
-  void ExportAndLoad(std::string_view hlo_string) {
+  void ExportAndLoad(
+      std::string_view hlo_string,
+      std::function<void(DebugOptions&)> set_debug_options = nullptr) {
     TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> module,
                             ParseAndReturnVerifiedModule(hlo_string));
+    if (set_debug_options) {
+      set_debug_options(module->mutable_config().mutable_debug_options());
+    }
 
     auto compiler = backend().compiler();
     auto name = absl::AsciiStrToUpper(
@@ -54,6 +63,13 @@ class CpuAotCompilationTest : public HloTestBase {
         std::vector<std::unique_ptr<Executable>> executables,
         compiler->Compile(std::move(module_group), {{stream_exec}}, nullptr));
 
+    // Every object file is exported once, even if several LLVM module parts
+    // share a kernel.
+    auto* cpu_executable = static_cast<CpuExecutable*>(executables[0].get());
+    absl::flat_hash_set<std::string_view> unique_obj_files(
+        cpu_executable->obj_files().begin(), cpu_executable->obj_files().end());
+    EXPECT_EQ(unique_obj_files.size(), cpu_executable->obj_files().size());
+
     TF_ASSERT_OK_AND_ASSIGN(
         std::unique_ptr<AotCompilationResult> exported_aot_result,
         compiler->Export(executables[0].get()));
@@ -99,4 +115,29 @@ TEST_F(CpuAotCompilationTest, ExportAndLoadExecutableNoKernels) {
   ExportAndLoad(hlo_string);
 }
 
+TEST_F(CpuAotCompilationTest, ExportAndLoadExecutableWithSharedKernels) {
+  // Identical kernels that end up in different LLVM module parts share one
+  // extracted kernel.
+  const absl::string_view hlo_string = R"(
+    HloModule Test
+
+    ENTRY main {
+      p0 = f32[1024]{0} parameter(0)
+      p1 = f32[1024]{0} parameter(1)
+      p2 = f32[1024]{0} parameter(2)
+      p3 = f32[1024]{0} parameter(3)
+      a0 = f32[1024]{0} add(p0, p0)
+      a1 = f32[1024]{0} add(p1, p1)
+      a2 = f32[1024]{0} add(p2, p2)
+      a3 = f32[1024]{0} add(p3, p3)
+      ROOT t = (f32[1024]{0}, f32[1024]{0}, f32[1024]{0}, f32[1024]{0})
+        tuple(a0, a1, a2, a3)
+    })";
+
+  ExportAndLoad(hlo_string, [](DebugOptions& debug_options) {
+    debug_options.set_xla_cpu_enable_kernel_object_cache(true);
+    debug_options.set_xla_cpu_parallel_codegen_split_count(4);
+  });
+}
+
 }  // namespace xla::cpu
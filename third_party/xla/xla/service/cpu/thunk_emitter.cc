@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "xla/service/cpu/thunk_emitter.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
@@ -68,6 +69,7 @@ limitations under the License.
 #include "xla/service/cpu/ir_emission_utils.h"
 #include "xla/service/cpu/ir_emitter2.h"
 #include "xla/service/hlo.pb.h"
+#include "xla/service/hlo_cost_analysis.h"
 #include "xla/service/hlo_module_config.h"
 #include "xla/service/pattern_matcher.h"
 #include "xla/shape.h"
@@ -84,18 +86,40 @@ namespace xla::cpu {
 ThunkEmitter::ThunkEmitter(IrEmitter2& ir_emitter,
                            const BufferAssignment& buffer_assignment,
                            const TargetMachineFeatures& target_machine_features,
-                           const HloModuleConfig& hlo_module_config)
+                           const HloModuleConfig& hlo_module_config,
+                           const HloCostAnalysis* cost_analysis)
     : ir_emitter_(ir_emitter),
       buffer_assignment_(buffer_assignment),
       target_machine_features_(target_machine_features),
       hlo_module_config_(hlo_module_config),
+      cost_analysis_(cost_analysis),
       communicator_resource_(
           Resource::Create(Resource::kCollectiveCommunicator)) {}
 
-static Thunk::Info ThunkInfo(const HloInstruction* instruction) {
+Thunk::Info ThunkEmitter::ThunkInfo(const HloInstruction* instruction) const {
   const HloModule* module = instruction->GetModule();
   return Thunk::Info{std::string(instruction->name()),
-                     std::string(module->name()), module->unique_id()};
+                     std::string(module->name()), module->unique_id(),
+                     EstimateCost(instruction)};
+}
+
+int64_t ThunkEmitter::EstimateCost(const HloInstruction* instruction) const {
+  if (cost_analysis_ == nullptr) return 0;
+
+  // Rough single core throughput. Only the relative cost of thunks matters to
+  // the ThunkExecutor, so we don't try to model the target machine precisely.
+  static constexpr double kFlopsPerNs = 32.0;
+  static constexpr double kTranscendentalsPerNs = 4.0;
+  static constexpr double kBytesPerNs = 16.0;
+
+  double compute_ns =
+      cost_analysis_->flop_count(*instruction) / kFlopsPerNs +
+      cost_analysis_->transcendental_count(*instruction) /
+          kTranscendentalsPerNs;
+  double memory_ns = cost_analysis_->bytes_accessed(*instruction) / kBytesPerNs;
+
+  // Every thunk has a non-zero launch overhead.
+  return 1 + static_cast<int64_t>(std::max(compute_ns, memory_ns));
 }
 
 absl::StatusOr<ThunkSequence> ThunkEmitter::EmitEntryComputation(
@@ -1136,7 +1160,7 @@ absl::StatusOr<ThunkSequence> ThunkEmitter::MakeKernelThunkSequence(
     const HloInstruction* instruction,
     const ThunkEmitter::HostKernelAllocationSlices& buffers,
     const IrEmitter2::KernelInfo& kernel,
-    std::optional<uint64_t> min_alignment) {
+    std::optional<uint64_t> min_alignment) const {
   return ThunkSequence::Of<KernelThunk>(
       ThunkInfo(instruction), buffers.arguments, buffers.results, kernel.name,
       kernel.thread_dims, kernel.invariant_arguments, min_alignment);
@@ -35,6 +35,7 @@ limitations under the License.
 #include "xla/hlo/ir/hlo_module.h"
 #include "xla/service/buffer_assignment.h"
 #include "xla/service/cpu/ir_emitter2.h"
+#include "xla/service/hlo_cost_analysis.h"
 #include "xla/service/hlo_module_config.h"
 #include "xla/shape_util.h"
 #include "xla/xla_data.pb.h"
@@ -50,10 +51,14 @@ namespace xla::cpu {
 // multiple LLVM modules compiled to object files).
 class ThunkEmitter {
  public:
+  // If `cost_analysis` is not null, thunks are annotated with the estimated
+  // cost of their instructions, which the ThunkExecutor uses to prioritize
+  // thunks on the critical path.
   ThunkEmitter(IrEmitter2& ir_emitter,
                const BufferAssignment& buffer_assignment,
                const TargetMachineFeatures& target_machine_features,
-               const HloModuleConfig& hlo_module_config);
+               const HloModuleConfig& hlo_module_config,
+               const HloCostAnalysis* cost_analysis = nullptr);
 
   // Emits HLO module entry computation as a sequence of thunks.
   absl::StatusOr<ThunkSequence> EmitEntryComputation(const HloModule& module);
@@ -64,6 +69,12 @@ class ThunkEmitter {
     std::vector<BufferAllocation::Slice> results;
   };
 
+  Thunk::Info ThunkInfo(const HloInstruction* instruction) const;
+
+  // Returns the estimated execution time of `instruction` in nanoseconds, or
+  // zero if there is no cost analysis.
+  int64_t EstimateCost(const HloInstruction* instruction) const;
+
   std::optional<SortThunk::SortDirection> MatchSortDirection(
       const HloComputation* hlo_comparator) const;
 
@@ -200,17 +211,18 @@ class ThunkEmitter {
       absl::Span<const PrimitiveType> supported_types);
 
   // Convenience function that creates a thunk sequence containing given kernel.
-  static absl::StatusOr<ThunkSequence> MakeKernelThunkSequence(
+  absl::StatusOr<ThunkSequence> MakeKernelThunkSequence(
       const HloInstruction* instruction,
       const ThunkEmitter::HostKernelAllocationSlices& buffers,
       const IrEmitter2::KernelInfo& kernel,
-      std::optional<uint64_t> min_alignment = std::nullopt);
+      std::optional<uint64_t> min_alignment = std::nullopt) const;
 
   IrEmitter2& ir_emitter_;
   const BufferAssignment& buffer_assignment_;
 
   const TargetMachineFeatures& target_machine_features_;
   const HloModuleConfig& hlo_module_config_;
+  const HloCostAnalysis* cost_analysis_;
 
   // A global resource that is used to order all collective operations.
   std::shared_ptr<Resource> communicator_resource_;
@@ -655,6 +655,87 @@ XLA_TEST_F(ReduceTest, Reduce2DAmong1) {
   ComputeAndCompareR1<float>(&builder, expected, {}, ErrorSpec(0.0001));
 }
 
+// Reduces rows that are not a multiple of the vector width, with an init value
+// that is not the identity of the reducer: the init value must be reduced into
+// every row exactly once.
+XLA_TEST_F(ReduceTest, Reduce2DAmong1WithInitValue) {
+  const int64_t rows = 7, cols = 37;
+
+  XlaBuilder builder(TestName());
+  auto add = CreateScalarAddComputation(F32, &builder);
+  Array2D<float> input_data(rows, cols);
+  input_data.FillRandom(1.0f, 0.5f);
+  auto m = ConstantR2FromArray2D<float>(&builder, input_data);
+  Reduce(m, ConstantR0<float>(&builder, 10.0f), add, {1});
+
+  std::vector<float> expected;
+  for (int64_t rowno = 0; rowno < rows; ++rowno) {
+    float row_sum = 10.0f;
+    for (int64_t colno = 0; colno < cols; ++colno) {
+      row_sum += input_data(rowno, colno);
+    }
+    expected.push_back(row_sum);
+  }
+  ComputeAndCompareR1<float>(&builder, expected, {}, ErrorSpec(0.001, 1e-4));
+}
+
+// Reduces enough rows for the CPU backends to split the reduction into
+// partitions that run in parallel, each of which must only write its rows.
+XLA_TEST_F(ReduceTest, Reduce2DAmong1Partitioned) {
+  const int64_t rows = 512, cols = 1027;
+
+  XlaBuilder builder(TestName());
+  auto add = CreateScalarAddComputation(F32, &builder);
+  // A parameter, so that the reduction isn't constant folded.
+  auto m = Parameter(&builder, 0, ShapeUtil::MakeShape(F32, {rows, cols}), "m");
+  Reduce(m, ConstantR0<float>(&builder, 10.0f), add, {1});
+
+  Array2D<float> input_data(rows, cols);
+  input_data.FillRandom(1.0f, 0.5f);
+  std::unique_ptr<GlobalData> input_global_data =
+      client_->TransferToServer(LiteralUtil::CreateR2FromArray2D(input_data))
+          .value();
+
+  std::vector<float> expected;
+  for (int64_t rowno = 0; rowno < rows; ++rowno) {
+    float row_sum = 10.0f;
+    for (int64_t colno = 0; colno < cols; ++colno) {
+      row_sum += input_data(rowno, colno);
+    }
+    expected.push_back(row_sum);
+  }
+  ComputeAndCompareR1<float>(&builder, expected, {input_global_data.get()},
+                             ErrorSpec(0.01, 1e-4));
+}
+
+// Reduces rows long enough for the CPU backends to reduce them in several
+// column blocks, the last of which is shorter than the others.
+XLA_TEST_F(ReduceTest, Reduce2DAmong1LongRows) {
+  const int64_t rows = 6, cols = 5003;
+
+  XlaBuilder builder(TestName());
+  auto add = CreateScalarAddComputation(F32, &builder);
+  auto m = Parameter(&builder, 0, ShapeUtil::MakeShape(F32, {rows, cols}), "m");
+  Reduce(m, ConstantR0<float>(&builder, 10.0f), add, {1});
+
+  Array2D<float> input_data(rows, cols);
+  input_data.FillRandom(1.0f, 0.5f);
+  std::unique_ptr<GlobalData> input_global_data =
+      client_->TransferToServer(LiteralUtil::CreateR2FromArray2D(input_data))
+          .value();
+
+  std::vector<float> expected;
+  for (int64_t rowno = 0; rowno < rows; ++rowno) {
+    float row_sum = 10.0f;
+    for (int64_t colno = 0; colno < cols; ++colno) {
+      row_sum += input_data(rowno, colno);
+    }
+    expected.push_back(row_sum);
+  }
+  ComputeAndCompareR1<float>(&builder, expected, {input_global_data.get()},
+                             ErrorSpec(0.01, 1e-4));
+}
+
 XLA_TEST_F(ReduceTest, Reduce2DAmong0and1) {
   // Reduce a matrix among dimensions 0 and 1 (sum it up to a scalar).
   XlaBuilder builder(TestName());
@@ -50,6 +50,7 @@ limitations under the License.
 #include "xla/tests/hlo_test_base.h"
 #include "xla/tests/test_macros.h"
 #include "xla/tsl/lib/core/status_test_util.h"
+#include "xla/xla.pb.h"
 #include "xla/xla_data.pb.h"
 #include "tsl/platform/errors.h"
 #include "tsl/platform/statusor.h"
@@ -1691,6 +1692,36 @@ ENTRY R3Window {
   EXPECT_TRUE(RunAndCompare(hlo_string, ErrorSpec{0.001}));
 }
 
+// The CPU thunk runtime emits reduce and reduce-window into host kernels
+// through the same entry point, which only emits tiled row reductions for
+// reduce.
+class ReduceWindowThunkRuntimeTest : public HloTestBase {
+ protected:
+  DebugOptions GetDebugOptionsForTest() const override {
+    DebugOptions debug_options = HloTestBase::GetDebugOptionsForTest();
+    debug_options.set_xla_cpu_use_thunk_runtime(true);
+    return debug_options;
+  }
+};
+
+XLA_TEST_F(ReduceWindowThunkRuntimeTest, R2WindowOverRows) {
+  const std::string hlo_string = R"(
+HloModule R2WindowOverRows
+add {
+  lhs = f32[] parameter(0)
+  rhs = f32[] parameter(1)
+  ROOT add = f32[] add(lhs, rhs)
+}
+ENTRY R2WindowOverRows {
+  operand = f32[64,128]{1,0} parameter(0)
+  constant = f32[] constant(0)
+  ROOT reduce-window = f32[64,1]{1,0} reduce-window(operand, constant),
+    window={size=1x128}, to_apply=add
+}
+)";
+  EXPECT_TRUE(RunAndCompare(hlo_string, ErrorSpec{0.001}));
+}
+
 XLA_TEST_F(HloTestBase, ReduceWindowIdentity) {
   const std::string hlo_string = R"(
 HloModule ReduceWindowIdentity